@@ -0,0 +1,145 @@
+#include "benchmark/loopback/LoadGenerator.h"
+
+#include <QFile>
+#include <QTextStream>
+
+#include <sodium.h>
+
+#include "benchmark/loopback/LoopbackServer.h"
+#include "src/crypto/Nonce.h"
+#include "src/encoding/Pkcs7.h"
+#include "src/exceptions/IllegalArgumentException.h"
+#include "src/messages/FullMessageHeader.h"
+#include "src/messages/MessageFlags.h"
+#include "src/messages/MessageWithEncryptedPayload.h"
+#include "src/messages/contact/ContactTextMessageContent.h"
+#include "src/protocol/MessageTime.h"
+#include "src/protocol/ProtocolSpecs.h"
+#include "src/protocol/PushFromId.h"
+#include "src/utility/QObjectConnectionMacro.h"
+
+#define OPENMITTSU_LOADGENERATOR_TICK_INTERVAL_MS (5)
+#define OPENMITTSU_LOADGENERATOR_MAX_SENDERS (9999)
+
+namespace openmittsu {
+	namespace benchmark {
+
+		LoadGenerator::Sender::Sender(openmittsu::protocol::ContactId const& senderId, openmittsu::crypto::KeyPair const& senderKey, openmittsu::crypto::PublicKey const& recipientPublicKey) : id(senderId), key(senderKey), sharedKey(recipientPublicKey, senderKey) {
+			// Intentionally left empty.
+		}
+
+		LoadGenerator::LoadGenerator(LoopbackServer* server, openmittsu::protocol::ContactId const& recipient, openmittsu::crypto::PublicKey const& recipientPublicKey, int senderCount, int messagesPerSecondPerSender) : QObject(),
+			m_server(server), m_recipient(recipient), m_messagesPerSecond(senderCount * messagesPerSecondPerSender), m_senders(), m_timer(), m_clock(), m_durationMilliseconds(0), m_messagesSent(0), m_messagesBehindSchedule(0), m_nextSender(0) {
+			if ((senderCount < 1) || (senderCount > OPENMITTSU_LOADGENERATOR_MAX_SENDERS)) {
+				throw openmittsu::exceptions::IllegalArgumentException() << "The number of senders has to be between 1 and " << OPENMITTSU_LOADGENERATOR_MAX_SENDERS << ", not " << senderCount << ".";
+			} else if (messagesPerSecondPerSender < 1) {
+				throw openmittsu::exceptions::IllegalArgumentException() << "The message rate has to be positive, not " << messagesPerSecondPerSender << ".";
+			}
+
+			for (int i = 1; i <= senderCount; ++i) {
+				QString const identity = QStringLiteral("LOOP%1").arg(i, 4, 10, QChar('0'));
+				m_senders.push_back(std::make_unique<Sender>(openmittsu::protocol::ContactId(identity), deriveKeyPair(QStringLiteral("openMittsu loopback sender %1").arg(identity)), recipientPublicKey));
+			}
+
+			m_timer.setInterval(OPENMITTSU_LOADGENERATOR_TICK_INTERVAL_MS);
+			OPENMITTSU_CONNECT(&m_timer, timeout(), this, timerOnTimeout());
+		}
+
+		LoadGenerator::~LoadGenerator() {
+			// Intentionally left empty.
+		}
+
+		openmittsu::crypto::KeyPair LoadGenerator::deriveKeyPair(QString const& seed) {
+			unsigned char seedHash[crypto_box_SEEDBYTES];
+			QByteArray const seedBytes = seed.toUtf8();
+			crypto_generichash(seedHash, sizeof(seedHash), reinterpret_cast<unsigned char const*>(seedBytes.constData()), seedBytes.size(), nullptr, 0);
+
+			unsigned char publicKey[crypto_box_PUBLICKEYBYTES];
+			unsigned char secretKey[crypto_box_SECRETKEYBYTES];
+			crypto_box_seed_keypair(publicKey, secretKey, seedHash);
+
+			openmittsu::crypto::KeyPair const result = openmittsu::crypto::KeyPair::fromArrays(publicKey, secretKey);
+			sodium_memzero(secretKey, sizeof(secretKey));
+			return result;
+		}
+
+		void LoadGenerator::writeContactsFile(QString const& filename) const {
+			QFile file(filename);
+			if (!file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text)) {
+				throw openmittsu::exceptions::IllegalArgumentException() << QString("Could not open the contacts file for writing: %1").arg(filename).toStdString();
+			}
+
+			QTextStream out(&file);
+			out.setCodec("UTF-8");
+			out << "# Sender identities of the openMittsu loopback load generator." << endl;
+			for (auto const& sender : m_senders) {
+				out << sender->id.toQString() << " : " << QString(sender->key.getPublicKey().toHex()) << " : Loopback " << sender->id.toQString() << endl;
+			}
+		}
+
+		void LoadGenerator::start(int durationSeconds) {
+			m_durationMilliseconds = static_cast<qint64>(durationSeconds) * 1000;
+			m_messagesSent = 0;
+			m_messagesBehindSchedule = 0;
+			m_clock.start();
+			m_timer.start();
+		}
+
+		void LoadGenerator::stop() {
+			m_timer.stop();
+		}
+
+		quint64 LoadGenerator::getMessagesSent() const {
+			return m_messagesSent;
+		}
+
+		quint64 LoadGenerator::getMessagesBehindSchedule() const {
+			return m_messagesBehindSchedule;
+		}
+
+		double LoadGenerator::getElapsedSeconds() const {
+			return m_clock.isValid() ? (static_cast<double>(m_clock.nsecsElapsed()) / 1e9) : 0.0;
+		}
+
+		void LoadGenerator::timerOnTimeout() {
+			qint64 const elapsed = m_clock.elapsed();
+			if (elapsed >= m_durationMilliseconds) {
+				stop();
+				emit finished();
+				return;
+			} else if (!m_server->isClientReady()) {
+				return;
+			}
+
+			// Catch up with the schedule, but return to the event loop after one tick worth of work so acknowledgments are read in time.
+			quint64 const due = static_cast<quint64>(elapsed) * static_cast<quint64>(m_messagesPerSecond) / 1000;
+			QElapsedTimer tickClock;
+			tickClock.start();
+			while ((m_messagesSent < due) && (tickClock.elapsed() < OPENMITTSU_LOADGENERATOR_TICK_INTERVAL_MS)) {
+				Sender const& sender = *m_senders.at(m_nextSender);
+				m_nextSender = (m_nextSender + 1) % m_senders.size();
+
+				openmittsu::protocol::MessageId const messageId(openmittsu::protocol::MessageId::random());
+				if (!m_server->deliver(messageId, buildPacket(sender, messageId))) {
+					break;
+				}
+				++m_messagesSent;
+			}
+			m_messagesBehindSchedule = (due > m_messagesSent) ? (due - m_messagesSent) : 0;
+		}
+
+		QByteArray LoadGenerator::buildPacket(Sender const& sender, openmittsu::protocol::MessageId const& messageId) {
+			openmittsu::messages::FullMessageHeader const header(m_recipient, openmittsu::protocol::MessageTime::now(), sender.id, messageId, openmittsu::messages::MessageFlags(), openmittsu::protocol::PushFromId(sender.id));
+			QString const text = QStringLiteral("Loopback message #%1 from %2.").arg(m_messagesSent).arg(sender.id.toQString());
+			QByteArray const payload = openmittsu::messages::contact::ContactTextMessageContent(text).toPacketPayload();
+
+			openmittsu::crypto::Nonce const nonce;
+			QByteArray const encryptedPayload = sender.sharedKey.encrypt(openmittsu::encoding::Pkcs7::encodePkcs7Sequence(payload), nonce);
+
+			QByteArray packet = openmittsu::messages::MessageWithEncryptedPayload(header, nonce, encryptedPayload).toPacket();
+			packet[0] = (PROTO_PACKET_SIGNATURE_DELIVERING_MSG);
+			return packet;
+		}
+
+	}
+}
@@ -0,0 +1,76 @@
+#ifndef OPENMITTSU_BENCHMARK_LOADGENERATOR_H_
+#define OPENMITTSU_BENCHMARK_LOADGENERATOR_H_
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+#include <memory>
+#include <vector>
+
+#include "src/crypto/KeyPair.h"
+#include "src/crypto/PrecomputedSharedKey.h"
+#include "src/crypto/PublicKey.h"
+#include "src/protocol/ContactId.h"
+#include "src/protocol/MessageId.h"
+
+namespace openmittsu {
+	namespace benchmark {
+
+		class LoopbackServer;
+
+		/**
+		 * Pushes text messages from a number of generated sender identities through a LoopbackServer at a fixed rate.
+		 * The sender keys are derived from their identities, so the contacts file only needs to be imported into the client once.
+		 */
+		class LoadGenerator : public QObject {
+			Q_OBJECT
+		public:
+			LoadGenerator(LoopbackServer* server, openmittsu::protocol::ContactId const& recipient, openmittsu::crypto::PublicKey const& recipientPublicKey, int senderCount, int messagesPerSecondPerSender);
+			virtual ~LoadGenerator();
+
+			/** Writes the sender identities and public keys in the format read by the LegacyContactImporter. */
+			void writeContactsFile(QString const& filename) const;
+
+			void start(int durationSeconds);
+			void stop();
+
+			quint64 getMessagesSent() const;
+			quint64 getMessagesBehindSchedule() const;
+			double getElapsedSeconds() const;
+
+			/** Derives a key pair from a seed string, e.g. for a server key that stays the same between runs. */
+			static openmittsu::crypto::KeyPair deriveKeyPair(QString const& seed);
+		signals:
+			void finished();
+		private slots:
+			void timerOnTimeout();
+		private:
+			struct Sender {
+				Sender(openmittsu::protocol::ContactId const& senderId, openmittsu::crypto::KeyPair const& senderKey, openmittsu::crypto::PublicKey const& recipientPublicKey);
+
+				openmittsu::protocol::ContactId const id;
+				openmittsu::crypto::KeyPair const key;
+				openmittsu::crypto::PrecomputedSharedKey const sharedKey;
+			};
+
+			LoopbackServer* const m_server;
+			openmittsu::protocol::ContactId const m_recipient;
+			int const m_messagesPerSecond;
+			std::vector<std::unique_ptr<Sender>> m_senders;
+
+			QTimer m_timer;
+			QElapsedTimer m_clock;
+			qint64 m_durationMilliseconds;
+			quint64 m_messagesSent;
+			quint64 m_messagesBehindSchedule;
+			std::size_t m_nextSender;
+
+			QByteArray buildPacket(Sender const& sender, openmittsu::protocol::MessageId const& messageId);
+		};
+
+	}
+}
+
+#endif // OPENMITTSU_BENCHMARK_LOADGENERATOR_H_
@@ -0,0 +1,265 @@
+#include "benchmark/loopback/LoopbackServer.h"
+
+#include <sodium.h>
+
+#include "src/crypto/Key.h"
+#include "src/crypto/Nonce.h"
+#include "src/exceptions/CryptoException.h"
+#include "src/protocol/ProtocolSpecs.h"
+#include "src/utility/Logging.h"
+#include "src/utility/QObjectConnectionMacro.h"
+
+namespace openmittsu {
+	namespace benchmark {
+
+		LoopbackServer::LoopbackServer(openmittsu::crypto::KeyPair const& serverLongTermKey, openmittsu::protocol::ContactId const& clientContactId, openmittsu::crypto::PublicKey const& clientLongTermPublicKey) : QObject(),
+			m_serverLongTermKey(serverLongTermKey), m_clientContactId(clientContactId), m_clientLongTermPublicKey(clientLongTermPublicKey), m_server(), m_socket(nullptr), m_state(State::WAITING_FOR_CLIENT_HELLO),
+			m_serverShortTermKey(), m_clientShortTermPublicKey(), m_serverNonceGenerator(), m_clientNonceGenerator(), m_sessionKey(), m_frameDecoder(), m_deliveredMessages(), m_clock(), m_metrics() {
+			m_clock.start();
+			OPENMITTSU_CONNECT(&m_server, newConnection(), this, serverOnNewConnection());
+		}
+
+		LoopbackServer::~LoopbackServer() {
+			if (m_socket != nullptr) {
+				m_socket->abort();
+			}
+		}
+
+		bool LoopbackServer::listen(QHostAddress const& address, quint16 port) {
+			return m_server.listen(address, port);
+		}
+
+		quint16 LoopbackServer::getPort() const {
+			return m_server.serverPort();
+		}
+
+		bool LoopbackServer::isClientReady() const {
+			return (m_socket != nullptr) && (m_state == State::READY);
+		}
+
+		int LoopbackServer::getUnacknowledgedMessageCount() const {
+			return m_deliveredMessages.size();
+		}
+
+		openmittsu::utility::MetricsRegistry const& LoopbackServer::getMetrics() const {
+			return m_metrics;
+		}
+
+		bool LoopbackServer::deliver(openmittsu::protocol::MessageId const& messageId, QByteArray const& packet) {
+			if (!isClientReady()) {
+				return false;
+			}
+
+			m_deliveredMessages.insert(messageId, m_clock.nsecsElapsed());
+			sendPacket(packet);
+			m_metrics.incrementCounter(QStringLiteral("loopback.messages.delivered"));
+			m_metrics.setGauge(QStringLiteral("loopback.messages.unacknowledged"), m_deliveredMessages.size());
+			return true;
+		}
+
+		void LoopbackServer::serverOnNewConnection() {
+			while (m_server.hasPendingConnections()) {
+				QTcpSocket* socket = m_server.nextPendingConnection();
+				if (m_socket != nullptr) {
+					LOGGER()->warn("Rejecting a second client connection, the loopback server only serves one client at a time.");
+					socket->abort();
+					socket->deleteLater();
+					continue;
+				}
+
+				LOGGER()->info("Client connected from {}:{}.", socket->peerAddress().toString().toStdString(), socket->peerPort());
+				m_socket = socket;
+				m_socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+				m_state = State::WAITING_FOR_CLIENT_HELLO;
+				m_frameDecoder.clear();
+				m_deliveredMessages.clear();
+				m_metrics.incrementCounter(QStringLiteral("loopback.connects"));
+
+				OPENMITTSU_CONNECT(m_socket, readyRead(), this, socketOnReadyRead());
+				OPENMITTSU_CONNECT(m_socket, disconnected(), this, socketOnDisconnected());
+			}
+		}
+
+		void LoopbackServer::socketOnDisconnected() {
+			if (m_socket == nullptr) {
+				return;
+			}
+
+			LOGGER()->info("Client disconnected, {} delivered messages were not acknowledged.", m_deliveredMessages.size());
+			m_metrics.incrementCounter(QStringLiteral("loopback.messages.lost"), static_cast<quint64>(m_deliveredMessages.size()));
+			m_deliveredMessages.clear();
+			m_metrics.setGauge(QStringLiteral("loopback.messages.unacknowledged"), 0);
+
+			bool const wasReady = (m_state == State::READY);
+			m_socket->deleteLater();
+			m_socket = nullptr;
+			m_state = State::WAITING_FOR_CLIENT_HELLO;
+			m_sessionKey.reset();
+
+			if (wasReady) {
+				emit clientDisconnected();
+			}
+		}
+
+		void LoopbackServer::dropClient(QString const& reason) {
+			LOGGER()->error("Dropping the client connection: {}", reason.toStdString());
+			if (m_socket != nullptr) {
+				m_socket->abort();
+			}
+		}
+
+		void LoopbackServer::socketOnReadyRead() {
+			if (m_socket == nullptr) {
+				return;
+			}
+
+			try {
+				if ((m_state == State::WAITING_FOR_CLIENT_HELLO) && !handleClientHello()) {
+					return;
+				}
+				if ((m_state == State::WAITING_FOR_AUTHENTICATION) && !handleAuthentication()) {
+					return;
+				}
+				if (m_state != State::READY) {
+					return;
+				}
+
+				m_frameDecoder.readFrom(m_socket);
+				QByteArray frame;
+				while ((m_socket != nullptr) && m_frameDecoder.nextFrame(frame)) {
+					openmittsu::crypto::Nonce const clientNonce(m_clientNonceGenerator->getNextNonce());
+					handlePacket(m_sessionKey->decrypt(frame, clientNonce));
+				}
+			} catch (openmittsu::exceptions::CryptoException& e) {
+				dropClient(QStringLiteral("Could not decrypt data from the client: %1").arg(e.what()));
+			}
+		}
+
+		bool LoopbackServer::handleClientHello() {
+			int const clientHelloSize = openmittsu::crypto::Key::getPublicKeyLength() + (PROTO_NONCE_PREFIX_LENGTH_BYTES);
+			if (m_socket->bytesAvailable() < clientHelloSize) {
+				return false;
+			}
+
+			QByteArray const clientHello = m_socket->read(clientHelloSize);
+			m_clientShortTermPublicKey = openmittsu::crypto::PublicKey::fromDecodedServerResponse(clientHello.left(openmittsu::crypto::Key::getPublicKeyLength()));
+			QByteArray const clientNoncePrefix = clientHello.mid(openmittsu::crypto::Key::getPublicKeyLength());
+			m_clientNonceGenerator = std::make_unique<openmittsu::crypto::NonceGenerator>(clientNoncePrefix);
+
+			// Server hello: our nonce prefix, then our short term public key and the client nonce prefix, boxed with our long term key.
+			m_serverShortTermKey = openmittsu::crypto::KeyPair::randomKey();
+			m_serverNonceGenerator = std::make_unique<openmittsu::crypto::NonceGenerator>();
+			openmittsu::crypto::PrecomputedSharedKey const helloKey(m_clientShortTermPublicKey, m_serverLongTermKey);
+
+			QByteArray serverHello(m_serverNonceGenerator->getNoncePrefix());
+			serverHello.append(helloKey.encrypt(m_serverShortTermKey.getPublicKey() + clientNoncePrefix, m_serverNonceGenerator->getNextNonce()));
+			if (serverHello.size() != (PROTO_SERVERHELLO_LENGTH_BYTES)) {
+				dropClient(QStringLiteral("Built a server hello of %1 instead of %2 Bytes.").arg(serverHello.size()).arg(PROTO_SERVERHELLO_LENGTH_BYTES));
+				return false;
+			}
+
+			m_sessionKey = std::make_unique<openmittsu::crypto::PrecomputedSharedKey>(m_clientShortTermPublicKey, m_serverShortTermKey);
+			m_socket->write(serverHello);
+			m_state = State::WAITING_FOR_AUTHENTICATION;
+			return true;
+		}
+
+		bool LoopbackServer::handleAuthentication() {
+			int const authenticationSize = (PROTO_AUTHENTICATION_UNENCRYPTED_LENGTH_BYTES) + static_cast<int>(crypto_box_MACBYTES);
+			if (m_socket->bytesAvailable() < authenticationSize) {
+				return false;
+			}
+
+			QByteArray const authenticationPacket = m_sessionKey->decrypt(m_socket->read(authenticationSize), m_clientNonceGenerator->getNextNonce());
+
+			// Identity, version string, random nonce, our nonce prefix and the vouch box for the client short term key.
+			int offset = 0;
+			openmittsu::protocol::ContactId const identity(authenticationPacket.mid(offset, PROTO_IDENTITY_LENGTH_BYTES));
+			offset += (PROTO_IDENTITY_LENGTH_BYTES);
+			QString const version = QString::fromUtf8(authenticationPacket.mid(offset, PROTO_AUTHENTICATION_VERSION_BYTES)).remove(QChar('\0'));
+			offset += (PROTO_AUTHENTICATION_VERSION_BYTES);
+			openmittsu::crypto::Nonce const vouchNonce(authenticationPacket.mid(offset, PROTO_AUTHENTICATION_RANDOMNONCE_BYTES));
+			offset += (PROTO_AUTHENTICATION_RANDOMNONCE_BYTES);
+			QByteArray const serverNoncePrefix = authenticationPacket.mid(offset, PROTO_NONCE_PREFIX_LENGTH_BYTES);
+			offset += (PROTO_NONCE_PREFIX_LENGTH_BYTES);
+			QByteArray const vouchBox = authenticationPacket.mid(offset);
+
+			if (identity != m_clientContactId) {
+				dropClient(QStringLiteral("Client authenticated as %1, but the loopback server was set up for %2.").arg(identity.toQString()).arg(m_clientContactId.toQString()));
+				return false;
+			} else if (serverNoncePrefix != m_serverNonceGenerator->getNoncePrefix()) {
+				dropClient(QStringLiteral("Client echoed a wrong server nonce prefix."));
+				return false;
+			}
+
+			openmittsu::crypto::PrecomputedSharedKey const vouchKey(m_clientLongTermPublicKey, m_serverLongTermKey);
+			if (vouchKey.decrypt(vouchBox, vouchNonce) != m_clientShortTermPublicKey.getPublicKey()) {
+				dropClient(QStringLiteral("The vouch box of the client does not match its short term key."));
+				return false;
+			}
+
+			m_socket->write(m_sessionKey->encrypt(QByteArray(PROTO_NONCE_LENGTH_BYTES, 0x00), m_serverNonceGenerator->getNextNonce()));
+			m_state = State::READY;
+			LOGGER()->info("Client {} ({}) authenticated.", identity.toString(), version.toStdString());
+
+			QByteArray connectionEstablished(PROTO_DATA_HEADER_TYPE_LENGTH_BYTES, 0x00);
+			connectionEstablished[0] = (PROTO_PACKET_SIGNATURE_CONNECTION_ESTABLISHED);
+			sendPacket(connectionEstablished);
+
+			emit clientReady();
+			return true;
+		}
+
+		void LoopbackServer::handlePacket(QByteArray const& packet) {
+			if (packet.size() < (PROTO_DATA_HEADER_TYPE_LENGTH_BYTES)) {
+				dropClient(QStringLiteral("Received a packet of only %1 Bytes.").arg(packet.size()));
+				return;
+			}
+
+			char const packetTypeByte = packet.at(0);
+			QByteArray const packetContents = packet.mid(PROTO_DATA_HEADER_TYPE_LENGTH_BYTES);
+			m_metrics.incrementCounter(QStringLiteral("loopback.packets.received{type=0x%1}").arg(static_cast<quint8>(packetTypeByte), 2, 16, QChar('0')));
+
+			if (packetTypeByte == (PROTO_PACKET_SIGNATURE_CLIENT_ACK)) {
+				openmittsu::protocol::MessageId const messageId(packetContents.mid(PROTO_IDENTITY_LENGTH_BYTES, PROTO_MESSAGE_MESSAGEID_LENGTH_BYTES));
+				auto const it = m_deliveredMessages.find(messageId);
+				if (it == m_deliveredMessages.end()) {
+					m_metrics.incrementCounter(QStringLiteral("loopback.acks.unexpected"));
+					return;
+				}
+
+				m_metrics.recordValue(QStringLiteral("loopback.ack.latency_us"), (m_clock.nsecsElapsed() - it.value()) / 1000);
+				m_metrics.incrementCounter(QStringLiteral("loopback.messages.acknowledged"));
+				m_deliveredMessages.erase(it);
+				m_metrics.setGauge(QStringLiteral("loopback.messages.unacknowledged"), m_deliveredMessages.size());
+			} else if (packetTypeByte == (PROTO_PACKET_SIGNATURE_KEEPALIVE_REQUEST)) {
+				QByteArray answer(PROTO_DATA_HEADER_TYPE_LENGTH_BYTES, 0x00);
+				answer[0] = (PROTO_PACKET_SIGNATURE_KEEPALIVE_ANSWER);
+				answer.append(packetContents);
+				sendPacket(answer);
+			} else if (packetTypeByte == (PROTO_PACKET_SIGNATURE_SENDING_MSG)) {
+				// Acknowledge with the receiver and message id, nothing is forwarded.
+				QByteArray acknowledgment(PROTO_DATA_HEADER_TYPE_LENGTH_BYTES, 0x00);
+				acknowledgment[0] = (PROTO_PACKET_SIGNATURE_SERVER_ACK);
+				acknowledgment.append(packetContents.mid(PROTO_IDENTITY_LENGTH_BYTES, PROTO_IDENTITY_LENGTH_BYTES));
+				acknowledgment.append(packetContents.mid(2 * (PROTO_IDENTITY_LENGTH_BYTES), PROTO_MESSAGE_MESSAGEID_LENGTH_BYTES));
+				sendPacket(acknowledgment);
+			}
+		}
+
+		void LoopbackServer::sendPacket(QByteArray const& packet) {
+			QByteArray const encryptedPacket = m_sessionKey->encrypt(packet, m_serverNonceGenerator->getNextNonce());
+			int const size = encryptedPacket.size();
+
+			QByteArray frame;
+			frame.reserve((PROTO_DATA_HEADER_SIZE_LENGTH_BYTES) + size);
+			frame.append(static_cast<char>(size & 0xFF));
+			frame.append(static_cast<char>((size >> 8) & 0xFF));
+			frame.append(encryptedPacket);
+
+			m_socket->write(frame);
+			m_metrics.incrementCounter(QStringLiteral("loopback.bytes.sent"), static_cast<quint64>(frame.size()));
+		}
+
+	}
+}
@@ -0,0 +1,94 @@
+#ifndef OPENMITTSU_BENCHMARK_LOOPBACKSERVER_H_
+#define OPENMITTSU_BENCHMARK_LOOPBACKSERVER_H_
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+#include <memory>
+
+#include "src/crypto/KeyPair.h"
+#include "src/crypto/NonceGenerator.h"
+#include "src/crypto/PrecomputedSharedKey.h"
+#include "src/crypto/PublicKey.h"
+#include "src/network/FrameDecoder.h"
+#include "src/protocol/ContactId.h"
+#include "src/protocol/MessageId.h"
+#include "src/utility/MetricsRegistry.h"
+
+namespace openmittsu {
+	namespace benchmark {
+
+		/**
+		 * A local stand-in for the chat server that speaks the handshake and transport framing expected by the ProtocolClient.
+		 * It serves one client at a time, answers keep-alives, acknowledges SENDING packets and measures the time from handing
+		 * a DELIVERING packet to the socket until the client acknowledges it.
+		 */
+		class LoopbackServer : public QObject {
+			Q_OBJECT
+		public:
+			LoopbackServer(openmittsu::crypto::KeyPair const& serverLongTermKey, openmittsu::protocol::ContactId const& clientContactId, openmittsu::crypto::PublicKey const& clientLongTermPublicKey);
+			virtual ~LoopbackServer();
+
+			bool listen(QHostAddress const& address, quint16 port);
+			quint16 getPort() const;
+
+			bool isClientReady() const;
+
+			/**
+			 * Sends a DELIVERING packet (including its type header) to the authenticated client.
+			 * @return False if no client is ready to receive messages.
+			 */
+			bool deliver(openmittsu::protocol::MessageId const& messageId, QByteArray const& packet);
+
+			int getUnacknowledgedMessageCount() const;
+			openmittsu::utility::MetricsRegistry const& getMetrics() const;
+		signals:
+			void clientReady();
+			void clientDisconnected();
+		private slots:
+			void serverOnNewConnection();
+			void socketOnReadyRead();
+			void socketOnDisconnected();
+		private:
+			enum class State {
+				WAITING_FOR_CLIENT_HELLO,
+				WAITING_FOR_AUTHENTICATION,
+				READY
+			};
+
+			openmittsu::crypto::KeyPair const m_serverLongTermKey;
+			openmittsu::protocol::ContactId const m_clientContactId;
+			openmittsu::crypto::PublicKey const m_clientLongTermPublicKey;
+
+			QTcpServer m_server;
+			QTcpSocket* m_socket;
+			State m_state;
+
+			openmittsu::crypto::KeyPair m_serverShortTermKey;
+			openmittsu::crypto::PublicKey m_clientShortTermPublicKey;
+			std::unique_ptr<openmittsu::crypto::NonceGenerator> m_serverNonceGenerator;
+			std::unique_ptr<openmittsu::crypto::NonceGenerator> m_clientNonceGenerator;
+			std::unique_ptr<openmittsu::crypto::PrecomputedSharedKey> m_sessionKey;
+			openmittsu::network::FrameDecoder m_frameDecoder;
+
+			// Delivery timestamps in nanoseconds on m_clock, keyed by message id.
+			QHash<openmittsu::protocol::MessageId, qint64> m_deliveredMessages;
+			QElapsedTimer m_clock;
+			openmittsu::utility::MetricsRegistry m_metrics;
+
+			bool handleClientHello();
+			bool handleAuthentication();
+			void handlePacket(QByteArray const& packet);
+			void sendPacket(QByteArray const& packet);
+			void dropClient(QString const& reason);
+		};
+
+	}
+}
+
+#endif // OPENMITTSU_BENCHMARK_LOOPBACKSERVER_H_
@@ -0,0 +1,127 @@
+#include <iostream>
+#include <string>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QSettings>
+#include <QTimer>
+
+#define OPENMITTSU_TESTS
+#include "Init.h"
+
+#include "benchmark/loopback/LoadGenerator.h"
+#include "benchmark/loopback/LoopbackServer.h"
+#include "src/utility/QObjectConnectionMacro.h"
+
+#define OPENMITTSU_LOOPBACK_DEFAULT_PORT (15222)
+#define OPENMITTSU_LOOPBACK_DRAIN_TIMEOUT_MS (30000)
+
+namespace {
+	int parseArgument(int argc, char* argv[], int index, int defaultValue) {
+		if (argc <= index) {
+			return defaultValue;
+		}
+
+		bool isValid = false;
+		int const result = QString::fromLocal8Bit(argv[index]).toInt(&isValid);
+		return isValid ? result : defaultValue;
+	}
+
+	void printReport(openmittsu::benchmark::LoopbackServer const& server, openmittsu::benchmark::LoadGenerator const& generator, double seconds) {
+		openmittsu::utility::MetricsRegistry const& metrics = server.getMetrics();
+		quint64 const acknowledged = metrics.getCounter(QStringLiteral("loopback.messages.acknowledged"));
+		openmittsu::utility::MetricsRegistry::Histogram const latency = metrics.getHistogram(QStringLiteral("loopback.ack.latency_us"));
+
+		std::cout << "Delivered " << metrics.getCounter(QStringLiteral("loopback.messages.delivered")) << " messages, " << acknowledged << " acknowledged, " << server.getUnacknowledgedMessageCount() << " still pending, " << generator.getMessagesBehindSchedule() << " behind schedule." << std::endl;
+		std::cout << "Throughput: " << ((seconds > 0.0) ? (static_cast<double>(acknowledged) / seconds) : 0.0) << " messages/s over " << seconds << " s." << std::endl;
+		std::cout << "Ack latency (us): p50 <= " << latency.getPercentileUpperBound(50.0) << ", p90 <= " << latency.getPercentileUpperBound(90.0) << ", p99 <= " << latency.getPercentileUpperBound(99.0) << ", max " << latency.getMax() << std::endl;
+		std::cout << std::endl << metrics.toText().toStdString();
+	}
+}
+
+int main(int argc, char* argv[]) {
+	std::cout << "OpenMittsu Loopback Server" << std::endl;
+	if (argc < 3) {
+		std::cout << "Usage: " << argv[0] << " <client identity> <client public key (hex)> [senders = 10] [messages per second and sender = 10] [duration in seconds = 30] [port = " << OPENMITTSU_LOOPBACK_DEFAULT_PORT << "]" << std::endl;
+		return -1;
+	}
+
+	if (!initializeLogging(OPENMITTSU_LOGGING_MAX_FILESIZE, OPENMITTSU_LOGGING_MAX_FILECOUNT)) {
+		return -2;
+	}
+
+	OPENMITTSU_REGISTER_TYPES();
+	QCoreApplication application(argc, argv);
+
+	if (!initializeLibSodium()) {
+		return -3;
+	}
+
+	int result = 0;
+	try {
+		openmittsu::protocol::ContactId const clientIdentity(QString::fromLocal8Bit(argv[1]));
+		openmittsu::crypto::PublicKey const clientPublicKey(openmittsu::crypto::PublicKey::fromHexString(QString::fromLocal8Bit(argv[2])));
+		int const senderCount = parseArgument(argc, argv, 3, 10);
+		int const messagesPerSecond = parseArgument(argc, argv, 4, 10);
+		int const durationSeconds = parseArgument(argc, argv, 5, 30);
+		int const port = parseArgument(argc, argv, 6, OPENMITTSU_LOOPBACK_DEFAULT_PORT);
+
+		openmittsu::crypto::KeyPair const serverKey = openmittsu::benchmark::LoadGenerator::deriveKeyPair(QStringLiteral("openMittsu loopback server"));
+		openmittsu::benchmark::LoopbackServer server(serverKey, clientIdentity, clientPublicKey);
+		if (!server.listen(QHostAddress::LocalHost, static_cast<quint16>(port))) {
+			std::cerr << "Could not listen on port " << port << "." << std::endl;
+			return -4;
+		}
+
+		openmittsu::benchmark::LoadGenerator generator(&server, clientIdentity, clientPublicKey, senderCount, messagesPerSecond);
+
+		QString const serverConfigurationFile = QDir::current().absoluteFilePath(QStringLiteral("loopback-server.ini"));
+		{
+			QSettings settings(serverConfigurationFile, QSettings::IniFormat);
+			settings.setValue(QStringLiteral("server/host"), QStringLiteral("127.0.0.1"));
+			settings.setValue(QStringLiteral("server/port"), server.getPort());
+			settings.setValue(QStringLiteral("server/longTermPublicKey"), QString(serverKey.getPublicKey().toHex()));
+		}
+		QString const contactsFile = QDir::current().absoluteFilePath(QStringLiteral("loopback-contacts.txt"));
+		generator.writeContactsFile(contactsFile);
+
+		std::cout << "Listening on port " << server.getPort() << " for " << clientIdentity.toString() << ", " << senderCount << " senders with " << messagesPerSecond << " messages per second each for " << durationSeconds << " s." << std::endl;
+		std::cout << "Import " << contactsFile.toStdString() << " into the client once, then start it with OPENMITTSU_SERVER_CONFIGURATION=" << serverConfigurationFile.toStdString() << std::endl;
+
+		// Start pushing once the client is authenticated, then wait for the outstanding acknowledgments before reporting.
+		QTimer drainTimer;
+		drainTimer.setSingleShot(true);
+		drainTimer.setInterval(OPENMITTSU_LOOPBACK_DRAIN_TIMEOUT_MS);
+		QTimer pollTimer;
+		pollTimer.setInterval(50);
+		bool isStarted = false;
+
+		QObject::connect(&server, &openmittsu::benchmark::LoopbackServer::clientReady, [&]() {
+			if (!isStarted) {
+				isStarted = true;
+				generator.start(durationSeconds);
+			}
+		});
+		QObject::connect(&generator, &openmittsu::benchmark::LoadGenerator::finished, [&]() {
+			drainTimer.start();
+			pollTimer.start();
+		});
+		QObject::connect(&pollTimer, &QTimer::timeout, [&]() {
+			if (server.getUnacknowledgedMessageCount() == 0) {
+				application.quit();
+			}
+		});
+		QObject::connect(&drainTimer, &QTimer::timeout, [&]() {
+			std::cerr << "Timed out waiting for " << server.getUnacknowledgedMessageCount() << " acknowledgments." << std::endl;
+			application.quit();
+		});
+
+		application.exec();
+		printReport(server, generator, generator.getElapsedSeconds());
+	} catch (std::exception& e) {
+		std::cerr << "Loopback server failed: " << e.what() << std::endl;
+		result = -1;
+	}
+
+	return result;
+}
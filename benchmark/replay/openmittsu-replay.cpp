@@ -0,0 +1,197 @@
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QTemporaryDir>
+#include <QTimer>
+
+#define OPENMITTSU_TESTS
+#include "Init.h"
+
+#include "src/crypto/FullCryptoBox.h"
+#include "src/database/Database.h"
+#include "src/dataproviders/KeyRegistry.h"
+#include "src/dataproviders/MessageCenter.h"
+#include "src/dataproviders/NetworkSentMessageAcceptor.h"
+#include "src/network/MessageCenterWrapper.h"
+#include "src/network/PacketCaptureReader.h"
+#include "src/network/ProtocolClient.h"
+#include "src/network/ServerConfiguration.h"
+#include "src/protocol/ProtocolSpecs.h"
+#include "src/protocol/PushFromId.h"
+#include "src/utility/OptionMaster.h"
+#include "src/widgets/TabController.h"
+
+#define OPENMITTSU_REPLAY_PACKETS_PER_TICK (256)
+#define OPENMITTSU_REPLAY_IDLE_TIMEOUT_MS (5000)
+
+namespace {
+	// There is no GUI here. Every tab counts as open, so incoming messages neither open tabs nor load their contacts and groups for them.
+	class HeadlessTabController : public openmittsu::widgets::TabController {
+	public:
+		virtual ~HeadlessTabController() {}
+
+		virtual bool hasTab(openmittsu::protocol::ContactId const&) const override { return true; }
+		virtual bool hasTab(openmittsu::protocol::GroupId const&) const override { return true; }
+
+		virtual openmittsu::widgets::ChatTab* getTab(openmittsu::protocol::ContactId const&) const override { return nullptr; }
+		virtual openmittsu::widgets::ChatTab* getTab(openmittsu::protocol::GroupId const&) const override { return nullptr; }
+
+		virtual void openTab(openmittsu::protocol::ContactId const&, openmittsu::dataproviders::BackedContact const&) override {}
+		virtual void openTab(openmittsu::protocol::GroupId const&, openmittsu::dataproviders::BackedGroup const&) override {}
+
+		virtual void closeTab(openmittsu::protocol::ContactId const&) override {}
+		virtual void closeTab(openmittsu::protocol::GroupId const&) override {}
+
+		virtual void focusTab(openmittsu::protocol::ContactId const&) override {}
+		virtual void focusTab(openmittsu::protocol::GroupId const&) override {}
+	};
+
+	typedef std::vector<std::pair<qint64, QByteArray>> Packets;
+
+	// Only DELIVERING packets are replayed, everything else refers to a connection that does not exist here.
+	Packets readDeliveringPackets(QString const& filename, QMap<int, quint64>& skippedPacketTypes) {
+		Packets result;
+		openmittsu::network::PacketCaptureReader reader(filename);
+		qint64 timestamp = 0;
+		QByteArray packet;
+		while (reader.readNext(timestamp, packet)) {
+			if (packet.isEmpty()) {
+				continue;
+			} else if (packet.at(0) != (PROTO_PACKET_SIGNATURE_DELIVERING_MSG)) {
+				skippedPacketTypes[static_cast<quint8>(packet.at(0))] += 1;
+				continue;
+			}
+			result.push_back(std::make_pair(timestamp, packet));
+		}
+		return result;
+	}
+
+	quint64 getAcknowledgedCount(openmittsu::network::ProtocolClient const& protocolClient) {
+		return static_cast<quint64>(protocolClient.getMetrics().getHistogram(QStringLiteral("protocol.acks.client.batchSize")).getSum());
+	}
+}
+
+int main(int argc, char* argv[]) {
+	std::cout << "OpenMittsu Capture Replay" << std::endl;
+	if (argc < 4) {
+		std::cout << "Usage: " << argv[0] << " <capture file> <database file> <database password> [speed = 0]" << std::endl;
+		std::cout << "Replays the DELIVERING packets of a capture recorded with OPENMITTSU_PACKET_CAPTURE against a scratch copy of the database." << std::endl;
+		std::cout << "A speed of 0 replays as fast as possible, 1 keeps the original timing, 2 replays twice as fast and so on." << std::endl;
+		return -1;
+	}
+
+	if (!initializeLogging(OPENMITTSU_LOGGING_MAX_FILESIZE, OPENMITTSU_LOGGING_MAX_FILECOUNT)) {
+		return -2;
+	}
+
+	OPENMITTSU_REGISTER_TYPES();
+	QCoreApplication application(argc, argv);
+
+	if (!initializeLibSodium()) {
+		return -3;
+	}
+
+	int result = 0;
+	try {
+		QString const captureFile = QString::fromLocal8Bit(argv[1]);
+		QString const databaseFile = QString::fromLocal8Bit(argv[2]);
+		QString const databasePassword = QString::fromLocal8Bit(argv[3]);
+		double const speed = (argc > 4) ? QString::fromLocal8Bit(argv[4]).toDouble() : 0.0;
+
+		QMap<int, quint64> skippedPacketTypes;
+		Packets const packets = readDeliveringPackets(captureFile, skippedPacketTypes);
+		std::cout << "Read " << packets.size() << " DELIVERING packets from " << captureFile.toStdString() << "." << std::endl;
+		for (auto it = skippedPacketTypes.constBegin(), end = skippedPacketTypes.constEnd(); it != end; ++it) {
+			std::cout << "Skipping " << it.value() << " packets of type 0x" << QString::number(it.key(), 16).toStdString() << "." << std::endl;
+		}
+
+		// Work on a copy, so the capture can be replayed any number of times.
+		QTemporaryDir scratchDirectory;
+		if (!scratchDirectory.isValid()) {
+			std::cerr << "Could not create a scratch directory." << std::endl;
+			return -4;
+		}
+		QString const scratchDatabaseFile = QDir(scratchDirectory.path()).absoluteFilePath(QFileInfo(databaseFile).fileName());
+		if (!QFile::copy(databaseFile, scratchDatabaseFile)) {
+			std::cerr << "Could not copy the database to " << scratchDatabaseFile.toStdString() << "." << std::endl;
+			return -4;
+		}
+
+		std::shared_ptr<openmittsu::database::Database> database = std::make_shared<openmittsu::database::Database>(scratchDatabaseFile, databasePassword, QDir(scratchDirectory.path()));
+		std::shared_ptr<openmittsu::utility::OptionMaster> optionMaster = std::make_shared<openmittsu::utility::OptionMaster>();
+		optionMaster->setDatabase(database);
+
+		std::shared_ptr<openmittsu::dataproviders::MessageCenter> messageCenter = std::make_shared<openmittsu::dataproviders::MessageCenter>(std::make_shared<HeadlessTabController>(), optionMaster);
+		messageCenter->setStorage(database);
+
+		std::shared_ptr<openmittsu::network::ServerConfiguration> serverConfiguration = std::make_shared<openmittsu::network::ServerConfiguration>();
+		std::shared_ptr<openmittsu::crypto::FullCryptoBox> cryptoBox = std::make_shared<openmittsu::crypto::FullCryptoBox>(openmittsu::dataproviders::KeyRegistry(serverConfiguration->getServerLongTermPublicKey(), database));
+		std::shared_ptr<openmittsu::network::ProtocolClient> protocolClient = std::make_shared<openmittsu::network::ProtocolClient>(cryptoBox, database->getSelfContact(), serverConfiguration, optionMaster, std::make_shared<openmittsu::network::MessageCenterWrapper>(messageCenter), openmittsu::protocol::PushFromId(database->getSelfContact()));
+		protocolClient->setup();
+		messageCenter->setNetworkSentMessageAcceptor(std::make_shared<openmittsu::dataproviders::NetworkSentMessageAcceptor>(protocolClient));
+
+		// Feed the packets from the event loop, so decryption results and storage calls interleave as they do with a live connection.
+		std::size_t nextPacket = 0;
+		quint64 lastAcknowledgedCount = 0;
+		QElapsedTimer replayClock;
+		QElapsedTimer idleClock;
+		QTimer feedTimer;
+		feedTimer.setInterval(0);
+		QObject::connect(&feedTimer, &QTimer::timeout, [&]() {
+			if (nextPacket < packets.size()) {
+				qint64 const captureStart = packets.front().first;
+				int fed = 0;
+				while ((nextPacket < packets.size()) && (fed < OPENMITTSU_REPLAY_PACKETS_PER_TICK)) {
+					if ((speed > 0.0) && (static_cast<double>(packets.at(nextPacket).first - captureStart) / speed > static_cast<double>(replayClock.elapsed()))) {
+						break;
+					}
+					protocolClient->replayPacket(packets.at(nextPacket).second);
+					++nextPacket;
+					++fed;
+				}
+				idleClock.restart();
+				return;
+			}
+
+			quint64 const acknowledgedCount = getAcknowledgedCount(*protocolClient);
+			if (acknowledgedCount != lastAcknowledgedCount) {
+				lastAcknowledgedCount = acknowledgedCount;
+				idleClock.restart();
+			}
+
+			if (acknowledgedCount >= packets.size()) {
+				application.quit();
+			} else if (idleClock.elapsed() > OPENMITTSU_REPLAY_IDLE_TIMEOUT_MS) {
+				std::cerr << "No progress for " << OPENMITTSU_REPLAY_IDLE_TIMEOUT_MS << " ms, " << (packets.size() - acknowledgedCount) << " messages were not stored (unknown senders or groups?)." << std::endl;
+				application.quit();
+			}
+		});
+
+		replayClock.start();
+		idleClock.start();
+		feedTimer.start();
+		application.exec();
+
+		double const seconds = static_cast<double>(replayClock.nsecsElapsed()) / 1e9;
+		quint64 const acknowledgedCount = getAcknowledgedCount(*protocolClient);
+		std::cout << "Stored " << acknowledgedCount << " of " << packets.size() << " messages in " << seconds << " s (" << ((seconds > 0.0) ? (static_cast<double>(acknowledgedCount) / seconds) : 0.0) << " messages/s)." << std::endl;
+		std::cout << std::endl << protocolClient->getMetrics().toText().toStdString();
+
+		messageCenter->setNetworkSentMessageAcceptor(nullptr);
+		protocolClient->teardown();
+	} catch (std::exception& e) {
+		std::cerr << "Replay failed: " << e.what() << std::endl;
+		result = -1;
+	}
+
+	return result;
+}
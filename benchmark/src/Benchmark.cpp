@@ -0,0 +1,25 @@
+#include "benchmark/src/Benchmark.h"
+
+#include <iomanip>
+#include <iostream>
+
+namespace openmittsu {
+	namespace benchmark {
+
+		bool Benchmark::add(std::string const& name, BenchmarkFunction const& function) {
+			getBenchmarks().push_back({ name, function });
+			return true;
+		}
+
+		std::vector<Benchmark::Entry>& Benchmark::getBenchmarks() {
+			static std::vector<Entry> benchmarks;
+			return benchmarks;
+		}
+
+		void Benchmark::report(std::string const& benchmarkName, std::string const& caseName, std::uint64_t operations, double seconds, std::string const& unit) {
+			double const rate = (seconds > 0.0) ? (static_cast<double>(operations) / seconds) : 0.0;
+			std::cout << std::left << std::setw(32) << benchmarkName << std::setw(40) << caseName << std::right << std::setw(16) << std::fixed << std::setprecision(1) << rate << " " << unit << "/s" << std::endl;
+		}
+
+	}
+}
@@ -0,0 +1,64 @@
+#ifndef OPENMITTSU_BENCHMARK_BENCHMARK_H_
+#define OPENMITTSU_BENCHMARK_BENCHMARK_H_
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace openmittsu {
+	namespace benchmark {
+
+		/**
+		 * A minimal registry for micro benchmarks.
+		 * Each benchmark is a plain function registered with OPENMITTSU_BENCHMARK and reports its own results via report().
+		 */
+		class Benchmark {
+		public:
+			typedef std::function<void()> BenchmarkFunction;
+
+			struct Entry {
+				std::string name;
+				BenchmarkFunction function;
+			};
+
+			static bool add(std::string const& name, BenchmarkFunction const& function);
+			static std::vector<Entry>& getBenchmarks();
+
+			static void report(std::string const& benchmarkName, std::string const& caseName, std::uint64_t operations, double seconds, std::string const& unit);
+
+			/**
+			 * Runs the operation repeatedly for at least minimumDuration and reports the achieved rate.
+			 */
+			template<typename Operation>
+			static void measure(std::string const& benchmarkName, std::string const& caseName, std::string const& unit, Operation&& operation, std::chrono::milliseconds minimumDuration = std::chrono::milliseconds(1000)) {
+				// Warm-up
+				for (int i = 0; i < 16; ++i) {
+					operation();
+				}
+
+				std::uint64_t operations = 0;
+				auto const start = std::chrono::steady_clock::now();
+				auto now = start;
+				do {
+					for (int i = 0; i < 64; ++i) {
+						operation();
+					}
+					operations += 64;
+					now = std::chrono::steady_clock::now();
+				} while ((now - start) < minimumDuration);
+
+				report(benchmarkName, caseName, operations, std::chrono::duration<double>(now - start).count(), unit);
+			}
+		};
+
+	}
+}
+
+#define OPENMITTSU_BENCHMARK(name) \
+	static void openmittsuBenchmark_##name(); \
+	static bool const openmittsuBenchmarkRegistered_##name = openmittsu::benchmark::Benchmark::add(#name, &openmittsuBenchmark_##name); \
+	static void openmittsuBenchmark_##name()
+
+#endif // OPENMITTSU_BENCHMARK_BENCHMARK_H_
@@ -0,0 +1,30 @@
+#include "benchmark/src/Benchmark.h"
+
+#include <QByteArray>
+
+#include "src/crypto/Crc32.h"
+
+// Media items are checksummed on every insert and every read, e.g. for each image shown in a chat.
+OPENMITTSU_BENCHMARK(Crc32) {
+	// A thumbnail, a typical photo and a large image.
+	int const dataSizes[] = { 16 * 1024, 256 * 1024, 4 * 1024 * 1024 };
+	for (int const dataSize : dataSizes) {
+		QByteArray data(dataSize, 0x00);
+		for (int i = 0; i < data.size(); ++i) {
+			data[i] = static_cast<char>(i * 131);
+		}
+		std::string const suffix = " (" + std::to_string(dataSize / 1024) + " KiB)";
+
+		openmittsu::benchmark::Benchmark::measure("Crc32", "bytewise" + suffix, "checksums", [&]() {
+			openmittsu::crypto::Crc32::checksum(data, openmittsu::crypto::Crc32::Implementation::BYTEWISE);
+		});
+		openmittsu::benchmark::Benchmark::measure("Crc32", "slicing-by-8" + suffix, "checksums", [&]() {
+			openmittsu::crypto::Crc32::checksum(data, openmittsu::crypto::Crc32::Implementation::SLICING_BY_8);
+		});
+		if (openmittsu::crypto::Crc32::isHardwareAccelerationAvailable()) {
+			openmittsu::benchmark::Benchmark::measure("Crc32", "hardware" + suffix, "checksums", [&]() {
+				openmittsu::crypto::Crc32::checksum(data, openmittsu::crypto::Crc32::Implementation::HARDWARE);
+			});
+		}
+	}
+}
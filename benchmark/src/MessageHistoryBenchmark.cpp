@@ -0,0 +1,109 @@
+#include "benchmark/src/Benchmark.h"
+
+#include <QDir>
+#include <QList>
+#include <QString>
+#include <QTemporaryDir>
+#include <QVector>
+
+#include <iostream>
+#include <stdexcept>
+
+#include "src/backup/ContactMessageBackupObject.h"
+#include "src/crypto/KeyPair.h"
+#include "src/database/Database.h"
+#include "src/protocol/ContactId.h"
+#include "src/protocol/MessageId.h"
+#include "src/protocol/MessageTime.h"
+
+#define OPENMITTSU_BENCHMARK_MESSAGEHISTORY_CONTACT_COUNT (1000)
+#define OPENMITTSU_BENCHMARK_MESSAGEHISTORY_MESSAGES_PER_CONTACT (1000)
+#define OPENMITTSU_BENCHMARK_MESSAGEHISTORY_INSERT_BATCH_SIZE (10000)
+
+namespace {
+	openmittsu::protocol::ContactId getContactId(int index) {
+		return openmittsu::protocol::ContactId(QStringLiteral("B%1").arg(index, 7, 10, QChar('0')));
+	}
+}
+
+// Opening and scrolling a chat in a database with one million messages spread over many contacts.
+OPENMITTSU_BENCHMARK(MessageHistory) {
+	QTemporaryDir temporaryDirectory;
+	if (!temporaryDirectory.isValid()) {
+		throw std::runtime_error("Could not create a temporary directory for the database.");
+	}
+	QDir const mediaStorageLocation(temporaryDirectory.path());
+
+	openmittsu::protocol::ContactId const selfContactId(QStringLiteral("AAAAAAAA"));
+	openmittsu::database::Database database(temporaryDirectory.filePath(QStringLiteral("benchmark.sqlite")), selfContactId, openmittsu::crypto::KeyPair::randomKey(), QStringLiteral("benchmark"), mediaStorageLocation);
+
+	std::cout << "Filling database with " << (OPENMITTSU_BENCHMARK_MESSAGEHISTORY_CONTACT_COUNT * OPENMITTSU_BENCHMARK_MESSAGEHISTORY_MESSAGES_PER_CONTACT) << " messages..." << std::endl;
+	for (int contactIndex = 0; contactIndex < OPENMITTSU_BENCHMARK_MESSAGEHISTORY_CONTACT_COUNT; ++contactIndex) {
+		database.storeNewContact(getContactId(contactIndex), openmittsu::crypto::KeyPair::randomKey());
+	}
+
+	// Interleaved like a real history, so the messages of one chat are spread over the whole table.
+	QList<openmittsu::backup::ContactMessageBackupObject> messages;
+	quint64 apiId = 1;
+	for (int messageIndex = 0; messageIndex < OPENMITTSU_BENCHMARK_MESSAGEHISTORY_MESSAGES_PER_CONTACT; ++messageIndex) {
+		for (int contactIndex = 0; contactIndex < OPENMITTSU_BENCHMARK_MESSAGEHISTORY_CONTACT_COUNT; ++contactIndex) {
+			openmittsu::protocol::MessageTime const time(openmittsu::protocol::MessageTime::fromDatabase(1500000000000LL + static_cast<qint64>(apiId) * 1000));
+			bool const isOutbox = (messageIndex % 2) == 0;
+			messages.append(openmittsu::backup::ContactMessageBackupObject(getContactId(contactIndex), openmittsu::protocol::MessageId(apiId), QStringLiteral("uid-%1").arg(apiId), isOutbox, true, false, openmittsu::dataproviders::messages::UserMessageState::READ,
+				time, time, time, time, openmittsu::dataproviders::messages::ContactMessageType::TEXT, QStringLiteral("Message number %1 in this chat.").arg(messageIndex), false, false, QString()));
+			++apiId;
+
+			if (messages.size() >= OPENMITTSU_BENCHMARK_MESSAGEHISTORY_INSERT_BATCH_SIZE) {
+				database.storeContactMessagesFromBackup(messages);
+				messages.clear();
+			}
+		}
+	}
+	if (!messages.isEmpty()) {
+		database.storeContactMessagesFromBackup(messages);
+	}
+
+	openmittsu::protocol::ContactId const contact(getContactId(OPENMITTSU_BENCHMARK_MESSAGEHISTORY_CONTACT_COUNT / 2));
+	openmittsu::benchmark::Benchmark::measure("MessageHistory", "open chat (last 50 messages)", "chats", [&]() {
+		database.getMessageCursor(contact).getLastMessages(50);
+	});
+	openmittsu::benchmark::Benchmark::measure("MessageHistory", "scroll back 50 messages", "scrolls", [&]() {
+		openmittsu::database::DatabaseContactMessageCursor cursor(database.getMessageCursor(contact));
+		cursor.seekToLast();
+		for (int i = 0; i < 50; ++i) {
+			cursor.previous();
+		}
+	});
+
+	openmittsu::benchmark::Benchmark::measure("MessageHistory", "scroll back 50 messages as one page", "scrolls", [&]() {
+		openmittsu::database::DatabaseContactMessageCursor cursor(database.getMessageCursor(contact));
+		cursor.previousRows(1);
+		cursor.previousRows(50);
+	});
+	openmittsu::benchmark::Benchmark::measure("MessageHistory", "page through the whole chat", "chats", [&]() {
+		openmittsu::database::DatabaseContactMessageCursor cursor(database.getMessageCursor(contact));
+		while (!cursor.previousRows(100).isEmpty()) {
+			// Intentionally left empty.
+		}
+	});
+
+	// What the chat view reads per bubble, once message by message and once with a single batched query.
+	QVector<QString> const lastUuids = database.getMessageCursor(contact).getLastMessages(50);
+	auto const readBubble = [](openmittsu::dataproviders::messages::ContactMessage const& message) {
+		return message.isRead() && message.isSent() && message.isStatusMessage() && !message.getContentAsText().isEmpty() && (message.getCreatedAt().getMessageTime() > 0) && (message.getSentAt().getMessageTime() > 0)
+			&& (message.getReceivedAt().getMessageTime() > 0) && (message.getSeenAt().getMessageTime() > 0) && (message.getModifiedAt().getMessageTime() > 0);
+	};
+	openmittsu::benchmark::Benchmark::measure("MessageHistory", "load 50 messages one by one", "chats", [&]() {
+		openmittsu::database::DatabaseContactMessageCursor cursor(database.getMessageCursor(contact));
+		for (QString const& uuid : lastUuids) {
+			cursor.seekByUuid(uuid);
+			readBubble(*cursor.getMessage());
+		}
+	});
+	openmittsu::benchmark::Benchmark::measure("MessageHistory", "load 50 messages batched", "chats", [&]() {
+		auto const loadedMessages = database.getMessageCursor(contact).getMessagesByUuid(lastUuids);
+		for (auto const& message : loadedMessages) {
+			readBubble(*message);
+		}
+	});
+}
@@ -0,0 +1,53 @@
+#include "benchmark/src/Benchmark.h"
+
+#include <QByteArray>
+#include <sodium.h>
+
+#include "src/crypto/KeyPair.h"
+#include "src/crypto/Nonce.h"
+#include "src/crypto/PrecomputedSharedKey.h"
+
+namespace {
+	QByteArray encryptPerFrame(QByteArray const& data, openmittsu::crypto::Nonce const& nonce, openmittsu::crypto::PublicKey const& publicKey, openmittsu::crypto::KeyPair const& privateKey) {
+		QByteArray encryptedData(data.size() + crypto_box_MACBYTES, 0x00);
+		crypto_box_easy(reinterpret_cast<unsigned char*>(encryptedData.data()), reinterpret_cast<unsigned char const*>(data.data()), data.size(), nonce.getNonceAsCharPtr(), reinterpret_cast<unsigned char const*>(publicKey.getPublicKey().data()), reinterpret_cast<unsigned char const*>(privateKey.getPrivateKey().data()));
+		return encryptedData;
+	}
+
+	QByteArray decryptPerFrame(QByteArray const& encryptedData, openmittsu::crypto::Nonce const& nonce, openmittsu::crypto::PublicKey const& publicKey, openmittsu::crypto::KeyPair const& privateKey) {
+		QByteArray decryptedData(encryptedData.size() - crypto_box_MACBYTES, 0x00);
+		crypto_box_open_easy(reinterpret_cast<unsigned char*>(decryptedData.data()), reinterpret_cast<unsigned char const*>(encryptedData.data()), encryptedData.size(), nonce.getNonceAsCharPtr(), reinterpret_cast<unsigned char const*>(publicKey.getPublicKey().data()), reinterpret_cast<unsigned char const*>(privateKey.getPrivateKey().data()));
+		return decryptedData;
+	}
+}
+
+// Compares the per-frame crypto_box_easy path with the precomputed session key used for server transport frames.
+OPENMITTSU_BENCHMARK(TransportCrypto) {
+	openmittsu::crypto::KeyPair const clientKey = openmittsu::crypto::KeyPair::randomKey();
+	openmittsu::crypto::KeyPair const serverKey = openmittsu::crypto::KeyPair::randomKey();
+	openmittsu::crypto::Nonce const nonce;
+
+	openmittsu::crypto::PrecomputedSharedKey const clientSessionKey(serverKey, clientKey);
+	openmittsu::crypto::PrecomputedSharedKey const serverSessionKey(clientKey, serverKey);
+
+	// Echo/keep-alive sized frames, acknowledgments and a typical text message.
+	int const frameSizes[] = { 8, 28, 512 };
+	for (int const frameSize : frameSizes) {
+		QByteArray const frame(frameSize, 'x');
+		QByteArray const encryptedFrame = serverSessionKey.encrypt(frame, nonce);
+		std::string const suffix = " (" + std::to_string(frameSize) + " bytes)";
+
+		openmittsu::benchmark::Benchmark::measure("TransportCrypto", "encrypt per frame" + suffix, "frames", [&]() {
+			encryptPerFrame(frame, nonce, serverKey, clientKey);
+		});
+		openmittsu::benchmark::Benchmark::measure("TransportCrypto", "encrypt session key" + suffix, "frames", [&]() {
+			clientSessionKey.encrypt(frame, nonce);
+		});
+		openmittsu::benchmark::Benchmark::measure("TransportCrypto", "decrypt per frame" + suffix, "frames", [&]() {
+			decryptPerFrame(encryptedFrame, nonce, serverKey, clientKey);
+		});
+		openmittsu::benchmark::Benchmark::measure("TransportCrypto", "decrypt session key" + suffix, "frames", [&]() {
+			clientSessionKey.decrypt(encryptedFrame, nonce);
+		});
+	}
+}
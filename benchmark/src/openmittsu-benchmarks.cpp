@@ -0,0 +1,43 @@
+#include <iostream>
+#include <string>
+
+#include <QCoreApplication>
+
+#define OPENMITTSU_TESTS
+#include "Init.h"
+
+#include "benchmark/src/Benchmark.h"
+
+int main(int argc, char* argv[]) {
+	std::cout << "OpenMittsu Benchmark Suite" << std::endl;
+	std::cout << "Usage: " << argv[0] << " [name filter]" << std::endl;
+
+	if (!initializeLogging(OPENMITTSU_LOGGING_MAX_FILESIZE, OPENMITTSU_LOGGING_MAX_FILECOUNT)) {
+		return -2;
+	}
+
+	OPENMITTSU_REGISTER_TYPES();
+	QCoreApplication application(argc, argv);
+
+	if (!initializeLibSodium()) {
+		return -3;
+	}
+
+	std::string const filter = (argc > 1) ? std::string(argv[1]) : std::string();
+
+	int result = 0;
+	for (openmittsu::benchmark::Benchmark::Entry const& entry : openmittsu::benchmark::Benchmark::getBenchmarks()) {
+		if (!filter.empty() && (entry.name.find(filter) == std::string::npos)) {
+			continue;
+		}
+
+		try {
+			entry.function();
+		} catch (std::exception& e) {
+			std::cerr << "Benchmark " << entry.name << " failed: " << e.what() << std::endl;
+			result = -1;
+		}
+	}
+
+	return result;
+}
@@ -0,0 +1,5 @@
+CREATE TABLE `pending_messages` (
+	`uid`		INTEGER PRIMARY KEY AUTOINCREMENT,
+	`waiting_for`	TEXT NOT NULL,
+	`message`	BLOB NOT NULL
+);
\ No newline at end of file
@@ -0,0 +1 @@
+CREATE INDEX IF NOT EXISTS `control_messages_unsent_outbox` ON `control_messages` (`is_queued`, `modified_at`) WHERE `is_outbox` = 1 AND `is_sent` = 0;
@@ -0,0 +1,2 @@
+CREATE INDEX IF NOT EXISTS `contact_messages_by_identity` ON `contact_messages` (`identity`, `sort_by`, `uid`, `apiid`);
+CREATE INDEX IF NOT EXISTS `contact_messages_unsent_outbox` ON `contact_messages` (`is_queued`, `modified_at`) WHERE `is_outbox` = 1 AND `is_sent` = 0;
@@ -0,0 +1,2 @@
+CREATE INDEX IF NOT EXISTS `group_messages_by_group` ON `group_messages` (`group_id`, `group_creator`, `sort_by`, `uid`, `apiid`);
+CREATE INDEX IF NOT EXISTS `group_messages_unsent_outbox` ON `group_messages` (`is_queued`, `modified_at`) WHERE `is_outbox` = 1 AND `is_sent` = 0;
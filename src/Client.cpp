@@ -10,6 +10,7 @@
 #include <iomanip>
 
 #include "Client.h"
+#include "src/network/HttpClient.h"
 #include "src/network/ServerConfiguration.h"
 
 #include "ui_main.h"
@@ -37,7 +38,6 @@
 #include "src/utility/MakeUnique.h"
 #include "src/utility/Version.h"
 #include "src/utility/QObjectConnectionMacro.h"
-#include "src/utility/ThreadDeleter.h"
 #include "src/utility/LegacyContactImporter.h"
 #include "src/backup/BackupReader.h"
 
@@ -49,10 +49,12 @@
 #include "src/exceptions/InvalidPasswordOrDatabaseException.h"
 #include "src/exceptions/ProtocolErrorException.h"
 
+#include "src/tasks/BlobDownloaderCallbackTask.h"
 #include "src/tasks/IdentityReceiverCallbackTask.h"
 #include "src/tasks/CheckFeatureLevelCallbackTask.h"
 #include "src/tasks/CheckContactActivityStatusCallbackTask.h"
 #include "src/tasks/SetFeatureLevelCallbackTask.h"
+#include "src/tasks/TaskExecutor.h"
 
 #include "src/protocol/ContactId.h"
 #include "src/protocol/GroupId.h"
@@ -110,8 +112,20 @@ Client::Client(QWidget* parent) : QMainWindow(parent),
 		}
 	}
 
+	// Allow pointing the client at a different chat server, e.g. the loopback server used for load testing.
+	QString const serverConfigurationFile = QString::fromLocal8Bit(qgetenv("OPENMITTSU_SERVER_CONFIGURATION"));
+	if (!serverConfigurationFile.isEmpty()) {
+		try {
+			m_serverConfiguration = std::make_shared<openmittsu::network::ServerConfiguration>(openmittsu::network::ServerConfiguration::fromFile(serverConfigurationFile));
+			LOGGER()->warn("Using the server configuration from {}: {}", serverConfigurationFile.toStdString(), m_serverConfiguration->toString().toStdString());
+		} catch (openmittsu::exceptions::BaseException& be) {
+			LOGGER()->error("Could not load the server configuration from {}, using the default configuration instead. Error: {}", serverConfigurationFile.toStdString(), be.what());
+		}
+	}
+
 	// Load stored settings
 	this->m_optionMaster = std::make_shared<openmittsu::utility::OptionMaster>();
+	openmittsu::tasks::TaskExecutor::globalInstance()->setWorkerCount(m_optionMaster->getOptionAsInt(openmittsu::utility::OptionMaster::Options::INTEGER_BACKGROUND_TASK_THREADS));
 	QString const databaseFile = m_optionMaster->getOptionAsQString(openmittsu::utility::OptionMaster::Options::FILEPATH_DATABASE);
 	QString const legacyClientConfiguration = m_optionMaster->getOptionAsQString(openmittsu::utility::OptionMaster::Options::FILEPATH_LEGACY_CLIENT_CONFIGURATION);
 	bool showFirstUseWizard = false;
@@ -206,6 +220,19 @@ Client::~Client() {
 	while (!m_protocolClientThread.isFinished()) {
 		QThread::currentThread()->wait(10);
 	}
+
+	// Tasks still waiting for a worker are deleted by the executor, running ones are allowed to finish.
+	// Their finished() is queued to this Client, so deliver it while we are still alive and the tasks get deleted in callbackTaskFinished().
+	// That may submit follow-up tasks, which are discarded in the next round.
+	openmittsu::tasks::TaskExecutor* const taskExecutor = openmittsu::tasks::TaskExecutor::globalInstance();
+	quint64 submittedTasks = 0;
+	do {
+		submittedTasks = taskExecutor->getSubmittedTaskCount();
+		taskExecutor->discardQueuedTasks();
+		taskExecutor->waitForDone();
+		QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+	} while (taskExecutor->getSubmittedTaskCount() != submittedTasks);
+	openmittsu::network::HttpClient::globalInstance()->shutdown();
 }
 
 void Client::closeEvent(QCloseEvent* event) {
@@ -273,6 +300,14 @@ void Client::setupProtocolClient() {
 	}
 	eventLoop.exec(); // blocks until "finished()" has been called
 
+	// Debugging aid for profiling the receive path offline, see openMittsuReplay.
+	QString const packetCaptureFile = QString::fromLocal8Bit(qgetenv("OPENMITTSU_PACKET_CAPTURE"));
+	if (!packetCaptureFile.isEmpty()) {
+		if (!QMetaObject::invokeMethod(m_protocolClient.get(), "setPacketCaptureFile", Qt::QueuedConnection, Q_ARG(QString, packetCaptureFile))) {
+			throw openmittsu::exceptions::InternalErrorException() << "Could not invoke method setPacketCaptureFile in " << __FILE__ << "  at line " << __LINE__ << ".";
+		}
+	}
+
 	m_messageCenter->setNetworkSentMessageAcceptor(std::make_shared<openmittsu::dataproviders::NetworkSentMessageAcceptor>(m_protocolClient));
 }
 
@@ -372,6 +407,7 @@ void Client::openDatabaseFile(QString const& fileName) {
 				location.cdUp();
 
 				this->m_database = std::make_shared<openmittsu::database::Database>(fileName, password, location);
+				openmittsu::tasks::BlobDownloaderCallbackTask::setSpoolDirectory(location);
 				this->m_optionMaster->setOption(openmittsu::utility::OptionMaster::Options::FILEPATH_DATABASE, fileName);
 				updateDatabaseInfo(fileName);
 
@@ -506,13 +542,13 @@ void Client::protocolClientOnConnectToFinished(int errCode, QString message) {
 			if (contactsRequiringFeatureLevelCheck.size() > 0) {
 				openmittsu::tasks::CheckFeatureLevelCallbackTask* taskCheckFeatureLevels = new openmittsu::tasks::CheckFeatureLevelCallbackTask(m_serverConfiguration, contactsRequiringFeatureLevelCheck);
 				OPENMITTSU_CONNECT_QUEUED(taskCheckFeatureLevels, finished(openmittsu::tasks::CallbackTask*), this, callbackTaskFinished(openmittsu::tasks::CallbackTask*));
-				taskCheckFeatureLevels->start();
+				openmittsu::tasks::TaskExecutor::globalInstance()->submit(taskCheckFeatureLevels, openmittsu::tasks::TaskExecutor::TaskPriority::LOW);
 			}
 
 			if (contactsRequiringAccountStatusCheck.size() > 0) {
 				openmittsu::tasks::CheckContactActivityStatusCallbackTask* taskCheckContactIdStatus = new openmittsu::tasks::CheckContactActivityStatusCallbackTask(m_serverConfiguration, contactsRequiringAccountStatusCheck);
 				OPENMITTSU_CONNECT_QUEUED(taskCheckContactIdStatus, finished(openmittsu::tasks::CallbackTask*), this, callbackTaskFinished(openmittsu::tasks::CallbackTask*));
-				taskCheckContactIdStatus->start();
+				openmittsu::tasks::TaskExecutor::globalInstance()->submit(taskCheckContactIdStatus, openmittsu::tasks::TaskExecutor::TaskPriority::LOW);
 			}
 		}
 	} else {
@@ -781,7 +817,22 @@ void Client::menuAboutStatisticsOnClick() {
 	} else {
 		QDateTime now = QDateTime::currentDateTime();
 		quint64 seconds = m_protocolClient->getConnectedSince().secsTo(now);
-		QMessageBox::information(this, "OpenMittsu - Statistics", QString("Current session:\n\nTime connected: %1\nSend: %2 Bytes\nReceived: %3 Bytes\nMessages send: %4\nMessages received: %5").arg(formatDuration(seconds)).arg(QString::number(m_protocolClient->getSendBytesCount(), 10)).arg(QString::number(m_protocolClient->getReceivedBytesCount(), 10)).arg(QString::number(m_protocolClient->getSendMessagesCount(), 10)).arg(QString::number(m_protocolClient->getReceivedMessagesCount(), 10)));
+		QString const metricsSnapshot = m_protocolClient->getMetrics().toText();
+
+		QMessageBox messageBox(QMessageBox::Information, "OpenMittsu - Statistics", QString("Current session:\n\nTime connected: %1\nSend: %2 Bytes\nReceived: %3 Bytes\nMessages send: %4\nMessages received: %5").arg(formatDuration(seconds)).arg(QString::number(m_protocolClient->getSendBytesCount(), 10)).arg(QString::number(m_protocolClient->getReceivedBytesCount(), 10)).arg(QString::number(m_protocolClient->getSendMessagesCount(), 10)).arg(QString::number(m_protocolClient->getReceivedMessagesCount(), 10)), QMessageBox::Ok, this);
+		messageBox.setDetailedText(metricsSnapshot);
+		QPushButton* exportButton = messageBox.addButton(tr("Export metrics..."), QMessageBox::ActionRole);
+		messageBox.exec();
+
+		if (messageBox.clickedButton() == exportButton) {
+			QString const fileName = QFileDialog::getSaveFileName(this, tr("Export protocol metrics"), QString(), tr("Text files (*.txt)"));
+			if (!fileName.isEmpty()) {
+				QFile file(fileName);
+				if (!file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text) || (file.write(metricsSnapshot.toUtf8()) < 0)) {
+					QMessageBox::warning(this, "OpenMittsu - Statistics", tr("Could not write the metrics to \"%1\".").arg(fileName));
+				}
+			}
+		}
 	}
 }
 
@@ -816,7 +867,7 @@ void Client::menuContactAddOnClick() {
 				
 				QEventLoop eventLoop;
 				OPENMITTSU_CONNECT(&ir, finished(openmittsu::tasks::CallbackTask*), &eventLoop, quit());
-				ir.start();
+				openmittsu::tasks::TaskExecutor::globalInstance()->submit(&ir, openmittsu::tasks::TaskExecutor::TaskPriority::HIGH);
 				eventLoop.exec();
 
 				if (!ir.hasFinished() || !ir.hasFinishedSuccessfully()) {
@@ -972,7 +1023,7 @@ void Client::callbackTaskFinished(openmittsu::tasks::CallbackTask* callbackTask)
 	}
 
 	if (dynamic_cast<openmittsu::tasks::CheckFeatureLevelCallbackTask*>(callbackTask) != nullptr) {
-		openmittsu::utility::UniquePtrWithDelayedThreadDeletion<openmittsu::tasks::CheckFeatureLevelCallbackTask> checkFeatureLevelTask(dynamic_cast<openmittsu::tasks::CheckFeatureLevelCallbackTask*>(callbackTask));
+		std::unique_ptr<openmittsu::tasks::CheckFeatureLevelCallbackTask> checkFeatureLevelTask(dynamic_cast<openmittsu::tasks::CheckFeatureLevelCallbackTask*>(callbackTask));
 		if (checkFeatureLevelTask->hasFinishedSuccessfully()) {
 			openmittsu::protocol::ContactId const selfIdentity = (m_database == nullptr) ? openmittsu::protocol::ContactId(0) : m_database->getSelfContact();
 
@@ -1000,14 +1051,14 @@ void Client::callbackTaskFinished(openmittsu::tasks::CallbackTask* callbackTask)
 					openmittsu::crypto::BasicCryptoBox basicCryptoBox(backupData.getClientLongTermKeyPair(), m_serverConfiguration->getServerLongTermPublicKey());
 					openmittsu::tasks::SetFeatureLevelCallbackTask* setFeatureLevelTask = new openmittsu::tasks::SetFeatureLevelCallbackTask(m_serverConfiguration, basicCryptoBox, backupData.getClientContactId(), openMittsuFeatureLevel);
 					OPENMITTSU_CONNECT(setFeatureLevelTask, finished(openmittsu::tasks::CallbackTask*), this, callbackTaskFinished(openmittsu::tasks::CallbackTask*));
-					setFeatureLevelTask->start();
+					openmittsu::tasks::TaskExecutor::globalInstance()->submit(setFeatureLevelTask, openmittsu::tasks::TaskExecutor::TaskPriority::LOW);
 				}
 			}
 		} else {
 			LOGGER()->error("Checking for supported feature levels of contacts failed: {}", checkFeatureLevelTask->getErrorMessage().toStdString());
 		}
 	} else if (dynamic_cast<openmittsu::tasks::CheckContactActivityStatusCallbackTask*>(callbackTask) != nullptr) {
-		openmittsu::utility::UniquePtrWithDelayedThreadDeletion<openmittsu::tasks::CheckContactActivityStatusCallbackTask> checkContactIdStatusTask(dynamic_cast<openmittsu::tasks::CheckContactActivityStatusCallbackTask*>(callbackTask));
+		std::unique_ptr<openmittsu::tasks::CheckContactActivityStatusCallbackTask> checkContactIdStatusTask(dynamic_cast<openmittsu::tasks::CheckContactActivityStatusCallbackTask*>(callbackTask));
 		if (checkContactIdStatusTask->hasFinishedSuccessfully()) {
 			if (m_database == nullptr) {
 				LOGGER()->error("Wanted to update feature levels, but the database is null!");
@@ -1019,7 +1070,7 @@ void Client::callbackTaskFinished(openmittsu::tasks::CallbackTask* callbackTask)
 			LOGGER()->error("Checking for status of contacts failed: {}", checkContactIdStatusTask->getErrorMessage().toStdString());
 		}
 	} else if (dynamic_cast<openmittsu::tasks::SetFeatureLevelCallbackTask*>(callbackTask) != nullptr) {
-		openmittsu::utility::UniquePtrWithDelayedThreadDeletion<openmittsu::tasks::SetFeatureLevelCallbackTask> setFeatureLevelTask(dynamic_cast<openmittsu::tasks::SetFeatureLevelCallbackTask*>(callbackTask));
+		std::unique_ptr<openmittsu::tasks::SetFeatureLevelCallbackTask> setFeatureLevelTask(dynamic_cast<openmittsu::tasks::SetFeatureLevelCallbackTask*>(callbackTask));
 		if (setFeatureLevelTask->hasFinishedSuccessfully()) {
 			LOGGER()->info("Updated feature level for used Client ID to latest support version {}.", openmittsu::protocol::FeatureLevelHelper::toInt(openmittsu::protocol::FeatureLevelHelper::latestSupported()));
 		} else {
@@ -3,6 +3,34 @@
 
 #include <QString>
 
+#include <cstring>
+
+#include "src/exceptions/IllegalFunctionCallException.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define OPENMITTSU_CRC32_HAVE_PCLMUL
+#include <emmintrin.h>
+#include <smmintrin.h>
+#include <wmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#if defined(__GNUC__) || defined(__clang__)
+#define OPENMITTSU_CRC32_TARGET_PCLMUL __attribute__((target("pclmul,sse4.1")))
+#else
+#define OPENMITTSU_CRC32_TARGET_PCLMUL
+#endif
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+// Only if the compiler already targets ARMv8 with the CRC extension, e.g. -march=armv8-a+crc or Apple Silicon.
+#define OPENMITTSU_CRC32_HAVE_ARMV8_CRC
+#include <arm_acle.h>
+#endif
+
+// Below this size the setup of the folding constants does not pay off.
+#define OPENMITTSU_CRC32_PCLMUL_MINIMUM_LENGTH (64)
+
 namespace openmittsu {
 	namespace crypto {
 
@@ -124,8 +152,199 @@ static UNS_32_BITS crc_32_tab[] = { /* CRC polynomial 0xedb88320 */
 			return ~oldcrc32;
 		}
 
+		namespace {
+			// Slicing-by-8, table[k][i] is the CRC of byte i followed by k zero bytes, see "A Systematic Approach to Building High Performance Software-based CRC Generators" by Kounavis and Berry.
+			struct SlicingTables {
+				uint32_t table[8][256];
+
+				SlicingTables() {
+					for (int i = 0; i < 256; ++i) {
+						table[0][i] = crc_32_tab[i];
+					}
+					for (int k = 1; k < 8; ++k) {
+						for (int i = 0; i < 256; ++i) {
+							table[k][i] = (table[k - 1][i] >> 8) ^ crc_32_tab[table[k - 1][i] & 0xff];
+						}
+					}
+				}
+			};
+
+			SlicingTables const& getSlicingTables() {
+				static SlicingTables const slicingTables;
+				return slicingTables;
+			}
+
+			bool detectHardwareSupport() {
+#if defined(OPENMITTSU_CRC32_HAVE_PCLMUL)
+				unsigned int ecx = 0;
+#if defined(_MSC_VER)
+				int cpuInfo[4] = { 0, 0, 0, 0 };
+				__cpuid(cpuInfo, 1);
+				ecx = static_cast<unsigned int>(cpuInfo[2]);
+#else
+				unsigned int eax = 0, ebx = 0, edx = 0;
+				if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0) {
+					return false;
+				}
+#endif
+				bool const hasPclmulqdq = (ecx & (1u << 1)) != 0;
+				bool const hasSse41 = (ecx & (1u << 19)) != 0;
+				return hasPclmulqdq && hasSse41;
+#elif defined(OPENMITTSU_CRC32_HAVE_ARMV8_CRC)
+				return true;
+#else
+				return false;
+#endif
+			}
+
+#if defined(OPENMITTSU_CRC32_HAVE_PCLMUL)
+			/*
+			 * Folds 64 bytes per iteration with carry-less multiplication and reduces the result with Barrett reduction, see
+			 * "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction" by Gopal et al. (Intel, 2009).
+			 * The constants are the ones for the reflected polynomial 0xedb88320 as used by zlib.
+			 * Expects the CRC register (not inverted at the end) and len to be a multiple of 16 of at least 64.
+			 */
+			OPENMITTSU_CRC32_TARGET_PCLMUL uint32_t crc32Pclmul(uint32_t crc, unsigned char const* buf, size_t len) {
+				__m128i const k1k2 = _mm_set_epi64x(0x01c6e41596LL, 0x0154442bd4LL);
+				__m128i const k3k4 = _mm_set_epi64x(0x00ccaa009eLL, 0x01751997d0LL);
+				__m128i const k5k0 = _mm_set_epi64x(0x0000000000LL, 0x0163cd6124LL);
+				__m128i const poly = _mm_set_epi64x(0x01f7011641LL, 0x01db710641LL);
+				__m128i const mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+				__m128i x1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(buf + 0x00));
+				__m128i x2 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(buf + 0x10));
+				__m128i x3 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(buf + 0x20));
+				__m128i x4 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(buf + 0x30));
+				x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+				buf += 64;
+				len -= 64;
+
+				// Fold four 128 bit lanes in parallel.
+				while (len >= 64) {
+					__m128i const x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+					__m128i const x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+					__m128i const x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+					__m128i const x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+
+					x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+					x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+					x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+					x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+
+					x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(reinterpret_cast<__m128i const*>(buf + 0x00)));
+					x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(reinterpret_cast<__m128i const*>(buf + 0x10)));
+					x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(reinterpret_cast<__m128i const*>(buf + 0x20)));
+					x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(reinterpret_cast<__m128i const*>(buf + 0x30)));
+
+					buf += 64;
+					len -= 64;
+				}
+
+				// Fold the four lanes into one.
+				__m128i x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+				x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x11), x2), x5);
+				x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+				x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x11), x3), x5);
+				x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+				x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x11), x4), x5);
+
+				// Remaining 16 byte blocks.
+				while (len >= 16) {
+					x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+					x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x11), _mm_loadu_si128(reinterpret_cast<__m128i const*>(buf))), x5);
+					buf += 16;
+					len -= 16;
+				}
+
+				// Fold 128 to 64 bits.
+				x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+				x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+				x2 = _mm_srli_si128(x1, 4);
+				x1 = _mm_and_si128(x1, mask32);
+				x1 = _mm_xor_si128(_mm_clmulepi64_si128(x1, k5k0, 0x00), x2);
+
+				// Barrett reduction to 32 bits.
+				x2 = _mm_and_si128(x1, mask32);
+				x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+				x2 = _mm_and_si128(x2, mask32);
+				x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+				x1 = _mm_xor_si128(x1, x2);
+
+				return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+			}
+#endif
+		}
+
+		uint32_t Crc32::crc32SlicingBy8(uint32_t crc, char const* buf, size_t len) {
+			SlicingTables const& tables = getSlicingTables();
+			unsigned char const* bytes = reinterpret_cast<unsigned char const*>(buf);
+
+			while (len >= 8) {
+				// Assembled byte by byte so this works regardless of endianess and alignment, compilers turn it into plain loads.
+				uint32_t const one = crc ^ (static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) | (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24));
+				uint32_t const two = static_cast<uint32_t>(bytes[4]) | (static_cast<uint32_t>(bytes[5]) << 8) | (static_cast<uint32_t>(bytes[6]) << 16) | (static_cast<uint32_t>(bytes[7]) << 24);
+				crc = tables.table[7][one & 0xff] ^ tables.table[6][(one >> 8) & 0xff] ^ tables.table[5][(one >> 16) & 0xff] ^ tables.table[4][one >> 24]
+					^ tables.table[3][two & 0xff] ^ tables.table[2][(two >> 8) & 0xff] ^ tables.table[1][(two >> 16) & 0xff] ^ tables.table[0][two >> 24];
+				bytes += 8;
+				len -= 8;
+			}
+
+			for (; len > 0; --len, ++bytes) {
+				crc = UPDC32(*bytes, crc);
+			}
+
+			return crc;
+		}
+
+		uint32_t Crc32::crc32Hardware(uint32_t crc, char const* buf, size_t len) {
+#if defined(OPENMITTSU_CRC32_HAVE_PCLMUL)
+			if (len >= OPENMITTSU_CRC32_PCLMUL_MINIMUM_LENGTH) {
+				size_t const foldedLength = len - (len % 16);
+				crc = crc32Pclmul(crc, reinterpret_cast<unsigned char const*>(buf), foldedLength);
+				buf += foldedLength;
+				len -= foldedLength;
+			}
+			return crc32SlicingBy8(crc, buf, len);
+#elif defined(OPENMITTSU_CRC32_HAVE_ARMV8_CRC)
+			while (len >= 8) {
+				uint64_t value;
+				std::memcpy(&value, buf, sizeof(value));
+				crc = __crc32d(crc, value);
+				buf += 8;
+				len -= 8;
+			}
+			for (; len > 0; --len, ++buf) {
+				crc = __crc32b(crc, static_cast<uint8_t>(*buf));
+			}
+			return crc;
+#else
+			return crc32SlicingBy8(crc, buf, len);
+#endif
+		}
+
+		bool Crc32::isHardwareAccelerationAvailable() {
+			static bool const isAvailable = detectHardwareSupport();
+			return isAvailable;
+		}
+
 		uint32_t Crc32::checksum(QByteArray const& data) {
-			return crc32buf(data.data(), data.size());
+			return checksum(data, isHardwareAccelerationAvailable() ? Implementation::HARDWARE : Implementation::SLICING_BY_8);
+		}
+
+		uint32_t Crc32::checksum(QByteArray const& data, Implementation implementation) {
+			switch (implementation) {
+				case Implementation::BYTEWISE:
+					return crc32buf(data.data(), data.size());
+				case Implementation::SLICING_BY_8:
+					return ~crc32SlicingBy8(0xFFFFFFFF, data.data(), data.size());
+				case Implementation::HARDWARE:
+					if (!isHardwareAccelerationAvailable()) {
+						throw openmittsu::exceptions::IllegalFunctionCallException() << "The CPU does not support hardware accelerated CRC32 computation.";
+					}
+					return ~crc32Hardware(0xFFFFFFFF, data.data(), data.size());
+				default:
+					throw openmittsu::exceptions::IllegalFunctionCallException() << "Unknown CRC32 implementation requested.";
+			}
 		}
 
 		QString Crc32::toString(uint32_t checksum) {
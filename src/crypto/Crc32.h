@@ -8,12 +8,26 @@
 namespace openmittsu {
 	namespace crypto {
 
+		/**
+		 * CRC-32 as used by zlib and the media item checksums.
+		 * checksum() uses the carry-less multiplication (x86, PCLMULQDQ) or CRC32 instructions (ARMv8) if the CPU supports them and falls back to slicing-by-8 otherwise.
+		 * All implementations produce identical checksums.
+		 */
 		class Crc32 {
 		public:
+			enum class Implementation {
+				BYTEWISE, SLICING_BY_8, HARDWARE
+			};
+
 			static uint32_t checksum(QByteArray const& data);
+			static uint32_t checksum(QByteArray const& data, Implementation implementation);
 			static QString toString(uint32_t checksum);
+
+			static bool isHardwareAccelerationAvailable();
 		private:
 			static uint32_t crc32buf(char const* buf, size_t len);
+			static uint32_t crc32SlicingBy8(uint32_t crc, char const* buf, size_t len);
+			static uint32_t crc32Hardware(uint32_t crc, char const* buf, size_t len);
 		};
 
 	}
@@ -2,13 +2,15 @@
 
 #include "src/exceptions/CryptoException.h"
 #include "src/utility/Endian.h"
+#include "src/utility/MakeUnique.h"
+#include <QMutexLocker>
 #include <sodium.h>
 
 namespace openmittsu {
 	namespace crypto {
 
-		FullCryptoBox::FullCryptoBox(openmittsu::dataproviders::KeyRegistry const& keyRegistry)
-			: BasicCryptoBox(keyRegistry.getClientLongTermKeyPair(), keyRegistry.getServerLongTermPublicKey()), m_keyRegistry(keyRegistry), m_clientShortTermKey(openmittsu::crypto::KeyPair::randomKey()), m_serverShortTermKey(), m_clientNonceGenerator(), m_serverNonceGenerator() {
+		FullCryptoBox::FullCryptoBox(openmittsu::dataproviders::KeyRegistry const& keyRegistry, int sharedKeyCacheSize)
+			: BasicCryptoBox(keyRegistry.getClientLongTermKeyPair(), keyRegistry.getServerLongTermPublicKey()), m_keyRegistry(keyRegistry), m_clientShortTermKey(openmittsu::crypto::KeyPair::randomKey()), m_serverShortTermKey(), m_clientNonceGenerator(), m_serverNonceGenerator(), m_serverSessionKey(), m_sharedKeyCacheMutex(std::make_unique<QMutex>()), m_sharedKeyCache(sharedKeyCacheSize), m_sharedKeyCacheGeneration(0) {
 			// Intentionally left empty.
 		}
 
@@ -22,27 +24,53 @@ namespace openmittsu {
 		}
 
 		std::pair<Nonce, QByteArray> FullCryptoBox::encrypt(QByteArray const& data, openmittsu::protocol::ContactId const& targetIdentity) {
-			if (!m_keyRegistry.hasIdentity(targetIdentity)) {
+			std::shared_ptr<openmittsu::crypto::PrecomputedSharedKey const> const sharedKey = getSharedKeyForIdentity(targetIdentity);
+			if (!sharedKey) {
 				throw openmittsu::exceptions::CryptoException() << "Can not encrypt for unknown identity.";
 			}
 
-			return BasicCryptoBox::encrypt(data, m_keyRegistry.getPublicKeyForIdentity(targetIdentity));
+			openmittsu::crypto::Nonce nonce;
+			return std::make_pair(nonce, sharedKey->encrypt(data, nonce));
 		}
 
 		QByteArray FullCryptoBox::decrypt(QByteArray const& encryptedData, openmittsu::crypto::Nonce const& nonce, openmittsu::protocol::ContactId const& sourceIdentity) {
-			if (!m_keyRegistry.hasIdentity(sourceIdentity)) {
+			std::shared_ptr<openmittsu::crypto::PrecomputedSharedKey const> const sharedKey = getSharedKeyForIdentity(sourceIdentity);
+			if (!sharedKey) {
 				throw openmittsu::exceptions::CryptoException() << "Can not decrypt from unknown identity.";
-			} else if ((encryptedData.size() - crypto_box_MACBYTES) < 1) {
-				throw openmittsu::exceptions::CryptoException() << "Failed to decrypt data: Cipher text too short.";
 			}
 
-			QByteArray decryptedData(encryptedData.size() - crypto_box_MACBYTES, 0x00);
+			return sharedKey->decrypt(encryptedData, nonce);
+		}
 
-			if (crypto_box_open_easy(reinterpret_cast<unsigned char*>(decryptedData.data()), reinterpret_cast<unsigned char const*>(encryptedData.data()), encryptedData.size(), nonce.getNonceAsCharPtr(), reinterpret_cast<unsigned char const*>(m_keyRegistry.getPublicKeyForIdentity(sourceIdentity).getPublicKey().data()), reinterpret_cast<unsigned char const*>(m_keyRegistry.getClientLongTermKeyPair().getPrivateKey().data())) != 0) {
-				throw openmittsu::exceptions::CryptoException() << "Failed to decrypt data.";
+		std::shared_ptr<openmittsu::crypto::PrecomputedSharedKey const> FullCryptoBox::getSharedKeyForIdentity(openmittsu::protocol::ContactId const& identity) {
+			quint64 const keyGeneration = m_keyRegistry.getKeyGeneration();
+			{
+				QMutexLocker lock(m_sharedKeyCacheMutex.get());
+				if (keyGeneration != m_sharedKeyCacheGeneration) {
+					m_sharedKeyCache.clear();
+					m_sharedKeyCacheGeneration = keyGeneration;
+				}
+
+				std::shared_ptr<openmittsu::crypto::PrecomputedSharedKey const> sharedKey;
+				if (m_sharedKeyCache.get(identity, sharedKey)) {
+					return sharedKey;
+				}
+			}
+
+			if (!m_keyRegistry.hasIdentity(identity)) {
+				return nullptr;
+			}
+
+			// Do the curve operation outside of the lock so that concurrent tasks for other contacts are not serialized.
+			std::shared_ptr<openmittsu::crypto::PrecomputedSharedKey const> const sharedKey = std::make_shared<openmittsu::crypto::PrecomputedSharedKey const>(m_keyRegistry.getPublicKeyForIdentity(identity), m_clientLongTermKey);
+			{
+				QMutexLocker lock(m_sharedKeyCacheMutex.get());
+				if (keyGeneration == m_sharedKeyCacheGeneration) {
+					m_sharedKeyCache.insert(identity, sharedKey);
+				}
 			}
 
-			return decryptedData;
+			return sharedKey;
 		}
 
 		openmittsu::dataproviders::KeyRegistry& FullCryptoBox::getKeyRegistry() {
@@ -71,6 +99,12 @@ namespace openmittsu {
 
 		void FullCryptoBox::setServerShortTermPublicKey(openmittsu::crypto::PublicKey const& newServerKey) {
 			m_serverShortTermKey = newServerKey;
+			// Both short-term keys are fixed for the rest of the connection, so derive the shared key only once.
+			m_serverSessionKey = std::make_shared<openmittsu::crypto::PrecomputedSharedKey const>(m_serverShortTermKey, m_clientShortTermKey);
+		}
+
+		bool FullCryptoBox::hasServerSessionKey() const {
+			return m_serverSessionKey != nullptr;
 		}
 
 		QByteArray FullCryptoBox::encrypt(QByteArray const& data, PublicKey const& pubKey, openmittsu::crypto::KeyPair const& privateKey, openmittsu::crypto::Nonce const& nonce) const {
@@ -84,6 +118,9 @@ namespace openmittsu {
 
 		QByteArray FullCryptoBox::encryptForServer(QByteArray const& data) {
 			Nonce clientNonce(m_clientNonceGenerator.getNextNonce());
+			if (m_serverSessionKey) {
+				return m_serverSessionKey->encrypt(data, clientNonce);
+			}
 
 			return encrypt(data, m_serverShortTermKey, m_clientShortTermKey, clientNonce);
 		}
@@ -103,6 +140,11 @@ namespace openmittsu {
 		}
 
 		QByteArray FullCryptoBox::decryptFromServer(QByteArray const& encryptedData) {
+			if (m_serverSessionKey) {
+				openmittsu::crypto::Nonce const serverNonce(m_serverNonceGenerator.getNextNonce());
+				return m_serverSessionKey->decrypt(encryptedData, serverNonce);
+			}
+
 			return decryptFromServer(encryptedData, m_serverShortTermKey);
 		}
 
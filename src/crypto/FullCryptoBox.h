@@ -1,17 +1,21 @@
 #ifndef OPENMITTSU_CRYPTO_FULLCRYPTOBOX_H_
 #define OPENMITTSU_CRYPTO_FULLCRYPTOBOX_H_
 
+#include <memory>
 #include <utility>
 #include <QByteArray>
+#include <QMutex>
 
 #include "src/protocol/ContactId.h"
 #include "src/crypto/BasicCryptoBox.h"
 #include "src/crypto/EncryptionKey.h"
 #include "src/crypto/Nonce.h"
 #include "src/crypto/NonceGenerator.h"
+#include "src/crypto/PrecomputedSharedKey.h"
 #include "src/dataproviders/KeyRegistry.h"
 #include "src/crypto/PublicKey.h"
 #include "src/crypto/KeyPair.h"
+#include "src/utility/LruCache.h"
 
 namespace openmittsu {
 	namespace protocol {
@@ -22,7 +26,7 @@ namespace openmittsu {
 
 		class FullCryptoBox : public BasicCryptoBox {
 		public:
-			FullCryptoBox(openmittsu::dataproviders::KeyRegistry const& keyRegistry);
+			FullCryptoBox(openmittsu::dataproviders::KeyRegistry const& keyRegistry, int sharedKeyCacheSize = 512);
 			FullCryptoBox(FullCryptoBox&& other) = default;
 
 			virtual ~FullCryptoBox();
@@ -44,6 +48,11 @@ namespace openmittsu {
 			void setServerNoncePrefixFromServerHello(QByteArray const& newServerNonce);
 			void setServerShortTermPublicKey(PublicKey const& newServerKey);
 
+			/**
+			 * True once the server short-term key is known and transport frames are handled with the precomputed session key.
+			 */
+			bool hasServerSessionKey() const;
+
 			friend class openmittsu::protocol::AuthenticationPacket;
 		private:
 			openmittsu::dataproviders::KeyRegistry m_keyRegistry;
@@ -52,6 +61,14 @@ namespace openmittsu {
 			openmittsu::crypto::PublicKey m_serverShortTermKey;
 			openmittsu::crypto::NonceGenerator m_clientNonceGenerator;
 			openmittsu::crypto::NonceGenerator m_serverNonceGenerator;
+			std::shared_ptr<openmittsu::crypto::PrecomputedSharedKey const> m_serverSessionKey;
+
+			// Precomputed shared keys of our long-term key with contact public keys, dropped whenever the KeyRegistry reports a key change.
+			std::unique_ptr<QMutex> m_sharedKeyCacheMutex;
+			openmittsu::utility::LruCache<openmittsu::protocol::ContactId, std::shared_ptr<openmittsu::crypto::PrecomputedSharedKey const>> m_sharedKeyCache;
+			quint64 m_sharedKeyCacheGeneration;
+
+			std::shared_ptr<openmittsu::crypto::PrecomputedSharedKey const> getSharedKeyForIdentity(openmittsu::protocol::ContactId const& identity);
 
 			openmittsu::crypto::PublicKey const& getServerShortTermPublicKey() const;
 			openmittsu::crypto::NonceGenerator const& getServerNonceGenerator() const;
@@ -0,0 +1,50 @@
+#include "src/crypto/PrecomputedSharedKey.h"
+
+#include "src/exceptions/CryptoException.h"
+#include <sodium.h>
+
+namespace openmittsu {
+	namespace crypto {
+
+		PrecomputedSharedKey::PrecomputedSharedKey(openmittsu::crypto::PublicKey const& publicKey, openmittsu::crypto::KeyPair const& privateKey) : m_sharedKey(static_cast<unsigned char*>(sodium_malloc(crypto_box_BEFORENMBYTES))) {
+			if (m_sharedKey == nullptr) {
+				throw openmittsu::exceptions::CryptoException() << "Failed to allocate locked memory for a shared key.";
+			}
+
+			if (crypto_box_beforenm(m_sharedKey, reinterpret_cast<unsigned char const*>(publicKey.getPublicKey().data()), reinterpret_cast<unsigned char const*>(privateKey.getPrivateKey().data())) != 0) {
+				sodium_free(m_sharedKey);
+				throw openmittsu::exceptions::CryptoException() << "Failed to compute shared key.";
+			}
+
+			sodium_mprotect_readonly(m_sharedKey);
+		}
+
+		PrecomputedSharedKey::~PrecomputedSharedKey() {
+			// sodium_free zeroes the memory before releasing it.
+			sodium_free(m_sharedKey);
+		}
+
+		QByteArray PrecomputedSharedKey::encrypt(QByteArray const& data, openmittsu::crypto::Nonce const& nonce) const {
+			QByteArray encryptedData(data.size() + crypto_box_MACBYTES, 0x00);
+			if (crypto_box_easy_afternm(reinterpret_cast<unsigned char*>(encryptedData.data()), reinterpret_cast<unsigned char const*>(data.data()), data.size(), nonce.getNonceAsCharPtr(), m_sharedKey) != 0) {
+				throw openmittsu::exceptions::CryptoException() << "Failed to encrypt data with shared key.";
+			}
+
+			return encryptedData;
+		}
+
+		QByteArray PrecomputedSharedKey::decrypt(QByteArray const& encryptedData, openmittsu::crypto::Nonce const& nonce) const {
+			if ((encryptedData.size() - crypto_box_MACBYTES) < 1) {
+				throw openmittsu::exceptions::CryptoException() << "Failed to decrypt data: Cipher text too short.";
+			}
+
+			QByteArray decryptedData(encryptedData.size() - crypto_box_MACBYTES, 0x00);
+			if (crypto_box_open_easy_afternm(reinterpret_cast<unsigned char*>(decryptedData.data()), reinterpret_cast<unsigned char const*>(encryptedData.data()), encryptedData.size(), nonce.getNonceAsCharPtr(), m_sharedKey) != 0) {
+				throw openmittsu::exceptions::CryptoException() << "Failed to decrypt data.";
+			}
+
+			return decryptedData;
+		}
+
+	}
+}
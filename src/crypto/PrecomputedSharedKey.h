@@ -0,0 +1,35 @@
+#ifndef OPENMITTSU_CRYPTO_PRECOMPUTEDSHAREDKEY_H_
+#define OPENMITTSU_CRYPTO_PRECOMPUTEDSHAREDKEY_H_
+
+#include <QByteArray>
+
+#include "src/crypto/KeyPair.h"
+#include "src/crypto/Nonce.h"
+#include "src/crypto/PublicKey.h"
+
+namespace openmittsu {
+	namespace crypto {
+
+		/**
+		 * The shared key of a crypto_box key pair combination, computed once via crypto_box_beforenm.
+		 * Encrypting or decrypting with it skips the X25519 scalar multiplication that crypto_box_easy does on every call.
+		 * The key material lives in guarded, locked memory obtained from sodium_malloc and is read-only after construction.
+		 */
+		class PrecomputedSharedKey {
+		public:
+			PrecomputedSharedKey(openmittsu::crypto::PublicKey const& publicKey, openmittsu::crypto::KeyPair const& privateKey);
+			virtual ~PrecomputedSharedKey();
+
+			PrecomputedSharedKey(PrecomputedSharedKey const& other) = delete;
+			PrecomputedSharedKey& operator=(PrecomputedSharedKey const& other) = delete;
+
+			QByteArray encrypt(QByteArray const& data, openmittsu::crypto::Nonce const& nonce) const;
+			QByteArray decrypt(QByteArray const& encryptedData, openmittsu::crypto::Nonce const& nonce) const;
+		private:
+			unsigned char* m_sharedKey;
+		};
+
+	}
+}
+
+#endif // OPENMITTSU_CRYPTO_PRECOMPUTEDSHAREDKEY_H_
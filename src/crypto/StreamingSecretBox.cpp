@@ -0,0 +1,87 @@
+#include "src/crypto/StreamingSecretBox.h"
+
+#include "src/exceptions/CryptoException.h"
+
+#include <QByteArray>
+
+#include <algorithm>
+
+#include <sodium.h>
+
+// Must be a multiple of the 64 byte XSalsa20 block size.
+#define OPENMITTSU_STREAMINGSECRETBOX_CHUNK_SIZE (64 * 1024)
+
+namespace openmittsu {
+	namespace crypto {
+
+		static void readFully(QIODevice& source, char* data, qint64 length) {
+			while (length > 0) {
+				qint64 const readBytes = source.read(data, length);
+				if (readBytes <= 0) {
+					throw openmittsu::exceptions::CryptoException() << "Failed to decrypt data: Could not read cipher text.";
+				}
+				data += readBytes;
+				length -= readBytes;
+			}
+		}
+
+		qint64 StreamingSecretBox::getDecryptedSize(qint64 encryptedSize) {
+			return encryptedSize - crypto_secretbox_MACBYTES;
+		}
+
+		void StreamingSecretBox::decrypt(QIODevice& source, qint64 encryptedSize, QIODevice& sink, openmittsu::crypto::EncryptionKey const& encryptionKey, openmittsu::crypto::Nonce const& nonce) {
+			if (getDecryptedSize(encryptedSize) < 1) {
+				throw openmittsu::exceptions::CryptoException() << "Failed to decrypt data: Cipher text too short.";
+			}
+
+			unsigned char const* const key = encryptionKey.getEncryptionKeyAsCharPtr();
+			unsigned char const* const nonceBytes = nonce.getNonceAsCharPtr();
+
+			// The first key stream block holds the Poly1305 key and the key stream for the first 32 bytes of cipher text.
+			unsigned char firstBlock[64];
+			crypto_stream_xsalsa20(firstBlock, sizeof(firstBlock), nonceBytes, key);
+
+			crypto_onetimeauth_poly1305_state authenticatorState;
+			crypto_onetimeauth_poly1305_init(&authenticatorState, firstBlock);
+
+			unsigned char mac[crypto_secretbox_MACBYTES];
+			readFully(source, reinterpret_cast<char*>(mac), crypto_secretbox_MACBYTES);
+
+			QByteArray buffer(OPENMITTSU_STREAMINGSECRETBOX_CHUNK_SIZE, 0x00);
+			unsigned char* const chunk = reinterpret_cast<unsigned char*>(buffer.data());
+
+			qint64 remaining = getDecryptedSize(encryptedSize);
+			bool isFirstChunk = true;
+			uint64_t nextBlock = 1;
+			while (remaining > 0) {
+				qint64 const chunkSize = std::min<qint64>(remaining, isFirstChunk ? 32 : OPENMITTSU_STREAMINGSECRETBOX_CHUNK_SIZE);
+				readFully(source, buffer.data(), chunkSize);
+				crypto_onetimeauth_poly1305_update(&authenticatorState, chunk, static_cast<unsigned long long>(chunkSize));
+
+				if (isFirstChunk) {
+					for (qint64 i = 0; i < chunkSize; ++i) {
+						chunk[i] ^= firstBlock[32 + i];
+					}
+					isFirstChunk = false;
+				} else {
+					crypto_stream_xsalsa20_xor_ic(chunk, chunk, static_cast<unsigned long long>(chunkSize), nonceBytes, nextBlock, key);
+					nextBlock += static_cast<uint64_t>(chunkSize / 64);
+				}
+
+				if (sink.write(buffer.constData(), chunkSize) != chunkSize) {
+					sodium_memzero(firstBlock, sizeof(firstBlock));
+					throw openmittsu::exceptions::CryptoException() << "Failed to decrypt data: Could not write plain text.";
+				}
+				remaining -= chunkSize;
+			}
+			sodium_memzero(firstBlock, sizeof(firstBlock));
+
+			unsigned char computedMac[crypto_secretbox_MACBYTES];
+			crypto_onetimeauth_poly1305_final(&authenticatorState, computedMac);
+			if (sodium_memcmp(mac, computedMac, crypto_secretbox_MACBYTES) != 0) {
+				throw openmittsu::exceptions::CryptoException() << "Failed to decrypt data for key and fixed nonce.";
+			}
+		}
+
+	}
+}
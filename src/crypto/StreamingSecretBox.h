@@ -0,0 +1,32 @@
+#ifndef OPENMITTSU_CRYPTO_STREAMINGSECRETBOX_H_
+#define OPENMITTSU_CRYPTO_STREAMINGSECRETBOX_H_
+
+#include <QIODevice>
+#include <QtGlobal>
+
+#include "src/crypto/EncryptionKey.h"
+#include "src/crypto/Nonce.h"
+
+namespace openmittsu {
+	namespace crypto {
+
+		/**
+		 * Opens a crypto_secretbox (XSalsa20-Poly1305, MAC first) chunk by chunk, so a blob never has to be held in memory as a whole.
+		 * The output is byte-identical to crypto_secretbox_open_easy, but it is written to the sink before the MAC could be checked:
+		 * if decrypt() throws, everything written to the sink must be discarded.
+		 */
+		class StreamingSecretBox {
+		public:
+			/**
+			 * Reads encryptedSize bytes (MAC plus cipher text) from source and writes the plain text to sink.
+			 * @throws CryptoException if the input is too short, could not be read or written, or does not authenticate.
+			 */
+			static void decrypt(QIODevice& source, qint64 encryptedSize, QIODevice& sink, openmittsu::crypto::EncryptionKey const& encryptionKey, openmittsu::crypto::Nonce const& nonce);
+
+			static qint64 getDecryptedSize(qint64 encryptedSize);
+		};
+
+	}
+}
+
+#endif // OPENMITTSU_CRYPTO_STREAMINGSECRETBOX_H_
@@ -22,12 +22,16 @@
 
 #include "Config.h"
 
+#define OPENMITTSU_DATABASE_STATEMENT_CACHE_CAPACITY (128)
+#define OPENMITTSU_DATABASE_WRITE_BATCH_WINDOW_MS (25)
+#define OPENMITTSU_DATABASE_WRITE_BATCH_MAX_OPERATIONS (256)
+
 namespace openmittsu {
 	namespace database {
 
 		using namespace openmittsu::dataproviders::messages;
 
-Database::Database(QString const& filename, QString const& password, QDir const& mediaStorageLocation) : MessageStorage(), database(), m_driverNameCrypto("QSQLCIPHER"), m_driverNameStandard("QSQLITE"), m_connectionName("openMittsuDatabaseConnection"), m_password(password), m_selfContact(0), m_selfLongTermKeyPair(), m_identityBackup(), m_contactAndGroupDataProvider(*this), m_mediaFileStorage(mediaStorageLocation, *this) {
+Database::Database(QString const& filename, QString const& password, QDir const& mediaStorageLocation) : MessageStorage(), database(), m_statementCache(OPENMITTSU_DATABASE_STATEMENT_CACHE_CAPACITY), m_driverNameCrypto("QSQLCIPHER"), m_driverNameStandard("QSQLITE"), m_connectionName("openMittsuDatabaseConnection"), m_password(password), m_selfContact(0), m_selfLongTermKeyPair(), m_identityBackup(), m_contactAndGroupDataProvider(*this), m_mediaFileStorage(mediaStorageLocation, *this), m_writeBatcher(OPENMITTSU_DATABASE_WRITE_BATCH_MAX_OPERATIONS) {
 	if (!(QSqlDatabase::isDriverAvailable(m_driverNameCrypto) || QSqlDatabase::isDriverAvailable(m_driverNameStandard))) {
 		throw openmittsu::exceptions::InternalErrorException() << "Neither the SQL driver " << m_driverNameCrypto.toStdString() << " nor the driver " << m_driverNameStandard.toStdString() << " are available. Available are: " << QSqlDatabase::drivers().join(", ").toStdString();
 	}
@@ -78,9 +82,10 @@ Database::Database(QString const& filename, QString const& password, QDir const&
 	}
 
 	setupQueueTimer();
+	setupWriteBatchTimer();
 }
 
-Database::Database(QString const& filename, openmittsu::protocol::ContactId const& selfContact, openmittsu::crypto::KeyPair const& selfLongTermKeyPair, QString const& password, QDir const& mediaStorageLocation) : MessageStorage(), database(), m_driverNameCrypto("QSQLCIPHER"), m_driverNameStandard("QSQLITE"), m_connectionName("openMittsuDatabaseConnection"), m_password(password), m_selfContact(selfContact), m_selfLongTermKeyPair(selfLongTermKeyPair), m_identityBackup(std::make_unique<openmittsu::backup::IdentityBackup>(selfContact, selfLongTermKeyPair)), m_contactAndGroupDataProvider(*this), m_mediaFileStorage(mediaStorageLocation, *this) {
+Database::Database(QString const& filename, openmittsu::protocol::ContactId const& selfContact, openmittsu::crypto::KeyPair const& selfLongTermKeyPair, QString const& password, QDir const& mediaStorageLocation) : MessageStorage(), database(), m_statementCache(OPENMITTSU_DATABASE_STATEMENT_CACHE_CAPACITY), m_driverNameCrypto("QSQLCIPHER"), m_driverNameStandard("QSQLITE"), m_connectionName("openMittsuDatabaseConnection"), m_password(password), m_selfContact(selfContact), m_selfLongTermKeyPair(selfLongTermKeyPair), m_identityBackup(std::make_unique<openmittsu::backup::IdentityBackup>(selfContact, selfLongTermKeyPair)), m_contactAndGroupDataProvider(*this), m_mediaFileStorage(mediaStorageLocation, *this), m_writeBatcher(OPENMITTSU_DATABASE_WRITE_BATCH_MAX_OPERATIONS) {
 	if (!(QSqlDatabase::isDriverAvailable(m_driverNameCrypto) || QSqlDatabase::isDriverAvailable(m_driverNameStandard))) {
 		throw openmittsu::exceptions::InternalErrorException() << "Neither the SQL driver " << m_driverNameCrypto.toStdString() << " nor the driver " << m_driverNameStandard.toStdString() << " are available. Available are: " << QSqlDatabase::drivers().join(", ").toStdString();
 	}
@@ -129,9 +134,18 @@ Database::Database(QString const& filename, openmittsu::protocol::ContactId cons
 		}
 	}
 	setupQueueTimer();
+	setupWriteBatchTimer();
 }
 
 Database::~Database() {
+	if (database.isOpen()) {
+		commitWriteBatch();
+	}
+
+	// Prepared statements have to be finalized before the connection is closed.
+	LOGGER_DEBUG("Prepared statement cache had {} hits and {} misses.", m_statementCache.getHitCount(), m_statementCache.getMissCount());
+	m_statementCache.clear();
+
 	if (database.isOpen()) {
 		database.close();
 		database.removeDatabase(m_connectionName);
@@ -186,6 +200,74 @@ void Database::onQueueTimeoutTimerFire() {
 	}
 }
 
+void Database::setupWriteBatchTimer() {
+	m_writeBatchTimer.setSingleShot(true);
+	m_writeBatchTimer.setInterval(OPENMITTSU_DATABASE_WRITE_BATCH_WINDOW_MS);
+	OPENMITTSU_CONNECT(&m_writeBatchTimer, timeout(), this, onWriteBatchTimerFire());
+}
+
+void Database::onWriteBatchTimerFire() {
+	commitWriteBatch();
+}
+
+void Database::beginBatchedWrite() {
+	if (m_writeBatcher.beginOperation()) {
+		if (!database.transaction()) {
+			LOGGER()->warn("Could not start a transaction for batched writes, writing without one. Error: {}", database.lastError().text().toStdString());
+			m_writeBatcher.clear();
+			return;
+		}
+		m_writeBatchTimer.start();
+	}
+}
+
+void Database::endBatchedWrite() {
+	if (m_writeBatcher.endOperation()) {
+		commitWriteBatch();
+	}
+}
+
+void Database::commitWriteBatch() {
+	if (!m_writeBatcher.isOpen()) {
+		return;
+	}
+
+	m_writeBatchTimer.stop();
+	int const operationCount = m_writeBatcher.getOperationCount();
+	if (!database.commit()) {
+		LOGGER()->error("Could not commit a batch of {} writes, rolling back. Error: {}", operationCount, database.lastError().text().toStdString());
+		database.rollback();
+		QList<std::function<void()>> const rollbackHandlers = m_writeBatcher.takeRollbackHandlers();
+		for (auto const& rollbackHandler : rollbackHandlers) {
+			rollbackHandler();
+		}
+		return;
+	}
+
+	LOGGER_DEBUG("Committed a batch of {} writes.", operationCount);
+	QList<std::function<void()>> const notifications = m_writeBatcher.takeNotifications();
+	for (auto const& notification : notifications) {
+		notification();
+	}
+}
+
+void Database::notifyAfterCommit(std::function<void()> const& notification) {
+	if (m_writeBatcher.isOpen()) {
+		m_writeBatcher.addNotification(notification);
+	} else {
+		notification();
+	}
+}
+
+void Database::runAfterCommit(std::function<void()> const& onCommitted, std::function<void()> const& onRolledBack) {
+	if (m_writeBatcher.isOpen()) {
+		m_writeBatcher.addNotification(onCommitted);
+		m_writeBatcher.addRollbackHandler(onRolledBack);
+	} else {
+		onCommitted();
+	}
+}
+
 QString Database::getDefaultDatabaseFileName() {
 	return QStringLiteral("openmittsu.sqlite");
 }
@@ -214,6 +296,9 @@ QString Database::getCreateStatementForTable(Tables const& table) {
 		case Tables::Media:
 			sqlFile.setFileName(QStringLiteral(":/sql/CreateMedia.sql"));
 			break;
+		case Tables::PendingMessages:
+			sqlFile.setFileName(QStringLiteral(":/sql/CreatePendingMessages.sql"));
+			break;
 		case Tables::Settings:
 			sqlFile.setFileName(QStringLiteral(":/sql/CreateSettings.sql"));
 			break;
@@ -259,6 +344,9 @@ QString Database::getTableName(Tables const& table) {
 		case Tables::Media:
 			return QStringLiteral("media");
 			break;
+		case Tables::PendingMessages:
+			return QStringLiteral("pending_messages");
+			break;
 		case Tables::Settings:
 			return QStringLiteral("settings");
 			break;
@@ -274,8 +362,8 @@ QString Database::getTableName(Tables const& table) {
 }
 
 bool Database::doesTableExist(Tables const& table) {
-	QSqlQuery tableExistanceQuery(database);
-	tableExistanceQuery.prepare("SELECT `name` FROM `sqlite_master` WHERE `type` = 'table' AND `name` = :tableName");
+	PreparedStatementCache::CachedQuery cachedTableExistanceQuery(prepareCachedQuery("SELECT `name` FROM `sqlite_master` WHERE `type` = 'table' AND `name` = :tableName"));
+	QSqlQuery& tableExistanceQuery = cachedTableExistanceQuery.get();
 
 	QString const tableName(getTableName(table));
 	tableExistanceQuery.bindValue(QStringLiteral(":tableName"), QVariant(tableName));
@@ -334,6 +422,43 @@ int Database::getTableVersion(Tables const& table) {
 	throw openmittsu::exceptions::InternalErrorException() << "Could not look up table version data for table '" << tableName.toStdString() << "'. Query error: " << query.lastError().text().toStdString();
 }
 
+QStringList Database::getUpgradeStatementsForTable(Tables const& table, int targetVersion) {
+	QString baseName;
+	switch (table) {
+		case Tables::ContactMessages:
+			baseName = QStringLiteral("ContactMessages");
+			break;
+		case Tables::ControlMessages:
+			baseName = QStringLiteral("ContactControlMessages");
+			break;
+		case Tables::GroupMessages:
+			baseName = QStringLiteral("GroupMessages");
+			break;
+		default:
+			throw openmittsu::exceptions::InternalErrorException() << "No upgrades known for table '" << getTableName(table).toStdString() << "' to version " << targetVersion << ".";
+	}
+
+	QFile sqlFile(QStringLiteral(":/sql/Upgrade%1ToVersion%2.sql").arg(baseName).arg(targetVersion));
+	if (!sqlFile.exists() || !sqlFile.open(QFile::ReadOnly)) {
+		throw openmittsu::exceptions::InternalErrorException() << "Could not find or open the file \"" << sqlFile.fileName().toStdString() << "\" containg the upgrade statements for table '" << getTableName(table).toStdString() << "'.";
+	}
+
+	QTextStream fileStream(&sqlFile);
+	QString const statements = fileStream.readAll();
+	sqlFile.close();
+
+	// QSqlQuery only executes the first statement of a string, so the upgrade files are split up. They do not contain string literals with semicolons.
+	QStringList result;
+	for (QString const& statement : statements.split(QChar(';'), QString::SkipEmptyParts)) {
+		QString const trimmedStatement = statement.trimmed();
+		if (!trimmedStatement.isEmpty()) {
+			result.append(trimmedStatement);
+		}
+	}
+
+	return result;
+}
+
 int Database::createTableIfMissingAndGetVersion(Tables const& table, int createStatementVersion) {
 	if (!doesTableExist(table)) {
 		QSqlQuery query(database);
@@ -348,46 +473,72 @@ int Database::createTableIfMissingAndGetVersion(Tables const& table, int createS
 	return currentTableVersion;
 }
 
-void Database::createOrUpdateTables() {
-	int versionTableVersions = createTableIfMissingAndGetVersion(Tables::TableVersions, 1);
-	int versionTableContacts = createTableIfMissingAndGetVersion(Tables::Contacts, 1);
-	int versionTableContactMessages = createTableIfMissingAndGetVersion(Tables::ContactMessages, 1);
-	int versionTableControlMessages = createTableIfMissingAndGetVersion(Tables::ControlMessages, 1);
-	int versionTableFeatureLevels = createTableIfMissingAndGetVersion(Tables::FeatureLevels, 1);
-	int versionTableGroups = createTableIfMissingAndGetVersion(Tables::Groups, 1);
-	int versionTableGroupMessages = createTableIfMissingAndGetVersion(Tables::GroupMessages, 1);
-	int versionTableMedia = createTableIfMissingAndGetVersion(Tables::Media, 1);
-	int versionTableSettings = createTableIfMissingAndGetVersion(Tables::Settings, 1);
-
-	if (versionTableVersions != 1) {
-		LOGGER()->warn("Table TableVersions has version {} instead of {}.", versionTableVersions, 1);
-	}
-	if (versionTableContacts != 1) {
-		LOGGER()->warn("Table Contacts has version {} instead of {}.", versionTableContacts, 1);
-	}
-	if (versionTableContactMessages != 1) {
-		LOGGER()->warn("Table ContactMessages has version {} instead of {}.", versionTableContactMessages, 1);
-	}
-	if (versionTableControlMessages != 1) {
-		LOGGER()->warn("Table ControlMessages has version {} instead of {}.", versionTableControlMessages, 1);
-	}
-	if (versionTableFeatureLevels != 1) {
-		LOGGER()->warn("Table FeatureLevels has version {} instead of {}.", versionTableFeatureLevels, 1);
-	}
-	if (versionTableGroups != 1) {
-		LOGGER()->warn("Table Groups has version {} instead of {}.", versionTableGroups, 1);
-	}
-	if (versionTableGroupMessages != 1) {
-		LOGGER()->warn("Table GroupMessages has version {} instead of {}.", versionTableGroupMessages, 1);
+void Database::createOrUpgradeTable(Tables const& table, int currentVersion) {
+	QString const tableName = getTableName(table);
+	int tableVersion = createTableIfMissingAndGetVersion(table, 1);
+	if (tableVersion > currentVersion) {
+		LOGGER()->warn("Table {} has version {}, which is newer than the supported version {}.", tableName.toStdString(), tableVersion, currentVersion);
+		return;
 	}
-	if (versionTableMedia != 1) {
-		LOGGER()->warn("Table Media has version {} instead of {}.", versionTableMedia, 1);
+
+	while (tableVersion < currentVersion) {
+		int const targetVersion = tableVersion + 1;
+		LOGGER()->info("Upgrading table {} from version {} to version {}.", tableName.toStdString(), tableVersion, targetVersion);
+		QStringList const statements = getUpgradeStatementsForTable(table, targetVersion);
+
+		if (!database.transaction()) {
+			throw openmittsu::exceptions::InternalErrorException() << "Could not start transaction for upgrading table '" << tableName.toStdString() << "' to version " << targetVersion << ". Error: " << database.lastError().text().toStdString();
+		}
+
+		for (QString const& statement : statements) {
+			QSqlQuery query(database);
+			if (!query.exec(statement)) {
+				QString const error = query.lastError().text();
+				database.rollback();
+				throw openmittsu::exceptions::InternalErrorException() << "Could not upgrade table '" << tableName.toStdString() << "' to version " << targetVersion << ". Statement: " << statement.toStdString() << ", Query error: " << error.toStdString();
+			}
+		}
+		try {
+			setTableVersion(table, targetVersion);
+		} catch (openmittsu::exceptions::InternalErrorException&) {
+			database.rollback();
+			throw;
+		}
+
+		if (!database.commit()) {
+			QString const error = database.lastError().text();
+			database.rollback();
+			throw openmittsu::exceptions::InternalErrorException() << "Could not commit upgrade of table '" << tableName.toStdString() << "' to version " << targetVersion << ". Error: " << error.toStdString();
+		}
+		tableVersion = targetVersion;
 	}
-	if (versionTableSettings != 1) {
-		LOGGER()->warn("Table Settings has version {} instead of {}.", versionTableSettings, 1);
+}
+
+void Database::createOrUpdateTables() {
+	createOrUpgradeTable(Tables::TableVersions, 1);
+	createOrUpgradeTable(Tables::Contacts, 1);
+	createOrUpgradeTable(Tables::ContactMessages, 2);
+	createOrUpgradeTable(Tables::ControlMessages, 2);
+	createOrUpgradeTable(Tables::FeatureLevels, 1);
+	createOrUpgradeTable(Tables::Groups, 1);
+	createOrUpgradeTable(Tables::GroupMessages, 2);
+	createOrUpgradeTable(Tables::Media, 1);
+	createOrUpgradeTable(Tables::PendingMessages, 1);
+	createOrUpgradeTable(Tables::Settings, 1);
+
+	// Pending messages were never acknowledged, so the server delivers them again.
+	QSqlQuery query(database);
+	if (!query.exec(QStringLiteral("DELETE FROM `pending_messages`"))) {
+		throw openmittsu::exceptions::InternalErrorException() << "Could not clear the table 'pending_messages'. Query error: " << query.lastError().text().toStdString();
 	}
+}
+
+PreparedStatementCache::CachedQuery Database::prepareCachedQuery(QString const& sql) const {
+	return m_statementCache.prepare(database, sql);
+}
 
-	// No updates neccessary as of yet.
+PreparedStatementCache const& Database::getStatementCache() const {
+	return m_statementCache;
 }
 
 QString Database::generateUuid() const {
@@ -490,52 +641,66 @@ openmittsu::protocol::MessageId Database::storeSentContactMessageNotificationTyp
 }
 
 void Database::storeReceivedContactMessageText(openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, openmittsu::protocol::MessageTime const& timeReceived, QString const& message) {
+	beginBatchedWrite();
 	DatabaseContactMessage::insertContactMessageFromThem(*this, sender, messageId, generateUuid(), timeSent, timeReceived, ContactMessageType::TEXT, message, false, QStringLiteral(""));
+	endBatchedWrite();
 }
 
 void Database::storeReceivedContactMessageImage(openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, openmittsu::protocol::MessageTime const& timeReceived, QByteArray const& image, QString const& caption) {
+	beginBatchedWrite();
 	QString const uuid = insertMediaItem(image);
 	DatabaseContactMessage::insertContactMessageFromThem(*this, sender, messageId, uuid, timeSent, timeReceived, ContactMessageType::IMAGE, QStringLiteral(""), false, caption);
+	endBatchedWrite();
 }
 
 void Database::storeReceivedContactMessageLocation(openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, openmittsu::protocol::MessageTime const& timeReceived, openmittsu::utility::Location const& location) {
+	beginBatchedWrite();
 	DatabaseContactMessage::insertContactMessageFromThem(*this, sender, messageId, generateUuid(), timeSent, timeReceived, ContactMessageType::LOCATION, location.toDatabaseString(), false, location.getDescription());
+	endBatchedWrite();
 }
 
 void Database::storeReceivedContactMessageReceiptReceived(openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, openmittsu::protocol::MessageId const& referredMessageId) {
+	beginBatchedWrite();
 	try {
 		DatabaseContactMessage message(*this, sender, referredMessageId);
 		message.setMessageState(UserMessageState::DELIVERED, timeSent);
 	} catch (openmittsu::exceptions::InternalErrorException& iee) {
 		LOGGER()->warn("Could not saved received \"received\" receipt: {}", iee.what());
 	}
+	endBatchedWrite();
 }
 
 void Database::storeReceivedContactMessageReceiptSeen(openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, openmittsu::protocol::MessageId const& referredMessageId) {
+	beginBatchedWrite();
 	try {
 		DatabaseContactMessage message(*this, sender, referredMessageId);
 		message.setMessageState(UserMessageState::READ, timeSent);
 	} catch (openmittsu::exceptions::InternalErrorException& iee) {
 		LOGGER()->warn("Could not saved received \"seen\" receipt: {}", iee.what());
 	}
+	endBatchedWrite();
 }
 
 void Database::storeReceivedContactMessageReceiptAgree(openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, openmittsu::protocol::MessageId const& referredMessageId) {
+	beginBatchedWrite();
 	try {
 		DatabaseContactMessage message(*this, sender, referredMessageId);
 		message.setMessageState(UserMessageState::USERACK, timeSent);
 	} catch (openmittsu::exceptions::InternalErrorException& iee) {
 		LOGGER()->warn("Could not saved received \"agree\" receipt: {}", iee.what());
 	}
+	endBatchedWrite();
 }
 
 void Database::storeReceivedContactMessageReceiptDisagree(openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, openmittsu::protocol::MessageId const& referredMessageId) {
+	beginBatchedWrite();
 	try {
 		DatabaseContactMessage message(*this, sender, referredMessageId);
 		message.setMessageState(UserMessageState::USERDEC, timeSent);
 	} catch (openmittsu::exceptions::InternalErrorException& iee) {
 		LOGGER()->warn("Could not saved received \"disagree\" receipt: {}", iee.what());
 	}
+	endBatchedWrite();
 }
 
 void Database::storeReceivedContactTypingNotificationTyping(openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent) {
@@ -555,23 +720,30 @@ void Database::storeReceivedContactTypingNotificationStopped(openmittsu::protoco
 }
 
 void Database::storeReceivedGroupMessageText(openmittsu::protocol::GroupId const& group, openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, openmittsu::protocol::MessageTime const& timeReceived, QString const& message) {
+	beginBatchedWrite();
 	DatabaseGroupMessage::insertGroupMessageFromThem(*this, group, sender, messageId, generateUuid(), timeSent, timeReceived, GroupMessageType::TEXT, message, false, QStringLiteral(""));
+	endBatchedWrite();
 }
 
 void Database::storeReceivedGroupMessageImage(openmittsu::protocol::GroupId const& group, openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, openmittsu::protocol::MessageTime const& timeReceived, QByteArray const& image, QString const& caption) {
+	beginBatchedWrite();
 	if (!hasGroup(group)) {
 		throw openmittsu::exceptions::InternalErrorException() << "Could not save group image message, the given group " << group.toString() << " is unknown!";
 	}
 
 	QString const uuid = insertMediaItem(image);
 	DatabaseGroupMessage::insertGroupMessageFromThem(*this, group, sender, messageId, uuid, timeSent, timeReceived, GroupMessageType::IMAGE, QStringLiteral(""), false, caption);
+	endBatchedWrite();
 }
 
 void Database::storeReceivedGroupMessageLocation(openmittsu::protocol::GroupId const& group, openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, openmittsu::protocol::MessageTime const& timeReceived, openmittsu::utility::Location const& location) {
+	beginBatchedWrite();
 	DatabaseGroupMessage::insertGroupMessageFromThem(*this, group, sender, messageId, generateUuid(), timeSent, timeReceived, GroupMessageType::LOCATION, location.toDatabaseString(), false, location.getDescription());
+	endBatchedWrite();
 }
 
 void Database::storeReceivedGroupLeave(openmittsu::protocol::GroupId const& group, openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, openmittsu::protocol::MessageTime const& timeReceived) {
+	beginBatchedWrite();
 	if (!hasGroup(group)) {
 		throw openmittsu::exceptions::InternalErrorException() << "The given group " << group.toString() << " is not known, can not store group leave request!";
 	}
@@ -581,9 +753,11 @@ void Database::storeReceivedGroupLeave(openmittsu::protocol::GroupId const& grou
 	QSet<openmittsu::protocol::ContactId> currentMembers = m_contactAndGroupDataProvider.getGroupMembers(group, false);
 	currentMembers.remove(sender);
 	m_contactAndGroupDataProvider.setGroupMembers(group, currentMembers);
+	endBatchedWrite();
 }
 
 void Database::storeReceivedGroupSyncRequest(openmittsu::protocol::GroupId const& group, openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, openmittsu::protocol::MessageTime const& timeReceived) {
+	beginBatchedWrite();
 	if (!hasGroup(group)) {
 		throw openmittsu::exceptions::InternalErrorException() << "The given group " << group.toString() << " is not known, can not store group sync request!";
 	} else if (!(group.getOwner() == getSelfContact())) {
@@ -591,9 +765,11 @@ void Database::storeReceivedGroupSyncRequest(openmittsu::protocol::GroupId const
 	}
 
 	DatabaseGroupMessage::insertGroupMessageFromThem(*this, group, sender, messageId, generateUuid(), timeSent, timeReceived, GroupMessageType::SYNC_REQUEST, QStringLiteral(""), true, QStringLiteral(""));
+	endBatchedWrite();
 }
 
 void Database::storeReceivedGroupSetTitle(openmittsu::protocol::GroupId const& group, openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, openmittsu::protocol::MessageTime const& timeReceived, QString const& title) {
+	beginBatchedWrite();
 	if (!hasGroup(group)) {
 		throw openmittsu::exceptions::InternalErrorException() << "The given group " << group.toString() << " is not known, can not set group title!";
 	} else if (!(group.getOwner() == sender)) {
@@ -602,9 +778,11 @@ void Database::storeReceivedGroupSetTitle(openmittsu::protocol::GroupId const& g
 		DatabaseGroupMessage::insertGroupMessageFromThem(*this, group, sender, messageId, generateUuid(), timeSent, timeReceived, GroupMessageType::SET_TITLE, title, true, QStringLiteral(""));
 		m_contactAndGroupDataProvider.setGroupTitle(group, title);
 	}
+	endBatchedWrite();
 }
 
 void Database::storeReceivedGroupSetImage(openmittsu::protocol::GroupId const& group, openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, openmittsu::protocol::MessageTime const& timeReceived, QByteArray const& image) {
+	beginBatchedWrite();
 	if (!hasGroup(group)) {
 		throw openmittsu::exceptions::InternalErrorException() << "The given group " << group.toString() << " is not known, can not set group image!";
 	} else if (!(group.getOwner() == sender)) {
@@ -614,9 +792,11 @@ void Database::storeReceivedGroupSetImage(openmittsu::protocol::GroupId const& g
 		DatabaseGroupMessage::insertGroupMessageFromThem(*this, group, sender, messageId, uuid, timeSent, timeReceived, GroupMessageType::SET_IMAGE, QStringLiteral(""), true, QStringLiteral(""));
 		m_contactAndGroupDataProvider.setGroupImage(group, image);
 	}
+	endBatchedWrite();
 }
 
 void Database::storeReceivedGroupCreation(openmittsu::protocol::GroupId const& group, openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, openmittsu::protocol::MessageTime const& timeReceived, QSet<openmittsu::protocol::ContactId> const& members) {
+	beginBatchedWrite();
 	if (!(group.getOwner() == sender)) {
 		throw openmittsu::exceptions::InternalErrorException() << "The given group " << group.toString() << " is owned by " << group.getOwner().toString() << ", can not store group group creation from " << sender.toString() << "!";
 	}
@@ -632,9 +812,11 @@ void Database::storeReceivedGroupCreation(openmittsu::protocol::GroupId const& g
 	DatabaseGroupMessage::insertGroupMessageFromThem(*this, group, sender, messageId, generateUuid(), timeSent, timeReceived, GroupMessageType::GROUP_CREATION, result, true, QStringLiteral(""));
 	
 	m_contactAndGroupDataProvider.addGroup(group, "", timeSent, members, false, false);
+	endBatchedWrite();
 }
 
 void Database::storeMessageSendFailed(openmittsu::protocol::ContactId const& receiver, openmittsu::protocol::MessageId const& messageId) {
+	beginBatchedWrite();
 	if (DatabaseControlMessage::exists(*this, receiver, messageId)) {
 		DatabaseControlMessage message(DatabaseControlMessage::fromReceiverAndControlMessageId(*this, receiver, messageId));
 		message.setMessageState(ControlMessageState::SENDFAILED, openmittsu::protocol::MessageTime::now());
@@ -642,9 +824,11 @@ void Database::storeMessageSendFailed(openmittsu::protocol::ContactId const& rec
 		DatabaseContactMessage message(*this, receiver, messageId);
 		message.setMessageState(UserMessageState::SENDFAILED, openmittsu::protocol::MessageTime::now());
 	}
+	endBatchedWrite();
 }
 
 void Database::storeMessageSendDone(openmittsu::protocol::ContactId const& receiver, openmittsu::protocol::MessageId const& messageId) {
+	beginBatchedWrite();
 	if (DatabaseControlMessage::exists(*this, receiver, messageId)) {
 		DatabaseControlMessage message(DatabaseControlMessage::fromReceiverAndControlMessageId(*this, receiver, messageId));
 		message.setMessageState(ControlMessageState::SENT, openmittsu::protocol::MessageTime::now());
@@ -652,16 +836,21 @@ void Database::storeMessageSendDone(openmittsu::protocol::ContactId const& recei
 		DatabaseContactMessage message(*this, receiver, messageId);
 		message.setMessageState(UserMessageState::SENT, openmittsu::protocol::MessageTime::now());
 	}
+	endBatchedWrite();
 }
 
 void Database::storeMessageSendFailed(openmittsu::protocol::GroupId const& group, openmittsu::protocol::MessageId const& messageId) {
+	beginBatchedWrite();
 	DatabaseGroupMessage message(*this, group, messageId);
 	message.setMessageState(UserMessageState::SENDFAILED, openmittsu::protocol::MessageTime::now());
+	endBatchedWrite();
 }
 
 void Database::storeMessageSendDone(openmittsu::protocol::GroupId const& group, openmittsu::protocol::MessageId const& messageId) {
+	beginBatchedWrite();
 	DatabaseGroupMessage message(*this, group, messageId);
 	message.setMessageState(UserMessageState::SENT, openmittsu::protocol::MessageTime::now());
+	endBatchedWrite();
 }
 
 void Database::storeContactMessagesFromBackup(QList<openmittsu::backup::ContactMessageBackupObject> const& messages) {
@@ -827,8 +1016,8 @@ openmittsu::protocol::ContactStatus Database::getContactStatus(openmittsu::proto
 }
 
 QString Database::getOptionValueInternal(QString const& optionName, bool isInternalOption) {
-	QSqlQuery query(database);
-	query.prepare(QStringLiteral("SELECT `value` FROM `settings` WHERE `is_internal` = :isInternal AND `name` = :name"));
+	PreparedStatementCache::CachedQuery cachedQuery(prepareCachedQuery(QStringLiteral("SELECT `value` FROM `settings` WHERE `is_internal` = :isInternal AND `name` = :name")));
+	QSqlQuery& query = cachedQuery.get();
 	query.bindValue(QStringLiteral(":name"), QVariant(optionName));
 	query.bindValue(QStringLiteral(":isInternal"), QVariant(((isInternalOption) ? 1 : 0)));
 
@@ -842,8 +1031,8 @@ QString Database::getOptionValueInternal(QString const& optionName, bool isInter
 }
 
 bool Database::hasOptionInternal(QString const& optionName, bool isInternalOption) {
-	QSqlQuery query(database);
-	query.prepare(QStringLiteral("SELECT `value` FROM `settings` WHERE `is_internal` = :isInternal AND `name` = :name"));
+	PreparedStatementCache::CachedQuery cachedQuery(prepareCachedQuery(QStringLiteral("SELECT `value` FROM `settings` WHERE `is_internal` = :isInternal AND `name` = :name")));
+	QSqlQuery& query = cachedQuery.get();
 	query.bindValue(QStringLiteral(":name"), QVariant(optionName));
 	query.bindValue(QStringLiteral(":isInternal"), QVariant(((isInternalOption) ? 1 : 0)));
 
@@ -866,8 +1055,8 @@ void Database::setOptionInternal(QString const& optionName, QString const& optio
 			throw openmittsu::exceptions::InternalErrorException() << "Could not update settings value in 'settings'. Query error: " << query.lastError().text().toStdString();
 		}
 	} else {
-		QSqlQuery query(database);
-		query.prepare(QStringLiteral("INSERT INTO `settings` (`name`, `is_internal`, `value`) VALUES (:name, :isInternal, :newValue);"));
+		PreparedStatementCache::CachedQuery cachedQuery(prepareCachedQuery(QStringLiteral("INSERT INTO `settings` (`name`, `is_internal`, `value`) VALUES (:name, :isInternal, :newValue);")));
+		QSqlQuery& query = cachedQuery.get();
 		query.bindValue(QStringLiteral(":name"), QVariant(optionName));
 		query.bindValue(QStringLiteral(":newValue"), QVariant(optionValue));
 		query.bindValue(QStringLiteral(":isInternal"), QVariant((isInternalOption) ? 1 : 0));
@@ -908,6 +1097,17 @@ QByteArray Database::getOptionValueAsByteArray(QString const& optionName) {
 	return QByteArray::fromHex(value.toUtf8());
 }
 
+int Database::getOptionValueAsInt(QString const& optionName) {
+	QString const value = getOptionValueInternal(optionName, false);
+	bool ok = false;
+	int const result = value.toInt(&ok);
+	if (!ok) {
+		throw openmittsu::exceptions::InternalErrorException() << "Could not convert value \"" << value.toStdString() << "\" of option " << optionName.toStdString() << " into an integer.";
+	}
+
+	return result;
+}
+
 void Database::setOptionValue(QString const& optionName, QString const& optionValue) {
 	setOptionInternal(optionName, optionValue, false);
 }
@@ -924,6 +1124,10 @@ void Database::setOptionValue(QString const& optionName, QByteArray const& optio
 	setOptionInternal(optionName, QString(optionValue.toHex()), false);
 }
 
+void Database::setOptionValue(QString const& optionName, int const& optionValue) {
+	setOptionInternal(optionName, QString::number(optionValue), false);
+}
+
 MediaFileItem Database::getMediaItem(QString const& uuid) const {
 	return m_mediaFileStorage.getMediaItem(uuid);
 }
@@ -1123,43 +1327,85 @@ DatabaseGroupMessageCursor Database::getMessageCursor(openmittsu::protocol::Grou
 }
 
 void Database::announceMessageChanged(QString const& uuid) {
-	LOGGER_DEBUG("Database: Announcing messageChanged() for UUID {}.", uuid.toStdString());
-	emit messageChanged(uuid);
+	notifyAfterCommit([this, uuid]() {
+		LOGGER_DEBUG("Database: Announcing messageChanged() for UUID {}.", uuid.toStdString());
+		emit messageChanged(uuid);
+	});
 }
 
 void Database::announceContactChanged(openmittsu::protocol::ContactId const& contact) {
-	emit contactChanged(contact);
+	notifyAfterCommit([this, contact]() { emit contactChanged(contact); });
 }
 
 void Database::announceGroupChanged(openmittsu::protocol::GroupId const& group) {
-	emit groupChanged(group);
+	notifyAfterCommit([this, group]() { emit groupChanged(group); });
 }
 
 void Database::announceNewMessage(openmittsu::protocol::ContactId const& contact, QString const& messageUuid) {
-	emit contactHasNewMessage(contact, messageUuid);
+	notifyAfterCommit([this, contact, messageUuid]() { emit contactHasNewMessage(contact, messageUuid); });
 }
 
 void Database::announceNewMessage(openmittsu::protocol::GroupId const& group, QString const& messageUuid) {
-	emit groupHasNewMessage(group, messageUuid);
+	notifyAfterCommit([this, group, messageUuid]() { emit groupHasNewMessage(group, messageUuid); });
 }
 
 void Database::announceReceivedNewMessage(openmittsu::protocol::ContactId const& contact) {
-	emit receivedNewContactMessage(contact);
+	notifyAfterCommit([this, contact]() { emit receivedNewContactMessage(contact); });
 }
 
 void Database::announceReceivedNewMessage(openmittsu::protocol::GroupId const& group) {
-	emit receivedNewGroupMessage(group);
+	notifyAfterCommit([this, group]() { emit receivedNewGroupMessage(group); });
+}
+
+void Database::storePendingMessage(QString const& waitingFor, QByteArray const& message) {
+	PreparedStatementCache::CachedQuery cachedQuery(prepareCachedQuery(QStringLiteral("INSERT INTO `pending_messages` (`waiting_for`, `message`) VALUES (:waitingFor, :message);")));
+	QSqlQuery& query = cachedQuery.get();
+	query.bindValue(QStringLiteral(":waitingFor"), QVariant(waitingFor));
+	query.bindValue(QStringLiteral(":message"), QVariant(message));
+
+	if (!query.exec()) {
+		throw openmittsu::exceptions::InternalErrorException() << "Could not insert pending message for " << waitingFor.toStdString() << " into 'pending_messages'. Query error: " << query.lastError().text().toStdString();
+	}
+}
+
+QList<QByteArray> Database::getPendingMessages(QString const& waitingFor) {
+	QList<QByteArray> result;
+
+	PreparedStatementCache::CachedQuery cachedQuery(prepareCachedQuery(QStringLiteral("SELECT `message` FROM `pending_messages` WHERE `waiting_for` = :waitingFor ORDER BY `uid` ASC")));
+	QSqlQuery& query = cachedQuery.get();
+	query.bindValue(QStringLiteral(":waitingFor"), QVariant(waitingFor));
+	if (!query.exec() || !query.isSelect()) {
+		throw openmittsu::exceptions::InternalErrorException() << "Could not query pending messages for " << waitingFor.toStdString() << " from 'pending_messages'. Query error: " << query.lastError().text().toStdString();
+	}
+
+	while (query.next()) {
+		result.append(query.value(QStringLiteral("message")).toByteArray());
+	}
+
+	return result;
+}
+
+void Database::removePendingMessages(QString const& waitingFor) {
+	PreparedStatementCache::CachedQuery cachedQuery(prepareCachedQuery(QStringLiteral("DELETE FROM `pending_messages` WHERE `waiting_for` = :waitingFor")));
+	QSqlQuery& query = cachedQuery.get();
+	query.bindValue(QStringLiteral(":waitingFor"), QVariant(waitingFor));
+
+	if (!query.exec()) {
+		throw openmittsu::exceptions::InternalErrorException() << "Could not delete pending messages for " << waitingFor.toStdString() << " from 'pending_messages'. Query error: " << query.lastError().text().toStdString();
+	}
 }
 
 void Database::sendAllWaitingMessages(openmittsu::dataproviders::SentMessageAcceptor& messageAcceptor) {
+	// Stops early if the acceptor asks for a pause, the remaining messages are still unqueued and picked up by the next call.
 	{
 		QSqlQuery query(database);
+		query.setForwardOnly(true);
 		query.prepare(QStringLiteral("SELECT `identity`, `apiid`, `uid`, `created_at`, `contact_message_type`, `body`, `caption` FROM `contact_messages` WHERE `is_outbox` = 1 AND `is_queued` = 0 AND `is_sent` = 0;"));
 		if (!query.exec() || !query.isSelect()) {
 			throw openmittsu::exceptions::InternalErrorException() << "Could not execute message enumeration query for table contact_messages. Query error: " << query.lastError().text().toStdString();
 		} 
 
-		while (query.next()) {
+		while (messageAcceptor.isReadyForMoreMessages() && query.next()) {
 			ContactMessageType const messageType = ContactMessageTypeHelper::fromString(query.value(QStringLiteral("contact_message_type")).toString());
 			openmittsu::protocol::ContactId const receiver(query.value(QStringLiteral("identity")).toString());
 			openmittsu::protocol::MessageId const messageId(query.value(QStringLiteral("apiid")).toString());
@@ -1199,12 +1445,13 @@ void Database::sendAllWaitingMessages(openmittsu::dataproviders::SentMessageAcce
 	}
 	{
 		QSqlQuery query(database);
+		query.setForwardOnly(true);
 		query.prepare(QStringLiteral("SELECT `group_id`, `group_creator`, `apiid`, `uid`, `created_at`, `group_message_type`, `body`, `caption` FROM `group_messages` WHERE `is_outbox` = 1 AND `is_queued` = 0 AND `is_sent` = 0;"));
 		if (!query.exec() || !query.isSelect()) {
 			throw openmittsu::exceptions::InternalErrorException() << "Could not execute message enumeration query for table group_messages. Query error: " << query.lastError().text().toStdString();
 		}
 
-		while (query.next()) {
+		while (messageAcceptor.isReadyForMoreMessages() && query.next()) {
 			GroupMessageType const messageType = GroupMessageTypeHelper::fromString(query.value(QStringLiteral("group_message_type")).toString());
 			openmittsu::protocol::GroupId const group(openmittsu::protocol::ContactId(query.value(QStringLiteral("group_creator")).toString()), query.value(QStringLiteral("group_id")).toString());
 			openmittsu::protocol::MessageId const messageId(query.value(QStringLiteral("apiid")).toString());
@@ -1269,12 +1516,13 @@ void Database::sendAllWaitingMessages(openmittsu::dataproviders::SentMessageAcce
 	}
 	{
 		QSqlQuery query(database);
+		query.setForwardOnly(true);
 		query.prepare(QStringLiteral("SELECT `identity`, `apiid`, `related_message_apiid`, `uid`, `created_at`, `control_message_type` FROM `control_messages` WHERE `is_outbox` = 1 AND `is_queued` = 0 AND `is_sent` = 0;"));
 		if (!query.exec() || !query.isSelect()) {
 			throw openmittsu::exceptions::InternalErrorException() << "Could not execute message enumeration query for table control_messages. Query error: " << query.lastError().text().toStdString();
 		}
 
-		while (query.next()) {
+		while (messageAcceptor.isReadyForMoreMessages() && query.next()) {
 			ControlMessageType const messageType = ControlMessageTypeHelper::fromString(query.value(QStringLiteral("control_message_type")).toString());
 			openmittsu::protocol::ContactId const receiver(query.value(QStringLiteral("identity")).toString());
 			openmittsu::protocol::MessageId const messageId(query.value(QStringLiteral("apiid")).toString());
@@ -5,11 +5,14 @@
 #include <QList>
 #include <QHash>
 #include <QString>
+#include <QStringList>
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QTimer>
 
+#include <functional>
+
 #include "src/protocol/ContactId.h"
 #include "src/protocol/AccountStatus.h"
 #include "src/protocol/ContactIdVerificationStatus.h"
@@ -28,6 +31,8 @@
 #include "src/database/DatabaseGroupMessageCursor.h"
 #include "src/database/DatabaseMessage.h"
 #include "src/database/ExternalMediaFileStorage.h"
+#include "src/database/PreparedStatementCache.h"
+#include "src/database/WriteBatcher.h"
 #include "src/dataproviders/messages/ContactMessageType.h"
 #include "src/dataproviders/messages/ControlMessageType.h"
 #include "src/dataproviders/messages/GroupMessageType.h"
@@ -79,10 +84,12 @@ namespace openmittsu {
 			QString getOptionValueAsString(QString const& optionName);
 			bool getOptionValueAsBool(QString const& optionName);
 			QByteArray getOptionValueAsByteArray(QString const& optionName);
+			int getOptionValueAsInt(QString const& optionName);
 
 			void setOptionValue(QString const& optionName, QString const& optionValue);
 			void setOptionValue(QString const& optionName, bool const& optionValue);
 			void setOptionValue(QString const& optionName, QByteArray const& optionValue);
+			void setOptionValue(QString const& optionName, int const& optionValue);
 
 			virtual openmittsu::dataproviders::BackedContact getBackedContact(openmittsu::protocol::ContactId const& contact, openmittsu::dataproviders::MessageCenter& messageCenter) override;
 			virtual openmittsu::dataproviders::BackedGroup getBackedGroup(openmittsu::protocol::GroupId const& group, openmittsu::dataproviders::MessageCenter& messageCenter) override;
@@ -136,6 +143,17 @@ namespace openmittsu {
 
 			virtual void sendAllWaitingMessages(openmittsu::dataproviders::SentMessageAcceptor& messageAcceptor) override;
 
+			virtual void storePendingMessage(QString const& waitingFor, QByteArray const& message) override;
+			virtual QList<QByteArray> getPendingMessages(QString const& waitingFor) override;
+			virtual void removePendingMessages(QString const& waitingFor) override;
+
+			virtual void runAfterCommit(std::function<void()> const& onCommitted, std::function<void()> const& onRolledBack) override;
+
+			PreparedStatementCache const& getStatementCache() const;
+
+			/** Commits the writes batched so far and emits their notifications. Does nothing if no batch is open. If the commit fails, the batch is rolled back and its rollback handlers are run. */
+			void commitWriteBatch();
+
 			friend class DatabaseMessage;
 			friend class DatabaseContactMessage;
 			friend class DatabaseControlMessage;
@@ -218,6 +236,7 @@ namespace openmittsu {
 			void announceReceivedNewMessage(openmittsu::protocol::GroupId const& group);
 		private:
 			QSqlDatabase database;
+			mutable PreparedStatementCache m_statementCache;
 			QString const m_driverNameCrypto;
 			QString const m_driverNameStandard;
 			QString const m_connectionName;
@@ -234,6 +253,9 @@ namespace openmittsu {
 
 			QTimer queueTimeoutTimer;
 
+			WriteBatcher m_writeBatcher;
+			QTimer m_writeBatchTimer;
+
 			enum class Tables {
 				Contacts,
 				ContactMessages,
@@ -242,6 +264,7 @@ namespace openmittsu {
 				Groups,
 				GroupMessages,
 				Media,
+				PendingMessages,
 				Settings,
 				TableVersions,
 				SqliteMaster,
@@ -251,8 +274,12 @@ namespace openmittsu {
 			int getTableVersion(Tables const& table);
 			QString getTableName(Tables const& table);
 			QString generateUuid() const;
+			PreparedStatementCache::CachedQuery prepareCachedQuery(QString const& sql) const;
 			QString getCreateStatementForTable(Tables const& table);
+			QStringList getUpgradeStatementsForTable(Tables const& table, int targetVersion);
 			int createTableIfMissingAndGetVersion(Tables const& table, int createStatementVersion);
+			/** Creates the table in version 1 if missing and applies all upgrades up to currentVersion, each in its own transaction. */
+			void createOrUpgradeTable(Tables const& table, int currentVersion);
 			void setTableVersion(Tables const& table, int tableVersion);
 			void createOrUpdateTables();
 			QString getOptionValueInternal(QString const& optionName, bool isInternalOption = false);
@@ -263,10 +290,17 @@ namespace openmittsu {
 			QString insertMediaItem(QByteArray const& data);
 			void removeMediaItem(QString const& uuid);
 			void setupQueueTimer();
+			void setupWriteBatchTimer();
+			/** Received messages, receipts and status changes are grouped into one transaction, see commitWriteBatch(). If a write throws, its batch stays open until the timer commits it. */
+			void beginBatchedWrite();
+			void endBatchedWrite();
+			/** Runs the notification now, or after the commit if a write batch is open. */
+			void notifyAfterCommit(std::function<void()> const& notification);
 			void setKey(QString const& password);
 			void updateCachedIdentityBackup();
 		private slots:
 			void onQueueTimeoutTimerFire();
+			void onWriteBatchTimerFire();
 		};
 
 	}
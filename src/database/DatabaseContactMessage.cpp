@@ -15,11 +15,16 @@ namespace openmittsu {
 		using namespace openmittsu::dataproviders::messages;
 
 		DatabaseContactMessage::DatabaseContactMessage(Database& database, openmittsu::protocol::ContactId const& contact, openmittsu::protocol::MessageId const& messageId) : DatabaseMessage(database, messageId), DatabaseUserMessage(database, messageId), ContactMessage(), m_contact(contact) {
-			if (!exists(database, contact, messageId)) {
+			// Checks for existance and reads all fields at once.
+			if (!loadRow()) {
 				throw openmittsu::exceptions::InternalErrorException() << "No message from contact \"" << contact.toString() << "\" and message ID \"" << messageId.toString() << "\" exists, can not manipulate.";
 			}
 		}
 
+		DatabaseContactMessage::DatabaseContactMessage(Database& database, openmittsu::protocol::ContactId const& contact, DatabaseMessageRow const& row) : DatabaseMessage(database, row), DatabaseUserMessage(database, row), ContactMessage(), m_contact(contact) {
+			//
+		}
+
 		DatabaseContactMessage::~DatabaseContactMessage() {
 			//
 		}
@@ -37,8 +42,8 @@ namespace openmittsu {
 		}
 
 		bool DatabaseContactMessage::exists(Database& database, openmittsu::protocol::ContactId const& contact, openmittsu::protocol::MessageId const& messageId) {
-			QSqlQuery query(database.database);
-			query.prepare(QStringLiteral("SELECT `apiid` FROM `contact_messages` WHERE `identity` = :identity AND `apiid` = :apiid;"));
+			PreparedStatementCache::CachedQuery cachedQuery(database.prepareCachedQuery(QStringLiteral("SELECT `apiid` FROM `contact_messages` WHERE `identity` = :identity AND `apiid` = :apiid;")));
+			QSqlQuery& query = cachedQuery.get();
 			query.bindValue(QStringLiteral(":identity"), QVariant(contact.toQString()));
 			query.bindValue(QStringLiteral(":apiid"), QVariant(messageId.toQString()));
 
@@ -199,6 +204,7 @@ namespace openmittsu {
 				caption.append(it->getCaption());
 			}
 
+			database.commitWriteBatch();
 			if (!database.database.transaction()) {
 				LOGGER()->warn("Could NOT start transaction!");
 			}
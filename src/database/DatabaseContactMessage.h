@@ -21,6 +21,7 @@ namespace openmittsu {
 		class DatabaseContactMessage : public virtual DatabaseUserMessage, public virtual openmittsu::dataproviders::messages::ContactMessage {
 		public:
 			explicit DatabaseContactMessage(Database& database, openmittsu::protocol::ContactId const& contact, openmittsu::protocol::MessageId const& messageId);
+			explicit DatabaseContactMessage(Database& database, openmittsu::protocol::ContactId const& contact, DatabaseMessageRow const& row);
 			virtual ~DatabaseContactMessage();
 
 			virtual openmittsu::protocol::ContactId const& getContactId() const override;
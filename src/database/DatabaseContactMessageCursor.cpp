@@ -38,6 +38,27 @@ namespace openmittsu {
 			return std::make_shared<DatabaseContactMessage>(getDatabase(), m_contact, getMessageId());
 		}
 
+		QVector<std::shared_ptr<ContactMessage>> DatabaseContactMessageCursor::getMessagesByUuid(QVector<QString> const& uuids) const {
+			return toMessages(getRowsByUuid(uuids));
+		}
+
+		QVector<std::shared_ptr<ContactMessage>> DatabaseContactMessageCursor::previousPage(std::size_t n) {
+			return toMessages(previousRows(n));
+		}
+
+		QVector<std::shared_ptr<ContactMessage>> DatabaseContactMessageCursor::nextPage(std::size_t n) {
+			return toMessages(nextRows(n));
+		}
+
+		QVector<std::shared_ptr<ContactMessage>> DatabaseContactMessageCursor::toMessages(QList<DatabaseMessageRow> const& rows) const {
+			QVector<std::shared_ptr<ContactMessage>> result;
+			result.reserve(rows.size());
+			for (DatabaseMessageRow const& row : rows) {
+				result.append(std::make_shared<DatabaseContactMessage>(getDatabase(), m_contact, row));
+			}
+			return result;
+		}
+
 		QString DatabaseContactMessageCursor::getWhereString() const {
 			return QStringLiteral("`identity` = :identity");
 		}
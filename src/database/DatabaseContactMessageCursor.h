@@ -23,11 +23,16 @@ namespace openmittsu {
 
 			virtual openmittsu::protocol::ContactId const& getContactId() const override;
 			virtual std::shared_ptr<openmittsu::dataproviders::messages::ContactMessage> getMessage() const override;
+			virtual QVector<std::shared_ptr<openmittsu::dataproviders::messages::ContactMessage>> getMessagesByUuid(QVector<QString> const& uuids) const override;
+			virtual QVector<std::shared_ptr<openmittsu::dataproviders::messages::ContactMessage>> previousPage(std::size_t n) override;
+			virtual QVector<std::shared_ptr<openmittsu::dataproviders::messages::ContactMessage>> nextPage(std::size_t n) override;
 		protected:
 			virtual QString getWhereString() const override;
 			virtual void bindWhereStringValues(QSqlQuery& query) const override;
 			virtual QString getTableName() const override;
 		private:
+			QVector<std::shared_ptr<openmittsu::dataproviders::messages::ContactMessage>> toMessages(QList<DatabaseMessageRow> const& rows) const;
+
 			openmittsu::protocol::ContactId const m_contact;
 		};
 
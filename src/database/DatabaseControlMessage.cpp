@@ -30,8 +30,8 @@ namespace openmittsu {
 		}
 
 		bool DatabaseControlMessage::exists(Database& database, openmittsu::protocol::ContactId const& contact, openmittsu::protocol::MessageId const& messageId) {
-			QSqlQuery query(database.database);
-			query.prepare(QStringLiteral("SELECT `apiid` FROM `control_messages` WHERE `identity` = :identity AND `apiid` = :apiid;"));
+			PreparedStatementCache::CachedQuery cachedQuery(database.prepareCachedQuery(QStringLiteral("SELECT `apiid` FROM `control_messages` WHERE `identity` = :identity AND `apiid` = :apiid;")));
+			QSqlQuery& query = cachedQuery.get();
 			query.bindValue(QStringLiteral(":identity"), QVariant(contact.toQString()));
 			query.bindValue(QStringLiteral(":apiid"), QVariant(messageId.toQString()));
 
@@ -42,8 +42,8 @@ namespace openmittsu {
 		}
 
 		bool DatabaseControlMessage::hasControlMessageFor(Database& database, openmittsu::protocol::ContactId const& contact, openmittsu::protocol::MessageId const& relatedMessageId, ControlMessageType const& controlMessageType) {
-			QSqlQuery query(database.database);
-			query.prepare(QStringLiteral("SELECT `apiid` FROM `control_messages` WHERE `identity` = :identity AND `related_message_apiid` = :relatedMessageId AND `control_message_type` = :controlType;"));
+			PreparedStatementCache::CachedQuery cachedQuery(database.prepareCachedQuery(QStringLiteral("SELECT `apiid` FROM `control_messages` WHERE `identity` = :identity AND `related_message_apiid` = :relatedMessageId AND `control_message_type` = :controlType;")));
+			QSqlQuery& query = cachedQuery.get();
 			query.bindValue(QStringLiteral(":identity"), QVariant(contact.toQString()));
 			query.bindValue(QStringLiteral(":relatedMessageId"), QVariant(relatedMessageId.toQString()));
 			query.bindValue(QStringLiteral(":controlType"), QVariant(ControlMessageTypeHelper::toString(controlMessageType)));
@@ -158,8 +158,8 @@ namespace openmittsu {
 		}
 
 		DatabaseControlMessage DatabaseControlMessage::fromUuid(Database& database, QString const& uuid) {
-			QSqlQuery query(database.database);
-			query.prepare(QStringLiteral("SELECT `identity`, `apiid`, `related_message_apiid`, `uid`, `control_message_type` FROM `control_messages` WHERE `uid` = :uid;"));
+			PreparedStatementCache::CachedQuery cachedQuery(database.prepareCachedQuery(QStringLiteral("SELECT `identity`, `apiid`, `related_message_apiid`, `uid`, `control_message_type` FROM `control_messages` WHERE `uid` = :uid;")));
+			QSqlQuery& query = cachedQuery.get();
 			query.bindValue(QStringLiteral(":uid"), QVariant(uuid));
 			if (!query.exec() || !query.isSelect()) {
 				throw openmittsu::exceptions::InternalErrorException() << "Could not execute control message query for table control_messages for UUID \"" << uuid.toStdString() << "\". Query error: " << query.lastError().text().toStdString();
@@ -177,8 +177,8 @@ namespace openmittsu {
 		}
 		
 		DatabaseControlMessage DatabaseControlMessage::fromReceiverAndControlMessageId(Database& database, openmittsu::protocol::ContactId const& contact, openmittsu::protocol::MessageId const& controlMessageId) {
-			QSqlQuery query(database.database);
-			query.prepare(QStringLiteral("SELECT `identity`, `apiid`, `related_message_apiid`, `uid`, `control_message_type` FROM `control_messages` WHERE `identity` = :identity AND `apiid` = :apiid;"));
+			PreparedStatementCache::CachedQuery cachedQuery(database.prepareCachedQuery(QStringLiteral("SELECT `identity`, `apiid`, `related_message_apiid`, `uid`, `control_message_type` FROM `control_messages` WHERE `identity` = :identity AND `apiid` = :apiid;")));
+			QSqlQuery& query = cachedQuery.get();
 			query.bindValue(QStringLiteral(":identity"), QVariant(contact.toQString()));
 			query.bindValue(QStringLiteral(":apiid"), QVariant(controlMessageId.toQString()));
 			if (!query.exec() || !query.isSelect()) {
@@ -14,11 +14,16 @@ namespace openmittsu {
 		using namespace openmittsu::dataproviders::messages;
 
 		DatabaseGroupMessage::DatabaseGroupMessage(Database& database, openmittsu::protocol::GroupId const& group, openmittsu::protocol::MessageId const& messageId) : DatabaseMessage(database, messageId), DatabaseUserMessage(database, messageId), GroupMessage(), m_group(group) {
-			if (!exists(database, group, messageId)) {
+			// Checks for existance and reads all fields at once.
+			if (!loadRow()) {
 				throw openmittsu::exceptions::InternalErrorException() << "No message from group \"" << group.toString() << "\" and message ID \"" << messageId.toString() << "\" exists, can not manipulate.";
 			}
 		}
 
+		DatabaseGroupMessage::DatabaseGroupMessage(Database& database, openmittsu::protocol::GroupId const& group, DatabaseMessageRow const& row) : DatabaseMessage(database, row), DatabaseUserMessage(database, row), GroupMessage(), m_group(group) {
+			//
+		}
+
 		DatabaseGroupMessage::~DatabaseGroupMessage() {
 			//
 		}
@@ -36,8 +41,8 @@ namespace openmittsu {
 		}
 
 		bool DatabaseGroupMessage::exists(Database& database, openmittsu::protocol::GroupId const& group, openmittsu::protocol::MessageId const& messageId) {
-			QSqlQuery query(database.database);
-			query.prepare(QStringLiteral("SELECT `apiid` FROM `group_messages` WHERE `group_id` = :groupId AND `group_creator` = :groupCreator AND `apiid` = :apiid;"));
+			PreparedStatementCache::CachedQuery cachedQuery(database.prepareCachedQuery(QStringLiteral("SELECT `apiid` FROM `group_messages` WHERE `group_id` = :groupId AND `group_creator` = :groupCreator AND `apiid` = :apiid;")));
+			QSqlQuery& query = cachedQuery.get();
 			query.bindValue(QStringLiteral(":groupId"), QVariant(group.groupIdWithoutOwnerToQString()));
 			query.bindValue(QStringLiteral(":groupCreator"), QVariant(group.getOwner().toQString()));
 			query.bindValue(QStringLiteral(":apiid"), QVariant(messageId.toQString()));
@@ -206,6 +211,7 @@ namespace openmittsu {
 				caption.append(it->getCaption());
 			}
 
+			database.commitWriteBatch();
 			if (!database.database.transaction()) {
 				LOGGER()->warn("Could NOT start transaction!");
 			}
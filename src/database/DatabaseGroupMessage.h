@@ -22,6 +22,7 @@ namespace openmittsu {
 		class DatabaseGroupMessage : public virtual DatabaseUserMessage, public virtual openmittsu::dataproviders::messages::GroupMessage {
 		public:
 			DatabaseGroupMessage(Database& database, openmittsu::protocol::GroupId const& group, openmittsu::protocol::MessageId const& messageId);
+			DatabaseGroupMessage(Database& database, openmittsu::protocol::GroupId const& group, DatabaseMessageRow const& row);
 			virtual ~DatabaseGroupMessage();
 
 			virtual openmittsu::protocol::GroupId const& getGroupId() const override;
@@ -37,6 +37,27 @@ namespace openmittsu {
 			return std::make_shared<DatabaseGroupMessage>(getDatabase(), m_group, getMessageId());
 		}
 
+		QVector<std::shared_ptr<GroupMessage>> DatabaseGroupMessageCursor::getMessagesByUuid(QVector<QString> const& uuids) const {
+			return toMessages(getRowsByUuid(uuids));
+		}
+
+		QVector<std::shared_ptr<GroupMessage>> DatabaseGroupMessageCursor::previousPage(std::size_t n) {
+			return toMessages(previousRows(n));
+		}
+
+		QVector<std::shared_ptr<GroupMessage>> DatabaseGroupMessageCursor::nextPage(std::size_t n) {
+			return toMessages(nextRows(n));
+		}
+
+		QVector<std::shared_ptr<GroupMessage>> DatabaseGroupMessageCursor::toMessages(QList<DatabaseMessageRow> const& rows) const {
+			QVector<std::shared_ptr<GroupMessage>> result;
+			result.reserve(rows.size());
+			for (DatabaseMessageRow const& row : rows) {
+				result.append(std::make_shared<DatabaseGroupMessage>(getDatabase(), m_group, row));
+			}
+			return result;
+		}
+
 		QString DatabaseGroupMessageCursor::getWhereString() const {
 			return QStringLiteral("`group_id` = :groupId AND `group_creator` = :groupCreator");
 		}
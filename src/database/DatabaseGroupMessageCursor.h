@@ -24,12 +24,16 @@ namespace openmittsu {
 
 			virtual openmittsu::protocol::GroupId const& getGroupId() const override;
 			virtual std::shared_ptr<openmittsu::dataproviders::messages::GroupMessage> getMessage() const override;
-
+			virtual QVector<std::shared_ptr<openmittsu::dataproviders::messages::GroupMessage>> getMessagesByUuid(QVector<QString> const& uuids) const override;
+			virtual QVector<std::shared_ptr<openmittsu::dataproviders::messages::GroupMessage>> previousPage(std::size_t n) override;
+			virtual QVector<std::shared_ptr<openmittsu::dataproviders::messages::GroupMessage>> nextPage(std::size_t n) override;
 		protected:
 			virtual QString getWhereString() const override;
 			virtual void bindWhereStringValues(QSqlQuery& query) const override;
 			virtual QString getTableName() const override;
 		private:
+			QVector<std::shared_ptr<openmittsu::dataproviders::messages::GroupMessage>> toMessages(QList<DatabaseMessageRow> const& rows) const;
+
 			openmittsu::protocol::GroupId const m_group;
 		};
 
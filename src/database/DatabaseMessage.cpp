@@ -5,6 +5,7 @@
 #include "src/exceptions/InternalErrorException.h"
 #include "src/utility/Logging.h"
 
+#include <QSqlRecord>
 #include <QVariant>
 
 namespace openmittsu {
@@ -12,7 +13,11 @@ namespace openmittsu {
 
 		using namespace openmittsu::dataproviders::messages;
 
-		DatabaseMessage::DatabaseMessage(Database& database, openmittsu::protocol::MessageId const& messageId) : Message(), m_database(database), m_messageId(messageId) {
+		DatabaseMessage::DatabaseMessage(Database& database, openmittsu::protocol::MessageId const& messageId) : Message(), m_database(database), m_messageId(messageId), m_row() {
+			//
+		}
+
+		DatabaseMessage::DatabaseMessage(Database& database, DatabaseMessageRow const& row) : Message(), m_database(database), m_messageId(row.getMessageId()), m_row(std::make_shared<DatabaseMessageRow const>(row)) {
 			//
 		}
 
@@ -24,20 +29,36 @@ namespace openmittsu {
 			return m_messageId;
 		}
 
-		QVariant DatabaseMessage::queryField(QString const& fieldName) const {
-			QSqlQuery query(m_database.database);
-
-			query.prepare(QStringLiteral("SELECT `%1` FROM `%2` WHERE %3 AND `apiid` = :apiid;").arg(fieldName).arg(getTableName()).arg(getWhereString()));
+		bool DatabaseMessage::loadRow() const {
+			PreparedStatementCache::CachedQuery cachedQuery(m_database.prepareCachedQuery(QStringLiteral("SELECT * FROM `%1` WHERE %2 AND `apiid` = :apiid;").arg(getTableName()).arg(getWhereString())));
+			QSqlQuery& query = cachedQuery.get();
 			bindWhereStringValues(query);
 			query.bindValue(QStringLiteral(":apiid"), QVariant(m_messageId.toQString()));
 
 			if (!query.exec() || !query.isSelect()) {
-				throw openmittsu::exceptions::InternalErrorException() << "Could not execute message field query for table " << getTableName().toStdString() << " with message ID \"" << m_messageId.toString() << "\" for field \"" << fieldName.toStdString() << "\". Query error: " << query.lastError().text().toStdString();
+				throw openmittsu::exceptions::InternalErrorException() << "Could not execute message row query for table " << getTableName().toStdString() << " with message ID \"" << m_messageId.toString() << "\". Query error: " << query.lastError().text().toStdString();
 			} else if (!query.next()) {
+				m_row.reset();
+				return false;
+			}
+
+			m_row = std::make_shared<DatabaseMessageRow const>(query.record());
+			return true;
+		}
+
+		DatabaseMessageRow const& DatabaseMessage::getRow() const {
+			if ((m_row == nullptr) && !loadRow()) {
 				throw openmittsu::exceptions::InternalErrorException() << "No message with message ID \"" << m_messageId.toString() << "\" exists, can not manipulate.";
 			}
+			return *m_row;
+		}
+
+		QVariant DatabaseMessage::queryField(QString const& fieldName) const {
+			return getRow().getField(fieldName);
+		}
 
-			return query.value(fieldName);
+		void DatabaseMessage::refresh() const {
+			m_row.reset();
 		}
 
 		void DatabaseMessage::setFields(QVariantMap const& fieldsAndValues) {
@@ -52,6 +73,7 @@ namespace openmittsu {
 					throw openmittsu::exceptions::InternalErrorException() << "Could not update message data in " << getTableName().toStdString() << " for message ID \"" << m_messageId.toString() << "\". Query error: " << query.lastError().text().toStdString();
 				}
 
+				refresh();
 				announceMessageChanged();
 			} else {
 				throw openmittsu::exceptions::InternalErrorException() << "DatabaseMessage::setFields() called with empty field/value map, this should never happen!";
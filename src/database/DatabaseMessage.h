@@ -5,6 +5,9 @@
 #include <QSqlQuery>
 #include <QVariant>
 
+#include <memory>
+
+#include "src/database/DatabaseMessageRow.h"
 #include "src/dataproviders/messages/Message.h"
 
 namespace openmittsu {
@@ -16,6 +19,8 @@ namespace openmittsu {
 		class DatabaseMessage : public virtual openmittsu::dataproviders::messages::Message {
 		public:
 			explicit DatabaseMessage(Database& database, openmittsu::protocol::MessageId const& messageId);
+			/** Uses an already loaded row instead of reading it again on first access. */
+			explicit DatabaseMessage(Database& database, DatabaseMessageRow const& row);
 			virtual ~DatabaseMessage();
 
 			virtual openmittsu::protocol::ContactId getSender() const override;
@@ -40,6 +45,8 @@ namespace openmittsu {
 			virtual void setIsSent() override;
 
 			virtual QString getUid() const override;
+
+			virtual void refresh() const override;
 		protected:
 			QSqlQuery getNewQuery();
 
@@ -47,6 +54,10 @@ namespace openmittsu {
 			virtual void bindWhereStringValues(QSqlQuery& query) const = 0;
 			virtual QString getTableName() const = 0;
 
+			/** Reads all columns of this message with one query, returns false if the message does not exist. */
+			bool loadRow() const;
+			DatabaseMessageRow const& getRow() const;
+
 			QVariant queryField(QString const& fieldName) const;
 			void setFields(QVariantMap const& fieldsAndValues);
 
@@ -56,6 +67,7 @@ namespace openmittsu {
 		private:
 			Database& m_database;
 			openmittsu::protocol::MessageId const m_messageId;
+			mutable std::shared_ptr<DatabaseMessageRow const> m_row;
 		};
 
 	}
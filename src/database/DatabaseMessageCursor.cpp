@@ -4,8 +4,16 @@
 #include "src/exceptions/InternalErrorException.h"
 #include "src/utility/Logging.h"
 
+#include <QHash>
+#include <QSqlRecord>
+#include <QStringList>
 #include <QVariant>
 
+#include <algorithm>
+
+// SQLite allows at most 999 host parameters per statement in its default configuration.
+#define OPENMITTSU_DATABASEMESSAGECURSOR_MAX_UUIDS_PER_QUERY (500)
+
 namespace openmittsu {
 	namespace database {
 
@@ -32,8 +40,8 @@ namespace openmittsu {
 		}
 
 		bool DatabaseMessageCursor::seek(openmittsu::protocol::MessageId const& messageId) {
-			QSqlQuery query(m_database.database);
-			query.prepare(QStringLiteral("SELECT `apiid`, `uid`, `sort_by` FROM `%1` WHERE %2 AND `apiid` = :apiid;").arg(getTableName()).arg(getWhereString()));
+			PreparedStatementCache::CachedQuery cachedQuery(m_database.prepareCachedQuery(QStringLiteral("SELECT `apiid`, `uid`, `sort_by` FROM `%1` WHERE %2 AND `apiid` = :apiid;").arg(getTableName()).arg(getWhereString())));
+			QSqlQuery& query = cachedQuery.get();
 			query.bindValue(QStringLiteral(":apiid"), QVariant(messageId.toQString()));
 			bindWhereStringValues(query);
 
@@ -54,8 +62,8 @@ namespace openmittsu {
 		}
 
 		bool DatabaseMessageCursor::seekByUuid(QString const& uuid) {
-			QSqlQuery query(m_database.database);
-			query.prepare(QStringLiteral("SELECT `apiid`, `uid`, `sort_by` FROM `%1` WHERE %2 AND `uid` = :uid;").arg(getTableName()).arg(getWhereString()));
+			PreparedStatementCache::CachedQuery cachedQuery(m_database.prepareCachedQuery(QStringLiteral("SELECT `apiid`, `uid`, `sort_by` FROM `%1` WHERE %2 AND `uid` = :uid;").arg(getTableName()).arg(getWhereString())));
+			QSqlQuery& query = cachedQuery.get();
 			query.bindValue(QStringLiteral(":uid"), QVariant(uuid));
 			bindWhereStringValues(query);
 
@@ -80,6 +88,16 @@ namespace openmittsu {
 				return false;
 			}
 
+			QList<DatabaseMessageRow> const rows = getRows(m_sortByValue, m_uid, ascending, 1);
+			if (rows.isEmpty()) {
+				return false;
+			}
+
+			setPosition(rows.first());
+			return true;
+		}
+
+		QList<DatabaseMessageRow> DatabaseMessageCursor::getRows(qint64 anchorSortByValue, QString const& anchorUid, bool ascending, std::size_t n) const {
 			QString sortOrder;
 			QString sortOrderSign;
 			if (ascending) {
@@ -90,64 +108,81 @@ namespace openmittsu {
 				sortOrderSign = QStringLiteral("<");
 			}
 
-#if defined(QT_VERSION) && (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
-			// Check in two steps to mitigate a cool bug in the query engine.
-			QSqlQuery query(m_database.database);
-			query.prepare(QStringLiteral("SELECT `apiid`, `uid`, `sort_by` FROM `%1` WHERE (%2) AND (((`sort_by` = :sortByValue) AND (`uid` %3 :uid))) ORDER BY `sort_by` %4, `uid` %4 LIMIT 1;").arg(getTableName()).arg(getWhereString()).arg(sortOrderSign).arg(sortOrder));
+			// Every placeholder is used only once, Qt 5.10 and later do not bind repeated named placeholders correctly with SQLite.
+			// The redundant bound on `sort_by` lets SQLite walk the (conversation, sort_by, uid) index from the anchor instead of from the end.
+			PreparedStatementCache::CachedQuery cachedQuery(m_database.prepareCachedQuery(QStringLiteral("SELECT * FROM `%1` WHERE (%2) AND (`sort_by` %3= :sortByBound) AND ((`sort_by` %3 :sortByValue) OR ((`sort_by` = :sortByEqual) AND (`uid` %3 :uid))) ORDER BY `sort_by` %4, `uid` %4 LIMIT :limit;").arg(getTableName()).arg(getWhereString()).arg(sortOrderSign).arg(sortOrder)));
+			QSqlQuery& query = cachedQuery.get();
 			bindWhereStringValues(query);
-			query.bindValue(QStringLiteral(":sortByValue"), QVariant(m_sortByValue));
-			query.bindValue(QStringLiteral(":uid"), QVariant(m_uid));
+			query.bindValue(QStringLiteral(":sortByBound"), QVariant(anchorSortByValue));
+			query.bindValue(QStringLiteral(":sortByValue"), QVariant(anchorSortByValue));
+			query.bindValue(QStringLiteral(":sortByEqual"), QVariant(anchorSortByValue));
+			query.bindValue(QStringLiteral(":uid"), QVariant(anchorUid));
+			query.bindValue(QStringLiteral(":limit"), QVariant(static_cast<qint64>(n)));
 
 			if (!query.exec() || !query.isSelect()) {
-				throw openmittsu::exceptions::InternalErrorException() << "Could not execute message iteration query for table " << getTableName().toStdString() << ". Query error: " << query.lastError().text().toStdString();
+				throw openmittsu::exceptions::InternalErrorException() << "Could not execute message page query for table " << getTableName().toStdString() << ". Query error: " << query.lastError().text().toStdString();
 			}
 
-			if (query.next()) {
-				m_isMessageIdValid = true;
-				m_messageId = openmittsu::protocol::MessageId(query.value(QStringLiteral("apiid")).toString());
-				m_uid = query.value(QStringLiteral("uid")).toString();
-				m_sortByValue = query.value(QStringLiteral("sort_by")).toLongLong();
-				return true;
+			QList<DatabaseMessageRow> result;
+			while (query.next()) {
+				if (ascending) {
+					result.append(DatabaseMessageRow(query.record()));
+				} else {
+					result.prepend(DatabaseMessageRow(query.record()));
+				}
+			}
+			return result;
+		}
+
+		QList<DatabaseMessageRow> DatabaseMessageCursor::getFirstOrLastRows(bool first, std::size_t n) const {
+			QString sortOrder;
+			if (first) {
+				sortOrder = QStringLiteral("ASC");
 			} else {
-				query.prepare(QStringLiteral("SELECT `apiid`, `uid`, `sort_by` FROM `%1` WHERE (%2) AND ((`sort_by` %3 :sortByValue)) ORDER BY `sort_by` %4, `uid` %4 LIMIT 1;").arg(getTableName()).arg(getWhereString()).arg(sortOrderSign).arg(sortOrder));
-				bindWhereStringValues(query);
-				query.bindValue(QStringLiteral(":sortByValue"), QVariant(m_sortByValue));
+				sortOrder = QStringLiteral("DESC");
+			}
 
-				if (!query.exec() || !query.isSelect()) {
-					throw openmittsu::exceptions::InternalErrorException() << "Could not execute message iteration query for table " << getTableName().toStdString() << ". Query error: " << query.lastError().text().toStdString();
-				}
+			PreparedStatementCache::CachedQuery cachedQuery(m_database.prepareCachedQuery(QStringLiteral("SELECT * FROM `%1` WHERE %2 ORDER BY `sort_by` %3, `uid` %3 LIMIT :limit;").arg(getTableName()).arg(getWhereString()).arg(sortOrder)));
+			QSqlQuery& query = cachedQuery.get();
+			bindWhereStringValues(query);
+			query.bindValue(QStringLiteral(":limit"), QVariant(static_cast<qint64>(n)));
 
-				if (query.next()) {
-					m_isMessageIdValid = true;
-					m_messageId = openmittsu::protocol::MessageId(query.value(QStringLiteral("apiid")).toString());
-					m_uid = query.value(QStringLiteral("uid")).toString();
-					m_sortByValue = query.value(QStringLiteral("sort_by")).toLongLong();
-					return true;
+			if (!query.exec() || !query.isSelect()) {
+				throw openmittsu::exceptions::InternalErrorException() << "Could not execute message first/last page query for table " << getTableName().toStdString() << ". Query error: " << query.lastError().text().toStdString();
+			}
+
+			QList<DatabaseMessageRow> result;
+			while (query.next()) {
+				if (first) {
+					result.append(DatabaseMessageRow(query.record()));
 				} else {
-					return false;
+					result.prepend(DatabaseMessageRow(query.record()));
 				}
 			}
-#else
-			QSqlQuery query(m_database.database);
-			query.prepare(QStringLiteral("SELECT `apiid`, `uid`, `sort_by` FROM `%1` WHERE %2 AND ((`sort_by` %3 :sortByValue) OR ((`sort_by` = :sortByValue) AND (`uid` %3 :uid))) ORDER BY `sort_by` %4, `uid` %4 LIMIT 1;").arg(getTableName()).arg(getWhereString()).arg(sortOrderSign).arg(sortOrder));
-			bindWhereStringValues(query);
-			query.bindValue(QStringLiteral(":sortByValue"), QVariant(m_sortByValue));
-			query.bindValue(QStringLiteral(":uid"), QVariant(m_uid));
+			return result;
+		}
 
-			if (!query.exec() || !query.isSelect()) {
-				throw openmittsu::exceptions::InternalErrorException() << "Could not execute message iteration query for table " << getTableName().toStdString() << ". Query error: " << query.lastError().text().toStdString();
+		QList<DatabaseMessageRow> DatabaseMessageCursor::previousRows(std::size_t n) {
+			QList<DatabaseMessageRow> const rows = (m_isMessageIdValid) ? getRows(m_sortByValue, m_uid, false, n) : getFirstOrLastRows(false, n);
+			if (!rows.isEmpty()) {
+				setPosition(rows.first());
 			}
+			return rows;
+		}
 
-			if (query.next()) {
-				m_isMessageIdValid = true;
-				m_messageId = openmittsu::protocol::MessageId(query.value(QStringLiteral("apiid")).toString());
-				m_uid = query.value(QStringLiteral("uid")).toString();
-				m_sortByValue = query.value(QStringLiteral("sort_by")).toLongLong();
-				return true;
-			} else {
-				return false;
+		QList<DatabaseMessageRow> DatabaseMessageCursor::nextRows(std::size_t n) {
+			QList<DatabaseMessageRow> const rows = (m_isMessageIdValid) ? getRows(m_sortByValue, m_uid, true, n) : getFirstOrLastRows(true, n);
+			if (!rows.isEmpty()) {
+				setPosition(rows.last());
 			}
-#endif
+			return rows;
+		}
+
+		void DatabaseMessageCursor::setPosition(DatabaseMessageRow const& row) {
+			m_isMessageIdValid = true;
+			m_messageId = row.getMessageId();
+			m_uid = row.getUid();
+			m_sortByValue = row.getField(QStringLiteral("sort_by")).toLongLong();
 		}
 
 		bool DatabaseMessageCursor::getFirstOrLastMessageId(bool first) {
@@ -158,8 +193,8 @@ namespace openmittsu {
 				sortOrder = QStringLiteral("DESC");
 			}
 
-			QSqlQuery query(m_database.database);
-			query.prepare(QStringLiteral("SELECT `apiid`, `uid`, `sort_by` FROM `%1` WHERE %2 ORDER BY `sort_by` %3, `uid` %3 LIMIT 1;").arg(getTableName()).arg(getWhereString()).arg(sortOrder));
+			PreparedStatementCache::CachedQuery cachedQuery(m_database.prepareCachedQuery(QStringLiteral("SELECT `apiid`, `uid`, `sort_by` FROM `%1` WHERE %2 ORDER BY `sort_by` %3, `uid` %3 LIMIT 1;").arg(getTableName()).arg(getWhereString()).arg(sortOrder)));
+			QSqlQuery& query = cachedQuery.get();
 			bindWhereStringValues(query);
 
 			if (!query.exec() || !query.isSelect()) {
@@ -178,9 +213,10 @@ namespace openmittsu {
 		}
 
 		QVector<QString> DatabaseMessageCursor::getLastMessages(std::size_t n) const {
-			QSqlQuery query(m_database.database);
-			query.prepare(QStringLiteral("SELECT `uid` FROM `%1` WHERE %2 ORDER BY `sort_by` DESC, `uid` DESC LIMIT %3;").arg(getTableName()).arg(getWhereString()).arg(n));
+			PreparedStatementCache::CachedQuery cachedQuery(m_database.prepareCachedQuery(QStringLiteral("SELECT `uid` FROM `%1` WHERE %2 ORDER BY `sort_by` DESC, `uid` DESC LIMIT :limit;").arg(getTableName()).arg(getWhereString())));
+			QSqlQuery& query = cachedQuery.get();
 			bindWhereStringValues(query);
+			query.bindValue(QStringLiteral(":limit"), QVariant(static_cast<qint64>(n)));
 
 			if (!query.exec() || !query.isSelect()) {
 				throw openmittsu::exceptions::InternalErrorException() << "Could not execute message enumeration query for table " << getTableName().toStdString() << ". Query error: " << query.lastError().text().toStdString();
@@ -195,6 +231,54 @@ namespace openmittsu {
 			return result;
 		}
 
+		QList<DatabaseMessageRow> DatabaseMessageCursor::getRowsByUuid(QVector<QString> const& uuids) const {
+			QHash<QString, DatabaseMessageRow> rowsByUuid;
+			for (int offset = 0; offset < uuids.size(); offset += OPENMITTSU_DATABASEMESSAGECURSOR_MAX_UUIDS_PER_QUERY) {
+				int const count = std::min(uuids.size() - offset, OPENMITTSU_DATABASEMESSAGECURSOR_MAX_UUIDS_PER_QUERY);
+
+				// Round the placeholder count up to a few fixed sizes, so only a handful of these statements end up in the statement cache.
+				int placeholderCount = OPENMITTSU_DATABASEMESSAGECURSOR_MAX_UUIDS_PER_QUERY;
+				for (int const size : { 1, 8, 32, 128 }) {
+					if (count <= size) {
+						placeholderCount = size;
+						break;
+					}
+				}
+
+				QStringList placeholders;
+				for (int i = 0; i < placeholderCount; ++i) {
+					placeholders.append(QStringLiteral(":uid%1").arg(i));
+				}
+
+				PreparedStatementCache::CachedQuery cachedQuery(m_database.prepareCachedQuery(QStringLiteral("SELECT * FROM `%1` WHERE %2 AND `uid` IN (%3);").arg(getTableName()).arg(getWhereString()).arg(placeholders.join(QStringLiteral(", ")))));
+				QSqlQuery& query = cachedQuery.get();
+				bindWhereStringValues(query);
+				for (int i = 0; i < placeholderCount; ++i) {
+					// Padding is bound to NULL, which never matches.
+					query.bindValue(placeholders.at(i), (i < count) ? QVariant(uuids.at(offset + i)) : QVariant(QVariant::String));
+				}
+
+				if (!query.exec() || !query.isSelect()) {
+					throw openmittsu::exceptions::InternalErrorException() << "Could not execute message row query for table " << getTableName().toStdString() << " with " << count << " UUIDs. Query error: " << query.lastError().text().toStdString();
+				}
+
+				while (query.next()) {
+					DatabaseMessageRow const row(query.record());
+					rowsByUuid.insert(row.getUid(), row);
+				}
+			}
+
+			QList<DatabaseMessageRow> result;
+			result.reserve(rowsByUuid.size());
+			for (QString const& uuid : uuids) {
+				auto const it = rowsByUuid.constFind(uuid);
+				if (it != rowsByUuid.constEnd()) {
+					result.append(it.value());
+				}
+			}
+			return result;
+		}
+
 		bool DatabaseMessageCursor::next() {
 			return getFollowingMessageId(true);
 		}
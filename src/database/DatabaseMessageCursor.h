@@ -1,6 +1,7 @@
 #ifndef OPENMITTSU_DATABASE_DATABASEMESSAGECURSOR_H_
 #define OPENMITTSU_DATABASE_DATABASEMESSAGECURSOR_H_
 
+#include <QList>
 #include <QString>
 #include <QSqlQuery>
 #include <QVector>
@@ -9,6 +10,7 @@
 #include "src/protocol/MessageId.h"
 #include "src/protocol/MessageTime.h"
 #include "src/database/DatabaseContactMessage.h"
+#include "src/database/DatabaseMessageRow.h"
 #include "src/dataproviders/messages/MessageCursor.h"
 
 namespace openmittsu {
@@ -31,9 +33,23 @@ namespace openmittsu {
 
 			virtual openmittsu::protocol::MessageId const& getMessageId() const override;
 			virtual QVector<QString> getLastMessages(std::size_t n) const override;
+
+			/**
+			 * Returns up to n messages right before the current position, oldest first, and moves the cursor to the oldest of them.
+			 * If the cursor is not valid, the newest n messages are returned. Each call is a single query.
+			 */
+			QList<DatabaseMessageRow> previousRows(std::size_t n);
+			/** Like previousRows(), but towards newer messages. The cursor ends on the newest returned message, an invalid cursor starts at the oldest message. */
+			QList<DatabaseMessageRow> nextRows(std::size_t n);
+
+			/** Returns up to n messages sorting strictly before or after the given (sort_by, uid) anchor, oldest first. The cursor is not moved. */
+			QList<DatabaseMessageRow> getRows(qint64 anchorSortByValue, QString const& anchorUid, bool ascending, std::size_t n) const;
 		protected:
 			Database& getDatabase() const;
 
+			/** Reads all columns of the messages with the given UUIDs, in the order given. Unknown UUIDs are skipped. */
+			QList<DatabaseMessageRow> getRowsByUuid(QVector<QString> const& uuids) const;
+
 			virtual QString getWhereString() const = 0;
 			virtual void bindWhereStringValues(QSqlQuery& query) const = 0;
 			virtual QString getTableName() const = 0;
@@ -46,6 +62,8 @@ namespace openmittsu {
 
 			bool getFollowingMessageId(bool ascending);
 			bool getFirstOrLastMessageId(bool first);
+			QList<DatabaseMessageRow> getFirstOrLastRows(bool first, std::size_t n) const;
+			void setPosition(DatabaseMessageRow const& row);
 		};
 
 	}
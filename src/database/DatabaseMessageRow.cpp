@@ -0,0 +1,46 @@
+#include "src/database/DatabaseMessageRow.h"
+
+#include "src/exceptions/InternalErrorException.h"
+
+namespace openmittsu {
+	namespace database {
+
+		DatabaseMessageRow::DatabaseMessageRow(QSqlRecord const& record) : m_record(record) {
+			// Intentionally left empty.
+		}
+
+		DatabaseMessageRow::DatabaseMessageRow(DatabaseMessageRow const& other) : m_record(other.m_record) {
+			// Intentionally left empty.
+		}
+
+		DatabaseMessageRow::~DatabaseMessageRow() {
+			// Intentionally left empty.
+		}
+
+		DatabaseMessageRow& DatabaseMessageRow::operator=(DatabaseMessageRow const& other) {
+			m_record = other.m_record;
+			return *this;
+		}
+
+		bool DatabaseMessageRow::hasField(QString const& fieldName) const {
+			return m_record.contains(fieldName);
+		}
+
+		QVariant DatabaseMessageRow::getField(QString const& fieldName) const {
+			int const index = m_record.indexOf(fieldName);
+			if (index < 0) {
+				throw openmittsu::exceptions::InternalErrorException() << "Message row has no field \"" << fieldName.toStdString() << "\".";
+			}
+			return m_record.value(index);
+		}
+
+		openmittsu::protocol::MessageId DatabaseMessageRow::getMessageId() const {
+			return openmittsu::protocol::MessageId(getField(QStringLiteral("apiid")).toString());
+		}
+
+		QString DatabaseMessageRow::getUid() const {
+			return getField(QStringLiteral("uid")).toString();
+		}
+
+	}
+}
@@ -0,0 +1,37 @@
+#ifndef OPENMITTSU_DATABASE_DATABASEMESSAGEROW_H_
+#define OPENMITTSU_DATABASE_DATABASEMESSAGEROW_H_
+
+#include <QSqlRecord>
+#include <QString>
+#include <QVariant>
+
+#include "src/protocol/MessageId.h"
+
+namespace openmittsu {
+	namespace database {
+
+		/**
+		 * All columns of one row of a message table, as read by a single query.
+		 * The values are a snapshot, later changes to the message in the database are not reflected.
+		 */
+		class DatabaseMessageRow {
+		public:
+			explicit DatabaseMessageRow(QSqlRecord const& record);
+			DatabaseMessageRow(DatabaseMessageRow const& other);
+			virtual ~DatabaseMessageRow();
+
+			DatabaseMessageRow& operator=(DatabaseMessageRow const& other);
+
+			bool hasField(QString const& fieldName) const;
+			QVariant getField(QString const& fieldName) const;
+
+			openmittsu::protocol::MessageId getMessageId() const;
+			QString getUid() const;
+		private:
+			QSqlRecord m_record;
+		};
+
+	}
+}
+
+#endif // OPENMITTSU_DATABASE_DATABASEMESSAGEROW_H_
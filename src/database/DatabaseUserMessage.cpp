@@ -14,6 +14,10 @@ namespace openmittsu {
 			//
 		}
 
+		DatabaseUserMessage::DatabaseUserMessage(Database& database, DatabaseMessageRow const& row) : DatabaseMessage(database, row), UserMessage() {
+			//
+		}
+
 		DatabaseUserMessage::~DatabaseUserMessage() {
 			//
 		}
@@ -17,6 +17,7 @@ namespace openmittsu {
 		class DatabaseUserMessage : public virtual DatabaseMessage, public virtual openmittsu::dataproviders::messages::UserMessage {
 		public:
 			explicit DatabaseUserMessage(Database& database, openmittsu::protocol::MessageId const& messageId);
+			explicit DatabaseUserMessage(Database& database, DatabaseMessageRow const& row);
 			virtual ~DatabaseUserMessage();
 
 			virtual bool isRead() const override;
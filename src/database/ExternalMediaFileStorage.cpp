@@ -11,8 +11,14 @@
 #include <QUuid>
 #include <QSqlQuery>
 
+#include <algorithm>
+
 #include <sodium.h>
 
+#define OPENMITTSU_EXTERNALMEDIAFILESTORAGE_FORMAT_WHOLE (1)
+#define OPENMITTSU_EXTERNALMEDIAFILESTORAGE_FORMAT_CHUNKED (2)
+#define OPENMITTSU_EXTERNALMEDIAFILESTORAGE_CHUNK_SIZE (64 * 1024)
+
 namespace openmittsu {
 	namespace database {
 
@@ -24,13 +30,13 @@ namespace openmittsu {
 			//
 		}
 
-		QString ExternalMediaFileStorage::buildFilename(QString const& uuid) const {
-			return QStringLiteral("encMedia_1_").append(uuid);
+		QString ExternalMediaFileStorage::buildFilename(QString const& uuid, int formatVersion) const {
+			return QStringLiteral("encMedia_%1_").arg(formatVersion).append(uuid);
 		}
 
 		bool ExternalMediaFileStorage::hasMediaItem(QString const& uuid) const {
-			QSqlQuery query(m_database.database);
-			query.prepare(QStringLiteral("SELECT `uid` FROM `media` WHERE `uid` = :uuid"));
+			PreparedStatementCache::CachedQuery cachedQuery(m_database.prepareCachedQuery(QStringLiteral("SELECT `uid` FROM `media` WHERE `uid` = :uuid")));
+			QSqlQuery& query = cachedQuery.get();
 			query.bindValue(QStringLiteral(":uuid"), QVariant(uuid));
 
 			if (query.exec() && query.isSelect()) {
@@ -45,8 +51,8 @@ namespace openmittsu {
 		}
 
 		MediaFileItem ExternalMediaFileStorage::getMediaItem(QString const& uuid) const {
-			QSqlQuery query(m_database.database);
-			query.prepare(QStringLiteral("SELECT `uid`, `size`, `checksum`, `nonce`, `key` FROM `media` WHERE `uid` = :uuid"));
+			PreparedStatementCache::CachedQuery cachedQuery(m_database.prepareCachedQuery(QStringLiteral("SELECT `uid`, `size`, `checksum`, `nonce`, `key` FROM `media` WHERE `uid` = :uuid")));
+			QSqlQuery& query = cachedQuery.get();
 			query.bindValue(QStringLiteral(":uuid"), QVariant(uuid));
 
 			if (query.exec() && query.isSelect() && query.next()) {
@@ -63,16 +69,31 @@ namespace openmittsu {
 					throw openmittsu::exceptions::InternalErrorException() << "Could not fetch media item for uuid \"" << uuid.toStdString() << "\". The key size is incorrect.";
 				}
 
-				QFile file(m_storagePath.filePath(buildFilename(uuid)));
-				if (!file.open(QFile::ReadOnly)) {
-					LOGGER()->warn("Could not fetch media item for uuid \"{}\". Could not open or read file.", uuid.toStdString());
-					return MediaFileItem(MediaFileItem::ItemStatus::UNAVAILABLE_EXTERNAL_FILE_DELETED);
+				QByteArray decryptedData;
+				QFile chunkedFile(m_storagePath.filePath(buildFilename(uuid, OPENMITTSU_EXTERNALMEDIAFILESTORAGE_FORMAT_CHUNKED)));
+				if (chunkedFile.open(QFile::ReadOnly)) {
+					MediaFileItem::ItemStatus const status = readEncryptedChunks(chunkedFile, uuid, size, key, nonce, decryptedData);
+					if (status != MediaFileItem::ItemStatus::AVAILABLE) {
+						return MediaFileItem(status);
+					}
+				} else {
+					QFile file(m_storagePath.filePath(buildFilename(uuid, OPENMITTSU_EXTERNALMEDIAFILESTORAGE_FORMAT_WHOLE)));
+					if (!file.open(QFile::ReadOnly)) {
+						LOGGER()->warn("Could not fetch media item for uuid \"{}\". Could not open or read file.", uuid.toStdString());
+						return MediaFileItem(MediaFileItem::ItemStatus::UNAVAILABLE_EXTERNAL_FILE_DELETED);
+					}
+
+					QByteArray const data = file.readAll();
+					file.close();
+
+					try {
+						decryptedData = decrypt(data, key, nonce);
+					} catch (openmittsu::exceptions::InternalErrorException& iee) {
+						LOGGER()->warn("Could not fetch media item for uuid \"{}\". Decryption failed: {}", uuid.toStdString(), iee.what());
+						return MediaFileItem(MediaFileItem::ItemStatus::UNAVAILABLE_DECRYPTION_FAILED);
+					}
 				}
-				
-				QByteArray const data = file.readAll();
-				file.close();
 
-				QByteArray const decryptedData = decrypt(data, key, nonce);
 				if (decryptedData.size() != size) {
 					LOGGER()->warn("Could not fetch media item for uuid \"{}\". File size {} Bytes does not match expected size of {} Bytes!", uuid.toStdString(), decryptedData.size(), size);
 					return MediaFileItem(MediaFileItem::ItemStatus::UNAVAILABLE_DECRYPTION_FAILED);
@@ -94,22 +115,23 @@ namespace openmittsu {
 
 			QByteArray const key = generateKey();
 			QByteArray const nonce = generateNonce();
-			QByteArray const encryptedData = encrypt(data, key, nonce);
-			int const encryptedSize = data.size() + cryptoGetHeaderSize();
 
-			QFile file(m_storagePath.filePath(buildFilename(uuid)));
+			QFile file(m_storagePath.filePath(buildFilename(uuid, OPENMITTSU_EXTERNALMEDIAFILESTORAGE_FORMAT_CHUNKED)));
 			if (!file.open(QFile::WriteOnly)) {
 				throw openmittsu::exceptions::InternalErrorException() << "Could not write media item for uuid \"" << uuid.toStdString() << "\". Could not open file for writing.";
 			}
-			
-			qint64 const writtenBytes = file.write(encryptedData);
-			if (writtenBytes != encryptedSize) {
-				throw openmittsu::exceptions::InternalErrorException() << "Could not write media item for uuid \"" << uuid.toStdString() << "\". Could not write file data (size missmatch, " << writtenBytes << " vs. " << encryptedSize << " Bytes).";
+
+			try {
+				writeEncryptedChunks(file, data, key, nonce);
+			} catch (openmittsu::exceptions::InternalErrorException&) {
+				file.close();
+				file.remove();
+				throw;
 			}
 			file.close();
 
-			QSqlQuery queryMedia(m_database.database);
-			queryMedia.prepare(QStringLiteral("INSERT INTO `media` (`uid`, `size`, `checksum`, `nonce`, `key`) VALUES (:uid, :size, :checksum, :nonce, :key);"));
+			PreparedStatementCache::CachedQuery cachedQueryMedia(m_database.prepareCachedQuery(QStringLiteral("INSERT INTO `media` (`uid`, `size`, `checksum`, `nonce`, `key`) VALUES (:uid, :size, :checksum, :nonce, :key);")));
+			QSqlQuery& queryMedia = cachedQueryMedia.get();
 			queryMedia.bindValue(QStringLiteral(":uid"), QVariant(uuid));
 			queryMedia.bindValue(QStringLiteral(":size"), QVariant(size));
 			queryMedia.bindValue(QStringLiteral(":checksum"), QVariant(actualChecksum));
@@ -128,10 +150,11 @@ namespace openmittsu {
 		}
 		
 		void ExternalMediaFileStorage::removeMediaItem(QString const& uuid) {
-			QFile::remove(m_storagePath.filePath(buildFilename(uuid)));
+			QFile::remove(m_storagePath.filePath(buildFilename(uuid, OPENMITTSU_EXTERNALMEDIAFILESTORAGE_FORMAT_WHOLE)));
+			QFile::remove(m_storagePath.filePath(buildFilename(uuid, OPENMITTSU_EXTERNALMEDIAFILESTORAGE_FORMAT_CHUNKED)));
 
-			QSqlQuery queryMedia(m_database.database);
-			queryMedia.prepare(QStringLiteral("DELETE FROM `media` WHERE `uid` = :uuid;"));
+			PreparedStatementCache::CachedQuery cachedQueryMedia(m_database.prepareCachedQuery(QStringLiteral("DELETE FROM `media` WHERE `uid` = :uuid;")));
+			QSqlQuery& queryMedia = cachedQueryMedia.get();
 			queryMedia.bindValue(QStringLiteral(":uuid"), QVariant(uuid));
 			if (!queryMedia.exec()) {
 				throw openmittsu::exceptions::InternalErrorException() << "Could not delete media data from table 'media'. Query error: " << queryMedia.lastError().text().toStdString();
@@ -174,19 +197,84 @@ namespace openmittsu {
 			return nonceBytes;
 		}
 		
-		QByteArray ExternalMediaFileStorage::encrypt(QByteArray const& unencryptedData, QByteArray const& key, QByteArray const& nonce) const {
-			QByteArray encryptedData(unencryptedData.size() + cryptoGetHeaderSize(), '\0');
-			unsigned long long ciphertext_len;
-			if (crypto_aead_xchacha20poly1305_ietf_encrypt(reinterpret_cast<unsigned char*>(encryptedData.data()), &ciphertext_len, reinterpret_cast<unsigned char const*>(unencryptedData.data()), unencryptedData.size(), NULL, 0, NULL, reinterpret_cast<unsigned char const*>(nonce.data()), reinterpret_cast<unsigned char const*>(key.data())) != 0) {
-				throw openmittsu::exceptions::InternalErrorException() << "Could not encrypt blob, data corrupt!";
-			} else if (static_cast<int>(ciphertext_len) != (unencryptedData.size() + cryptoGetHeaderSize())) {
-				throw openmittsu::exceptions::InternalErrorException() << "Could not encrypt media item blob: Expected size was " << (unencryptedData.size() + cryptoGetHeaderSize()) << " Bytes, but we got " << ciphertext_len << " Bytes instead!";
+		static QByteArray buildChunkAdditionalData(quint64 chunkIndex, bool isLastChunk) {
+			QByteArray additionalData(9, '\0');
+			for (int i = 0; i < 8; ++i) {
+				additionalData[i] = static_cast<char>((chunkIndex >> (8 * i)) & 0xFF);
 			}
+			additionalData[8] = isLastChunk ? 1 : 0;
+			return additionalData;
+		}
+
+		qint64 ExternalMediaFileStorage::getChunkedEncryptedSize(int size) const {
+			qint64 const chunkCount = std::max(1, (size + OPENMITTSU_EXTERNALMEDIAFILESTORAGE_CHUNK_SIZE - 1) / OPENMITTSU_EXTERNALMEDIAFILESTORAGE_CHUNK_SIZE);
+			return static_cast<qint64>(size) + (chunkCount * cryptoGetHeaderSize());
+		}
+
+		void ExternalMediaFileStorage::writeEncryptedChunks(QFile& file, QByteArray const& data, QByteArray const& key, QByteArray const& nonce) const {
+			QByteArray chunkNonce(nonce);
+			QByteArray encryptedChunk(OPENMITTSU_EXTERNALMEDIAFILESTORAGE_CHUNK_SIZE + cryptoGetHeaderSize(), '\0');
+
+			int const size = data.size();
+			int offset = 0;
+			quint64 chunkIndex = 0;
+			do {
+				int const chunkSize = std::min(OPENMITTSU_EXTERNALMEDIAFILESTORAGE_CHUNK_SIZE, size - offset);
+				QByteArray const additionalData = buildChunkAdditionalData(chunkIndex, (offset + chunkSize) >= size);
+
+				unsigned long long ciphertext_len;
+				if (crypto_aead_xchacha20poly1305_ietf_encrypt(reinterpret_cast<unsigned char*>(encryptedChunk.data()), &ciphertext_len, reinterpret_cast<unsigned char const*>(data.constData() + offset), chunkSize, reinterpret_cast<unsigned char const*>(additionalData.constData()), additionalData.size(), NULL, reinterpret_cast<unsigned char const*>(chunkNonce.constData()), reinterpret_cast<unsigned char const*>(key.constData())) != 0) {
+					throw openmittsu::exceptions::InternalErrorException() << "Could not encrypt media item chunk " << chunkIndex << ".";
+				}
+
+				qint64 const writtenBytes = file.write(encryptedChunk.constData(), static_cast<qint64>(ciphertext_len));
+				if (writtenBytes != static_cast<qint64>(ciphertext_len)) {
+					throw openmittsu::exceptions::InternalErrorException() << "Could not write media item chunk " << chunkIndex << " (size missmatch, " << writtenBytes << " vs. " << ciphertext_len << " Bytes).";
+				}
+
+				sodium_increment(reinterpret_cast<unsigned char*>(chunkNonce.data()), chunkNonce.size());
+				offset += chunkSize;
+				++chunkIndex;
+			} while (offset < size);
+		}
+
+		MediaFileItem::ItemStatus ExternalMediaFileStorage::readEncryptedChunks(QFile& file, QString const& uuid, int size, QByteArray const& key, QByteArray const& nonce, QByteArray& decryptedData) const {
+			if (file.size() != getChunkedEncryptedSize(size)) {
+				LOGGER()->warn("Could not fetch media item for uuid \"{}\". File size {} Bytes does not match expected size of {} Bytes!", uuid.toStdString(), file.size(), getChunkedEncryptedSize(size));
+				return MediaFileItem::ItemStatus::UNAVAILABLE_FILE_CORRUPTED;
+			}
+
+			decryptedData = QByteArray(size, '\0');
+			QByteArray chunkNonce(nonce);
+			QByteArray encryptedChunk(OPENMITTSU_EXTERNALMEDIAFILESTORAGE_CHUNK_SIZE + cryptoGetHeaderSize(), '\0');
+
+			int offset = 0;
+			quint64 chunkIndex = 0;
+			do {
+				int const chunkSize = std::min(OPENMITTSU_EXTERNALMEDIAFILESTORAGE_CHUNK_SIZE, size - offset);
+				qint64 const encryptedChunkSize = chunkSize + cryptoGetHeaderSize();
+				if (file.read(encryptedChunk.data(), encryptedChunkSize) != encryptedChunkSize) {
+					LOGGER()->warn("Could not fetch media item for uuid \"{}\". Reading chunk {} failed: {}", uuid.toStdString(), chunkIndex, file.errorString().toStdString());
+					return MediaFileItem::ItemStatus::UNAVAILABLE_FILE_CORRUPTED;
+				}
+
+				QByteArray const additionalData = buildChunkAdditionalData(chunkIndex, (offset + chunkSize) >= size);
+				unsigned long long decrypted_len;
+				if (crypto_aead_xchacha20poly1305_ietf_decrypt(reinterpret_cast<unsigned char*>(decryptedData.data() + offset), &decrypted_len, NULL, reinterpret_cast<unsigned char const*>(encryptedChunk.constData()), encryptedChunkSize, reinterpret_cast<unsigned char const*>(additionalData.constData()), additionalData.size(), reinterpret_cast<unsigned char const*>(chunkNonce.constData()), reinterpret_cast<unsigned char const*>(key.constData())) != 0) {
+					LOGGER()->warn("Could not fetch media item for uuid \"{}\". Chunk {} failed authentication.", uuid.toStdString(), chunkIndex);
+					return MediaFileItem::ItemStatus::UNAVAILABLE_DECRYPTION_FAILED;
+				}
+
+				sodium_increment(reinterpret_cast<unsigned char*>(chunkNonce.data()), chunkNonce.size());
+				offset += chunkSize;
+				++chunkIndex;
+			} while (offset < size);
 
-			return encryptedData;
+			return MediaFileItem::ItemStatus::AVAILABLE;
 		}
 
 		void ExternalMediaFileStorage::insertMediaItemsFromBackup(QList<openmittsu::backup::ContactMediaItemBackupObject> const& items) {
+			m_database.commitWriteBatch();
 			if (!m_database.database.transaction()) {
 				LOGGER()->warn("ExternalMediaFileStorage: Could NOT start transaction!");
 			}
@@ -203,6 +291,7 @@ namespace openmittsu {
 		}
 
 		void ExternalMediaFileStorage::insertMediaItemsFromBackup(QList<openmittsu::backup::GroupMediaItemBackupObject> const& items) {
+			m_database.commitWriteBatch();
 			if (!m_database.database.transaction()) {
 				LOGGER()->warn("ExternalMediaFileStorage: Could NOT start transaction!");
 			}
@@ -2,6 +2,9 @@
 #define OPENMITTSU_DATABASE_EXTERNALMEDIAFILESTORAGE_H_
 
 #include "src/database/MediaFileStorage.h"
+
+#include <QFile>
+
 #include <utility>
 
 namespace openmittsu {
@@ -23,7 +26,10 @@ namespace openmittsu {
 			virtual void insertMediaItemsFromBackup(QList<openmittsu::backup::ContactMediaItemBackupObject> const& items) override;
 			virtual void insertMediaItemsFromBackup(QList<openmittsu::backup::GroupMediaItemBackupObject> const& items) override;
 		private:
-			QString buildFilename(QString const& uuid) const;
+			/**
+			 * Format 1 encrypts the whole item at once, format 2 in fixed-size chunks (see writeEncryptedChunks()).
+			 */
+			QString buildFilename(QString const& uuid, int formatVersion) const;
 			
 			int cryptoGetNonceSize() const;
 			int cryptoGetHeaderSize() const;
@@ -33,7 +39,18 @@ namespace openmittsu {
 			QByteArray decrypt(QByteArray const& encryptedData, QByteArray const& key, QByteArray const& nonce) const;
 			QByteArray generateKey() const;
 			QByteArray generateNonce() const;
-			QByteArray encrypt(QByteArray const& unencryptedData, QByteArray const& key, QByteArray const& nonce) const;
+
+			/**
+			 * Encrypts data chunk by chunk into file. Each chunk is sealed on its own, with the nonce incremented per chunk and the chunk index
+			 * and a last-chunk flag as additional data, so chunks can neither be reordered nor dropped from the end.
+			 * Only one chunk of cipher text is held in memory at any time.
+			 */
+			void writeEncryptedChunks(QFile& file, QByteArray const& data, QByteArray const& key, QByteArray const& nonce) const;
+			/**
+			 * Reads and authenticates all chunks written by writeEncryptedChunks(). A short or unreadable file is reported as corrupted, a chunk failing authentication as a failed decryption.
+			 */
+			MediaFileItem::ItemStatus readEncryptedChunks(QFile& file, QString const& uuid, int size, QByteArray const& key, QByteArray const& nonce, QByteArray& decryptedData) const;
+			qint64 getChunkedEncryptedSize(int size) const;
 
 			QDir const m_storagePath;
 			openmittsu::database::Database& m_database;
@@ -0,0 +1,83 @@
+#include "src/database/PreparedStatementCache.h"
+
+#include <QMap>
+#include <QVariant>
+
+namespace openmittsu {
+	namespace database {
+
+		PreparedStatementCache::CachedQuery::CachedQuery(PreparedStatementCache* cache, QString const& sql, std::shared_ptr<QSqlQuery> const& query, bool isPrepared) : m_cache(cache), m_sql(sql), m_query(query), m_isPrepared(isPrepared) {
+			// Intentionally left empty.
+		}
+
+		PreparedStatementCache::CachedQuery::CachedQuery(CachedQuery&& other) : m_cache(other.m_cache), m_sql(std::move(other.m_sql)), m_query(std::move(other.m_query)), m_isPrepared(other.m_isPrepared) {
+			other.m_cache = nullptr;
+		}
+
+		PreparedStatementCache::CachedQuery::~CachedQuery() {
+			if ((m_cache != nullptr) && (m_query != nullptr) && m_isPrepared) {
+				m_cache->release(m_sql, m_query);
+			}
+		}
+
+		QSqlQuery& PreparedStatementCache::CachedQuery::get() {
+			return *m_query;
+		}
+
+		PreparedStatementCache::PreparedStatementCache(int capacity) : m_statements(capacity), m_hits(0), m_misses(0) {
+			// Intentionally left empty.
+		}
+
+		PreparedStatementCache::~PreparedStatementCache() {
+			// Intentionally left empty.
+		}
+
+		PreparedStatementCache::CachedQuery PreparedStatementCache::prepare(QSqlDatabase const& database, QString const& sql) {
+			std::shared_ptr<QSqlQuery> query;
+			if (m_statements.get(sql, query)) {
+				m_statements.remove(sql);
+				++m_hits;
+				return CachedQuery(this, sql, query, true);
+			}
+
+			++m_misses;
+			query = std::make_shared<QSqlQuery>(database);
+			bool const isPrepared = query->prepare(sql);
+			return CachedQuery(this, sql, query, isPrepared);
+		}
+
+		void PreparedStatementCache::release(QString const& sql, std::shared_ptr<QSqlQuery> const& query) {
+			// A caller that prepared different SQL on the same object must not leave it behind under the old key.
+			if (query->lastQuery() != sql) {
+				return;
+			}
+
+			query->finish();
+			QMap<QString, QVariant> const boundValues = query->boundValues();
+			auto it = boundValues.constBegin();
+			auto const end = boundValues.constEnd();
+			for (; it != end; ++it) {
+				query->bindValue(it.key(), QVariant());
+			}
+
+			m_statements.insert(sql, query);
+		}
+
+		void PreparedStatementCache::clear() {
+			m_statements.clear();
+		}
+
+		quint64 PreparedStatementCache::getHitCount() const {
+			return m_hits;
+		}
+
+		quint64 PreparedStatementCache::getMissCount() const {
+			return m_misses;
+		}
+
+		int PreparedStatementCache::getSize() const {
+			return m_statements.size();
+		}
+
+	}
+}
@@ -0,0 +1,68 @@
+#ifndef OPENMITTSU_DATABASE_PREPAREDSTATEMENTCACHE_H_
+#define OPENMITTSU_DATABASE_PREPAREDSTATEMENTCACHE_H_
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+
+#include <memory>
+
+#include "src/utility/LruCache.h"
+
+namespace openmittsu {
+	namespace database {
+
+		/**
+		 * Keeps the prepared statements of one database connection, keyed by their SQL text, so point lookups do not parse and plan the same SQL again.
+		 * A statement is handed out exclusively until its CachedQuery is destroyed, a nested use of the same SQL text prepares a second one.
+		 * Not thread-safe, just like the connection it belongs to.
+		 */
+		class PreparedStatementCache {
+		public:
+			class CachedQuery {
+			public:
+				CachedQuery(CachedQuery&& other);
+				~CachedQuery();
+
+				CachedQuery(CachedQuery const& other) = delete;
+				CachedQuery& operator=(CachedQuery const& other) = delete;
+				CachedQuery& operator=(CachedQuery&& other) = delete;
+
+				QSqlQuery& get();
+			private:
+				friend class PreparedStatementCache;
+				CachedQuery(PreparedStatementCache* cache, QString const& sql, std::shared_ptr<QSqlQuery> const& query, bool isPrepared);
+
+				PreparedStatementCache* m_cache;
+				QString m_sql;
+				std::shared_ptr<QSqlQuery> m_query;
+				bool m_isPrepared;
+			};
+
+			explicit PreparedStatementCache(int capacity);
+			virtual ~PreparedStatementCache();
+
+			/**
+			 * Returns a statement prepared with the given SQL, with all bound values reset.
+			 * If preparing fails, the statement is returned anyway so the caller reports the error from exec() as before, but it is not cached.
+			 */
+			CachedQuery prepare(QSqlDatabase const& database, QString const& sql);
+
+			/** Drops all idle statements, has to be called before the connection is closed. */
+			void clear();
+
+			quint64 getHitCount() const;
+			quint64 getMissCount() const;
+			int getSize() const;
+		private:
+			openmittsu::utility::LruCache<QString, std::shared_ptr<QSqlQuery>> m_statements;
+			quint64 m_hits;
+			quint64 m_misses;
+
+			void release(QString const& sql, std::shared_ptr<QSqlQuery> const& query);
+		};
+
+	}
+}
+
+#endif // OPENMITTSU_DATABASE_PREPAREDSTATEMENTCACHE_H_
@@ -0,0 +1,75 @@
+#include "src/database/WriteBatcher.h"
+
+#include "src/exceptions/IllegalArgumentException.h"
+
+namespace openmittsu {
+	namespace database {
+
+		WriteBatcher::WriteBatcher(int maxOperations) : m_maxOperations(maxOperations), m_isOpen(false), m_operationCount(0), m_notifications(), m_rollbackHandlers() {
+			if (maxOperations < 1) {
+				throw openmittsu::exceptions::IllegalArgumentException() << "The maximal number of operations per batch has to be positive, not " << maxOperations << ".";
+			}
+		}
+
+		WriteBatcher::~WriteBatcher() {
+			// Intentionally left empty.
+		}
+
+		bool WriteBatcher::beginOperation() {
+			if (m_isOpen) {
+				return false;
+			}
+
+			m_isOpen = true;
+			m_operationCount = 0;
+			return true;
+		}
+
+		bool WriteBatcher::endOperation() {
+			if (!m_isOpen) {
+				return false;
+			}
+
+			++m_operationCount;
+			return m_operationCount >= m_maxOperations;
+		}
+
+		bool WriteBatcher::isOpen() const {
+			return m_isOpen;
+		}
+
+		int WriteBatcher::getOperationCount() const {
+			return m_operationCount;
+		}
+
+		void WriteBatcher::addNotification(std::function<void()> const& notification) {
+			m_notifications.append(notification);
+		}
+
+		void WriteBatcher::addRollbackHandler(std::function<void()> const& rollbackHandler) {
+			m_rollbackHandlers.append(rollbackHandler);
+		}
+
+		QList<std::function<void()>> WriteBatcher::takeNotifications() {
+			QList<std::function<void()>> result;
+			result.swap(m_notifications);
+			clear();
+			return result;
+		}
+
+		QList<std::function<void()>> WriteBatcher::takeRollbackHandlers() {
+			QList<std::function<void()>> result;
+			result.swap(m_rollbackHandlers);
+			clear();
+			return result;
+		}
+
+		void WriteBatcher::clear() {
+			m_notifications.clear();
+			m_rollbackHandlers.clear();
+			m_isOpen = false;
+			m_operationCount = 0;
+		}
+
+	}
+}
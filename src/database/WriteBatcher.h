@@ -0,0 +1,50 @@
+#ifndef OPENMITTSU_DATABASE_WRITEBATCHER_H_
+#define OPENMITTSU_DATABASE_WRITEBATCHER_H_
+
+#include <QList>
+
+#include <functional>
+
+namespace openmittsu {
+	namespace database {
+
+		/**
+		 * Bookkeeping for grouping many small writes into one transaction, so a burst of them costs one journal sync instead of one each.
+		 * Notifications caused by the batched writes are held back until the batch has been committed, listeners never see a change that could still be rolled back.
+		 * The transaction itself is handled by the owner of the connection.
+		 */
+		class WriteBatcher {
+		public:
+			explicit WriteBatcher(int maxOperations);
+			virtual ~WriteBatcher();
+
+			/** Returns true if this operation opens a new batch, in which case the caller has to start a transaction. */
+			bool beginOperation();
+			/** Returns true if the batch has reached its maximal size and should be committed now. */
+			bool endOperation();
+
+			bool isOpen() const;
+			int getOperationCount() const;
+
+			void addNotification(std::function<void()> const& notification);
+			/** Registers a handler that is told if the batch is rolled back, so the writer learns that its write was lost. */
+			void addRollbackHandler(std::function<void()> const& rollbackHandler);
+
+			/** Closes the batch after a commit, drops the rollback handlers and returns the held back notifications in the order they were added. */
+			QList<std::function<void()>> takeNotifications();
+			/** Closes the batch after a rollback, drops the notifications and returns the rollback handlers in the order they were added. */
+			QList<std::function<void()>> takeRollbackHandlers();
+			/** Closes the batch and drops its notifications and rollback handlers, used when the transaction could not be started. */
+			void clear();
+		private:
+			int const m_maxOperations;
+			bool m_isOpen;
+			int m_operationCount;
+			QList<std::function<void()>> m_notifications;
+			QList<std::function<void()>> m_rollbackHandlers;
+		};
+
+	}
+}
+
+#endif // OPENMITTSU_DATABASE_WRITEBATCHER_H_
@@ -165,6 +165,7 @@ namespace openmittsu {
 		void BackedMessage::onMessageChanged(QString const& uuid) {
 			if (m_uuid == uuid) {
 				LOGGER_DEBUG("BackedMessage: Reloading cache and announcing messageChanged() for UUID {}.", uuid.toStdString());
+				getMessage().refresh();
 				loadCache();
 
 				emit messageDataChanged();
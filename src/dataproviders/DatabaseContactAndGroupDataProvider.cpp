@@ -38,9 +38,8 @@ namespace openmittsu {
 		}
 
 		bool DatabaseContactAndGroupDataProvider::hasGroup(openmittsu::protocol::GroupId const& group) const {
-			QSqlQuery query(m_database.database);
-
-			query.prepare(QStringLiteral("SELECT `members` FROM `groups` WHERE `id` = :groupId AND `creator` = :groupCreator AND `is_deleted` = 0"));
+			openmittsu::database::PreparedStatementCache::CachedQuery cachedQuery(m_database.prepareCachedQuery(QStringLiteral("SELECT `members` FROM `groups` WHERE `id` = :groupId AND `creator` = :groupCreator AND `is_deleted` = 0")));
+			QSqlQuery& query = cachedQuery.get();
 			query.bindValue(QStringLiteral(":groupId"), QVariant(group.groupIdWithoutOwnerToQString()));
 			query.bindValue(QStringLiteral(":groupCreator"), QVariant(group.getOwner().toQString()));
 
@@ -52,9 +51,8 @@ namespace openmittsu {
 		}
 
 		openmittsu::protocol::GroupStatus DatabaseContactAndGroupDataProvider::getGroupStatus(openmittsu::protocol::GroupId const& group) const {
-			QSqlQuery query(m_database.database);
-
-			query.prepare(QStringLiteral("SELECT `is_deleted`, `is_awaiting_sync` FROM `groups` WHERE `id` = :groupId AND `creator` = :groupCreator"));
+			openmittsu::database::PreparedStatementCache::CachedQuery cachedQuery(m_database.prepareCachedQuery(QStringLiteral("SELECT `is_deleted`, `is_awaiting_sync` FROM `groups` WHERE `id` = :groupId AND `creator` = :groupCreator")));
+			QSqlQuery& query = cachedQuery.get();
 			query.bindValue(QStringLiteral(":groupId"), QVariant(group.groupIdWithoutOwnerToQString()));
 			query.bindValue(QStringLiteral(":groupCreator"), QVariant(group.getOwner().toQString()));
 
@@ -226,8 +224,8 @@ namespace openmittsu {
 		}
 
 		QSet<openmittsu::protocol::GroupId> DatabaseContactAndGroupDataProvider::getKnownGroups() const {
-			QSqlQuery query(m_database.database);
-			query.prepare(QStringLiteral("SELECT `id`, `creator` FROM `groups` WHERE `is_deleted` = 0"));
+			openmittsu::database::PreparedStatementCache::CachedQuery cachedQuery(m_database.prepareCachedQuery(QStringLiteral("SELECT `id`, `creator` FROM `groups` WHERE `is_deleted` = 0")));
+			QSqlQuery& query = cachedQuery.get();
 
 			if (query.exec() && query.isSelect()) {
 				QSet<openmittsu::protocol::GroupId> result;
@@ -245,8 +243,8 @@ namespace openmittsu {
 		}
 
 		QHash<openmittsu::protocol::GroupId, std::pair<QSet<openmittsu::protocol::ContactId>, QString>> DatabaseContactAndGroupDataProvider::getKnownGroupsWithMembersAndTitles() const {
-			QSqlQuery query(m_database.database);
-			query.prepare(QStringLiteral("SELECT `id`, `creator`, `groupname`, `members` FROM `groups` WHERE `is_deleted` = 0"));
+			openmittsu::database::PreparedStatementCache::CachedQuery cachedQuery(m_database.prepareCachedQuery(QStringLiteral("SELECT `id`, `creator`, `groupname`, `members` FROM `groups` WHERE `is_deleted` = 0")));
+			QSqlQuery& query = cachedQuery.get();
 
 			if (query.exec() && query.isSelect()) {
 				QHash<openmittsu::protocol::GroupId, std::pair<QSet<openmittsu::protocol::ContactId>, QString>> result;
@@ -267,8 +265,8 @@ namespace openmittsu {
 		}
 
 		QSet<openmittsu::protocol::GroupId> DatabaseContactAndGroupDataProvider::getKnownGroupsContainingMember(openmittsu::protocol::ContactId const& identity) const {
-			QSqlQuery query(m_database.database);
-			query.prepare(QStringLiteral("SELECT `id`, `creator`, `members` FROM `groups` WHERE `is_deleted` = 0"));
+			openmittsu::database::PreparedStatementCache::CachedQuery cachedQuery(m_database.prepareCachedQuery(QStringLiteral("SELECT `id`, `creator`, `members` FROM `groups` WHERE `is_deleted` = 0")));
+			QSqlQuery& query = cachedQuery.get();
 
 			if (query.exec() && query.isSelect()) {
 				QSet<openmittsu::protocol::GroupId> result;
@@ -311,9 +309,8 @@ namespace openmittsu {
 		}
 
 		QVariant DatabaseContactAndGroupDataProvider::queryField(openmittsu::protocol::GroupId const& group, QString const& fieldName) const {
-			QSqlQuery query(m_database.database);
-
-			query.prepare(QStringLiteral("SELECT `%1` FROM `groups` WHERE `id` = :groupId AND `creator` = :groupCreator;").arg(fieldName));
+			openmittsu::database::PreparedStatementCache::CachedQuery cachedQuery(m_database.prepareCachedQuery(QStringLiteral("SELECT `%1` FROM `groups` WHERE `id` = :groupId AND `creator` = :groupCreator;").arg(fieldName)));
+			QSqlQuery& query = cachedQuery.get();
 			query.bindValue(QStringLiteral(":groupId"), QVariant(group.groupIdWithoutOwnerToQString()));
 			query.bindValue(QStringLiteral(":groupCreator"), QVariant(group.getOwner().toQString()));
 
@@ -366,9 +363,8 @@ namespace openmittsu {
 		}
 
 		QVariant DatabaseContactAndGroupDataProvider::queryField(openmittsu::protocol::ContactId const& contact, QString const& fieldName) const {
-			QSqlQuery query(m_database.database);
-
-			query.prepare(QStringLiteral("SELECT `%1` FROM `contacts` WHERE `identity` = :identity;").arg(fieldName));
+			openmittsu::database::PreparedStatementCache::CachedQuery cachedQuery(m_database.prepareCachedQuery(QStringLiteral("SELECT `%1` FROM `contacts` WHERE `identity` = :identity;").arg(fieldName)));
+			QSqlQuery& query = cachedQuery.get();
 			query.bindValue(QStringLiteral(":identity"), QVariant(contact.toQString()));
 
 			if (!query.exec() || !query.isSelect()) {
@@ -397,9 +393,8 @@ namespace openmittsu {
 
 		// Contacts
 		bool DatabaseContactAndGroupDataProvider::hasContact(openmittsu::protocol::ContactId const& contact) const {
-			QSqlQuery query(m_database.database);
-
-			query.prepare(QStringLiteral("SELECT `identity` FROM `contacts` WHERE `identity` = :identity;"));
+			openmittsu::database::PreparedStatementCache::CachedQuery cachedQuery(m_database.prepareCachedQuery(QStringLiteral("SELECT `identity` FROM `contacts` WHERE `identity` = :identity;")));
+			QSqlQuery& query = cachedQuery.get();
 			query.bindValue(QStringLiteral(":identity"), QVariant(contact.toQString()));
 
 			if (!query.exec() || !query.isSelect()) {
@@ -529,6 +524,7 @@ namespace openmittsu {
 			auto end = status.constEnd();
 			qint64 const timeNow = openmittsu::protocol::MessageTime::now().getMessageTimeMSecs();
 
+			m_database.commitWriteBatch();
 			m_database.database.transaction();
 			for (; it != end; ++it) {
 				setFields(it.key(), { {QStringLiteral("status"), openmittsu::protocol::AccountStatusHelper::toInt(it.value())}, {QStringLiteral("status_last_check"), timeNow} }, false);
@@ -544,6 +540,7 @@ namespace openmittsu {
 			auto end = featureLevels.constEnd();
 			qint64 const timeNow = openmittsu::protocol::MessageTime::now().getMessageTimeMSecs();
 
+			m_database.commitWriteBatch();
 			m_database.database.transaction();
 			for (; it != end; ++it) {
 				setFields(it.key(), { {QStringLiteral("feature_level"), openmittsu::protocol::FeatureLevelHelper::toInt(it.value())}, {QStringLiteral("feature_level_last_check"), timeNow} }, false);
@@ -561,8 +558,8 @@ namespace openmittsu {
 		QSet<openmittsu::protocol::ContactId> DatabaseContactAndGroupDataProvider::getKnownContacts() const {
 			QSet<openmittsu::protocol::ContactId> result;
 
-			QSqlQuery query(m_database.database);
-			query.prepare(QStringLiteral("SELECT `identity` FROM `contacts`;"));
+			openmittsu::database::PreparedStatementCache::CachedQuery cachedQuery(m_database.prepareCachedQuery(QStringLiteral("SELECT `identity` FROM `contacts`;")));
+			QSqlQuery& query = cachedQuery.get();
 
 			if (query.exec() && query.isSelect()) {
 				while (query.next()) {
@@ -609,8 +606,8 @@ namespace openmittsu {
 		QHash<openmittsu::protocol::ContactId, openmittsu::crypto::PublicKey> DatabaseContactAndGroupDataProvider::getKnownContactsWithPublicKeys() const {
 			QHash<openmittsu::protocol::ContactId, openmittsu::crypto::PublicKey> result;
 
-			QSqlQuery query(m_database.database);
-			query.prepare(QStringLiteral("SELECT `identity`, `publickey` FROM `contacts`;"));
+			openmittsu::database::PreparedStatementCache::CachedQuery cachedQuery(m_database.prepareCachedQuery(QStringLiteral("SELECT `identity`, `publickey` FROM `contacts`;")));
+			QSqlQuery& query = cachedQuery.get();
 
 			if (query.exec() && query.isSelect()) {
 				while (query.next()) {
@@ -630,8 +627,8 @@ namespace openmittsu {
 			QHash<openmittsu::protocol::ContactId, QString> result;
 			openmittsu::protocol::ContactId const selfContact = m_database.getSelfContact();
 
-			QSqlQuery query(m_database.database);
-			query.prepare(QStringLiteral("SELECT `identity`, `firstname`, `lastname`, `nick_name` FROM `contacts`;"));
+			openmittsu::database::PreparedStatementCache::CachedQuery cachedQuery(m_database.prepareCachedQuery(QStringLiteral("SELECT `identity`, `firstname`, `lastname`, `nick_name` FROM `contacts`;")));
+			QSqlQuery& query = cachedQuery.get();
 
 			if (query.exec() && query.isSelect()) {
 				while (query.next()) {
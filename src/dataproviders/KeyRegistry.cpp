@@ -11,11 +11,11 @@
 namespace openmittsu {
 	namespace dataproviders {
 
-		KeyRegistry::KeyRegistry() : QObject(), m_mutex(), m_isCacheValid(false), m_cachedSelfContactId(0), m_serverLongTermPublicKey(), m_database() {
+		KeyRegistry::KeyRegistry() : QObject(), m_mutex(), m_isCacheValid(false), m_keyGeneration(0), m_cachedSelfContactId(0), m_serverLongTermPublicKey(), m_database() {
 			throw;
 		}
 
-		KeyRegistry::KeyRegistry(KeyRegistry const& other) : m_mutex(), m_isCacheValid(false), m_cachedSelfContactId(0), m_serverLongTermPublicKey(other.m_serverLongTermPublicKey), m_database(other.m_database) {
+		KeyRegistry::KeyRegistry(KeyRegistry const& other) : m_mutex(), m_isCacheValid(false), m_keyGeneration(0), m_cachedSelfContactId(0), m_serverLongTermPublicKey(other.m_serverLongTermPublicKey), m_database(other.m_database) {
 			{
 				auto db = m_database.lock();
 				if (!db) {
@@ -28,7 +28,7 @@ namespace openmittsu {
 		}
 
 		KeyRegistry::KeyRegistry(openmittsu::crypto::PublicKey const& serverLongTermPublicKey, std::weak_ptr<openmittsu::database::Database> const& database)
-			: m_mutex(), m_isCacheValid(false), m_cachedSelfContactId(0), m_serverLongTermPublicKey(serverLongTermPublicKey), m_database(database) {
+			: m_mutex(), m_isCacheValid(false), m_keyGeneration(0), m_cachedSelfContactId(0), m_serverLongTermPublicKey(serverLongTermPublicKey), m_database(database) {
 			{
 				auto db = m_database.lock();
 				if (!db) {
@@ -88,10 +88,27 @@ namespace openmittsu {
 			return m_cachedClientLongTermKeyPair;
 		}
 
+		quint64 KeyRegistry::getKeyGeneration() const {
+			return m_keyGeneration.load();
+		}
+
 		openmittsu::crypto::PublicKey const& KeyRegistry::getServerLongTermPublicKey() const {
 			return m_serverLongTermPublicKey;
 		}
 
+		bool KeyRegistry::hasChangedOrRemovedKeys(QHash<openmittsu::protocol::ContactId, openmittsu::crypto::PublicKey> const& publicKeys) const {
+			// A removed contact counts as well, it might come back later with a different key.
+			auto it = m_cachedPublicKeys.constBegin();
+			auto const end = m_cachedPublicKeys.constEnd();
+			for (; it != end; ++it) {
+				auto const newKey = publicKeys.constFind(it.key());
+				if ((newKey == publicKeys.constEnd()) || (newKey.value() != it.value())) {
+					return true;
+				}
+			}
+			return false;
+		}
+
 		void KeyRegistry::invalidateCache() {
 			this->m_isCacheValid = false;
 		}
@@ -102,10 +119,18 @@ namespace openmittsu {
 				throw openmittsu::exceptions::InternalErrorException() << "KeyRegistry::updateCache() called while the database is unavailable.";
 			} else {
 				openmittsu::backup::IdentityBackup const backupData = db->getBackup();
+				QHash<openmittsu::protocol::ContactId, openmittsu::crypto::PublicKey> const publicKeys = db->getKnownContactsWithPublicKeys();
+
+				// Most contact changes (nicknames, colors, new contacts, ...) leave the known keys untouched, only announce real key changes.
+				bool const keysChanged = (m_cachedClientLongTermKeyPair != backupData.getClientLongTermKeyPair()) || hasChangedOrRemovedKeys(publicKeys);
 
 				m_cachedSelfContactId = backupData.getClientContactId();
 				m_cachedClientLongTermKeyPair = backupData.getClientLongTermKeyPair();
-				m_cachedPublicKeys = db->getKnownContactsWithPublicKeys();
+				m_cachedPublicKeys = publicKeys;
+
+				if (keysChanged) {
+					++m_keyGeneration;
+				}
 
 				this->m_isCacheValid = true;
 				LOGGER_DEBUG("Updated cache in KeyRegistry.");
@@ -9,6 +9,7 @@
 #include <QMutex>
 #include <QHash>
 
+#include <atomic>
 #include <memory>
 
 namespace openmittsu {
@@ -32,15 +33,22 @@ namespace openmittsu {
 			openmittsu::crypto::PublicKey const& getServerLongTermPublicKey() const;
 
 			openmittsu::protocol::ContactId getSelfContactId() const;
+
+			/**
+			 * A counter that is incremented whenever a cached key changes. Does not take the mutex, so derived caches can cheaply check whether they are stale.
+			 */
+			quint64 getKeyGeneration() const;
 		private slots:
 			void onContactChanged();
 		private:
 			KeyRegistry();
 			void invalidateCache();
 			void updateCache();
+			bool hasChangedOrRemovedKeys(QHash<openmittsu::protocol::ContactId, openmittsu::crypto::PublicKey> const& publicKeys) const;
 
 			mutable QMutex m_mutex;
 			bool m_isCacheValid;
+			std::atomic<quint64> m_keyGeneration;
 
 			openmittsu::protocol::ContactId m_cachedSelfContactId;
 			openmittsu::crypto::KeyPair m_cachedClientLongTermKeyPair;
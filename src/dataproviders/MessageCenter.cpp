@@ -458,7 +458,7 @@ namespace openmittsu {
 		}
 
 		void MessageCenter::tryResendingMessagesToNetwork() {
-			if ((this->m_networkSentMessageAcceptor != nullptr) && (this->m_networkSentMessageAcceptor->isConnected()) && (this->m_storage != nullptr)) {
+			if ((this->m_networkSentMessageAcceptor != nullptr) && (this->m_networkSentMessageAcceptor->isConnected()) && (this->m_networkSentMessageAcceptor->isReadyForMoreMessages()) && (this->m_storage != nullptr)) {
 				LOGGER()->info("Asking database to send all queued messges now...");
 				this->m_storage->sendAllWaitingMessages(*m_networkSentMessageAcceptor);
 			}
@@ -473,6 +473,7 @@ namespace openmittsu {
 			}
 
 			this->m_storage = newStorage;
+			m_messageQueue.setStorage(newStorage);
 			OPENMITTSU_CONNECT(dynamic_cast<QObject*>(newStorage.get()), messageChanged(QString const&), this, databaseOnMessageChanged(QString const&));
 			OPENMITTSU_CONNECT(dynamic_cast<QObject*>(newStorage.get()), haveQueuedMessages(), this, tryResendingMessagesToNetwork());
 			OPENMITTSU_CONNECT(dynamic_cast<QObject*>(newStorage.get()), receivedNewContactMessage(openmittsu::protocol::ContactId const&), this, databaseOnReceivedNewContactMessage(openmittsu::protocol::ContactId const&));
@@ -492,9 +493,7 @@ namespace openmittsu {
 
 			openTabForIncomingMessage(sender);
 			this->m_storage->storeReceivedContactMessageText(sender, messageId, timeSent, timeReceived, message);
-			if (this->m_networkSentMessageAcceptor != nullptr) {
-				this->m_networkSentMessageAcceptor->sendMessageReceivedAcknowledgement(sender, messageId);
-			}
+			sendMessageReceivedAcknowledgementAfterCommit(sender, messageId);
 
 			sendReceipt(sender, messageId, openmittsu::messages::contact::ReceiptMessageContent::ReceiptType::RECEIVED);
 		}
@@ -509,9 +508,7 @@ namespace openmittsu {
 
 			openTabForIncomingMessage(sender);
 			this->m_storage->storeReceivedContactMessageImage(sender, messageId, timeSent, timeReceived, image, caption);
-			if (this->m_networkSentMessageAcceptor != nullptr) {
-				this->m_networkSentMessageAcceptor->sendMessageReceivedAcknowledgement(sender, messageId);
-			}
+			sendMessageReceivedAcknowledgementAfterCommit(sender, messageId);
 
 			sendReceipt(sender, messageId, openmittsu::messages::contact::ReceiptMessageContent::ReceiptType::RECEIVED);
 		}
@@ -524,9 +521,7 @@ namespace openmittsu {
 
 			openTabForIncomingMessage(sender);
 			this->m_storage->storeReceivedContactMessageLocation(sender, messageId, timeSent, timeReceived, location);
-			if (this->m_networkSentMessageAcceptor != nullptr) {
-				this->m_networkSentMessageAcceptor->sendMessageReceivedAcknowledgement(sender, messageId);
-			}
+			sendMessageReceivedAcknowledgementAfterCommit(sender, messageId);
 
 			sendReceipt(sender, messageId, openmittsu::messages::contact::ReceiptMessageContent::ReceiptType::RECEIVED);
 		}
@@ -539,9 +534,7 @@ namespace openmittsu {
 
 			LOGGER_DEBUG("We received a contact message receipt type RECEIVED from sender {} with message ID #{} sent at {} for message ID #{}.", sender.toString(), messageId.toString(), timeSent.toString(), referredMessageId.toString());
 			this->m_storage->storeReceivedContactMessageReceiptReceived(sender, messageId, timeSent, referredMessageId);
-			if (this->m_networkSentMessageAcceptor != nullptr) {
-				this->m_networkSentMessageAcceptor->sendMessageReceivedAcknowledgement(sender, messageId);
-			}
+			sendMessageReceivedAcknowledgementAfterCommit(sender, messageId);
 		}
 
 		void MessageCenter::processReceivedContactMessageReceiptSeen(openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, openmittsu::protocol::MessageId const& referredMessageId) {
@@ -552,9 +545,7 @@ namespace openmittsu {
 
 			LOGGER_DEBUG("We received a contact message receipt type SEEN from sender {} with message ID #{} sent at {} for message ID #{}.", sender.toString(), messageId.toString(), timeSent.toString(), referredMessageId.toString());
 			this->m_storage->storeReceivedContactMessageReceiptSeen(sender, messageId, timeSent, referredMessageId);
-			if (this->m_networkSentMessageAcceptor != nullptr) {
-				this->m_networkSentMessageAcceptor->sendMessageReceivedAcknowledgement(sender, messageId);
-			}
+			sendMessageReceivedAcknowledgementAfterCommit(sender, messageId);
 		}
 
 		void MessageCenter::processReceivedContactMessageReceiptAgree(openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, openmittsu::protocol::MessageId const& referredMessageId) {
@@ -566,9 +557,7 @@ namespace openmittsu {
 			LOGGER_DEBUG("We received a contact message receipt type AGREE from sender {} with message ID #{} sent at {} for message ID #{}.", sender.toString(), messageId.toString(), timeSent.toString(), referredMessageId.toString());
 			openTabForIncomingMessage(sender);
 			this->m_storage->storeReceivedContactMessageReceiptAgree(sender, messageId, timeSent, referredMessageId);
-			if (this->m_networkSentMessageAcceptor != nullptr) {
-				this->m_networkSentMessageAcceptor->sendMessageReceivedAcknowledgement(sender, messageId);
-			}
+			sendMessageReceivedAcknowledgementAfterCommit(sender, messageId);
 		}
 
 		void MessageCenter::processReceivedContactMessageReceiptDisagree(openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, openmittsu::protocol::MessageId const& referredMessageId) {
@@ -580,9 +569,7 @@ namespace openmittsu {
 			LOGGER_DEBUG("We received a contact message receipt type DISAGREE from sender {} with message ID #{} sent at {} for message ID #{}.", sender.toString(), messageId.toString(), timeSent.toString(), referredMessageId.toString());
 			openTabForIncomingMessage(sender);
 			this->m_storage->storeReceivedContactMessageReceiptDisagree(sender, messageId, timeSent, referredMessageId);
-			if (this->m_networkSentMessageAcceptor != nullptr) {
-				this->m_networkSentMessageAcceptor->sendMessageReceivedAcknowledgement(sender, messageId);
-			}
+			sendMessageReceivedAcknowledgementAfterCommit(sender, messageId);
 		}
 
 		void MessageCenter::processReceivedContactTypingNotificationTyping(openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent) {
@@ -593,9 +580,7 @@ namespace openmittsu {
 
 			LOGGER_DEBUG("We received a typing start notification from sender {} with message ID #{} sent at {}.", sender.toString(), messageId.toString(), timeSent.toString());
 			this->m_storage->storeReceivedContactTypingNotificationTyping(sender, messageId, timeSent);
-			if (this->m_networkSentMessageAcceptor != nullptr) {
-				this->m_networkSentMessageAcceptor->sendMessageReceivedAcknowledgement(sender, messageId);
-			}
+			sendMessageReceivedAcknowledgementAfterCommit(sender, messageId);
 		}
 
 		void MessageCenter::processReceivedContactTypingNotificationStopped(openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent) {
@@ -606,9 +591,7 @@ namespace openmittsu {
 
 			LOGGER_DEBUG("We received a typing stop notification from sender {} with message ID #{} sent at {}.", sender.toString(), messageId.toString(), timeSent.toString());
 			this->m_storage->storeReceivedContactTypingNotificationStopped(sender, messageId, timeSent);
-			if (this->m_networkSentMessageAcceptor != nullptr) {
-				this->m_networkSentMessageAcceptor->sendMessageReceivedAcknowledgement(sender, messageId);
-			}
+			sendMessageReceivedAcknowledgementAfterCommit(sender, messageId);
 		}
 
 		void MessageCenter::processReceivedGroupMessageText(openmittsu::protocol::GroupId const& group, openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, openmittsu::protocol::MessageTime const& timeReceived, QString const& message) {
@@ -624,9 +607,7 @@ namespace openmittsu {
 
 			openTabForIncomingMessage(group);
 			this->m_storage->storeReceivedGroupMessageText(group, sender, messageId, timeSent, timeReceived, message);
-			if (this->m_networkSentMessageAcceptor != nullptr) {
-				this->m_networkSentMessageAcceptor->sendMessageReceivedAcknowledgement(sender, messageId);
-			}
+			sendMessageReceivedAcknowledgementAfterCommit(sender, messageId);
 		}
 
 		void MessageCenter::processReceivedGroupMessageImage(openmittsu::protocol::GroupId const& group, openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, openmittsu::protocol::MessageTime const& timeReceived, QByteArray const& image) {
@@ -644,9 +625,7 @@ namespace openmittsu {
 
 			openTabForIncomingMessage(group);
 			this->m_storage->storeReceivedGroupMessageImage(group, sender, messageId, timeSent, timeReceived, image, caption);
-			if (this->m_networkSentMessageAcceptor != nullptr) {
-				this->m_networkSentMessageAcceptor->sendMessageReceivedAcknowledgement(sender, messageId);
-			}
+			sendMessageReceivedAcknowledgementAfterCommit(sender, messageId);
 		}
 
 		void MessageCenter::processReceivedGroupMessageLocation(openmittsu::protocol::GroupId const& group, openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, openmittsu::protocol::MessageTime const& timeReceived, openmittsu::utility::Location const& location) {
@@ -664,9 +643,7 @@ namespace openmittsu {
 
 			openTabForIncomingMessage(group);
 			this->m_storage->storeReceivedGroupMessageLocation(group, sender, messageId, timeSent, timeReceived, location);
-			if (this->m_networkSentMessageAcceptor != nullptr) {
-				this->m_networkSentMessageAcceptor->sendMessageReceivedAcknowledgement(sender, messageId);
-			}
+			sendMessageReceivedAcknowledgementAfterCommit(sender, messageId);
 		}
 
 
@@ -696,9 +673,7 @@ namespace openmittsu {
 			}
 
 			this->m_storage->storeReceivedGroupCreation(group, sender, messageId, timeSent, timeReceived, members);
-			if (this->m_networkSentMessageAcceptor != nullptr) {
-				this->m_networkSentMessageAcceptor->sendMessageReceivedAcknowledgement(sender, messageId);
-			}
+			sendMessageReceivedAcknowledgementAfterCommit(sender, messageId);
 
 			QVector<MessageQueue::ReceivedGroupMessage> queuedMessages = m_messageQueue.getAndRemoveQueuedMessages(group);
 			auto it = queuedMessages.constBegin();
@@ -748,9 +723,7 @@ namespace openmittsu {
 			}
 
 			this->m_storage->storeReceivedGroupSetImage(group, sender, messageId, timeSent, timeReceived, image);
-			if (this->m_networkSentMessageAcceptor != nullptr) {
-				this->m_networkSentMessageAcceptor->sendMessageReceivedAcknowledgement(sender, messageId);
-			}
+			sendMessageReceivedAcknowledgementAfterCommit(sender, messageId);
 		}
 
 		void MessageCenter::processReceivedGroupSetTitle(openmittsu::protocol::GroupId const& group, openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, openmittsu::protocol::MessageTime const& timeReceived, QString const& groupTitle) {
@@ -768,9 +741,7 @@ namespace openmittsu {
 			}
 
 			this->m_storage->storeReceivedGroupSetTitle(group, sender, messageId, timeSent, timeReceived, groupTitle);
-			if (this->m_networkSentMessageAcceptor != nullptr) {
-				this->m_networkSentMessageAcceptor->sendMessageReceivedAcknowledgement(sender, messageId);
-			}
+			sendMessageReceivedAcknowledgementAfterCommit(sender, messageId);
 		}
 
 		void MessageCenter::processReceivedGroupSyncRequest(openmittsu::protocol::GroupId const& group, openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, openmittsu::protocol::MessageTime const& timeReceived) {
@@ -791,9 +762,7 @@ namespace openmittsu {
 			}
 
 			this->m_storage->storeReceivedGroupSyncRequest(group, sender, messageId, timeSent, timeReceived);
-			if (this->m_networkSentMessageAcceptor != nullptr) {
-				this->m_networkSentMessageAcceptor->sendMessageReceivedAcknowledgement(sender, messageId);
-			}
+			sendMessageReceivedAcknowledgementAfterCommit(sender, messageId);
 
 			this->resendGroupSetup(group, {sender});
 		}
@@ -810,9 +779,7 @@ namespace openmittsu {
 			}
 
 			this->m_storage->storeReceivedGroupLeave(group, sender, messageId, timeSent, timeReceived);
-			if (this->m_networkSentMessageAcceptor != nullptr) {
-				this->m_networkSentMessageAcceptor->sendMessageReceivedAcknowledgement(sender, messageId);
-			}
+			sendMessageReceivedAcknowledgementAfterCommit(sender, messageId);
 		}
 
 		void MessageCenter::onMessageSendFailed(openmittsu::protocol::ContactId const& receiver, openmittsu::protocol::MessageId const& messageId) {
@@ -873,6 +840,49 @@ namespace openmittsu {
 			this->m_storage->storeNewGroup(groupId, members, false);
 		}
 
+		void MessageCenter::onPendingMessageSpilled(QString const& waitingFor, QByteArray const& messagePacket) {
+			if (this->m_storage == nullptr) {
+				LOGGER()->warn("Could not store a message waiting for {} as the storage system is not ready, it will be delivered again.", waitingFor.toStdString());
+				return;
+			}
+
+			this->m_storage->storePendingMessage(waitingFor, messagePacket);
+		}
+
+		void MessageCenter::onPendingMessagesReady(QString const& waitingFor) {
+			if (this->m_networkSentMessageAcceptor == nullptr) {
+				LOGGER()->warn("Could not restore the messages waiting for {} as there is no connection, they will be delivered again.", waitingFor.toStdString());
+				if (this->m_storage != nullptr) {
+					this->m_storage->removePendingMessages(waitingFor);
+				}
+				return;
+			} else if (this->m_storage == nullptr) {
+				// Still answered, the ProtocolClient holds back newer messages for this key until it is.
+				LOGGER()->warn("Could not restore the messages waiting for {} as the storage system is not ready, they will be delivered again.", waitingFor.toStdString());
+				this->m_networkSentMessageAcceptor->restorePendingMessages(waitingFor, QList<QByteArray>());
+				return;
+			}
+
+			// Handed back in one go, the ProtocolClient holds back newer messages for this key until it has them.
+			QList<QByteArray> messagePackets;
+			try {
+				messagePackets = this->m_storage->getPendingMessages(waitingFor);
+			} catch (openmittsu::exceptions::InternalErrorException& iee) {
+				LOGGER()->error("Could not read the messages waiting for {} from the storage, they will be delivered again: {}", waitingFor.toStdString(), iee.what());
+			}
+			LOGGER_DEBUG("Restoring {} messages that were waiting for {}.", messagePackets.size(), waitingFor.toStdString());
+			this->m_networkSentMessageAcceptor->restorePendingMessages(waitingFor, messagePackets);
+			this->m_storage->removePendingMessages(waitingFor);
+		}
+
+		void MessageCenter::onPendingMessagesFailed(QString const& waitingFor) {
+			if (this->m_storage == nullptr) {
+				return;
+			}
+
+			this->m_storage->removePendingMessages(waitingFor);
+		}
+
 		bool MessageCenter::createNewGroupAndInformMembers(QSet<openmittsu::protocol::ContactId> const& members, bool addSelfContact, QVariant const& groupTitle, QVariant const& groupImage) {
 			if (this->m_storage == nullptr) {
 				return false;
@@ -982,6 +992,19 @@ namespace openmittsu {
 			}
 		}
 
+		void MessageCenter::sendMessageReceivedAcknowledgementAfterCommit(openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId) {
+			if (this->m_networkSentMessageAcceptor == nullptr) {
+				return;
+			}
+
+			std::shared_ptr<NetworkSentMessageAcceptor> const networkSentMessageAcceptor = this->m_networkSentMessageAcceptor;
+			this->m_storage->runAfterCommit([networkSentMessageAcceptor, sender, messageId]() {
+				networkSentMessageAcceptor->sendMessageReceivedAcknowledgement(sender, messageId);
+			}, [sender, messageId]() {
+				LOGGER()->error("Message #{} from {} could not be saved, not acknowledging it so the server delivers it again.", messageId.toString(), sender.toString());
+			});
+		}
+
 		void MessageCenter::requestSyncForGroupIfApplicable(openmittsu::protocol::GroupId const& group) {
 			if (!m_messageQueue.hasMessageForGroup(group)) {
 				this->sendSyncRequest(group);
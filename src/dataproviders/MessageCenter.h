@@ -99,6 +99,11 @@ namespace openmittsu {
 			void onFoundNewContact(openmittsu::protocol::ContactId const& newContact, openmittsu::crypto::PublicKey const& publicKey);
 			void onFoundNewGroup(openmittsu::protocol::GroupId const& groupId, QSet<openmittsu::protocol::ContactId> const& members);
 
+			// Received messages waiting for missing identities that the ProtocolClient could not keep in memory
+			void onPendingMessageSpilled(QString const& waitingFor, QByteArray const& messagePacket);
+			void onPendingMessagesReady(QString const& waitingFor);
+			void onPendingMessagesFailed(QString const& waitingFor);
+
 			bool createNewGroupAndInformMembers(QSet<openmittsu::protocol::ContactId> const& members, bool addSelfContact, QVariant const& groupTitle, QVariant const& groupImage);
 
 			void resendGroupSetup(openmittsu::protocol::GroupId const& group);
@@ -128,6 +133,8 @@ namespace openmittsu {
 
 			bool checkAndFixGroupMembership(openmittsu::protocol::GroupId const& group, openmittsu::protocol::ContactId const& sender);
 			void requestSyncForGroupIfApplicable(openmittsu::protocol::GroupId const& group);
+			/** The server deletes acknowledged messages, so the acknowledgement waits until the received message has been committed. */
+			void sendMessageReceivedAcknowledgementAfterCommit(openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId);
 
 			QString parseCaptionFromImage(QByteArray const& image) const;
 			void embedCaptionIntoImage(QByteArray& image, QString const& caption) const;
@@ -1,5 +1,16 @@
 #include "src/dataproviders/MessageQueue.h"
 
+#include <QDataStream>
+
+#include "src/dataproviders/MessageStorage.h"
+#include "src/exceptions/IllegalArgumentException.h"
+#include "src/exceptions/InternalErrorException.h"
+#include "src/utility/Logging.h"
+
+#define OPENMITTSU_MESSAGEQUEUE_DEFAULT_MEMORY_BUDGET_BYTES (16 * 1024 * 1024)
+#define OPENMITTSU_MESSAGEQUEUE_MESSAGE_OVERHEAD_BYTES (128)
+#define OPENMITTSU_MESSAGEQUEUE_SERIALIZATION_VERSION (1)
+
 namespace openmittsu {
 	namespace dataproviders {
 
@@ -15,7 +26,11 @@ namespace openmittsu {
 			//
 		}
 
-		MessageQueue::MessageQueue() {
+		MessageQueue::MessageQueue() : MessageQueue(OPENMITTSU_MESSAGEQUEUE_DEFAULT_MEMORY_BUDGET_BYTES) {
+			//
+		}
+
+		MessageQueue::MessageQueue(qint64 memoryBudgetBytes) : m_storedContactMessages(), m_storedGroupMessages(), m_mutex(), m_memoryBudgetBytes(memoryBudgetBytes), m_memoryUsageBytes(0), m_storage(nullptr), m_spilledGroupMessages() {
 			//
 		}
 		
@@ -35,8 +50,22 @@ namespace openmittsu {
 			}
 		}
 
+		void MessageQueue::setStorage(std::shared_ptr<MessageStorage> const& storage) {
+			QMutexLocker lock(&m_mutex);
+			m_storage = storage;
+		}
+
 		void MessageQueue::storeGroupMessage(ReceivedGroupMessage const& message) {
 			QMutexLocker lock(&m_mutex);
+			qint64 const messageSize = getMemoryUsageEstimate(message);
+			if ((m_storage != nullptr) && (m_spilledGroupMessages.contains(message.group) || (m_memoryUsageBytes + messageSize > m_memoryBudgetBytes))) {
+				LOGGER_DEBUG("Group message queue is over its memory budget, moving message #{} for group {} to the storage.", message.messageId.toString(), message.group.toString());
+				m_storage->storePendingMessage(getPendingMessagesKey(message.group), serialize(message));
+				m_spilledGroupMessages[message.group] += 1;
+				return;
+			}
+
+			m_memoryUsageBytes += messageSize;
 			if (m_storedGroupMessages.contains(message.group)) {
 				QVector<ReceivedGroupMessage>& queue = *m_storedGroupMessages.find(message.group);
 				queue.append(message);
@@ -48,7 +77,10 @@ namespace openmittsu {
 		}
 
 		bool MessageQueue::hasMessageForGroup(openmittsu::protocol::GroupId const& group) const {
-			if (m_storedGroupMessages.contains(group)) {
+			QMutexLocker lock(&m_mutex);
+			if (m_spilledGroupMessages.contains(group)) {
+				return true;
+			} else if (m_storedGroupMessages.contains(group)) {
 				return m_storedGroupMessages.constFind(group)->size() > 0;
 			}
 			return false;
@@ -67,13 +99,167 @@ namespace openmittsu {
 
 		QVector<MessageQueue::ReceivedGroupMessage> MessageQueue::getAndRemoveQueuedMessages(openmittsu::protocol::GroupId const& group) {
 			QMutexLocker lock(&m_mutex);
+
+			// Read back everything from the storage before changing any state, so a failing query loses nothing.
+			QVector<ReceivedGroupMessage> spilledQueue;
+			if (m_spilledGroupMessages.contains(group) && (m_storage != nullptr)) {
+				QList<QByteArray> const spilledMessages = m_storage->getPendingMessages(getPendingMessagesKey(group));
+				LOGGER_DEBUG("Restoring {} group messages for group {} from the storage.", spilledMessages.size(), group.toString());
+				for (QByteArray const& spilledMessage : spilledMessages) {
+					try {
+						spilledQueue.append(deserialize(spilledMessage));
+					} catch (openmittsu::exceptions::IllegalArgumentException& iae) {
+						LOGGER()->error("Dropping a queued message for group {} that could not be read back from the storage: {}", group.toString(), iae.what());
+					}
+				}
+				m_storage->removePendingMessages(getPendingMessagesKey(group));
+			}
+			m_spilledGroupMessages.remove(group);
+
+			QVector<ReceivedGroupMessage> queue;
 			if (m_storedGroupMessages.contains(group)) {
-				QVector<ReceivedGroupMessage> queue = *m_storedGroupMessages.find(group);
+				queue = *m_storedGroupMessages.find(group);
 				m_storedGroupMessages.remove(group);
-				return queue;
-			} else {
-				return QVector<ReceivedGroupMessage>();
+				for (ReceivedGroupMessage const& message : queue) {
+					m_memoryUsageBytes -= getMemoryUsageEstimate(message);
+				}
 			}
+			queue += spilledQueue;
+
+			return queue;
+		}
+
+		qint64 MessageQueue::getMemoryUsageBytes() const {
+			QMutexLocker lock(&m_mutex);
+			return m_memoryUsageBytes;
+		}
+
+		int MessageQueue::getSpilledMessageCount() const {
+			QMutexLocker lock(&m_mutex);
+			int result = 0;
+			for (int const count : m_spilledGroupMessages) {
+				result += count;
+			}
+			return result;
+		}
+
+		qint64 MessageQueue::getMemoryUsageEstimate(ReceivedGroupMessage const& message) {
+			qint64 contentSize = 0;
+			switch (message.messageType) {
+				case messages::GroupMessageType::IMAGE:
+				case messages::GroupMessageType::SET_IMAGE:
+					contentSize = message.content.toByteArray().size();
+					break;
+				case messages::GroupMessageType::TEXT:
+				case messages::GroupMessageType::SET_TITLE:
+					contentSize = message.content.toString().size() * static_cast<qint64>(sizeof(QChar));
+					break;
+				case messages::GroupMessageType::LOCATION:
+					contentSize = message.content.value<openmittsu::utility::Location>().toDatabaseString().size() * static_cast<qint64>(sizeof(QChar));
+					break;
+				default:
+					break;
+			}
+			return contentSize + OPENMITTSU_MESSAGEQUEUE_MESSAGE_OVERHEAD_BYTES;
+		}
+
+		QString MessageQueue::getPendingMessagesKey(openmittsu::protocol::GroupId const& group) {
+			return QStringLiteral("queue/group/%1").arg(group.toQString());
+		}
+
+		QByteArray MessageQueue::serialize(ReceivedGroupMessage const& message) {
+			QByteArray result;
+			QDataStream stream(&result, QIODevice::WriteOnly);
+			stream.setVersion(QDataStream::Qt_5_9);
+			stream << static_cast<quint8>(OPENMITTSU_MESSAGEQUEUE_SERIALIZATION_VERSION);
+			stream << message.group.getOwner().toQString() << message.group.getGroupId();
+			stream << message.sender.toQString() << message.messageId.getMessageId();
+			stream << message.timeSent.getMessageTimeMSecs() << message.timeReceived.getMessageTimeMSecs();
+			stream << messages::GroupMessageTypeHelper::toQString(message.messageType);
+
+			switch (message.messageType) {
+				case messages::GroupMessageType::IMAGE:
+				case messages::GroupMessageType::SET_IMAGE:
+					stream << message.content.toByteArray();
+					break;
+				case messages::GroupMessageType::TEXT:
+				case messages::GroupMessageType::SET_TITLE:
+					stream << message.content.toString();
+					break;
+				case messages::GroupMessageType::LOCATION:
+					stream << message.content.value<openmittsu::utility::Location>().toDatabaseString();
+					break;
+				default:
+					break;
+			}
+
+			return result;
+		}
+
+		MessageQueue::ReceivedGroupMessage MessageQueue::deserialize(QByteArray const& data) {
+			QDataStream stream(data);
+			stream.setVersion(QDataStream::Qt_5_9);
+
+			quint8 version = 0;
+			stream >> version;
+			if (version != OPENMITTSU_MESSAGEQUEUE_SERIALIZATION_VERSION) {
+				throw openmittsu::exceptions::IllegalArgumentException() << "Queued group message has unsupported serialization version " << static_cast<int>(version) << ".";
+			}
+
+			QString groupOwner;
+			quint64 groupId = 0;
+			QString sender;
+			quint64 messageId = 0;
+			qint64 timeSent = 0;
+			qint64 timeReceived = 0;
+			QString messageTypeString;
+			stream >> groupOwner >> groupId >> sender >> messageId >> timeSent >> timeReceived >> messageTypeString;
+			if (stream.status() != QDataStream::Ok) {
+				throw openmittsu::exceptions::IllegalArgumentException() << "Queued group message is truncated.";
+			}
+
+			messages::GroupMessageType messageType;
+			try {
+				messageType = messages::GroupMessageTypeHelper::fromString(messageTypeString);
+			} catch (openmittsu::exceptions::InternalErrorException&) {
+				throw openmittsu::exceptions::IllegalArgumentException() << "Queued group message has unknown type " << messageTypeString.toStdString() << ".";
+			}
+
+			QVariant content;
+			switch (messageType) {
+				case messages::GroupMessageType::IMAGE:
+				case messages::GroupMessageType::SET_IMAGE: {
+					QByteArray image;
+					stream >> image;
+					content = image;
+					break;
+				}
+				case messages::GroupMessageType::TEXT:
+				case messages::GroupMessageType::SET_TITLE: {
+					QString text;
+					stream >> text;
+					content = text;
+					break;
+				}
+				case messages::GroupMessageType::LOCATION: {
+					QString location;
+					stream >> location;
+					try {
+						content.setValue(openmittsu::utility::Location::fromDatabaseString(location));
+					} catch (openmittsu::exceptions::InternalErrorException&) {
+						throw openmittsu::exceptions::IllegalArgumentException() << "Queued group message has an unreadable location.";
+					}
+					break;
+				}
+				default:
+					break;
+			}
+
+			if (stream.status() != QDataStream::Ok) {
+				throw openmittsu::exceptions::IllegalArgumentException() << "Queued group message is truncated.";
+			}
+
+			return ReceivedGroupMessage(openmittsu::protocol::GroupId(openmittsu::protocol::ContactId(groupOwner), groupId), openmittsu::protocol::ContactId(sender), openmittsu::protocol::MessageId(messageId), openmittsu::protocol::MessageTime::fromDatabase(timeSent), openmittsu::protocol::MessageTime::fromDatabase(timeReceived), messageType, content);
 		}
 
 	}
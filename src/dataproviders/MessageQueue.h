@@ -1,6 +1,7 @@
 #ifndef OPENMITTSU_DATAPROVIDERS_MESSAGEQUEUE_H_
 #define OPENMITTSU_DATAPROVIDERS_MESSAGEQUEUE_H_
 
+#include <QByteArray>
 #include <QHash>
 #include <QMutex>
 #include <QSet>
@@ -20,10 +21,16 @@
 
 namespace openmittsu {
 	namespace dataproviders {
-		
+		class MessageStorage;
+
+		/**
+		 * Holds received messages until their group is known.
+		 * Once the queued group messages exceed the memory budget, further messages of the affected groups are moved to the storage and read back when they are taken.
+		 */
 		class MessageQueue {
 		public:
 			MessageQueue();
+			explicit MessageQueue(qint64 memoryBudgetBytes);
 			virtual ~MessageQueue();
 
 			class ReceivedContactMessage {
@@ -51,6 +58,8 @@ namespace openmittsu {
 				QVariant content;
 			};
 
+			void setStorage(std::shared_ptr<MessageStorage> const& storage);
+
 			void storeContactMessage(ReceivedContactMessage const& message);
 			void storeGroupMessage(ReceivedGroupMessage const& message);
 
@@ -58,10 +67,26 @@ namespace openmittsu {
 
 			QVector<ReceivedContactMessage> getAndRemoveQueuedMessages(openmittsu::protocol::ContactId const& sender);
 			QVector<ReceivedGroupMessage> getAndRemoveQueuedMessages(openmittsu::protocol::GroupId const& group);
+
+			qint64 getMemoryUsageBytes() const;
+			int getSpilledMessageCount() const;
+
+			static QByteArray serialize(ReceivedGroupMessage const& message);
+			/** Throws an IllegalArgumentException if the data was not written by serialize() of this version. */
+			static ReceivedGroupMessage deserialize(QByteArray const& data);
 		private:
 			QHash<openmittsu::protocol::ContactId, QVector<ReceivedContactMessage>> m_storedContactMessages;
 			QHash<openmittsu::protocol::GroupId, QVector<ReceivedGroupMessage>> m_storedGroupMessages;
-			QMutex m_mutex;
+			mutable QMutex m_mutex;
+
+			qint64 const m_memoryBudgetBytes;
+			qint64 m_memoryUsageBytes;
+			std::shared_ptr<MessageStorage> m_storage;
+			// Number of messages per group moved to the storage, later messages of these groups follow them to keep the order
+			QHash<openmittsu::protocol::GroupId, int> m_spilledGroupMessages;
+
+			static qint64 getMemoryUsageEstimate(ReceivedGroupMessage const& message);
+			static QString getPendingMessagesKey(openmittsu::protocol::GroupId const& group);
 		};
 	}
 }
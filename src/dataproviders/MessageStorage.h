@@ -2,10 +2,13 @@
 #define OPENMITTSU_DATAPROVIDERS_MESSAGESTORAGE_H_
 
 #include <QByteArray>
+#include <QList>
 #include <QObject>
 #include <QSet>
 #include <QString>
 
+#include <functional>
+
 #include "src/dataproviders/BackedContact.h"
 #include "src/dataproviders/BackedGroup.h"
 #include "src/dataproviders/SentMessageAcceptor.h"
@@ -94,6 +97,15 @@ namespace openmittsu {
 
 			virtual void sendAllWaitingMessages(openmittsu::dataproviders::SentMessageAcceptor& messageAcceptor) = 0;
 
+			// Received messages kept out of memory while they wait for their sender or group to become known, in the order they were stored.
+			// Reading them does not remove them, that is left to the caller once it has handled them
+			virtual void storePendingMessage(QString const& waitingFor, QByteArray const& message) = 0;
+			virtual QList<QByteArray> getPendingMessages(QString const& waitingFor) = 0;
+			virtual void removePendingMessages(QString const& waitingFor) = 0;
+
+			// Writes may be held back to be committed together. Runs onCommitted once everything written so far is committed, or onRolledBack if it was lost instead
+			virtual void runAfterCommit(std::function<void()> const& onCommitted, std::function<void()> const& onRolledBack) = 0;
+
 			virtual openmittsu::dataproviders::BackedContact getBackedContact(openmittsu::protocol::ContactId const& contact, MessageCenter& messageCenter) = 0;
 			virtual openmittsu::dataproviders::BackedGroup getBackedGroup(openmittsu::protocol::GroupId const& group, MessageCenter& messageCenter) = 0;
 			virtual QSet<openmittsu::protocol::ContactId> getGroupMembers(openmittsu::protocol::GroupId const& group, bool excludeSelfContact) const = 0;
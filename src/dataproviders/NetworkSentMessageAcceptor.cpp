@@ -5,15 +5,19 @@
 #include "src/utility/Logging.h"
 #include "src/utility/QObjectConnectionMacro.h"
 
+#define OPENMITTSU_NETWORKSENTMESSAGEACCEPTOR_MESSAGES_PER_BATCH (64)
+
 namespace openmittsu {
 	namespace dataproviders {
 
-		NetworkSentMessageAcceptor::NetworkSentMessageAcceptor(std::weak_ptr<openmittsu::network::ProtocolClient> const& protocolClient) : SentMessageAcceptor(), m_protocolClient(protocolClient) {
+		NetworkSentMessageAcceptor::NetworkSentMessageAcceptor(std::weak_ptr<openmittsu::network::ProtocolClient> const& protocolClient) : SentMessageAcceptor(), m_protocolClient(protocolClient), m_isOutgoingQueueFull(false), m_isWaitingForDrain(false), m_messagesInCurrentBatch(0) {
 			auto sPtr = m_protocolClient.lock();
 			if (!sPtr) {
 				throw openmittsu::exceptions::IllegalArgumentException() << "NetworkSentMessageAcceptor constructed with null ProtocolClient!";
 			} else {
 				OPENMITTSU_CONNECT_QUEUED(sPtr.get(), connectToFinished(int, QString), this, onConnectToFinished(int));
+				OPENMITTSU_CONNECT_QUEUED(sPtr.get(), outgoingQueueFull(), this, onOutgoingQueueFull());
+				OPENMITTSU_CONNECT_QUEUED(sPtr.get(), outgoingQueueDrained(), this, onOutgoingQueueDrained());
 			}
 		}
 
@@ -27,6 +31,7 @@ namespace openmittsu {
 				if (!QMetaObject::invokeMethod(sPtr.get(), "sendContactMessage", Qt::QueuedConnection, Q_ARG(openmittsu::messages::contact::PreliminaryContactMessage, message))) {
 					throw openmittsu::exceptions::InternalErrorException() << "Could not invoke method sendContactMessage in " << __FILE__ << "  at line " << __LINE__ << ".";
 				}
+				countSentMessage();
 			} else {
 				LOGGER()->error("NetworkSentMessageAcceptor::send(PreliminaryContactMessage) invoked, but the ProtocolClient pointer is null!");
 			}
@@ -43,12 +48,24 @@ namespace openmittsu {
 			}
 		}
 
+		void NetworkSentMessageAcceptor::restorePendingMessages(QString const& waitingFor, QList<QByteArray> const& messagePackets) {
+			auto sPtr = m_protocolClient.lock();
+			if (sPtr) {
+				if (!QMetaObject::invokeMethod(sPtr.get(), "restorePendingMessages", Qt::QueuedConnection, Q_ARG(QString, waitingFor), Q_ARG(QList<QByteArray>, messagePackets))) {
+					throw openmittsu::exceptions::InternalErrorException() << "Could not invoke method restorePendingMessages in " << __FILE__ << "  at line " << __LINE__ << ".";
+				}
+			} else {
+				LOGGER()->error("NetworkSentMessageAcceptor::restorePendingMessages invoked, but the ProtocolClient pointer is null!");
+			}
+		}
+
 		void NetworkSentMessageAcceptor::send(openmittsu::messages::group::PreliminaryGroupMessage const& message) {
 			auto sPtr = m_protocolClient.lock();
 			if (sPtr) {
 				if (!QMetaObject::invokeMethod(sPtr.get(), "sendGroupMessage", Qt::QueuedConnection, Q_ARG(openmittsu::messages::group::PreliminaryGroupMessage, message))) {
 					throw openmittsu::exceptions::InternalErrorException() << "Could not invoke method sendGroupMessage in " << __FILE__ << "  at line " << __LINE__ << ".";
 				}
+				countSentMessage();
 			}
 		}
 
@@ -148,10 +165,44 @@ namespace openmittsu {
 			return sPtr->getIsConnected();
 		}
 
+		bool NetworkSentMessageAcceptor::isReadyForMoreMessages() const {
+			return !m_isOutgoingQueueFull && !m_isWaitingForDrain;
+		}
+
+		void NetworkSentMessageAcceptor::countSentMessage() {
+			++m_messagesInCurrentBatch;
+			if (m_isWaitingForDrain || (m_messagesInCurrentBatch < OPENMITTSU_NETWORKSENTMESSAGEACCEPTOR_MESSAGES_PER_BATCH)) {
+				return;
+			}
+
+			auto sPtr = m_protocolClient.lock();
+			if (sPtr) {
+				if (!QMetaObject::invokeMethod(sPtr.get(), "requestOutgoingQueueDrainedNotification", Qt::QueuedConnection)) {
+					throw openmittsu::exceptions::InternalErrorException() << "Could not invoke method requestOutgoingQueueDrainedNotification in " << __FILE__ << "  at line " << __LINE__ << ".";
+				}
+				m_isWaitingForDrain = true;
+			}
+		}
+
 		void NetworkSentMessageAcceptor::onConnectToFinished(int errCode) {
 			if (errCode == 0) {
 				emit readyToAcceptMessages();
 			}
 		}
+
+		void NetworkSentMessageAcceptor::onOutgoingQueueFull() {
+			m_isOutgoingQueueFull = true;
+		}
+
+		void NetworkSentMessageAcceptor::onOutgoingQueueDrained() {
+			bool const wasPaused = !isReadyForMoreMessages();
+			m_isOutgoingQueueFull = false;
+			m_isWaitingForDrain = false;
+			m_messagesInCurrentBatch = 0;
+
+			if (wasPaused) {
+				emit readyToAcceptMessages();
+			}
+		}
 	}
 }
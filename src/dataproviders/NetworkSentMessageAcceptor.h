@@ -48,18 +48,29 @@ namespace openmittsu {
 			virtual void processSentGroupLeave(openmittsu::protocol::GroupId const& group, QSet<openmittsu::protocol::ContactId> const& targetGroupMembers, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, openmittsu::protocol::ContactId const& ourContactId) override;
 
 			virtual bool isConnected() const;
+			virtual bool isReadyForMoreMessages() const override;
 			virtual void sendMessageReceivedAcknowledgement(openmittsu::protocol::ContactId const& messageSender, openmittsu::protocol::MessageId const& messageId);
+			virtual void restorePendingMessages(QString const& waitingFor, QList<QByteArray> const& messagePackets);
 
 			friend class openmittsu::test::MockNetworkSentMessageAcceptor;
 		signals:
 			void readyToAcceptMessages();
 		private slots:
 			void onConnectToFinished(int errCode);
+			void onOutgoingQueueFull();
+			void onOutgoingQueueDrained();
 		private:
-			NetworkSentMessageAcceptor() {} // For Mock-testing only
+			NetworkSentMessageAcceptor() : m_isOutgoingQueueFull(false), m_isWaitingForDrain(false), m_messagesInCurrentBatch(0) {} // For Mock-testing only
 
 			std::weak_ptr<openmittsu::network::ProtocolClient> m_protocolClient;
 
+			// Messages are handed over in batches, the next batch is started once the ProtocolClient has drained the previous one
+			bool m_isOutgoingQueueFull;
+			bool m_isWaitingForDrain;
+			int m_messagesInCurrentBatch;
+
+			void countSentMessage();
+
 			void send(openmittsu::messages::contact::PreliminaryContactMessage const& message);
 			void send(openmittsu::messages::group::PreliminaryGroupMessage const& message);
 		};
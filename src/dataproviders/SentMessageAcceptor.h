@@ -20,6 +20,13 @@ namespace openmittsu {
 		public:
 			virtual ~SentMessageAcceptor() {}
 
+			/**
+			 * Bulk senders (e.g. resending the outbox) should stop handing over messages while this returns false.
+			 */
+			virtual bool isReadyForMoreMessages() const {
+				return true;
+			}
+
 			virtual void processSentContactMessageText(openmittsu::protocol::ContactId const& receiver, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, QString const& message) = 0;
 			virtual void processSentContactMessageImage(openmittsu::protocol::ContactId const& receiver, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, QByteArray const& image, QString const& caption) = 0;
 			virtual void processSentContactMessageLocation(openmittsu::protocol::ContactId const& receiver, openmittsu::protocol::MessageId const& messageId, openmittsu::protocol::MessageTime const& timeSent, openmittsu::utility::Location const& location) = 0;
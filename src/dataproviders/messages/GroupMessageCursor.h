@@ -1,6 +1,9 @@
 #ifndef OPENMITTSU_DATAPROVIDERS_GROUPMESSAGECURSOR_H_
 #define OPENMITTSU_DATAPROVIDERS_GROUPMESSAGECURSOR_H_
 
+#include <QString>
+#include <QVector>
+
 #include <memory>
 
 #include "src/dataproviders/messages/GroupMessage.h"
@@ -17,6 +20,14 @@ namespace openmittsu {
 
 				virtual openmittsu::protocol::GroupId const& getGroupId() const = 0;
 				virtual std::shared_ptr<GroupMessage> getMessage() const = 0;
+
+				/** Loads the messages with the given UUIDs in the given order, UUIDs not belonging to this group are skipped. The cursor position is not changed. */
+				virtual QVector<std::shared_ptr<GroupMessage>> getMessagesByUuid(QVector<QString> const& uuids) const = 0;
+
+				/** Loads up to n messages before the current position, oldest first, and moves the cursor to the oldest of them. An invalid cursor starts after the newest message. */
+				virtual QVector<std::shared_ptr<GroupMessage>> previousPage(std::size_t n) = 0;
+				/** Loads up to n messages after the current position, oldest first, and moves the cursor to the newest of them. An invalid cursor starts before the oldest message. */
+				virtual QVector<std::shared_ptr<GroupMessage>> nextPage(std::size_t n) = 0;
 			};
 
 		}
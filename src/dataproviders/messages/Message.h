@@ -38,6 +38,9 @@ namespace openmittsu {
 				virtual void setIsSent() = 0;
 
 				virtual QString getUid() const = 0;
+
+				/** Drops data that was read ahead of time, so the next getter returns the current state of the message. */
+				virtual void refresh() const = 0;
 			};
 
 
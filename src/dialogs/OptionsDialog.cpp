@@ -5,11 +5,14 @@
 #include <QGroupBox>
 #include <QLineEdit>
 #include <QCheckBox>
+#include <QSpinBox>
 #include <QVBoxLayout>
 
 #include "src/exceptions/InternalErrorException.h"
 #include "src/utility/Logging.h"
 
+#include <limits>
+
 namespace openmittsu {
 	namespace dialogs {
 
@@ -78,6 +81,18 @@ namespace openmittsu {
 
 						optionToWidgetMap.insert(option, ow);
 						layout->addWidget(edt);
+					} else if (optionData.type == openmittsu::utility::OptionMaster::OptionTypes::TYPE_INTEGER) {
+						QSpinBox* spin = new QSpinBox();
+						spin->setRange(0, std::numeric_limits<int>::max());
+						spin->setValue(optionMaster->getOptionAsInt(option));
+						spin->setToolTip(optionData.description);
+
+						OptionWidget ow;
+						ow.type = optionData.type;
+						ow.spinPtr = spin;
+
+						optionToWidgetMap.insert(option, ow);
+						layout->addWidget(spin);
 					} else {
 						throw openmittsu::exceptions::InternalErrorException() << "Unknown option type!";
 					}
@@ -103,6 +118,9 @@ namespace openmittsu {
 				} else if (i.value().type == openmittsu::utility::OptionMaster::OptionTypes::TYPE_FILEPATH) {
 					QString const value = i.value().edtPtr->text();
 					m_optionMaster->setOption(i.key(), value);
+				} else if (i.value().type == openmittsu::utility::OptionMaster::OptionTypes::TYPE_INTEGER) {
+					int const value = i.value().spinPtr->value();
+					m_optionMaster->setOption(i.key(), value);
 				} else {
 					throw openmittsu::exceptions::InternalErrorException() << "Unknown option type!";
 				}
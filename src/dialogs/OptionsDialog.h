@@ -7,6 +7,7 @@
 #include <QWidget>
 #include <QLineEdit>
 #include <QCheckBox>
+#include <QSpinBox>
 
 #include <memory>
 
@@ -36,6 +37,7 @@ namespace openmittsu {
 				union {
 					QCheckBox* cboxPtr;
 					QLineEdit* edtPtr;
+					QSpinBox* spinPtr;
 				};
 			};
 
@@ -1,9 +1,11 @@
 #include "src/messages/group/GroupImageIdAndKeyMessageContent.h"
 
 #include "src/utility/Endian.h"
+#include "src/crypto/FixedNonces.h"
 #include "src/exceptions/IllegalArgumentException.h"
 #include "src/messages/MessageContentRegistry.h"
 #include "src/messages/group/GroupEncryptedImageAndKeyMessageContent.h"
+#include "src/messages/group/GroupImageMessageContent.h"
 #include "src/protocol/ProtocolSpecs.h"
 #include "src/tasks/BlobDownloaderCallbackTask.h"
 #include "src/utility/ByteArrayConversions.h"
@@ -39,14 +41,20 @@ namespace openmittsu {
 			}
 
 			openmittsu::tasks::CallbackTask* GroupImageIdAndKeyMessageContent::getPostReceiveCallbackTask(Message* message, std::shared_ptr<openmittsu::network::ServerConfiguration> const& serverConfiguration, std::shared_ptr<openmittsu::crypto::FullCryptoBox> const& cryptoBox) const {
-				return new openmittsu::tasks::BlobDownloaderCallbackTask(serverConfiguration, message, std::shared_ptr<openmittsu::acknowledgments::AcknowledgmentProcessor>(), imageId);
+				// Downloading and decrypting in one go means the encrypted blob is never held in memory.
+				return new openmittsu::tasks::BlobDownloaderCallbackTask(serverConfiguration, message, std::shared_ptr<openmittsu::acknowledgments::AcknowledgmentProcessor>(), imageId, encryptionKey, openmittsu::crypto::FixedNonces::getFixedGroupImageNonce());
 			}
 
 			MessageContent* GroupImageIdAndKeyMessageContent::integrateCallbackTaskResult(openmittsu::tasks::CallbackTask const* callbackTask) const {
 				if (dynamic_cast<openmittsu::tasks::BlobDownloaderCallbackTask const*>(callbackTask) != nullptr) {
 					openmittsu::tasks::BlobDownloaderCallbackTask const* bdct = dynamic_cast<openmittsu::tasks::BlobDownloaderCallbackTask const*>(callbackTask);
-					if (bdct->getDownloadedBlob().size() != static_cast<int>(sizeInBytes)) {
-						LOGGER()->warn("Size of downloaded blob differs from stated size ({} Bytes downloaded vs. {} Bytes promised).", bdct->getDownloadedBlob().size(), sizeInBytes);
+					if (bdct->getDownloadedBlobSize() != static_cast<qint64>(sizeInBytes)) {
+						LOGGER()->warn("Size of downloaded blob differs from stated size ({} Bytes downloaded vs. {} Bytes promised).", bdct->getDownloadedBlobSize(), sizeInBytes);
+					}
+
+					if (bdct->hasDecryptedBlob()) {
+						LOGGER_DEBUG("Integrating decrypted result from BlobDownloaderCallbackTask into a new GroupImageMessageContent.");
+						return new GroupImageMessageContent(getGroupId(), bdct->getDownloadedBlob());
 					}
 
 					LOGGER_DEBUG("Integrating result from BlobDownloaderCallbackTask into a new GroupEncryptedImageAndKeyMessageContent.");
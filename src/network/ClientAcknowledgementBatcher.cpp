@@ -0,0 +1,48 @@
+#include "src/network/ClientAcknowledgementBatcher.h"
+
+#include "src/protocol/ClientAcknowledgement.h"
+
+namespace openmittsu {
+	namespace network {
+
+		ClientAcknowledgementBatcher::ClientAcknowledgementBatcher() : m_packets(), m_batchedPackets() {
+			// Intentionally left empty.
+		}
+
+		ClientAcknowledgementBatcher::~ClientAcknowledgementBatcher() {
+			// Intentionally left empty.
+		}
+
+		bool ClientAcknowledgementBatcher::add(openmittsu::protocol::ContactId const& messageSender, openmittsu::protocol::MessageId const& messageId) {
+			QByteArray const packet = openmittsu::protocol::ClientAcknowledgement(messageSender, messageId).toPacket();
+			if (m_batchedPackets.contains(packet)) {
+				return false;
+			}
+
+			m_batchedPackets.insert(packet);
+			m_packets.append(packet);
+			return true;
+		}
+
+		bool ClientAcknowledgementBatcher::isEmpty() const {
+			return m_packets.isEmpty();
+		}
+
+		int ClientAcknowledgementBatcher::size() const {
+			return m_packets.size();
+		}
+
+		QList<QByteArray> ClientAcknowledgementBatcher::takePackets() {
+			QList<QByteArray> result;
+			result.swap(m_packets);
+			m_batchedPackets.clear();
+			return result;
+		}
+
+		void ClientAcknowledgementBatcher::clear() {
+			m_packets.clear();
+			m_batchedPackets.clear();
+		}
+
+	}
+}
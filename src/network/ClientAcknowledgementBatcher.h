@@ -0,0 +1,40 @@
+#ifndef OPENMITTSU_NETWORK_CLIENTACKNOWLEDGEMENTBATCHER_H_
+#define OPENMITTSU_NETWORK_CLIENTACKNOWLEDGEMENTBATCHER_H_
+
+#include <QByteArray>
+#include <QList>
+#include <QSet>
+
+#include "src/protocol/ContactId.h"
+#include "src/protocol/MessageId.h"
+
+namespace openmittsu {
+	namespace network {
+
+		/**
+		 * Collects the client acknowledgments for received messages, so a burst of them is queued for the server in one go.
+		 * Duplicates within a batch (e.g. a message delivered twice in one burst) are only acknowledged once.
+		 */
+		class ClientAcknowledgementBatcher {
+		public:
+			ClientAcknowledgementBatcher();
+			virtual ~ClientAcknowledgementBatcher();
+
+			/** Returns false if this acknowledgment is already part of the current batch. */
+			bool add(openmittsu::protocol::ContactId const& messageSender, openmittsu::protocol::MessageId const& messageId);
+
+			bool isEmpty() const;
+			int size() const;
+
+			/** Returns the packets of the current batch in the order they were added and starts a new batch. */
+			QList<QByteArray> takePackets();
+			void clear();
+		private:
+			QList<QByteArray> m_packets;
+			QSet<QByteArray> m_batchedPackets;
+		};
+
+	}
+}
+
+#endif // OPENMITTSU_NETWORK_CLIENTACKNOWLEDGEMENTBATCHER_H_
@@ -0,0 +1,146 @@
+#include "src/network/FrameDecoder.h"
+
+#include "src/exceptions/IllegalArgumentException.h"
+#include "src/protocol/ProtocolSpecs.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace openmittsu {
+	namespace network {
+
+		namespace {
+			int nextPowerOfTwo(int value) {
+				int result = 1;
+				while (result < value) {
+					result <<= 1;
+				}
+				return result;
+			}
+		}
+
+		FrameDecoder::FrameDecoder(int initialCapacity) : m_buffer(nextPowerOfTwo(std::max(initialCapacity, 2 * (PROTO_DATA_HEADER_SIZE_LENGTH_BYTES))), 0x00), m_scratch(), m_readPosition(0), m_size(0) {
+			// Intentionally left empty.
+		}
+
+		FrameDecoder::~FrameDecoder() {
+			// Intentionally left empty.
+		}
+
+		int FrameDecoder::getMask() const {
+			return m_buffer.size() - 1;
+		}
+
+		quint8 FrameDecoder::byteAt(int offset) const {
+			return static_cast<quint8>(m_buffer.at((m_readPosition + offset) & getMask()));
+		}
+
+		void FrameDecoder::grow(int minimalCapacity) {
+			int const newCapacity = nextPowerOfTwo(minimalCapacity);
+			QByteArray newBuffer(newCapacity, 0x00);
+
+			// Linearize the buffered data at the start of the new buffer
+			int const firstPart = std::min(m_size, m_buffer.size() - m_readPosition);
+			std::memcpy(newBuffer.data(), m_buffer.constData() + m_readPosition, firstPart);
+			std::memcpy(newBuffer.data() + firstPart, m_buffer.constData(), m_size - firstPart);
+
+			m_buffer = newBuffer;
+			m_readPosition = 0;
+		}
+
+		void FrameDecoder::ensureWritable(int length) {
+			if (length < 0) {
+				throw openmittsu::exceptions::IllegalArgumentException() << "Can not write a negative number of bytes (" << length << ") to the FrameDecoder.";
+			}
+			if (m_size == 0) {
+				// Maximizes the contiguous free space, costs nothing since the buffer is empty.
+				m_readPosition = 0;
+			}
+			if ((m_buffer.size() - m_size) < length) {
+				grow(m_size + length);
+			}
+		}
+
+		void FrameDecoder::append(QByteArray const& data) {
+			append(data.constData(), data.size());
+		}
+
+		void FrameDecoder::append(char const* data, int length) {
+			ensureWritable(length);
+
+			int const writePosition = (m_readPosition + m_size) & getMask();
+			int const firstPart = std::min(length, m_buffer.size() - writePosition);
+			char* const bufferData = m_buffer.data();
+			std::memcpy(bufferData + writePosition, data, firstPart);
+			std::memcpy(bufferData, data + firstPart, length - firstPart);
+
+			m_size += length;
+		}
+
+		qint64 FrameDecoder::readFrom(QIODevice* device) {
+			qint64 totalBytesRead = 0;
+			qint64 bytesAvailable = device->bytesAvailable();
+			while (bytesAvailable > 0) {
+				ensureWritable(static_cast<int>(std::min<qint64>(bytesAvailable, m_buffer.size())));
+
+				// Read into the contiguous free region following the buffered data
+				int const writePosition = (m_readPosition + m_size) & getMask();
+				int const contiguousFree = (writePosition >= m_readPosition) ? (m_buffer.size() - writePosition) : (m_readPosition - writePosition);
+				qint64 const bytesRead = device->read(m_buffer.data() + writePosition, std::min<qint64>(contiguousFree, bytesAvailable));
+				if (bytesRead <= 0) {
+					break;
+				}
+
+				m_size += static_cast<int>(bytesRead);
+				totalBytesRead += bytesRead;
+				bytesAvailable = device->bytesAvailable();
+			}
+
+			return totalBytesRead;
+		}
+
+		bool FrameDecoder::nextFrame(QByteArray& frame) {
+			if (m_size < (PROTO_DATA_HEADER_SIZE_LENGTH_BYTES)) {
+				// Not enough data, not even the length Bytes!
+				return false;
+			}
+
+			// Unsigned Two-Byte Integer in Little-Endian
+			int const packetLength = static_cast<int>(byteAt(0)) | (static_cast<int>(byteAt(1)) << 8);
+			if (m_size < (PROTO_DATA_HEADER_SIZE_LENGTH_BYTES + packetLength)) {
+				// packet not yet complete
+				return false;
+			}
+
+			int const packetStart = (m_readPosition + PROTO_DATA_HEADER_SIZE_LENGTH_BYTES) & getMask();
+			if ((packetStart + packetLength) <= m_buffer.size()) {
+				frame = QByteArray::fromRawData(m_buffer.constData() + packetStart, packetLength);
+			} else {
+				int const firstPart = m_buffer.size() - packetStart;
+				m_scratch.resize(packetLength);
+				std::memcpy(m_scratch.data(), m_buffer.constData() + packetStart, firstPart);
+				std::memcpy(m_scratch.data() + firstPart, m_buffer.constData(), packetLength - firstPart);
+				frame = m_scratch;
+			}
+
+			m_readPosition = (m_readPosition + PROTO_DATA_HEADER_SIZE_LENGTH_BYTES + packetLength) & getMask();
+			m_size -= PROTO_DATA_HEADER_SIZE_LENGTH_BYTES + packetLength;
+
+			return true;
+		}
+
+		void FrameDecoder::clear() {
+			m_readPosition = 0;
+			m_size = 0;
+		}
+
+		int FrameDecoder::getBufferedBytesCount() const {
+			return m_size;
+		}
+
+		int FrameDecoder::getCapacity() const {
+			return m_buffer.size();
+		}
+
+	}
+}
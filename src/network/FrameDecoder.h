@@ -0,0 +1,53 @@
+#ifndef OPENMITTSU_NETWORK_FRAMEDECODER_H_
+#define OPENMITTSU_NETWORK_FRAMEDECODER_H_
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QtGlobal>
+
+namespace openmittsu {
+	namespace network {
+
+		/**
+		 * Splits the stream received from the server into frames (two length bytes in Little-Endian, followed by the packet).
+		 *
+		 * Incoming data is stored in a ring buffer, so consuming a frame never moves the remaining data.
+		 * Frames are handed out as views into the ring buffer; a view is only valid until the next call to one of the write functions.
+		 */
+		class FrameDecoder {
+		public:
+			explicit FrameDecoder(int initialCapacity = 64 * 1024);
+			virtual ~FrameDecoder();
+
+			/** Appends the given data to the buffer. */
+			void append(QByteArray const& data);
+			void append(char const* data, int length);
+
+			/** Reads all data currently available on the given device directly into the buffer. Returns the number of bytes read. */
+			qint64 readFrom(QIODevice* device);
+
+			/**
+			 * If a complete frame is available, sets frame to a view of its packet data, consumes it and returns true.
+			 * Frames wrapping around the end of the ring buffer are copied into a scratch buffer.
+			 */
+			bool nextFrame(QByteArray& frame);
+
+			void clear();
+			int getBufferedBytesCount() const;
+			int getCapacity() const;
+		private:
+			QByteArray m_buffer;
+			QByteArray m_scratch;
+			int m_readPosition;
+			int m_size;
+
+			int getMask() const;
+			quint8 byteAt(int offset) const;
+			void ensureWritable(int length);
+			void grow(int minimalCapacity);
+		};
+
+	}
+}
+
+#endif // OPENMITTSU_NETWORK_FRAMEDECODER_H_
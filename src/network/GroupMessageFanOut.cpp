@@ -0,0 +1,120 @@
+#include "src/network/GroupMessageFanOut.h"
+
+#include "src/exceptions/BaseException.h"
+#include "src/messages/MessageWithEncryptedPayload.h"
+#include "src/messages/MessageWithPayload.h"
+#include "src/utility/Logging.h"
+
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+
+#include <algorithm>
+
+// Below this many copies the thread hand-off costs more than it saves.
+#define OPENMITTSU_GROUPMESSAGEFANOUT_MINIMAL_PARALLEL_COPIES (8)
+
+namespace openmittsu {
+	namespace network {
+
+		class GroupMessageFanOutChunk : public QRunnable {
+		public:
+			GroupMessageFanOutChunk(GroupMessageFanOut* owner, std::shared_ptr<GroupMessageFanOut::FanOut> const& fanOut, int begin, int end) : QRunnable(), m_owner(owner), m_fanOut(fanOut), m_begin(begin), m_end(end) {
+				setAutoDelete(true);
+			}
+
+			virtual void run() override {
+				GroupMessageFanOut::encryptCopies(m_owner->m_cryptoBox, *m_fanOut, m_begin, m_end);
+				if (!m_fanOut->pendingChunks.deref()) {
+					// Last chunk of this fan-out, the signal is delivered queued to the protocol thread.
+					emit m_owner->fanOutProgressed();
+				}
+			}
+		private:
+			GroupMessageFanOut* const m_owner;
+			std::shared_ptr<GroupMessageFanOut::FanOut> const m_fanOut;
+			int const m_begin;
+			int const m_end;
+		};
+
+		GroupMessageFanOut::FanOut::FanOut(std::vector<openmittsu::messages::FullMessageHeader> const& messageHeaders, QByteArray const& messagePayload, std::shared_ptr<openmittsu::acknowledgments::AcknowledgmentProcessor> const& messageAcknowledgmentProcessor)
+			: headers(messageHeaders), payload(messagePayload), acknowledgmentProcessor(messageAcknowledgmentProcessor), packets(messageHeaders.size()), pendingChunks(0) {
+			// Intentionally left empty.
+		}
+
+		GroupMessageFanOut::GroupMessageFanOut(std::shared_ptr<openmittsu::crypto::FullCryptoBox> const& cryptoBox, int maximalThreadCount) : QObject(nullptr), m_cryptoBox(cryptoBox), m_threadPool(), m_mutex(), m_fanOuts() {
+			setMaximalThreadCount(maximalThreadCount);
+		}
+
+		GroupMessageFanOut::~GroupMessageFanOut() {
+			m_threadPool.waitForDone();
+		}
+
+		void GroupMessageFanOut::setMaximalThreadCount(int maximalThreadCount) {
+			if (maximalThreadCount <= 0) {
+				maximalThreadCount = std::max(1, QThread::idealThreadCount());
+			}
+			m_threadPool.setMaxThreadCount(maximalThreadCount);
+		}
+
+		int GroupMessageFanOut::getMaximalThreadCount() const {
+			return m_threadPool.maxThreadCount();
+		}
+
+		void GroupMessageFanOut::submit(std::vector<openmittsu::messages::FullMessageHeader> const& headers, QByteArray const& payload, std::shared_ptr<openmittsu::acknowledgments::AcknowledgmentProcessor> const& acknowledgmentProcessor) {
+			std::shared_ptr<FanOut> fanOut = std::make_shared<FanOut>(headers, payload, acknowledgmentProcessor);
+			int const copyCount = static_cast<int>(headers.size());
+			int const chunkCount = std::max(1, std::min(m_threadPool.maxThreadCount(), copyCount / OPENMITTSU_GROUPMESSAGEFANOUT_MINIMAL_PARALLEL_COPIES));
+
+			QMutexLocker lock(&m_mutex);
+			if ((chunkCount == 1) && m_fanOuts.empty()) {
+				// Nothing to overtake, encrypt directly on the calling thread.
+				encryptCopies(m_cryptoBox, *fanOut, 0, copyCount);
+				m_fanOuts.push_back(fanOut);
+				lock.unlock();
+
+				emit fanOutProgressed();
+				return;
+			}
+
+			fanOut->pendingChunks.store(chunkCount);
+			m_fanOuts.push_back(fanOut);
+			lock.unlock();
+
+			int const chunkSize = (copyCount + chunkCount - 1) / chunkCount;
+			for (int begin = 0; begin < copyCount; begin += chunkSize) {
+				m_threadPool.start(new GroupMessageFanOutChunk(this, fanOut, begin, std::min(copyCount, begin + chunkSize)));
+			}
+		}
+
+		std::list<std::shared_ptr<GroupMessageFanOut::FanOut>> GroupMessageFanOut::takeCompletedFanOuts() {
+			QMutexLocker lock(&m_mutex);
+			std::list<std::shared_ptr<FanOut>> result;
+			while (!m_fanOuts.empty() && (m_fanOuts.front()->pendingChunks.loadAcquire() == 0)) {
+				result.push_back(m_fanOuts.front());
+				m_fanOuts.pop_front();
+			}
+
+			return result;
+		}
+
+		bool GroupMessageFanOut::hasPendingFanOuts() const {
+			QMutexLocker lock(&m_mutex);
+			return !m_fanOuts.empty();
+		}
+
+		void GroupMessageFanOut::encryptCopies(std::shared_ptr<openmittsu::crypto::FullCryptoBox> const& cryptoBox, FanOut& fanOut, int begin, int end) {
+			for (int i = begin; i < end; ++i) {
+				openmittsu::messages::FullMessageHeader const& header = fanOut.headers.at(static_cast<std::size_t>(i));
+				try {
+					openmittsu::messages::MessageWithPayload const messageWithPayload(header, fanOut.payload);
+					fanOut.packets[static_cast<std::size_t>(i)] = messageWithPayload.encrypt(cryptoBox).toPacket();
+				} catch (openmittsu::exceptions::BaseException& be) {
+					// Runs on a worker thread, so nothing may escape from here.
+					LOGGER()->error("Could not encrypt group message {} for contact {}: {}", header.getMessageId().toString(), header.getReceiver().toString(), be.what());
+				}
+			}
+		}
+
+	}
+}
@@ -0,0 +1,78 @@
+#ifndef OPENMITTSU_NETWORK_GROUPMESSAGEFANOUT_H_
+#define OPENMITTSU_NETWORK_GROUPMESSAGEFANOUT_H_
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QMutex>
+#include <QObject>
+#include <QThreadPool>
+
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "src/acknowledgments/AcknowledgmentProcessor.h"
+#include "src/crypto/FullCryptoBox.h"
+#include "src/messages/FullMessageHeader.h"
+
+namespace openmittsu {
+	namespace network {
+
+		/**
+		 * Encrypts the per-recipient copies of a group message on a bounded worker pool.
+		 * Completed fan-outs are handed out in the order they were submitted, with the copies in the order of their headers.
+		 * Packets the caller sends without going through the fan-out are not ordered against pending fan-outs.
+		 */
+		class GroupMessageFanOut : public QObject {
+			Q_OBJECT
+		public:
+			struct FanOut {
+				FanOut(std::vector<openmittsu::messages::FullMessageHeader> const& messageHeaders, QByteArray const& messagePayload, std::shared_ptr<openmittsu::acknowledgments::AcknowledgmentProcessor> const& messageAcknowledgmentProcessor);
+
+				std::vector<openmittsu::messages::FullMessageHeader> const headers;
+				QByteArray const payload;
+				std::shared_ptr<openmittsu::acknowledgments::AcknowledgmentProcessor> const acknowledgmentProcessor;
+
+				// One packet per header, left empty if encrypting that copy failed.
+				std::vector<QByteArray> packets;
+				QAtomicInt pendingChunks;
+			};
+
+			GroupMessageFanOut(std::shared_ptr<openmittsu::crypto::FullCryptoBox> const& cryptoBox, int maximalThreadCount);
+			virtual ~GroupMessageFanOut();
+
+			/**
+			 * @param maximalThreadCount The number of worker threads, zero or less selects the number of cores.
+			 */
+			void setMaximalThreadCount(int maximalThreadCount);
+			int getMaximalThreadCount() const;
+
+			/**
+			 * Queues the encryption of one copy of payload per header. Small fan-outs are encrypted right away if nothing else is pending.
+			 * Listen to fanOutProgressed() and collect the results with takeCompletedFanOuts().
+			 */
+			void submit(std::vector<openmittsu::messages::FullMessageHeader> const& headers, QByteArray const& payload, std::shared_ptr<openmittsu::acknowledgments::AcknowledgmentProcessor> const& acknowledgmentProcessor);
+
+			/**
+			 * Removes and returns the completed fan-outs at the head of the queue.
+			 */
+			std::list<std::shared_ptr<FanOut>> takeCompletedFanOuts();
+			bool hasPendingFanOuts() const;
+		signals:
+			void fanOutProgressed();
+		private:
+			std::shared_ptr<openmittsu::crypto::FullCryptoBox> const m_cryptoBox;
+			QThreadPool m_threadPool;
+
+			mutable QMutex m_mutex;
+			std::list<std::shared_ptr<FanOut>> m_fanOuts;
+
+			static void encryptCopies(std::shared_ptr<openmittsu::crypto::FullCryptoBox> const& cryptoBox, FanOut& fanOut, int begin, int end);
+
+			friend class GroupMessageFanOutChunk;
+		};
+
+	}
+}
+
+#endif // OPENMITTSU_NETWORK_GROUPMESSAGEFANOUT_H_
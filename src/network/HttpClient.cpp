@@ -0,0 +1,258 @@
+#include "src/network/HttpClient.h"
+
+#include "src/exceptions/IllegalFunctionCallException.h"
+#include "src/utility/Logging.h"
+#include "src/utility/MakeUnique.h"
+#include "src/utility/QObjectConnectionMacro.h"
+
+#include <QCryptographicHash>
+#include <QHttpMultiPart>
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QNetworkAccessManager>
+#include <QSemaphore>
+#include <QtGlobal>
+
+#define OPENMITTSU_HTTPCLIENT_DOWNLOAD_BUFFER_SIZE (64 * 1024)
+
+namespace openmittsu {
+	namespace network {
+
+		struct HttpClient::PendingRequest {
+			PendingRequest(Method requestMethod, QNetworkRequest const& networkRequest, QByteArray const& requestData, QString const& requestPartName, QString const& requestFileName, QIODevice* requestSink)
+				: method(requestMethod), request(networkRequest), data(requestData), partName(requestPartName), fileName(requestFileName), sink(requestSink), sinkFailed(false), done(0), response() {
+				// Intentionally left empty.
+			}
+
+			Method const method;
+			QNetworkRequest request;
+			QByteArray const data;
+			QString const partName;
+			QString const fileName;
+			QIODevice* const sink;
+			bool sinkFailed;
+
+			QSemaphore done;
+			Response response;
+		};
+
+		HttpClient::Response::Response() : error(QNetworkReply::NoError), errorString(), httpStatusCode(0), body() {
+			// Intentionally left empty.
+		}
+
+		bool HttpClient::Response::isSuccess() const {
+			return error == QNetworkReply::NoError;
+		}
+
+		HttpClient::HttpClient() : QObject(nullptr), m_thread(), m_networkAccessManager(), m_activeRequests(), m_mutex(), m_queuedRequests(), m_isShutDown(false), m_sslConfigurationMutex(), m_sslConfigurations() {
+			m_thread.setObjectName("HttpClient");
+			moveToThread(&m_thread);
+			m_thread.start();
+		}
+
+		HttpClient::~HttpClient() {
+			shutdown();
+		}
+
+		HttpClient* HttpClient::globalInstance() {
+			static HttpClient httpClient;
+			return &httpClient;
+		}
+
+		HttpClient::Response HttpClient::get(QNetworkRequest const& request) {
+			return execute(Method::GET, request, QByteArray());
+		}
+
+		HttpClient::Response HttpClient::download(QNetworkRequest const& request, QIODevice* sink) {
+			return execute(Method::DOWNLOAD, request, QByteArray(), QString(), QString(), sink);
+		}
+
+		HttpClient::Response HttpClient::post(QNetworkRequest const& request, QByteArray const& data) {
+			return execute(Method::POST, request, data);
+		}
+
+		HttpClient::Response HttpClient::postFormData(QNetworkRequest const& request, QString const& partName, QString const& fileName, QByteArray const& data) {
+			return execute(Method::POST_FORM_DATA, request, data, partName, fileName);
+		}
+
+		HttpClient::Response HttpClient::execute(Method method, QNetworkRequest const& request, QByteArray const& data, QString const& partName, QString const& fileName, QIODevice* sink) {
+			if (QThread::currentThread() == &m_thread) {
+				throw openmittsu::exceptions::IllegalFunctionCallException() << "Blocking HTTP requests can not be made from the HTTP client thread.";
+			}
+
+			std::shared_ptr<PendingRequest> pendingRequest = std::make_shared<PendingRequest>(method, request, data, partName, fileName, sink);
+			{
+				QMutexLocker lock(&m_mutex);
+				if (m_isShutDown) {
+					finishRequest(pendingRequest, QNetworkReply::OperationCanceledError, QStringLiteral("The HTTP client has been shut down."));
+					return pendingRequest->response;
+				}
+
+				m_queuedRequests.push_back(pendingRequest);
+			}
+
+			QMetaObject::invokeMethod(this, "processQueuedRequests", Qt::QueuedConnection);
+			pendingRequest->done.acquire();
+
+			return pendingRequest->response;
+		}
+
+		void HttpClient::processQueuedRequests() {
+			std::list<std::shared_ptr<PendingRequest>> requests;
+			{
+				QMutexLocker lock(&m_mutex);
+				requests.swap(m_queuedRequests);
+			}
+
+			if (requests.empty()) {
+				return;
+			}
+
+			if (!m_networkAccessManager) {
+				m_networkAccessManager = std::make_unique<QNetworkAccessManager>();
+				OPENMITTSU_CONNECT(m_networkAccessManager.get(), finished(QNetworkReply*), this, replyFinished(QNetworkReply*));
+			}
+
+			for (std::shared_ptr<PendingRequest> const& pendingRequest : requests) {
+				QNetworkRequest& request = pendingRequest->request;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+				request.setAttribute(QNetworkRequest::HTTP2AllowedAttribute, true);
+#endif
+
+				QNetworkReply* reply = nullptr;
+				if ((pendingRequest->method == Method::GET) || (pendingRequest->method == Method::DOWNLOAD)) {
+					// Only idempotent requests may be pipelined behind others on a kept-alive connection.
+					request.setAttribute(QNetworkRequest::HttpPipeliningAllowedAttribute, true);
+					reply = m_networkAccessManager->get(request);
+					if (pendingRequest->method == Method::DOWNLOAD) {
+						// Makes the reply stop reading from the socket until its buffer has been drained into the sink.
+						reply->setReadBufferSize(OPENMITTSU_HTTPCLIENT_DOWNLOAD_BUFFER_SIZE);
+						OPENMITTSU_CONNECT(reply, readyRead(), this, replyReadyRead());
+					}
+				} else if (pendingRequest->method == Method::POST) {
+					reply = m_networkAccessManager->post(request, pendingRequest->data);
+				} else {
+					QHttpMultiPart* multiPart = new QHttpMultiPart(QHttpMultiPart::FormDataType);
+
+					QHttpPart dataPart;
+					dataPart.setHeader(QNetworkRequest::ContentTypeHeader, QVariant("application/octet-stream"));
+					dataPart.setHeader(QNetworkRequest::ContentDispositionHeader, QVariant(QString("form-data; name=\"%1\"; filename=\"%2\"").arg(pendingRequest->partName).arg(pendingRequest->fileName)));
+					dataPart.setBody(pendingRequest->data);
+					multiPart->append(dataPart);
+
+					reply = m_networkAccessManager->post(request, multiPart);
+					multiPart->setParent(reply);
+				}
+
+				m_activeRequests.insert(reply, pendingRequest);
+			}
+		}
+
+		bool HttpClient::writeToSink(std::shared_ptr<PendingRequest> const& pendingRequest, QNetworkReply* reply) {
+			QByteArray const chunk = reply->readAll();
+			if (!chunk.isEmpty() && (pendingRequest->sink->write(chunk) != chunk.size())) {
+				pendingRequest->sinkFailed = true;
+				return false;
+			}
+			return true;
+		}
+
+		void HttpClient::replyReadyRead() {
+			QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
+			auto const it = m_activeRequests.constFind(reply);
+			if ((reply == nullptr) || (it == m_activeRequests.constEnd()) || (reply->error() != QNetworkReply::NoError)) {
+				return;
+			}
+
+			if (!writeToSink(*it, reply)) {
+				reply->abort();
+			}
+		}
+
+		void HttpClient::replyFinished(QNetworkReply* reply) {
+			std::shared_ptr<PendingRequest> const pendingRequest = m_activeRequests.take(reply);
+			reply->deleteLater();
+			if (!pendingRequest) {
+				LOGGER()->warn("HttpClient received a reply for an unknown request.");
+				return;
+			}
+
+			pendingRequest->response.httpStatusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+			if (pendingRequest->method == Method::DOWNLOAD) {
+				if (reply->error() == QNetworkReply::NoError) {
+					writeToSink(pendingRequest, reply);
+				}
+				if (pendingRequest->sinkFailed) {
+					finishRequest(pendingRequest, QNetworkReply::UnknownContentError, QStringLiteral("Could not write the downloaded data: %1").arg(pendingRequest->sink->errorString()));
+					return;
+				}
+			} else if (reply->error() == QNetworkReply::NoError) {
+				pendingRequest->response.body = reply->readAll();
+			}
+			finishRequest(pendingRequest, reply->error(), reply->errorString());
+		}
+
+		void HttpClient::releaseNetworkAccessManager() {
+			// Aborting emits finished() right away, which wakes up the waiting callers.
+			QList<QNetworkReply*> const replies = m_activeRequests.keys();
+			for (QNetworkReply* reply : replies) {
+				reply->abort();
+			}
+			m_networkAccessManager.reset();
+		}
+
+		void HttpClient::finishRequest(std::shared_ptr<PendingRequest> const& pendingRequest, QNetworkReply::NetworkError error, QString const& errorString) {
+			pendingRequest->response.error = error;
+			if (error != QNetworkReply::NoError) {
+				pendingRequest->response.errorString = errorString;
+			}
+			pendingRequest->done.release();
+		}
+
+		void HttpClient::shutdown() {
+			std::list<std::shared_ptr<PendingRequest>> requests;
+			{
+				QMutexLocker lock(&m_mutex);
+				if (m_isShutDown) {
+					return;
+				}
+				m_isShutDown = true;
+				requests.swap(m_queuedRequests);
+			}
+
+			for (std::shared_ptr<PendingRequest> const& pendingRequest : requests) {
+				finishRequest(pendingRequest, QNetworkReply::OperationCanceledError, QStringLiteral("The HTTP client has been shut down."));
+			}
+
+			if (m_thread.isRunning() && (QThread::currentThread() != &m_thread)) {
+				QMetaObject::invokeMethod(this, "releaseNetworkAccessManager", Qt::BlockingQueuedConnection);
+				m_thread.quit();
+				m_thread.wait();
+			}
+		}
+
+		QSslConfiguration HttpClient::getSslConfiguration(QList<QSslCertificate> const& additionalCaCertificates) {
+			QByteArray key;
+			for (QSslCertificate const& certificate : additionalCaCertificates) {
+				key.append(certificate.digest(QCryptographicHash::Sha256));
+			}
+
+			QMutexLocker lock(&m_sslConfigurationMutex);
+			auto const it = m_sslConfigurations.constFind(key);
+			if (it != m_sslConfigurations.constEnd()) {
+				return *it;
+			}
+
+			QSslConfiguration sslConfiguration = QSslConfiguration::defaultConfiguration();
+			QList<QSslCertificate> caCertificates = sslConfiguration.caCertificates();
+			caCertificates.append(additionalCaCertificates);
+			sslConfiguration.setCaCertificates(caCertificates);
+			// Lets new connections in the pool resume an earlier TLS session instead of doing a full handshake.
+			sslConfiguration.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+
+			m_sslConfigurations.insert(key, sslConfiguration);
+			return sslConfiguration;
+		}
+
+	}
+}
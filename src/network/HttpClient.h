@@ -0,0 +1,113 @@
+#ifndef OPENMITTSU_NETWORK_HTTPCLIENT_H_
+#define OPENMITTSU_NETWORK_HTTPCLIENT_H_
+
+#include <QByteArray>
+#include <QHash>
+#include <QIODevice>
+#include <QList>
+#include <QMutex>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QObject>
+#include <QSslCertificate>
+#include <QSslConfiguration>
+#include <QString>
+#include <QThread>
+
+#include <list>
+#include <memory>
+
+class QNetworkAccessManager;
+
+namespace openmittsu {
+	namespace network {
+
+		/**
+		 * A long-lived HTTP client shared by all background tasks.
+		 * All requests go through one QNetworkAccessManager living on a dedicated thread, so connections (and TLS sessions) to the blob and directory servers are kept alive and reused between requests.
+		 * The request methods block the calling worker thread until the reply has been received and must not be called from the client's own thread.
+		 */
+		class HttpClient : public QObject {
+			Q_OBJECT
+		public:
+			struct Response {
+				Response();
+
+				QNetworkReply::NetworkError error;
+				QString errorString;
+				int httpStatusCode;
+				QByteArray body;
+
+				bool isSuccess() const;
+			};
+
+			virtual ~HttpClient();
+
+			/**
+			 * The client shared by all parts of the application.
+			 */
+			static HttpClient* globalInstance();
+
+			Response get(QNetworkRequest const& request);
+
+			/**
+			 * Like get(), but the body is written to sink as it arrives instead of being collected in the response.
+			 * At most one chunk of the body is buffered in memory. The sink is written from the client thread while the caller waits.
+			 */
+			Response download(QNetworkRequest const& request, QIODevice* sink);
+
+			Response post(QNetworkRequest const& request, QByteArray const& data);
+
+			/**
+			 * Posts data as a single multipart/form-data part of type application/octet-stream.
+			 */
+			Response postFormData(QNetworkRequest const& request, QString const& partName, QString const& fileName, QByteArray const& data);
+
+			/**
+			 * The default configuration with the given certificates added to the trusted CAs.
+			 * Building it loads the system CA store, so the result is cached per set of certificates.
+			 */
+			QSslConfiguration getSslConfiguration(QList<QSslCertificate> const& additionalCaCertificates);
+
+			/**
+			 * Aborts running requests, fails queued ones and stops the client thread. Requests made afterwards fail immediately.
+			 */
+			void shutdown();
+		private slots:
+			void processQueuedRequests();
+			void replyReadyRead();
+			void replyFinished(QNetworkReply* reply);
+			void releaseNetworkAccessManager();
+		private:
+			HttpClient();
+
+			enum class Method {
+				GET,
+				DOWNLOAD,
+				POST,
+				POST_FORM_DATA
+			};
+
+			struct PendingRequest;
+
+			QThread m_thread;
+			// Only touched on m_thread.
+			std::unique_ptr<QNetworkAccessManager> m_networkAccessManager;
+			QHash<QNetworkReply*, std::shared_ptr<PendingRequest>> m_activeRequests;
+
+			QMutex m_mutex;
+			std::list<std::shared_ptr<PendingRequest>> m_queuedRequests;
+			bool m_isShutDown;
+
+			QMutex m_sslConfigurationMutex;
+			QHash<QByteArray, QSslConfiguration> m_sslConfigurations;
+
+			Response execute(Method method, QNetworkRequest const& request, QByteArray const& data, QString const& partName = QString(), QString const& fileName = QString(), QIODevice* sink = nullptr);
+			static bool writeToSink(std::shared_ptr<PendingRequest> const& pendingRequest, QNetworkReply* reply);
+			static void finishRequest(std::shared_ptr<PendingRequest> const& pendingRequest, QNetworkReply::NetworkError error, QString const& errorString);
+		};
+
+	}
+}
+
+#endif // OPENMITTSU_NETWORK_HTTPCLIENT_H_
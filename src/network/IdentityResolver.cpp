@@ -0,0 +1,85 @@
+#include "src/network/IdentityResolver.h"
+
+#include "src/exceptions/IllegalArgumentException.h"
+
+namespace openmittsu {
+	namespace network {
+
+		IdentityResolver::IdentityResolver(qint64 negativeCacheTtlMs, int maxBatchSize) : m_negativeCacheTtlMs(negativeCacheTtlMs), m_maxBatchSize(maxBatchSize), m_pending(), m_requested(), m_inFlight(), m_failedUntil() {
+			if (maxBatchSize < 1) {
+				throw openmittsu::exceptions::IllegalArgumentException() << "The maximal batch size has to be positive, not " << maxBatchSize << ".";
+			}
+		}
+
+		IdentityResolver::~IdentityResolver() {
+			// Intentionally left empty.
+		}
+
+		bool IdentityResolver::request(openmittsu::protocol::ContactId const& contactId, qint64 now) {
+			purgeExpiredFailures(now);
+			if (m_failedUntil.contains(contactId)) {
+				return false;
+			} else if (m_requested.contains(contactId) || m_inFlight.contains(contactId)) {
+				return true;
+			}
+
+			m_pending.append(contactId);
+			m_requested.insert(contactId);
+			return true;
+		}
+
+		bool IdentityResolver::hasFailedRecently(openmittsu::protocol::ContactId const& contactId, qint64 now) const {
+			auto const it = m_failedUntil.constFind(contactId);
+			return (it != m_failedUntil.constEnd()) && (it.value() > now);
+		}
+
+		bool IdentityResolver::hasPendingRequests() const {
+			return !m_pending.isEmpty();
+		}
+
+		int IdentityResolver::getInFlightCount() const {
+			return m_inFlight.size();
+		}
+
+		QSet<openmittsu::protocol::ContactId> IdentityResolver::takeBatch() {
+			QSet<openmittsu::protocol::ContactId> result;
+			while (!m_pending.isEmpty() && (result.size() < m_maxBatchSize)) {
+				openmittsu::protocol::ContactId const contactId = m_pending.takeFirst();
+				m_requested.remove(contactId);
+				m_inFlight.insert(contactId);
+				result.insert(contactId);
+			}
+			return result;
+		}
+
+		void IdentityResolver::resolved(openmittsu::protocol::ContactId const& contactId) {
+			m_inFlight.remove(contactId);
+			m_failedUntil.remove(contactId);
+		}
+
+		void IdentityResolver::failed(openmittsu::protocol::ContactId const& contactId, qint64 now) {
+			m_inFlight.remove(contactId);
+			m_failedUntil.insert(contactId, now + m_negativeCacheTtlMs);
+		}
+
+		void IdentityResolver::retry(openmittsu::protocol::ContactId const& contactId) {
+			m_inFlight.remove(contactId);
+			if (!m_requested.contains(contactId)) {
+				m_pending.append(contactId);
+				m_requested.insert(contactId);
+			}
+		}
+
+		void IdentityResolver::purgeExpiredFailures(qint64 now) {
+			auto it = m_failedUntil.begin();
+			while (it != m_failedUntil.end()) {
+				if (it.value() <= now) {
+					it = m_failedUntil.erase(it);
+				} else {
+					++it;
+				}
+			}
+		}
+
+	}
+}
@@ -0,0 +1,53 @@
+#ifndef OPENMITTSU_NETWORK_IDENTITYRESOLVER_H_
+#define OPENMITTSU_NETWORK_IDENTITYRESOLVER_H_
+
+#include <QHash>
+#include <QList>
+#include <QSet>
+
+#include "src/protocol/ContactId.h"
+
+namespace openmittsu {
+	namespace network {
+
+		/**
+		 * Bookkeeping for public key lookups of unknown identities.
+		 * Requests are collected until the next batch is taken, an identity that is already pending or being looked up is only requested once.
+		 * Identities that could not be resolved are remembered for a while, so messages from them do not trigger a new lookup each time.
+		 * Times are in milliseconds and supplied by the caller.
+		 */
+		class IdentityResolver {
+		public:
+			IdentityResolver(qint64 negativeCacheTtlMs, int maxBatchSize);
+			virtual ~IdentityResolver();
+
+			/** Returns false if the identity recently failed to resolve and should not be looked up again yet. */
+			bool request(openmittsu::protocol::ContactId const& contactId, qint64 now);
+			bool hasFailedRecently(openmittsu::protocol::ContactId const& contactId, qint64 now) const;
+
+			bool hasPendingRequests() const;
+			int getInFlightCount() const;
+
+			/** Returns up to maxBatchSize pending identities in the order they were requested and marks them as being looked up. */
+			QSet<openmittsu::protocol::ContactId> takeBatch();
+
+			void resolved(openmittsu::protocol::ContactId const& contactId);
+			void failed(openmittsu::protocol::ContactId const& contactId, qint64 now);
+			/** The lookup could not reach the server, the identity is requested again with the next batch instead of being remembered as failed. */
+			void retry(openmittsu::protocol::ContactId const& contactId);
+		private:
+			qint64 const m_negativeCacheTtlMs;
+			int const m_maxBatchSize;
+
+			QList<openmittsu::protocol::ContactId> m_pending;
+			QSet<openmittsu::protocol::ContactId> m_requested;
+			QSet<openmittsu::protocol::ContactId> m_inFlight;
+			QHash<openmittsu::protocol::ContactId, qint64> m_failedUntil;
+
+			void purgeExpiredFailures(qint64 now);
+		};
+
+	}
+}
+
+#endif // OPENMITTSU_NETWORK_IDENTITYRESOLVER_H_
@@ -0,0 +1,124 @@
+#include "src/network/IncomingMessageDecryptor.h"
+
+#include "src/exceptions/ProtocolErrorException.h"
+#include "src/messages/IncomingMessagesParser.h"
+#include "src/messages/MessageWithPayload.h"
+#include "src/utility/Logging.h"
+#include "src/utility/MakeUnique.h"
+
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+
+#include <algorithm>
+
+namespace openmittsu {
+	namespace network {
+
+		class IncomingMessageDecryptorTask : public QRunnable {
+		public:
+			IncomingMessageDecryptorTask(IncomingMessageDecryptor* owner, std::shared_ptr<IncomingMessageDecryptor::Job> const& job) : QRunnable(), m_owner(owner), m_job(job) {
+				setAutoDelete(true);
+			}
+
+			virtual void run() override {
+				IncomingMessageDecryptor::decryptAndParse(m_owner->m_cryptoBox, *m_job);
+				m_job->isDone.storeRelease(1);
+
+				// Delivered queued to the protocol thread.
+				emit m_owner->jobsCompleted();
+			}
+		private:
+			IncomingMessageDecryptor* const m_owner;
+			std::shared_ptr<IncomingMessageDecryptor::Job> const m_job;
+		};
+
+		IncomingMessageDecryptor::Job::Job(openmittsu::messages::MessageWithEncryptedPayload const& encryptedMessage) : message(encryptedMessage), result(), decryptionMicroseconds(0), parsingMicroseconds(0), isDone(0) {
+			// Intentionally left empty.
+		}
+
+		IncomingMessageDecryptor::IncomingMessageDecryptor(std::shared_ptr<openmittsu::crypto::FullCryptoBox> const& cryptoBox, int maximalThreadCount) : QObject(nullptr), m_cryptoBox(cryptoBox), m_threadPool(), m_mutex(), m_jobsBySender() {
+			setMaximalThreadCount(maximalThreadCount);
+		}
+
+		IncomingMessageDecryptor::~IncomingMessageDecryptor() {
+			m_threadPool.waitForDone();
+		}
+
+		void IncomingMessageDecryptor::setMaximalThreadCount(int maximalThreadCount) {
+			if (maximalThreadCount <= 0) {
+				maximalThreadCount = std::max(1, QThread::idealThreadCount());
+			}
+			m_threadPool.setMaxThreadCount(maximalThreadCount);
+		}
+
+		int IncomingMessageDecryptor::getMaximalThreadCount() const {
+			return m_threadPool.maxThreadCount();
+		}
+
+		void IncomingMessageDecryptor::submit(openmittsu::messages::MessageWithEncryptedPayload const& message) {
+			std::shared_ptr<Job> job = std::make_shared<Job>(message);
+			{
+				QMutexLocker lock(&m_mutex);
+				m_jobsBySender[message.getMessageHeader().getSender()].push_back(job);
+			}
+
+			m_threadPool.start(new IncomingMessageDecryptorTask(this, job));
+		}
+
+		std::list<std::shared_ptr<IncomingMessageDecryptor::Job>> IncomingMessageDecryptor::takeCompletedJobs() {
+			QMutexLocker lock(&m_mutex);
+			std::list<std::shared_ptr<Job>> result;
+
+			auto it = m_jobsBySender.begin();
+			while (it != m_jobsBySender.end()) {
+				std::list<std::shared_ptr<Job>>& jobs = it.value();
+				while (!jobs.empty() && (jobs.front()->isDone.loadAcquire() != 0)) {
+					result.push_back(jobs.front());
+					jobs.pop_front();
+				}
+
+				if (jobs.empty()) {
+					it = m_jobsBySender.erase(it);
+				} else {
+					++it;
+				}
+			}
+
+			return result;
+		}
+
+		bool IncomingMessageDecryptor::hasPendingJobs() const {
+			QMutexLocker lock(&m_mutex);
+			return !m_jobsBySender.isEmpty();
+		}
+
+		void IncomingMessageDecryptor::decryptAndParse(std::shared_ptr<openmittsu::crypto::FullCryptoBox> const& cryptoBox, Job& job) {
+			openmittsu::messages::FullMessageHeader const& header = job.message.getMessageHeader();
+
+			// Runs on a worker thread, so nothing may escape from here.
+			QElapsedTimer timer;
+			timer.start();
+			std::unique_ptr<openmittsu::messages::MessageWithPayload> messageWithPayload;
+			try {
+				messageWithPayload = std::make_unique<openmittsu::messages::MessageWithPayload>(job.message.decrypt(cryptoBox));
+			} catch (std::exception& e) {
+				LOGGER()->error("Could not decrypt received message from {} with ID {}: {}", header.getSender().toString(), header.getMessageId().toString(), e.what());
+				return;
+			}
+			job.decryptionMicroseconds = timer.nsecsElapsed() / 1000;
+
+			timer.restart();
+			try {
+				job.result = openmittsu::messages::IncomingMessagesParser::parseMessageWithPayloadToMessage(*messageWithPayload);
+			} catch (openmittsu::exceptions::ProtocolErrorException& pee) {
+				LOGGER()->warn("Encountered an error while parsing payload of received message from {} with ID {}: {}\nThe payload was: {}", header.getSender().toString(), header.getMessageId().toString(), pee.what(), QString(messageWithPayload->getPayload().toHex()).toStdString());
+			} catch (std::exception& e) {
+				LOGGER()->critical("Unknown error while parsing payload of received message from {} with ID {}: {}", header.getSender().toString(), header.getMessageId().toString(), e.what());
+			}
+			job.parsingMicroseconds = timer.nsecsElapsed() / 1000;
+		}
+
+	}
+}
@@ -0,0 +1,76 @@
+#ifndef OPENMITTSU_NETWORK_INCOMINGMESSAGEDECRYPTOR_H_
+#define OPENMITTSU_NETWORK_INCOMINGMESSAGEDECRYPTOR_H_
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QThreadPool>
+
+#include <list>
+#include <memory>
+
+#include "src/crypto/FullCryptoBox.h"
+#include "src/messages/Message.h"
+#include "src/messages/MessageWithEncryptedPayload.h"
+#include "src/protocol/ContactId.h"
+
+namespace openmittsu {
+	namespace network {
+
+		/**
+		 * Decrypts and parses incoming messages on a bounded worker pool.
+		 * Messages of one sender are handed out in the order they were submitted, messages of different senders may overtake each other.
+		 */
+		class IncomingMessageDecryptor : public QObject {
+			Q_OBJECT
+		public:
+			struct Job {
+				explicit Job(openmittsu::messages::MessageWithEncryptedPayload const& encryptedMessage);
+
+				openmittsu::messages::MessageWithEncryptedPayload const message;
+
+				// Null if decrypting or parsing failed, the error has already been logged.
+				std::shared_ptr<openmittsu::messages::Message> result;
+				qint64 decryptionMicroseconds;
+				qint64 parsingMicroseconds;
+				QAtomicInt isDone;
+			};
+
+			IncomingMessageDecryptor(std::shared_ptr<openmittsu::crypto::FullCryptoBox> const& cryptoBox, int maximalThreadCount);
+			virtual ~IncomingMessageDecryptor();
+
+			/**
+			 * @param maximalThreadCount The number of worker threads, zero or less selects the number of cores.
+			 */
+			void setMaximalThreadCount(int maximalThreadCount);
+			int getMaximalThreadCount() const;
+
+			/**
+			 * Queues the message for decryption. Listen to jobsCompleted() and collect the results with takeCompletedJobs().
+			 */
+			void submit(openmittsu::messages::MessageWithEncryptedPayload const& message);
+
+			/**
+			 * Removes and returns, per sender, the completed jobs that are not preceded by a pending one.
+			 */
+			std::list<std::shared_ptr<Job>> takeCompletedJobs();
+			bool hasPendingJobs() const;
+		signals:
+			void jobsCompleted();
+		private:
+			std::shared_ptr<openmittsu::crypto::FullCryptoBox> const m_cryptoBox;
+			QThreadPool m_threadPool;
+
+			mutable QMutex m_mutex;
+			QHash<openmittsu::protocol::ContactId, std::list<std::shared_ptr<Job>>> m_jobsBySender;
+
+			static void decryptAndParse(std::shared_ptr<openmittsu::crypto::FullCryptoBox> const& cryptoBox, Job& job);
+
+			friend class IncomingMessageDecryptorTask;
+		};
+
+	}
+}
+
+#endif // OPENMITTSU_NETWORK_INCOMINGMESSAGEDECRYPTOR_H_
@@ -21,6 +21,24 @@ namespace openmittsu {
 			}
 		}
 
+		void MessageCenterWrapper::storePendingMessage(QString const& waitingFor, QByteArray const& messagePacket) {
+			if (!QMetaObject::invokeMethod(m_messageCenter.get(), "onPendingMessageSpilled", Qt::QueuedConnection, Q_ARG(QString, waitingFor), Q_ARG(QByteArray, messagePacket))) {
+				throw openmittsu::exceptions::InternalErrorException() << "Could not invoke method onPendingMessageSpilled in " << __FILE__ << "  at line " << __LINE__ << ".";
+			}
+		}
+
+		void MessageCenterWrapper::restorePendingMessages(QString const& waitingFor) {
+			if (!QMetaObject::invokeMethod(m_messageCenter.get(), "onPendingMessagesReady", Qt::QueuedConnection, Q_ARG(QString, waitingFor))) {
+				throw openmittsu::exceptions::InternalErrorException() << "Could not invoke method onPendingMessagesReady in " << __FILE__ << "  at line " << __LINE__ << ".";
+			}
+		}
+
+		void MessageCenterWrapper::discardPendingMessages(QString const& waitingFor) {
+			if (!QMetaObject::invokeMethod(m_messageCenter.get(), "onPendingMessagesFailed", Qt::QueuedConnection, Q_ARG(QString, waitingFor))) {
+				throw openmittsu::exceptions::InternalErrorException() << "Could not invoke method onPendingMessagesFailed in " << __FILE__ << "  at line " << __LINE__ << ".";
+			}
+		}
+
 		void MessageCenterWrapper::processMessageSendFailed(openmittsu::protocol::ContactId const& receiver, openmittsu::protocol::MessageId const& messageId) {
 			if (!QMetaObject::invokeMethod(m_messageCenter.get(), "onMessageSendFailed", Qt::QueuedConnection, Q_ARG(openmittsu::protocol::ContactId, receiver), Q_ARG(openmittsu::protocol::MessageId, messageId))) {
 				throw openmittsu::exceptions::InternalErrorException() << "Could not invoke method onMessageSendFailed in " << __FILE__ << "  at line " << __LINE__ << ".";
@@ -25,6 +25,11 @@ namespace openmittsu {
 
 			virtual void addNewContact(openmittsu::protocol::ContactId const& contact, openmittsu::crypto::PublicKey const& publicKey);
 
+			// Messages waiting for missing identities that do not fit into memory, see MessageStorage::storePendingMessage
+			virtual void storePendingMessage(QString const& waitingFor, QByteArray const& messagePacket);
+			virtual void restorePendingMessages(QString const& waitingFor);
+			virtual void discardPendingMessages(QString const& waitingFor);
+
 			virtual void processMessageSendFailed(openmittsu::protocol::ContactId const& receiver, openmittsu::protocol::MessageId const& messageId);
 			virtual void processMessageSendDone(openmittsu::protocol::ContactId const& receiver, openmittsu::protocol::MessageId const& messageId);
 			virtual void processMessageSendFailed(openmittsu::protocol::GroupId const& group, openmittsu::protocol::MessageId const& messageId);
@@ -7,11 +7,11 @@
 namespace openmittsu {
 	namespace network {
 
-		MissingIdentityProcessor::MissingIdentityProcessor(openmittsu::protocol::ContactId const& missingContact) : hasErrors(false), missingContacts(), queuedMessages(), groupIdPtr(nullptr) {
+		MissingIdentityProcessor::MissingIdentityProcessor(openmittsu::protocol::ContactId const& missingContact) : hasErrors(false), missingContacts(), queuedMessages(), queuedMessagesBytes(0), spilledMessages(0), restoring(false), restoredMessages(), groupIdPtr(nullptr), pendingMessagesKey(QStringLiteral("identity/contact/%1").arg(missingContact.toQString())) {
 			missingContacts.insert(missingContact);
 		}
 
-		MissingIdentityProcessor::MissingIdentityProcessor(openmittsu::protocol::GroupId const& groupId, QSet<openmittsu::protocol::ContactId> const& missingContacts) : hasErrors(false), missingContacts(missingContacts), queuedMessages(), groupIdPtr(std::make_unique<openmittsu::protocol::GroupId>(groupId)) {
+		MissingIdentityProcessor::MissingIdentityProcessor(openmittsu::protocol::GroupId const& groupId, QSet<openmittsu::protocol::ContactId> const& missingContacts) : hasErrors(false), missingContacts(missingContacts), queuedMessages(), queuedMessagesBytes(0), spilledMessages(0), restoring(false), restoredMessages(), groupIdPtr(std::make_unique<openmittsu::protocol::GroupId>(groupId)), pendingMessagesKey(QStringLiteral("identity/group/%1").arg(groupId.toQString())) {
 			// Intentionally left empty.
 		}
 
@@ -37,6 +37,45 @@ namespace openmittsu {
 
 		void MissingIdentityProcessor::enqueueMessage(openmittsu::messages::MessageWithEncryptedPayload const& message) {
 			queuedMessages.push_back(message);
+			queuedMessagesBytes += openmittsu::messages::FullMessageHeader::getFullMessageHeaderSize() + message.getEncryptedPayload().size();
+		}
+
+		qint64 MissingIdentityProcessor::getQueuedMessagesBytes() const {
+			return queuedMessagesBytes;
+		}
+
+		QString const& MissingIdentityProcessor::getPendingMessagesKey() const {
+			return pendingMessagesKey;
+		}
+
+		void MissingIdentityProcessor::countSpilledMessage() {
+			spilledMessages += 1;
+		}
+
+		int MissingIdentityProcessor::getSpilledMessageCount() const {
+			return spilledMessages;
+		}
+
+		void MissingIdentityProcessor::startRestoring() {
+			restoring = true;
+			queuedMessages.clear();
+			queuedMessagesBytes = 0;
+			spilledMessages = 0;
+		}
+
+		bool MissingIdentityProcessor::isRestoring() const {
+			return restoring;
+		}
+
+		void MissingIdentityProcessor::addRestoredMessage(openmittsu::messages::MessageWithEncryptedPayload const& message) {
+			restoredMessages.insert(qMakePair(message.getMessageHeader().getSender(), message.getMessageHeader().getMessageId()));
+		}
+
+		bool MissingIdentityProcessor::isRestoredMessage(openmittsu::messages::MessageWithEncryptedPayload const*const message) const {
+			if (!restoring || (message == nullptr)) {
+				return false;
+			}
+			return restoredMessages.contains(qMakePair(message->getMessageHeader().getSender(), message->getMessageHeader().getMessageId()));
 		}
 
 		void MissingIdentityProcessor::identityFetcherTaskFinished(openmittsu::protocol::ContactId const& contactId, bool successful) {
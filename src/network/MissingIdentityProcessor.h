@@ -2,7 +2,9 @@
 #define OPENMITTSU_NETWORK_MISSINGIDENTITYPROCESSOR_H_
 
 #include <QObject>
+#include <QPair>
 #include <QSet>
+#include <QString>
 #include <list>
 #include <memory>
 #include <utility>
@@ -10,6 +12,7 @@
 #include "src/messages/MessageWithEncryptedPayload.h"
 #include "src/protocol/ContactId.h"
 #include "src/protocol/GroupId.h"
+#include "src/protocol/MessageId.h"
 
 namespace openmittsu {
 	namespace network {
@@ -27,6 +30,22 @@ namespace openmittsu {
 
 			std::list<openmittsu::messages::MessageWithEncryptedPayload> const& getQueuedMessages() const;
 			void enqueueMessage(openmittsu::messages::MessageWithEncryptedPayload const& message);
+			qint64 getQueuedMessagesBytes() const;
+
+			/** Messages that did not fit into memory are kept in the storage under this key, see MessageStorage::storePendingMessage. */
+			QString const& getPendingMessagesKey() const;
+			void countSpilledMessage();
+			int getSpilledMessageCount() const;
+
+			/**
+			 * Marks the processor as handing its messages back, until that is done newer messages are queued behind them in the storage.
+			 * Clears the queued messages and the count of spilled messages, only messages spilled from now on are counted.
+			 */
+			void startRestoring();
+			bool isRestoring() const;
+			/** Remembers a message that is handed back, it must not be queued again on its way through. */
+			void addRestoredMessage(openmittsu::messages::MessageWithEncryptedPayload const& message);
+			bool isRestoredMessage(openmittsu::messages::MessageWithEncryptedPayload const*const message) const;
 
 			void identityFetcherTaskFinished(openmittsu::protocol::ContactId const& contactId, bool successful);
 
@@ -36,7 +55,12 @@ namespace openmittsu {
 			bool hasErrors;
 			QSet<openmittsu::protocol::ContactId> missingContacts;
 			std::list<openmittsu::messages::MessageWithEncryptedPayload> queuedMessages;
+			qint64 queuedMessagesBytes;
+			int spilledMessages;
+			bool restoring;
+			QSet<QPair<openmittsu::protocol::ContactId, openmittsu::protocol::MessageId>> restoredMessages;
 			std::unique_ptr<openmittsu::protocol::GroupId> const groupIdPtr;
+			QString const pendingMessagesKey;
 		};
 
 	}
@@ -0,0 +1,44 @@
+#include "src/network/PacketCaptureReader.h"
+
+#include "src/exceptions/IllegalArgumentException.h"
+#include "src/network/PacketCaptureWriter.h"
+
+namespace openmittsu {
+	namespace network {
+
+		PacketCaptureReader::PacketCaptureReader(QString const& filename) : m_file(filename), m_stream() {
+			if (!m_file.open(QFile::ReadOnly)) {
+				throw openmittsu::exceptions::IllegalArgumentException() << QString("Could not open the packet capture file for reading: %1").arg(filename).toStdString();
+			}
+
+			m_stream.setDevice(&m_file);
+			m_stream.setByteOrder(QDataStream::LittleEndian);
+
+			QByteArray const& magic = PacketCaptureWriter::getMagic();
+			if (m_file.read(magic.size()) != magic) {
+				throw openmittsu::exceptions::IllegalArgumentException() << QString("Not a packet capture file: %1").arg(filename).toStdString();
+			}
+		}
+
+		PacketCaptureReader::~PacketCaptureReader() {
+			m_file.close();
+		}
+
+		bool PacketCaptureReader::readNext(qint64& timestamp, QByteArray& packet) {
+			if (m_stream.atEnd()) {
+				return false;
+			}
+
+			quint32 size = 0;
+			m_stream >> timestamp >> size;
+			if ((m_stream.status() != QDataStream::Ok) || (static_cast<qint64>(size) > m_file.bytesAvailable())) {
+				throw openmittsu::exceptions::IllegalArgumentException() << QString("The packet capture file %1 is truncated.").arg(m_file.fileName()).toStdString();
+			}
+
+			packet.resize(static_cast<int>(size));
+			m_stream.readRawData(packet.data(), packet.size());
+			return true;
+		}
+
+	}
+}
@@ -0,0 +1,32 @@
+#ifndef OPENMITTSU_NETWORK_PACKETCAPTUREREADER_H_
+#define OPENMITTSU_NETWORK_PACKETCAPTUREREADER_H_
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QFile>
+#include <QString>
+
+namespace openmittsu {
+	namespace network {
+
+		/**
+		 * Reads the packets recorded by a PacketCaptureWriter, in the order they were received.
+		 */
+		class PacketCaptureReader {
+		public:
+			explicit PacketCaptureReader(QString const& filename);
+			virtual ~PacketCaptureReader();
+
+			/**
+			 * @return True iff another packet was read, false at the end of the capture.
+			 */
+			bool readNext(qint64& timestamp, QByteArray& packet);
+		private:
+			QFile m_file;
+			QDataStream m_stream;
+		};
+
+	}
+}
+
+#endif // OPENMITTSU_NETWORK_PACKETCAPTUREREADER_H_
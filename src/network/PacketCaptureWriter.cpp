@@ -0,0 +1,52 @@
+#include "src/network/PacketCaptureWriter.h"
+
+#include <QDateTime>
+
+#include "src/exceptions/IllegalArgumentException.h"
+#include "src/exceptions/InternalErrorException.h"
+
+namespace openmittsu {
+	namespace network {
+
+		PacketCaptureWriter::PacketCaptureWriter(QString const& filename) : m_filename(filename), m_file(filename), m_stream(), m_packetCount(0) {
+			if (!m_file.open(QFile::WriteOnly | QFile::Truncate)) {
+				throw openmittsu::exceptions::IllegalArgumentException() << QString("Could not open the packet capture file for writing: %1").arg(filename).toStdString();
+			}
+
+			m_stream.setDevice(&m_file);
+			m_stream.setByteOrder(QDataStream::LittleEndian);
+			m_stream.writeRawData(getMagic().constData(), getMagic().size());
+		}
+
+		PacketCaptureWriter::~PacketCaptureWriter() {
+			m_file.close();
+		}
+
+		QByteArray const& PacketCaptureWriter::getMagic() {
+			static QByteArray const magic("OMCAP\x00\x00\x01", 8);
+			return magic;
+		}
+
+		void PacketCaptureWriter::write(QByteArray const& packet) {
+			m_stream << static_cast<qint64>(QDateTime::currentMSecsSinceEpoch()) << static_cast<quint32>(packet.size());
+			m_stream.writeRawData(packet.constData(), packet.size());
+			if (m_stream.status() != QDataStream::Ok) {
+				throw openmittsu::exceptions::InternalErrorException() << QString("Could not write to the packet capture file: %1").arg(m_filename).toStdString();
+			}
+			++m_packetCount;
+		}
+
+		void PacketCaptureWriter::flush() {
+			m_file.flush();
+		}
+
+		QString const& PacketCaptureWriter::getFilename() const {
+			return m_filename;
+		}
+
+		quint64 PacketCaptureWriter::getPacketCount() const {
+			return m_packetCount;
+		}
+
+	}
+}
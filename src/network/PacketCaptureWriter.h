@@ -0,0 +1,40 @@
+#ifndef OPENMITTSU_NETWORK_PACKETCAPTUREWRITER_H_
+#define OPENMITTSU_NETWORK_PACKETCAPTUREWRITER_H_
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QFile>
+#include <QString>
+
+namespace openmittsu {
+	namespace network {
+
+		/**
+		 * Records decrypted server packets (type header and payload) to a binary capture file for replaying them offline.
+		 * The file starts with an eight Byte magic, followed by one record per packet: the capture time in milliseconds since the epoch (64 bit),
+		 * the packet length (32 bit), both little endian, and the packet itself. See PacketCaptureReader.
+		 * Captures contain message contents that are still end-to-end encrypted, but everything else in plain text.
+		 */
+		class PacketCaptureWriter {
+		public:
+			explicit PacketCaptureWriter(QString const& filename);
+			virtual ~PacketCaptureWriter();
+
+			void write(QByteArray const& packet);
+			void flush();
+
+			QString const& getFilename() const;
+			quint64 getPacketCount() const;
+
+			static QByteArray const& getMagic();
+		private:
+			QString const m_filename;
+			QFile m_file;
+			QDataStream m_stream;
+			quint64 m_packetCount;
+		};
+
+	}
+}
+
+#endif // OPENMITTSU_NETWORK_PACKETCAPTUREWRITER_H_
@@ -3,6 +3,9 @@
 #include <QMutex>
 #include <QByteArray>
 
+#include <algorithm>
+#include <limits>
+
 #include "src/acknowledgments/ContactMessageAcknowledgmentProcessor.h"
 #include "src/acknowledgments/GroupContentMessageAcknowledgmentProcessor.h"
 #include "src/acknowledgments/GroupCreationMessageAcknowledgmentProcessor.h"
@@ -10,15 +13,15 @@
 #include "src/exceptions/IllegalArgumentException.h"
 #include "src/exceptions/ProtocolErrorException.h"
 #include "src/tasks/CallbackTask.h"
-#include "src/tasks/IdentityReceiverCallbackTask.h"
+#include "src/tasks/IdentityBulkReceiverCallbackTask.h"
 #include "src/tasks/MessageCallbackTask.h"
+#include "src/tasks/TaskExecutor.h"
 #include "src/utility/ByteArrayConversions.h"
 #include "src/utility/ByteArrayToHexString.h"
 #include "src/utility/Logging.h"
 #include "src/utility/MakeUnique.h"
 #include "src/utility/OptionMaster.h"
 #include "src/utility/QObjectConnectionMacro.h"
-#include "src/utility/ThreadDeleter.h"
 
 #include "src/messages/Message.h"
 #include "src/messages/MessageFlagsFactory.h"
@@ -41,13 +44,28 @@
 
 #include "sodium.h"
 
+#define OPENMITTSU_PROTOCOLCLIENT_CONNECT_TIMEOUT_MS (10000)
+#define OPENMITTSU_PROTOCOLCLIENT_HANDSHAKE_PHASE_TIMEOUT_MS (5000)
+#define OPENMITTSU_PROTOCOLCLIENT_OUTGOING_HIGH_WATER_MARK_BYTES (1024 * 1024)
+#define OPENMITTSU_PROTOCOLCLIENT_OUTGOING_LOW_WATER_MARK_BYTES (256 * 1024)
+#define OPENMITTSU_PROTOCOLCLIENT_SOCKET_BUFFER_TARGET_BYTES (64 * 1024)
+#define OPENMITTSU_PROTOCOLCLIENT_INTERACTIVE_LANE_WEIGHT (4)
+#define OPENMITTSU_PROTOCOLCLIENT_CLIENT_ACKNOWLEDGEMENT_FLUSH_DELAY_MS (10)
+#define OPENMITTSU_PROTOCOLCLIENT_CLIENT_ACKNOWLEDGEMENT_MAX_BATCH_SIZE (256)
+#define OPENMITTSU_PROTOCOLCLIENT_IDENTITY_LOOKUP_DELAY_MS (20)
+#define OPENMITTSU_PROTOCOLCLIENT_IDENTITY_LOOKUP_MAX_BATCH_SIZE (100)
+#define OPENMITTSU_PROTOCOLCLIENT_IDENTITY_NEGATIVE_CACHE_TTL_MS (10 * 60 * 1000)
+#define OPENMITTSU_PROTOCOLCLIENT_IDENTITY_LOOKUP_RETRY_MIN_DELAY_MS (2000)
+#define OPENMITTSU_PROTOCOLCLIENT_IDENTITY_LOOKUP_RETRY_MAX_DELAY_MS (60 * 1000)
+#define OPENMITTSU_PROTOCOLCLIENT_PENDING_MESSAGES_MEMORY_BUDGET_BYTES (8 * 1024 * 1024)
+
 namespace openmittsu {
 	namespace network {
 
 		ProtocolClient::ProtocolClient(std::shared_ptr<openmittsu::crypto::FullCryptoBox> cryptoBox, openmittsu::protocol::ContactId const& ourContactId, std::shared_ptr<openmittsu::network::ServerConfiguration> const& serverConfiguration, std::shared_ptr<openmittsu::utility::OptionMaster> const& optionMaster, std::shared_ptr<openmittsu::network::MessageCenterWrapper> const& messageCenterWrapper, openmittsu::protocol::PushFromId const& pushFromId)
 			: QObject(nullptr), m_cryptoBox(std::move(cryptoBox)), m_messageCenterWrapper(messageCenterWrapper), m_pushFromIdPtr(std::make_unique<openmittsu::protocol::PushFromId>(pushFromId)),
-			m_isSetupDone(false), m_isNetworkSessionReady(false), m_isConnected(false), m_isAllowedToSend(false), m_isDisconnecting(false), m_socket(nullptr), m_networkSession(nullptr), m_ourContactId(ourContactId), m_serverConfiguration(serverConfiguration), m_optionMaster(optionMaster), outgoingMessagesTimer(nullptr), acknowledgmentWaitingTimer(nullptr), keepAliveTimer(nullptr), keepAliveCounter(0), failedReconnectAttempts(0) {
-			// Intentionally left empty.
+			m_isSetupDone(false), m_isNetworkSessionReady(false), m_isConnected(false), m_isAllowedToSend(false), m_isDisconnecting(false), m_handshakeState(HandshakeState::NONE), m_handshakeTimeoutTimer(nullptr), m_handshakePhaseTimer(), m_handshakeConnectLatency(-1), m_handshakeServerHelloLatency(-1), m_handshakeAuthenticationLatency(-1), m_frameDecoder(), m_socket(nullptr), m_networkSession(nullptr), m_ourContactId(ourContactId), m_serverConfiguration(serverConfiguration), m_optionMaster(optionMaster), outgoingMessages(), outgoingMessagesBytes(0), outgoingMessagesTimer(nullptr), outgoingMessagesMutex(), m_isOutgoingQueueFull(false), m_isOutgoingQueueDrainedNotificationRequested(false), m_clientAcknowledgementBatcher(), m_clientAcknowledgementFlushTimer(nullptr), m_groupMessageFanOut(nullptr), m_incomingMessageDecryptor(nullptr), acknowledgmentWaitingTimer(nullptr), m_identityResolver(OPENMITTSU_PROTOCOLCLIENT_IDENTITY_NEGATIVE_CACHE_TTL_MS, OPENMITTSU_PROTOCOLCLIENT_IDENTITY_LOOKUP_MAX_BATCH_SIZE), m_identityLookupTimer(nullptr), m_identityLookupRetryDelayMs(0), m_pendingMessagesBytes(0), keepAliveTimer(nullptr), keepAliveCounter(0), failedReconnectAttempts(0), messagesReceived(0), messagesSend(0), bytesSend(0), bytesReceived(0), outgoingDrainsPerformed(0), lastDrainMessagesSend(0), lastDrainBytesSend(0), readWakeups(0), lastFramesPerWakeup(0), maxFramesPerWakeup(0), connectionStart(), m_metrics(), m_metricsClock(), m_packetCaptureWriter(nullptr) {
+			m_metricsClock.start();
 		}
 
 		ProtocolClient::~ProtocolClient() {
@@ -85,11 +103,23 @@ namespace openmittsu {
 			messagesSend = 0;
 			bytesSend = 0;
 			bytesReceived = 0;
+			outgoingDrainsPerformed = 0;
+			lastDrainMessagesSend = 0;
+			lastDrainBytesSend = 0;
+			readWakeups = 0;
+			lastFramesPerWakeup = 0;
+			maxFramesPerWakeup = 0;
 			//acknowledgmentWaitingMutex.lock();
 			//acknowledgmentWaitingMessages.clear();
 			//acknowledgmentWaitingMutex.unlock();
 
+			m_handshakeConnectLatency = -1;
+			m_handshakeServerHelloLatency = -1;
+			m_handshakeAuthenticationLatency = -1;
+			m_metrics.incrementCounter(QStringLiteral("protocol.connects"));
+
 			LOGGER()->info("Now connecting to {} on port {}.", m_serverConfiguration->getServerHost().toStdString(), m_serverConfiguration->getServerPort());
+			enterHandshakeState(HandshakeState::CONNECTING);
 			m_socket->connectToHost(m_serverConfiguration->getServerHost(), m_serverConfiguration->getServerPort());
 		}
 
@@ -97,11 +127,13 @@ namespace openmittsu {
 			LOGGER()->info("Socket is now in state disconnected.");
 			m_isConnected = false;
 			m_isAllowedToSend = false;
+			enterHandshakeState(HandshakeState::NONE);
 			keepAliveTimer->stop();
 			outgoingMessagesTimer->stop();
 
 			if (!m_isDisconnecting && (failedReconnectAttempts < 3) && m_optionMaster->getOptionAsBool(openmittsu::utility::OptionMaster::Options::BOOLEAN_RECONNECT_ON_CONNECTION_LOSS)) {
 				LOGGER()->info("Trying to reconnect...");
+				m_metrics.incrementCounter(QStringLiteral("protocol.reconnects"));
 				connectToServer();
 				return;
 			} else if (failedReconnectAttempts >= 3) {
@@ -138,15 +170,42 @@ namespace openmittsu {
 				OPENMITTSU_CONNECT(m_socket.get(), error(QAbstractSocket::SocketError), this, socketOnError(QAbstractSocket::SocketError));
 				OPENMITTSU_CONNECT(m_socket.get(), connected(), this, socketConnected());
 				OPENMITTSU_CONNECT(m_socket.get(), disconnected(), this, socketDisconnected());
+				OPENMITTSU_CONNECT(m_socket.get(), bytesWritten(qint64), this, socketOnBytesWritten(qint64));
 
+				// The outgoing queue is drained in one burst once control returns to the event loop, coalescing all packets enqueued in the meantime.
 				outgoingMessagesTimer = std::make_unique<QTimer>();
-				outgoingMessagesTimer->setInterval(500);
+				outgoingMessagesTimer->setSingleShot(true);
+				outgoingMessagesTimer->setInterval(0);
 				OPENMITTSU_CONNECT(outgoingMessagesTimer.get(), timeout(), this, outgoingMessagesTimerOnTimer());
 
+				m_clientAcknowledgementFlushTimer = std::make_unique<QTimer>();
+				m_clientAcknowledgementFlushTimer->setSingleShot(true);
+				m_clientAcknowledgementFlushTimer->setInterval(OPENMITTSU_PROTOCOLCLIENT_CLIENT_ACKNOWLEDGEMENT_FLUSH_DELAY_MS);
+				OPENMITTSU_CONNECT(m_clientAcknowledgementFlushTimer.get(), timeout(), this, clientAcknowledgementFlushTimerOnTimer());
+
+				// Gives the members of a new group (or a burst of unknown senders) a moment to arrive, so they are looked up together.
+				m_identityLookupTimer = std::make_unique<QTimer>();
+				m_identityLookupTimer->setSingleShot(true);
+				m_identityLookupTimer->setInterval(std::max(m_identityLookupRetryDelayMs, OPENMITTSU_PROTOCOLCLIENT_IDENTITY_LOOKUP_DELAY_MS));
+				OPENMITTSU_CONNECT(m_identityLookupTimer.get(), timeout(), this, identityLookupTimerOnTimer());
+				if (m_identityResolver.hasPendingRequests()) {
+					m_identityLookupTimer->start();
+				}
+
+				m_groupMessageFanOut = std::make_unique<GroupMessageFanOut>(m_cryptoBox, m_optionMaster->getOptionAsInt(openmittsu::utility::OptionMaster::Options::INTEGER_NETWORK_GROUP_ENCRYPTION_THREADS));
+				OPENMITTSU_CONNECT(m_groupMessageFanOut.get(), fanOutProgressed(), this, groupMessageFanOutProgressed());
+
+				m_incomingMessageDecryptor = std::make_unique<IncomingMessageDecryptor>(m_cryptoBox, m_optionMaster->getOptionAsInt(openmittsu::utility::OptionMaster::Options::INTEGER_NETWORK_DECRYPTION_THREADS));
+				OPENMITTSU_CONNECT(m_incomingMessageDecryptor.get(), jobsCompleted(), this, incomingMessagesDecrypted());
+
 				acknowledgmentWaitingTimer = std::make_unique<QTimer>();
-				acknowledgmentWaitingTimer->setInterval(5000);
+				acknowledgmentWaitingTimer->setSingleShot(true);
+				acknowledgmentWaitingTimer->setTimerType(Qt::PreciseTimer);
 				OPENMITTSU_CONNECT(acknowledgmentWaitingTimer.get(), timeout(), this, acknowledgmentWaitingTimerOnTimer());
-				acknowledgmentWaitingTimer->start();
+
+				m_handshakeTimeoutTimer = std::make_unique<QTimer>();
+				m_handshakeTimeoutTimer->setSingleShot(true);
+				OPENMITTSU_CONNECT(m_handshakeTimeoutTimer.get(), timeout(), this, handshakeTimeoutTimerOnTimer());
 
 				keepAliveTimer = std::make_unique<QTimer>();
 				keepAliveTimer->setInterval(3 * 60 * 1000);
@@ -191,10 +250,16 @@ namespace openmittsu {
 				OPENMITTSU_DISCONNECT(m_socket.get(), error(QAbstractSocket::SocketError), this, socketOnError(QAbstractSocket::SocketError));
 				OPENMITTSU_DISCONNECT(m_socket.get(), connected(), this, socketConnected());
 				OPENMITTSU_DISCONNECT(m_socket.get(), disconnected(), this, socketDisconnected());
+				OPENMITTSU_DISCONNECT(m_socket.get(), bytesWritten(qint64), this, socketOnBytesWritten(qint64));
 
 				OPENMITTSU_DISCONNECT(outgoingMessagesTimer.get(), timeout(), this, outgoingMessagesTimerOnTimer());
+				OPENMITTSU_DISCONNECT(m_clientAcknowledgementFlushTimer.get(), timeout(), this, clientAcknowledgementFlushTimerOnTimer());
+				OPENMITTSU_DISCONNECT(m_identityLookupTimer.get(), timeout(), this, identityLookupTimerOnTimer());
+				OPENMITTSU_DISCONNECT(m_groupMessageFanOut.get(), fanOutProgressed(), this, groupMessageFanOutProgressed());
+				OPENMITTSU_DISCONNECT(m_incomingMessageDecryptor.get(), jobsCompleted(), this, incomingMessagesDecrypted());
 				OPENMITTSU_DISCONNECT(acknowledgmentWaitingTimer.get(), timeout(), this, acknowledgmentWaitingTimerOnTimer());
 				OPENMITTSU_DISCONNECT(keepAliveTimer.get(), timeout(), this, keepAliveTimerOnTimer());
+				OPENMITTSU_DISCONNECT(m_handshakeTimeoutTimer.get(), timeout(), this, handshakeTimeoutTimerOnTimer());
 
 				if (m_isConnected) {
 					LOGGER()->info("Disconnecting from Server on teardown.");
@@ -213,6 +278,21 @@ namespace openmittsu {
 
 				outgoingMessagesTimer->stop();
 				outgoingMessagesTimer = nullptr;
+
+				// Unacknowledged messages are delivered again by the server.
+				m_clientAcknowledgementFlushTimer->stop();
+				m_clientAcknowledgementFlushTimer = nullptr;
+				m_clientAcknowledgementBatcher.clear();
+
+				// Pending lookups are kept, the messages waiting for them are still queued and the lookups start again on the next setup.
+				m_identityLookupTimer->stop();
+				m_identityLookupTimer = nullptr;
+
+				// Waits for running encryption chunks, copies still pending are dropped.
+				m_groupMessageFanOut = nullptr;
+
+				// Waits for running decryptions, messages still pending are not acknowledged and will be delivered again by the server.
+				m_incomingMessageDecryptor = nullptr;
 		
 				acknowledgmentWaitingTimer->stop();
 				acknowledgmentWaitingTimer = nullptr;
@@ -220,6 +300,10 @@ namespace openmittsu {
 				keepAliveTimer->stop();
 				keepAliveTimer = nullptr;
 
+				m_handshakeState = HandshakeState::NONE;
+				m_handshakeTimeoutTimer->stop();
+				m_handshakeTimeoutTimer = nullptr;
+
 				m_isSetupDone = false;
 			}
 			emit teardownComplete();
@@ -227,54 +311,158 @@ namespace openmittsu {
 
 		void ProtocolClient::outgoingMessagesTimerOnTimer() {
 			QMutexLocker lock(&outgoingMessagesMutex);
-			if (!m_isConnected || !m_isAllowedToSend) {
-				if (outgoingMessages.size() == 0) {
-					outgoingMessagesTimer->stop();
+			outgoingMessagesTimer->stop();
+			if (!m_isConnected || !m_isAllowedToSend || (getQueuedOutgoingMessagesCount() == 0)) {
+				// Nothing to do, the queue is drained again once the server allows us to send.
+				return;
+			}
+
+			// Keep the socket buffer short, so packets from a higher lane never wait behind a large backlog. Continued from socketOnBytesWritten().
+			qint64 budget = OPENMITTSU_PROTOCOLCLIENT_SOCKET_BUFFER_TARGET_BYTES - m_socket->bytesToWrite();
+			if (budget <= 0) {
+				return;
+			}
+
+			// Control packets always go out, the budget is then shared by interactive and bulk packets according to their weight.
+			QList<QByteArray>& controlLane = outgoingMessages[static_cast<std::size_t>(OutgoingLane::CONTROL)];
+			QList<QByteArray>& interactiveLane = outgoingMessages[static_cast<std::size_t>(OutgoingLane::INTERACTIVE)];
+			QList<QByteArray>& bulkLane = outgoingMessages[static_cast<std::size_t>(OutgoingLane::BULK)];
+
+			QList<QByteArray> packets;
+			auto takePacket = [&packets, &budget](QList<QByteArray>& lane) {
+				budget -= getOutgoingFrameSize(lane.first());
+				packets.append(lane.takeFirst());
+			};
+
+			while (!controlLane.isEmpty()) {
+				takePacket(controlLane);
+			}
+
+			int interactiveInRow = 0;
+			while (((budget > 0) || packets.isEmpty()) && (!interactiveLane.isEmpty() || !bulkLane.isEmpty())) {
+				if (!interactiveLane.isEmpty() && (bulkLane.isEmpty() || (interactiveInRow < OPENMITTSU_PROTOCOLCLIENT_INTERACTIVE_LANE_WEIGHT))) {
+					takePacket(interactiveLane);
+					++interactiveInRow;
 				} else {
-					outgoingMessagesTimer->setInterval(500);
-					outgoingMessagesTimer->start();
+					takePacket(bulkLane);
+					interactiveInRow = 0;
 				}
-			} else {
-				QList<QByteArray>::const_iterator i;
-				size_t count = 0;
-				for (i = outgoingMessages.constBegin(); i != outgoingMessages.constEnd(); ++i) {
-					QByteArray const& data = *i;
-					quint16 const size = openmittsu::utility::Endian::uint16FromHostEndianToLittleEndian(static_cast<quint16>(data.size()));
-					QByteArray const lengthBytes = openmittsu::utility::ByteArrayConversions::convertQuint16toQByteArray(size);
-					// First write the two bytes giving the length of the packet
-					m_socket->write(lengthBytes);
-					// Then write the data itself
-					m_socket->write(data);
-					m_socket->flush();
-
-					// Update stats
-					bytesSend += (2 + data.size());
-					messagesSend += 1;
-
-					++count;
-				}
-				LOGGER_DEBUG("Wrote {} messages to server.", count);
-				outgoingMessages.clear();
-				outgoingMessagesTimer->stop();
 			}
+
+			// Assemble the frames (length prefix followed by the encrypted packet) into one contiguous buffer.
+			int frameBufferSize = 0;
+			for (QByteArray const& data : packets) {
+				frameBufferSize += getOutgoingFrameSize(data);
+			}
+
+			QByteArray frameBuffer;
+			frameBuffer.reserve(frameBufferSize);
+			for (QByteArray const& data : packets) {
+				QByteArray const encryptedData = m_cryptoBox->encryptForServer(data);
+
+				// The two bytes giving the length of the packet, in Little-Endian
+				quint16 const size = static_cast<quint16>(encryptedData.size());
+				char const lengthBytes[PROTO_DATA_HEADER_SIZE_LENGTH_BYTES] = { static_cast<char>(size & 0xFF), static_cast<char>((size >> 8) & 0xFF) };
+				frameBuffer.append(lengthBytes, PROTO_DATA_HEADER_SIZE_LENGTH_BYTES);
+				frameBuffer.append(encryptedData);
+			}
+
+			qint64 const bytesWritten = m_socket->write(frameBuffer);
+			if (bytesWritten != frameBuffer.size()) {
+				LOGGER()->error("Could only write {} of {} Bytes of the outbound queue to the socket.", bytesWritten, frameBuffer.size());
+			}
+			m_socket->flush();
+
+			// Update stats
+			int const count = packets.size();
+			bytesSend += frameBuffer.size();
+			messagesSend += count;
+			outgoingDrainsPerformed += 1;
+			lastDrainMessagesSend = count;
+			lastDrainBytesSend = frameBuffer.size();
+			m_metrics.incrementCounter(QStringLiteral("protocol.bytes.sent"), static_cast<quint64>(frameBuffer.size()));
+			m_metrics.recordValue(QStringLiteral("protocol.drain.frames"), count);
+
+			LOGGER_DEBUG("Wrote {} messages with {} Bytes to server, {} messages remain queued.", count, frameBuffer.size(), getQueuedOutgoingMessagesCount());
+			outgoingMessagesBytes -= frameBufferSize;
+			m_metrics.setGauge(QStringLiteral("protocol.queue.outgoing"), getQueuedOutgoingMessagesCount());
+
+			checkOutgoingQueueLowWaterMark();
+		}
+
+		void ProtocolClient::socketOnBytesWritten(qint64 bytes) {
+			Q_UNUSED(bytes);
+			QMutexLocker lock(&outgoingMessagesMutex);
+			if ((getQueuedOutgoingMessagesCount() > 0) && (m_socket->bytesToWrite() < OPENMITTSU_PROTOCOLCLIENT_SOCKET_BUFFER_TARGET_BYTES) && !outgoingMessagesTimer->isActive()) {
+				outgoingMessagesTimer->start();
+			}
+			checkOutgoingQueueLowWaterMark();
+		}
+
+		int ProtocolClient::getQueuedOutgoingMessagesCount() const {
+			int result = 0;
+			for (QList<QByteArray> const& lane : outgoingMessages) {
+				result += lane.size();
+			}
+			return result;
+		}
+
+		int ProtocolClient::getOutgoingFrameSize(QByteArray const& dataPacket) {
+			return PROTO_DATA_HEADER_SIZE_LENGTH_BYTES + static_cast<int>(crypto_box_MACBYTES) + dataPacket.size();
+		}
+
+		void ProtocolClient::requestOutgoingQueueDrainedNotification() {
+			QMutexLocker lock(&outgoingMessagesMutex);
+			m_isOutgoingQueueDrainedNotificationRequested = true;
+			checkOutgoingQueueLowWaterMark();
+		}
+
+		qint64 ProtocolClient::getPendingOutgoingBytes() const {
+			qint64 result = outgoingMessagesBytes;
+			if (m_socket != nullptr) {
+				result += m_socket->bytesToWrite();
+			}
+			return result;
+		}
+
+		void ProtocolClient::checkOutgoingQueueLowWaterMark() {
+			if ((!m_isOutgoingQueueFull && !m_isOutgoingQueueDrainedNotificationRequested) || (getPendingOutgoingBytes() > OPENMITTSU_PROTOCOLCLIENT_OUTGOING_LOW_WATER_MARK_BYTES)) {
+				return;
+			}
+
+			if (m_isOutgoingQueueFull) {
+				LOGGER_DEBUG("Outgoing queue drained below its low water mark.");
+			}
+			m_isOutgoingQueueFull = false;
+			m_isOutgoingQueueDrainedNotificationRequested = false;
+			emit outgoingQueueDrained();
 		}
 
 		void ProtocolClient::acknowledgmentWaitingTimerOnTimer() {
 			QMutexLocker lock(&acknowledgmentWaitingMutex);
-			if (acknowledgmentWaitingMessages.size() > 0) {
-				QDateTime const now = QDateTime::currentDateTime();
-				QHash<openmittsu::protocol::MessageId, std::shared_ptr<openmittsu::acknowledgments::AcknowledgmentProcessor>>::iterator i = acknowledgmentWaitingMessages.begin();
-				QHash<openmittsu::protocol::MessageId, std::shared_ptr<openmittsu::acknowledgments::AcknowledgmentProcessor>>::iterator end = acknowledgmentWaitingMessages.end();
-				while (i != end) {
-					if (i.value()->getTimeoutTime() <= now) {
-						i.value()->sendFailedTimeout(this);
-
-						i = acknowledgmentWaitingMessages.erase(i);
-					} else {
-						++i;
-					}
-				}
+			auto const expiredMessages = acknowledgmentWaitingMessages.takeExpired(QDateTime::currentMSecsSinceEpoch());
+			for (auto const& expiredMessage : expiredMessages) {
+				expiredMessage.second.processor->sendFailedTimeout(this);
 			}
+			m_metrics.incrementCounter(QStringLiteral("protocol.acks.timedOut"), expiredMessages.size());
+			m_metrics.setGauge(QStringLiteral("protocol.queue.awaitingAck"), acknowledgmentWaitingMessages.size());
+
+			rearmAcknowledgmentWaitingTimer();
+		}
+
+		void ProtocolClient::rearmAcknowledgmentWaitingTimer() {
+			if (acknowledgmentWaitingTimer == nullptr) {
+				return;
+			}
+
+			qint64 const nextDeadline = acknowledgmentWaitingMessages.getNextDeadline();
+			if (nextDeadline < 0) {
+				acknowledgmentWaitingTimer->stop();
+				return;
+			}
+
+			qint64 const interval = std::max<qint64>(0, nextDeadline - QDateTime::currentMSecsSinceEpoch());
+			acknowledgmentWaitingTimer->start(static_cast<int>(std::min<qint64>(interval, std::numeric_limits<int>::max())));
 		}
 
 		void ProtocolClient::keepAliveTimerOnTimer() {
@@ -291,7 +479,7 @@ namespace openmittsu {
 				packet[0] = (PROTO_PACKET_SIGNATURE_KEEPALIVE_REQUEST);
 
 				packet.append(openmittsu::utility::ByteArrayConversions::convertQuint32toQByteArray(keepAliveValue));
-				encryptAndSendDataPacketToServer(packet);
+				encryptAndSendDataPacketToServer(packet, OutgoingLane::CONTROL);
 			}
 		}
 
@@ -313,41 +501,125 @@ namespace openmittsu {
 
 		void ProtocolClient::socketOnReadyRead() {
 			if (!m_isConnected) {
-				// ignore until the handshake is complete.
-				return;
+				if ((m_handshakeState == HandshakeState::NONE) || !processHandshakeData() || (m_socket->bytesAvailable() <= 0)) {
+					// ignore until the handshake is complete.
+					return;
+				}
+				LOGGER_DEBUG("Socket has {} Bytes available after handshake.", m_socket->bytesAvailable());
 			}
-			QByteArray newData(m_socket->readAll());
-			bytesReceived += newData.size();
+			qint64 const bytesRead = m_frameDecoder.readFrom(m_socket.get());
+			bytesReceived += bytesRead;
+			m_metrics.incrementCounter(QStringLiteral("protocol.bytes.received"), static_cast<quint64>(std::max<qint64>(0, bytesRead)));
+
+			// Handle all complete frames available right now, the frame data is a view into the receive buffer.
+			quint64 framesThisWakeup = 0;
+			QByteArray packet;
+			QElapsedTimer decryptionTimer;
+			while (m_isConnected && m_frameDecoder.nextFrame(packet)) {
+				decryptionTimer.start();
+				QByteArray const decodedPacket = m_cryptoBox->decryptFromServer(packet);
+				m_metrics.recordValue(QStringLiteral("protocol.frame.decrypt_us"), decryptionTimer.nsecsElapsed() / 1000);
+				packet.clear();
+
+				if (m_packetCaptureWriter != nullptr) {
+					try {
+						m_packetCaptureWriter->write(decodedPacket);
+					} catch (openmittsu::exceptions::InternalErrorException& iee) {
+						// Only a diagnostic aid, losing it must not affect the connection.
+						LOGGER()->error("Stopped recording packets after {} packets: {}", m_packetCaptureWriter->getPacketCount(), iee.what());
+						m_packetCaptureWriter.reset();
+					}
+				}
 
-			m_readyReadRemainingData.append(newData);
-			int bytesAvailable = m_readyReadRemainingData.size();
+				// Update stats
+				messagesReceived += 1;
+				++framesThisWakeup;
 
-			if (bytesAvailable < PROTO_DATA_HEADER_SIZE_LENGTH_BYTES) {
-				// Not enough data, not even the length Bytes!
-				return;
+				handleIncomingPacket(decodedPacket);
 			}
 
-			// Unsigned Two-Byte Integer in Little-Endian
-			quint16 packetLength = openmittsu::utility::Endian::uint16FromLittleEndianToHostEndian(openmittsu::utility::ByteArrayConversions::convert2ByteQByteArrayToQuint16(m_readyReadRemainingData.left(PROTO_DATA_HEADER_SIZE_LENGTH_BYTES)));
-			if (bytesAvailable < static_cast<int>((PROTO_DATA_HEADER_SIZE_LENGTH_BYTES + packetLength))) {
-				// packet not yet complete
-				LOGGER_DEBUG("Deferring, packet not yet complete.");
-				return;
+			if (framesThisWakeup > 0) {
+				if (m_packetCaptureWriter != nullptr) {
+					m_packetCaptureWriter->flush();
+				}
+
+				readWakeups += 1;
+				lastFramesPerWakeup = framesThisWakeup;
+				maxFramesPerWakeup = std::max(maxFramesPerWakeup, framesThisWakeup);
+				m_metrics.recordValue(QStringLiteral("protocol.read.framesPerWakeup"), static_cast<qint64>(framesThisWakeup));
+				LOGGER_DEBUG("Handled {} frames in one read, {} Bytes remain buffered.", framesThisWakeup, m_frameDecoder.getBufferedBytesCount());
 			}
+		}
 
-			// Remove the two length-bytes and packet
-			QByteArray const packet = m_readyReadRemainingData.mid(PROTO_DATA_HEADER_SIZE_LENGTH_BYTES, packetLength);
-			m_readyReadRemainingData = m_readyReadRemainingData.mid(PROTO_DATA_HEADER_SIZE_LENGTH_BYTES + packetLength, -1);
+		void ProtocolClient::setPacketCaptureFile(QString const& filename) {
+			if (m_packetCaptureWriter != nullptr) {
+				LOGGER()->info("Stopped recording packets to {} after {} packets.", m_packetCaptureWriter->getFilename().toStdString(), m_packetCaptureWriter->getPacketCount());
+				m_packetCaptureWriter = nullptr;
+			}
 
-			QByteArray const decodedPacket = m_cryptoBox->decryptFromServer(packet);
+			if (!filename.isEmpty()) {
+				try {
+					m_packetCaptureWriter = std::make_unique<PacketCaptureWriter>(filename);
+					LOGGER()->warn("Recording all received packets to {}. The capture contains identities and message metadata in plain text.", filename.toStdString());
+				} catch (openmittsu::exceptions::IllegalArgumentException& iae) {
+					LOGGER()->error("Could not start recording packets: {}", iae.what());
+				}
+			}
+		}
 
-			// Update stats
+		void ProtocolClient::replayPacket(QByteArray const& decodedPacket) {
 			messagesReceived += 1;
+			handleIncomingPacket(decodedPacket);
+		}
+
+		void ProtocolClient::restorePendingMessages(QString const& waitingFor, QList<QByteArray> const& messagePackets) {
+			if (!m_restoringMissingIdentityProcessors.contains(waitingFor)) {
+				LOGGER()->warn("Received {} messages waiting for {} from the storage, but nothing is being restored for it.", messagePackets.size(), waitingFor.toStdString());
+				return;
+			}
+			std::shared_ptr<MissingIdentityProcessor> const missingIdentityProcessor = m_restoringMissingIdentityProcessors.value(waitingFor);
 
-			// Handle packet
+			for (QByteArray const& messagePacket : messagePackets) {
+				try {
+					openmittsu::messages::MessageWithEncryptedPayload const message(openmittsu::messages::MessageWithEncryptedPayload::fromPacket(messagePacket));
+					missingIdentityProcessor->addRestoredMessage(message);
+					handleIncomingMessage(message);
+				} catch (openmittsu::exceptions::ProtocolErrorException& pee) {
+					LOGGER()->error("Could not restore pending message waiting for {} from the storage: {}", waitingFor.toStdString(), pee.what());
+				} catch (std::exception& e) {
+					LOGGER()->critical("Unknown error while restoring pending message waiting for {} from the storage: {}", waitingFor.toStdString(), e.what());
+				}
+			}
+
+			// Messages that arrived in the meantime were queued behind the restored ones, fetch them as well before letting new messages through.
+			if (missingIdentityProcessor->getSpilledMessageCount() > 0) {
+				LOGGER_DEBUG("Restoring {} further messages waiting for {} from the storage.", missingIdentityProcessor->getSpilledMessageCount(), waitingFor.toStdString());
+				missingIdentityProcessor->startRestoring();
+				m_messageCenterWrapper->restorePendingMessages(waitingFor);
+				return;
+			}
+
+			LOGGER_DEBUG("Finished restoring the messages waiting for {}.", waitingFor.toStdString());
+			m_restoringMissingIdentityProcessors.remove(waitingFor);
+			if (missingIdentityProcessor->hasAssociatedGroupId()) {
+				groupsWithMissingIdentities.remove(missingIdentityProcessor->getAssociatedGroupId());
+			} else {
+				auto it = missingIdentityProcessors.begin();
+				while (it != missingIdentityProcessors.end()) {
+					if (it.value() == missingIdentityProcessor) {
+						it = missingIdentityProcessors.erase(it);
+					} else {
+						++it;
+					}
+				}
+			}
+		}
+
+		void ProtocolClient::handleIncomingPacket(QByteArray const& decodedPacket) {
 			// Extract LSB:
 			char const packetTypeByte = decodedPacket.at(0);
 			QByteArray const packetContents = decodedPacket.mid(PROTO_DATA_HEADER_TYPE_LENGTH_BYTES, -1);
+			m_metrics.incrementCounter(getPacketTypeMetricName(QStringLiteral("protocol.packets.received"), packetTypeByte));
 
 			if (packetTypeByte == (PROTO_PACKET_SIGNATURE_SENDING_MSG)) {
 				LOGGER()->warn("Received a SENDING packet.\nThis should _NOT_ happen?!\nPayload: {}", QString(decodedPacket.toHex()).toStdString());
@@ -380,6 +652,9 @@ namespace openmittsu {
 				m_isAllowedToSend = true;
 				keepAliveCounter = 1;
 				keepAliveTimer->start();
+
+				// Flush everything that was queued while we were not yet allowed to send.
+				outgoingMessagesTimer->start();
 			} else if (packetTypeByte == (PROTO_PACKET_SIGNATURE_CONNECTION_DUPLICATE)) {
 				LOGGER()->warn("Received a CONNECTION_DUPLICATE warning, we will be forcefully disconnected after this. Message from Server: {}", QString::fromUtf8(packetContents).toStdString());
 				failedReconnectAttempts = std::numeric_limits<decltype(failedReconnectAttempts)>::max();
@@ -388,21 +663,18 @@ namespace openmittsu {
 			} else {
 				LOGGER()->warn("Received an UNKNOWN packet with signature {} and payload {}.", QString(decodedPacket.left(PROTO_DATA_HEADER_TYPE_LENGTH_BYTES).toHex()).toStdString(), QString(decodedPacket.toHex()).toStdString());
 			}
-
-			// Check if there is more to do
-			if (m_readyReadRemainingData.size() > 0) {
-				QTimer::singleShot(0, this, SLOT(socketOnReadyRead()));
-			}
 		}
 
 		void ProtocolClient::handleIncomingAcknowledgment(openmittsu::protocol::MessageId const& messageId) {
 			QMutexLocker lock(&acknowledgmentWaitingMutex);
-			if (acknowledgmentWaitingMessages.contains(messageId)) {
-				QHash<openmittsu::protocol::MessageId, std::shared_ptr<openmittsu::acknowledgments::AcknowledgmentProcessor>>::const_iterator i = acknowledgmentWaitingMessages.constFind(messageId);
-				i.value()->sendSuccess(this, messageId);
+			AcknowledgmentWait acknowledgmentWait;
+			if (acknowledgmentWaitingMessages.get(messageId, acknowledgmentWait)) {
+				m_metrics.recordValue(QStringLiteral("protocol.ack.latency_ms"), m_metricsClock.elapsed() - acknowledgmentWait.enqueuedAt);
+				acknowledgmentWait.processor->sendSuccess(this, messageId);
 
-				if (i.value()->isDone()) {
+				if (acknowledgmentWait.processor->isDone()) {
 					acknowledgmentWaitingMessages.remove(messageId);
+					m_metrics.setGauge(QStringLiteral("protocol.queue.awaitingAck"), acknowledgmentWaitingMessages.size());
 				}
 			} else {
 				LOGGER()->warn("Received an incoming acknowledgment for message ID #{}, but no AcknowledgmentProcessor is registered for this message ID.", messageId.toString());
@@ -419,15 +691,51 @@ namespace openmittsu {
 				if (needToWaitForMissingIdentity(sender, &message)) {
 					return;
 				}
+
+				if (m_incomingMessageDecryptor != nullptr) {
+					m_incomingMessageDecryptor->submit(message);
+					return;
+				}
 		
+				QElapsedTimer decryptionTimer;
+				decryptionTimer.start();
 				openmittsu::messages::MessageWithPayload messageWithPayload(message.decrypt(m_cryptoBox));
+				m_metrics.recordValue(QStringLiteral("protocol.message.decrypt_us"), decryptionTimer.nsecsElapsed() / 1000);
 				handleIncomingMessage(messageWithPayload, &message);
 			}
 		}
 
+		void ProtocolClient::incomingMessagesDecrypted() {
+			if (m_incomingMessageDecryptor == nullptr) {
+				return;
+			}
+
+			std::list<std::shared_ptr<IncomingMessageDecryptor::Job>> const jobs = m_incomingMessageDecryptor->takeCompletedJobs();
+			for (std::shared_ptr<IncomingMessageDecryptor::Job> const& job : jobs) {
+				m_metrics.recordValue(QStringLiteral("protocol.message.decrypt_us"), job->decryptionMicroseconds);
+				if (job->result == nullptr) {
+					// Decrypting or parsing failed, the error has already been logged.
+					continue;
+				}
+
+				m_metrics.recordValue(QStringLiteral("protocol.message.parse_us"), job->parsingMicroseconds);
+				openmittsu::messages::FullMessageHeader const& header = job->message.getMessageHeader();
+				try {
+					handleIncomingMessage(job->result.get(), &job->message);
+				} catch (openmittsu::exceptions::ProtocolErrorException& pee) {
+					LOGGER()->warn("Encountered an error while handling received message from {} with ID {}: {}", header.getSender().toString(), header.getMessageId().toString(), pee.what());
+				} catch (std::exception& e) {
+					LOGGER()->critical("Unknown error while handling received message from {} with ID {}: {}", header.getSender().toString(), header.getMessageId().toString(), e.what());
+				}
+			}
+		}
+
 		void ProtocolClient::handleIncomingMessage(openmittsu::messages::MessageWithPayload const& messageWithPayload, openmittsu::messages::MessageWithEncryptedPayload const*const message) {
 			try {
+				QElapsedTimer parseTimer;
+				parseTimer.start();
 				std::shared_ptr<openmittsu::messages::Message> messageSharedPtr = openmittsu::messages::IncomingMessagesParser::parseMessageWithPayloadToMessage(messageWithPayload);
+				m_metrics.recordValue(QStringLiteral("protocol.message.parse_us"), parseTimer.nsecsElapsed() / 1000);
 				openmittsu::messages::Message const* messagePtr = messageSharedPtr.get();
 				handleIncomingMessage(messagePtr, message);
 			} catch (openmittsu::exceptions::ProtocolErrorException& pee) {
@@ -506,19 +814,21 @@ namespace openmittsu {
 		}
 
 		bool ProtocolClient::needToWaitForMissingIdentity(openmittsu::protocol::ContactId const& contactId, openmittsu::messages::MessageWithEncryptedPayload const*const messageWithEncryptedPayload) {
-			if (missingIdentityProcessors.contains(contactId)) {
+			if (missingIdentityProcessors.contains(contactId) && !missingIdentityProcessors.constFind(contactId).value()->isRestoredMessage(messageWithEncryptedPayload)) {
 				LOGGER()->info("Enqueing incoming message on existing MissingIdentityProcessor for ID {}.", contactId.toString());
-				missingIdentityProcessors.constFind(contactId).value()->enqueueMessage(*messageWithEncryptedPayload);
+				enqueuePendingMessage(missingIdentityProcessors.constFind(contactId).value(), *messageWithEncryptedPayload);
 				return true;
 			} else if ((!m_cryptoBox->getKeyRegistry().hasIdentity(contactId))) {
+				if (!requestIdentityLookup(contactId)) {
+					// Not acknowledged, so the server delivers it again once the identity may be looked up again.
+					LOGGER()->warn("Identity {} could not be retrieved recently, discarding message without looking it up again.", contactId.toString());
+					return true;
+				}
+
 				std::shared_ptr<MissingIdentityProcessor> missingIdentityProcessor = std::make_shared<MissingIdentityProcessor>(contactId);
-				missingIdentityProcessor->enqueueMessage(*messageWithEncryptedPayload);
+				enqueuePendingMessage(missingIdentityProcessor, *messageWithEncryptedPayload);
 				missingIdentityProcessors.insert(contactId, missingIdentityProcessor);
 				LOGGER()->info("Enqueing MissingIdentityProcessor for ID {}.", contactId.toString());
-
-				openmittsu::tasks::CallbackTask* callbackTask = new openmittsu::tasks::IdentityReceiverCallbackTask(m_serverConfiguration, contactId);
-
-				enqeueCallbackTask(callbackTask);
 				return true;
 			}
 
@@ -528,14 +838,14 @@ namespace openmittsu {
 		bool ProtocolClient::needToWaitForGroupData(openmittsu::protocol::GroupId const& groupId, openmittsu::messages::MessageWithEncryptedPayload const*const messageWithEncryptedPayload, bool isGroupCreationMessage) {
 			if (needToWaitForMissingIdentity(groupId.getOwner(), messageWithEncryptedPayload)) {
 				return true;
-			} else if (groupsWithMissingIdentities.contains(groupId)) {
+			} else if (groupsWithMissingIdentities.contains(groupId) && !groupsWithMissingIdentities.constFind(groupId).value()->isRestoredMessage(messageWithEncryptedPayload)) {
 				if (messageWithEncryptedPayload == nullptr) {
 					LOGGER()->warn("Trying to enqueue new message for group {} on existing MissingIdentityProcessor, but the encryptedPayload pointer is null.", groupId.toString());
 					return true;
 				}
 
 				LOGGER_DEBUG("Enqueuing new message for group {} on existing MissingIdentityProcessor.", groupId.toString());
-				groupsWithMissingIdentities.constFind(groupId).value()->enqueueMessage(*messageWithEncryptedPayload);
+				enqueuePendingMessage(groupsWithMissingIdentities.constFind(groupId).value(), *messageWithEncryptedPayload);
 				return true;
 			}
 
@@ -584,16 +894,20 @@ namespace openmittsu {
 
 			QSet<openmittsu::protocol::ContactId> missingIds;
 			for (; it != end; ++it) {
-				if (missingIdentityProcessors.contains(*it)) {
+				if (missingIdentityProcessors.contains(*it) && !missingIdentityProcessors.constFind(*it).value()->isRestoredMessage(messageWithEncryptedPayload)) {
 					if (messageWithEncryptedPayload == nullptr) {
 						LOGGER()->warn("Trying to handle GroupCreationMessage for group {} on existing MissingIdentityProcessor, but the encryptedPayload pointer is null.", groupCreationMessageContent->getGroupId().toString());
 						return;
 					}
 
 					LOGGER_DEBUG("Enqueing group creation message into existing MissingIdentityProcessor for ID {}.", it->toString());
-					missingIdentityProcessors.constFind(*it).value()->enqueueMessage(*messageWithEncryptedPayload);
+					enqueuePendingMessage(missingIdentityProcessors.constFind(*it).value(), *messageWithEncryptedPayload);
 					return;
 				} else if (!m_cryptoBox->getKeyRegistry().hasIdentity(*it)) {
+					if (m_identityResolver.hasFailedRecently(*it, QDateTime::currentMSecsSinceEpoch())) {
+						LOGGER()->warn("Group member {} of group {} could not be retrieved recently, discarding GroupCreationMessage without looking it up again.", it->toString(), groupCreationMessageContent->getGroupId().toString());
+						return;
+					}
 					missingIds.insert(*it);
 				}
 			}
@@ -604,16 +918,14 @@ namespace openmittsu {
 				}
 
 				std::shared_ptr<MissingIdentityProcessor> missingIdentityProcessor = std::make_shared<MissingIdentityProcessor>(groupCreationMessageContent->getGroupId(), missingIds);
-				missingIdentityProcessor->enqueueMessage(*messageWithEncryptedPayload);
+				enqueuePendingMessage(missingIdentityProcessor, *messageWithEncryptedPayload);
 				groupsWithMissingIdentities.insert(groupCreationMessageContent->getGroupId(), missingIdentityProcessor);
 				auto itMissing = missingIds.constBegin();
 				auto const endMissing = missingIds.constEnd();
 				for (; itMissing != endMissing; ++itMissing) {
 					LOGGER()->info("Enqueing MissingIdentityProcessor for group member with ID {}.", itMissing->toString());
 					missingIdentityProcessors.insert(*itMissing, missingIdentityProcessor);
-
-					openmittsu::tasks::CallbackTask* callbackTask = new openmittsu::tasks::IdentityReceiverCallbackTask(m_serverConfiguration, *itMissing);
-					enqeueCallbackTask(callbackTask);
+					requestIdentityLookup(*itMissing);
 				}
 				return;
 			}
@@ -689,7 +1001,7 @@ namespace openmittsu {
 			packet[0] = (PROTO_PACKET_SIGNATURE_KEEPALIVE_ANSWER);
 
 			packet.append(packetData);
-			encryptAndSendDataPacketToServer(packet);
+			encryptAndSendDataPacketToServer(packet, OutgoingLane::CONTROL);
 		}
 
 		void ProtocolClient::handleIncomingKeepAliveAnswer(QByteArray const& packetData) {
@@ -730,7 +1042,15 @@ namespace openmittsu {
 			openmittsu::messages::MessageWithPayload messageWithPayload(contactMessage->getMessageHeader(), contactMessage->getContactMessageContent()->toPacketPayload());
 			openmittsu::messages::MessageWithEncryptedPayload messageWithEncryptedPayload(messageWithPayload.encrypt(m_cryptoBox));
 
-			encryptAndSendDataPacketToServer(messageWithEncryptedPayload.toPacket());
+			// Typing notifications and receipts are small and time critical, images go with the bulk traffic.
+			OutgoingLane lane = OutgoingLane::INTERACTIVE;
+			openmittsu::messages::contact::ContactMessageContent const* const content = contactMessage->getContactMessageContent();
+			if ((dynamic_cast<openmittsu::messages::contact::UserTypingMessageContent const*>(content) != nullptr) || (dynamic_cast<openmittsu::messages::contact::ReceiptMessageContent const*>(content) != nullptr)) {
+				lane = OutgoingLane::CONTROL;
+			} else if (dynamic_cast<openmittsu::messages::contact::ContactImageIdAndKeyMessageContent const*>(content) != nullptr) {
+				lane = OutgoingLane::BULK;
+			}
+			encryptAndSendDataPacketToServer(messageWithEncryptedPayload.toPacket(), lane);
 
 			if (!contactMessage->getMessageHeader().getFlags().isNoAckExpectedForMessage()) {
 				enqeueWaitForAcknowledgment(contactMessage->getMessageHeader().getReceiver(), contactMessage->getMessageHeader().getMessageId(), acknowledgmentProcessor);
@@ -745,27 +1065,61 @@ namespace openmittsu {
 				return;
 			}
 
-			QSet<openmittsu::protocol::ContactId>::const_iterator it = message->getRecipients().constBegin();
-			QSet<openmittsu::protocol::ContactId>::const_iterator end = message->getRecipients().constEnd();
-			for (; it != end; ++it) {
-				if (*it != m_ourContactId) {
-					openmittsu::messages::group::SpecializedGroupMessage groupMessageForSingleContact(*message, *it, message->getMessageHeader().getMessageId());
+			// Sorted, so that the copies always go out in the same order.
+			QList<openmittsu::protocol::ContactId> recipients = message->getRecipients().toList();
+			std::sort(recipients.begin(), recipients.end());
 
-					handleOutgoingMessage(&groupMessageForSingleContact, acknowledgmentProcessor);
+			std::vector<openmittsu::messages::FullMessageHeader> headers;
+			headers.reserve(static_cast<std::size_t>(recipients.size()));
+			for (openmittsu::protocol::ContactId const& recipient : recipients) {
+				if (recipient != m_ourContactId) {
+					LOGGER_DEBUG("Sending GroupMessage to Contact {} with ID {}.", recipient.toString(), message->getMessageHeader().getMessageId().toString());
+					headers.push_back(openmittsu::messages::FullMessageHeader(message->getMessageHeader(), recipient, message->getMessageHeader().getMessageId()));
 				}
 			}
+
+			if (headers.empty()) {
+				return;
+			}
+
+			// The payload is identical for all members, only the header and the encryption differ.
+			// Fan-outs complete in the order they were submitted, so messages to the same group keep their order.
+			// Contact messages sent meanwhile are not held back and may reach the server before these copies: sends are only ordered within a conversation, not across conversations.
+			m_groupMessageFanOut->submit(headers, message->getGroupMessageContent()->toPacketPayload(), acknowledgmentProcessor);
 		}
 
-		void ProtocolClient::handleOutgoingMessage(openmittsu::messages::group::SpecializedGroupMessage const*const message, std::shared_ptr<openmittsu::acknowledgments::AcknowledgmentProcessor> const& acknowledgmentProcessor) {
-			LOGGER_DEBUG("Sending GroupMessage to Contact {} with ID {}.", message->getMessageHeader().getReceiver().toString(), message->getMessageHeader().getMessageId().toString());
+		void ProtocolClient::groupMessageFanOutProgressed() {
+			if (m_groupMessageFanOut == nullptr) {
+				return;
+			}
+
+			std::list<std::shared_ptr<GroupMessageFanOut::FanOut>> const fanOuts = m_groupMessageFanOut->takeCompletedFanOuts();
+			for (std::shared_ptr<GroupMessageFanOut::FanOut> const& fanOut : fanOuts) {
+				std::vector<openmittsu::messages::FullMessageHeader const*> failedCopies;
+				for (std::size_t i = 0; i < fanOut->headers.size(); ++i) {
+					openmittsu::messages::FullMessageHeader const& header = fanOut->headers.at(i);
+					QByteArray const& packet = fanOut->packets.at(i);
+					if (packet.isEmpty()) {
+						// Encryption failed, the error has already been logged.
+						failedCopies.push_back(&header);
+						continue;
+					}
 
-			openmittsu::messages::MessageWithPayload messageWithPayload(message->getMessageHeader(), message->getGroupMessageContent()->toPacketPayload());
-			openmittsu::messages::MessageWithEncryptedPayload messageWithEncryptedPayload(messageWithPayload.encrypt(m_cryptoBox));
+					encryptAndSendDataPacketToServer(packet, OutgoingLane::BULK);
 
-			encryptAndSendDataPacketToServer(messageWithEncryptedPayload.toPacket());
+					if (!header.getFlags().isNoAckExpectedForMessage()) {
+						enqeueWaitForAcknowledgment(header.getReceiver(), header.getMessageId(), fanOut->acknowledgmentProcessor);
+					}
+				}
 
-			if (!message->getMessageHeader().getFlags().isNoAckExpectedForMessage()) {
-				enqeueWaitForAcknowledgment(message->getMessageHeader().getReceiver(), message->getMessageHeader().getMessageId(), acknowledgmentProcessor);
+				// All failed copies are counted before the first is reported, otherwise the processor could consider the group message done too early.
+				for (openmittsu::messages::FullMessageHeader const* header : failedCopies) {
+					fanOut->acknowledgmentProcessor->addMessage(header->getMessageId());
+				}
+				for (openmittsu::messages::FullMessageHeader const* header : failedCopies) {
+					LOGGER()->warn("Group message {} could not be sent to contact {}, reporting it as failed.", header->getMessageId().toString(), header->getReceiver().toString());
+					fanOut->acknowledgmentProcessor->sendFailed(this, header->getMessageId());
+				}
 			}
 		}
 
@@ -781,64 +1135,180 @@ namespace openmittsu {
 			m_pushFromIdPtr = std::make_unique<openmittsu::protocol::PushFromId>(newPushFromId);
 		}
 
-		void ProtocolClient::enqeueCallbackTask(openmittsu::tasks::CallbackTask* callbackTask) {
-			if (callbackTask == nullptr) {
-				LOGGER()->warn("Ignoring nullptr callback task.");
+		void ProtocolClient::enqueuePendingMessage(std::shared_ptr<MissingIdentityProcessor> const& missingIdentityProcessor, openmittsu::messages::MessageWithEncryptedPayload const& message) {
+			// Once a processor has spilled, all its later messages follow, so they are restored in the order they arrived.
+			if (missingIdentityProcessor->isRestoring() || (missingIdentityProcessor->getSpilledMessageCount() > 0) || (m_pendingMessagesBytes >= OPENMITTSU_PROTOCOLCLIENT_PENDING_MESSAGES_MEMORY_BUDGET_BYTES)) {
+				LOGGER_DEBUG("Messages waiting for missing identities exceed their memory budget, moving message #{} to the storage.", message.getMessageHeader().getMessageId().toString());
+				m_messageCenterWrapper->storePendingMessage(missingIdentityProcessor->getPendingMessagesKey(), message.toPacket());
+				missingIdentityProcessor->countSpilledMessage();
+				m_metrics.incrementCounter(QStringLiteral("protocol.pending.spilled"));
 				return;
 			}
 
-			OPENMITTSU_CONNECT_QUEUED(callbackTask, finished(openmittsu::tasks::CallbackTask*), this, callbackTaskFinished(openmittsu::tasks::CallbackTask*));
+			qint64 const bytesBefore = missingIdentityProcessor->getQueuedMessagesBytes();
+			missingIdentityProcessor->enqueueMessage(message);
+			m_pendingMessagesBytes += missingIdentityProcessor->getQueuedMessagesBytes() - bytesBefore;
+		}
+
+		bool ProtocolClient::requestIdentityLookup(openmittsu::protocol::ContactId const& contactId) {
+			if (!m_identityResolver.request(contactId, QDateTime::currentMSecsSinceEpoch())) {
+				m_metrics.incrementCounter(QStringLiteral("protocol.identities.negativeCacheHits"));
+				return false;
+			}
 
-			if (!QMetaObject::invokeMethod(callbackTask, "start", Qt::QueuedConnection)) {
-				throw openmittsu::exceptions::InternalErrorException() << "Could not invoke method start in " << __FILE__ << "  at line " << __LINE__ << ".";
+			if ((m_identityLookupTimer != nullptr) && !m_identityLookupTimer->isActive()) {
+				m_identityLookupTimer->start();
 			}
+			return true;
 		}
 
-		void ProtocolClient::callbackTaskFinished(openmittsu::tasks::CallbackTask* callbackTask) {
-			if (dynamic_cast<openmittsu::tasks::IdentityReceiverCallbackTask*>(callbackTask) != nullptr) {
-				openmittsu::utility::UniquePtrWithDelayedThreadDeletion<openmittsu::tasks::IdentityReceiverCallbackTask> irct(dynamic_cast<openmittsu::tasks::IdentityReceiverCallbackTask*>(callbackTask));
-				if (!missingIdentityProcessors.contains(irct->getContactIdOfFetchedPublicKey())) {
-					LOGGER()->warn("IdentityReceiver CallbackTask finished for ID {}, but no MissingIdentityProcessor is registered for this ID.", irct->getContactIdOfFetchedPublicKey().toString());
-				} else {
-					std::shared_ptr<MissingIdentityProcessor> missingIdentityProcessor = missingIdentityProcessors.value(irct->getContactIdOfFetchedPublicKey());
-					missingIdentityProcessors.remove(irct->getContactIdOfFetchedPublicKey());
-					LOGGER_DEBUG("IdentityReceiverCallbackTask finished for ID {}, removing related MissingIdentityProcessor.", irct->getContactIdOfFetchedPublicKey().toString());
+		void ProtocolClient::scheduleIdentityLookupRetry(bool hasFailedToReachServer) {
+			if (!hasFailedToReachServer) {
+				m_identityLookupRetryDelayMs = 0;
+			} else if (m_identityLookupRetryDelayMs == 0) {
+				m_identityLookupRetryDelayMs = OPENMITTSU_PROTOCOLCLIENT_IDENTITY_LOOKUP_RETRY_MIN_DELAY_MS;
+			} else {
+				m_identityLookupRetryDelayMs = std::min(2 * m_identityLookupRetryDelayMs, OPENMITTSU_PROTOCOLCLIENT_IDENTITY_LOOKUP_RETRY_MAX_DELAY_MS);
+			}
 
-					if (!irct->hasFinishedSuccessfully()) {
-						LOGGER()->warn("Received a message from user {} that we can not decrypt since the Identity could not be retrieved. Error: {}", irct->getContactIdOfFetchedPublicKey().toString(), irct->getErrorMessage().toStdString());
-						missingIdentityProcessor->identityFetcherTaskFinished(irct->getContactIdOfFetchedPublicKey(), false);
-					} else {
-						missingIdentityProcessor->identityFetcherTaskFinished(irct->getContactIdOfFetchedPublicKey(), true);
-						if (m_cryptoBox->getKeyRegistry().hasIdentity(irct->getContactIdOfFetchedPublicKey())) {
-							LOGGER()->warn("Identity {} is already known to KeyRegistry, ignoring result of IdentityReceiverCallbackTask.", irct->getContactIdOfFetchedPublicKey().toString());
-						} else {
-							// TODO FIXME: Add new identity to database!
-							//m_cryptoBox->getKeyRegistry().addIdentity(irct->getContactIdOfFetchedPublicKey(), irct->getFetchedPublicKey());
+			if (m_identityLookupTimer == nullptr) {
+				return;
+			}
 
-							LOGGER_DEBUG("PublicKey for Identity {} is {}.", irct->getContactIdOfFetchedPublicKey().toString(), irct->getFetchedPublicKey().toString());
-							m_messageCenterWrapper->addNewContact(irct->getContactIdOfFetchedPublicKey(), irct->getFetchedPublicKey());
-						}
-					}
+			// New lookups wait for the back-off as well, they would not get through either.
+			m_identityLookupTimer->setInterval(std::max(m_identityLookupRetryDelayMs, OPENMITTSU_PROTOCOLCLIENT_IDENTITY_LOOKUP_DELAY_MS));
+			if (hasFailedToReachServer) {
+				LOGGER()->warn("Could not reach the server for identity lookups, trying again in {} ms.", m_identityLookupRetryDelayMs);
+				m_identityLookupTimer->start();
+			}
+		}
 
-					if (missingIdentityProcessor->hasFinished()) {
-						if (missingIdentityProcessor->hasAssociatedGroupId()) {
-							groupsWithMissingIdentities.remove(missingIdentityProcessor->getAssociatedGroupId());
+		void ProtocolClient::identityLookupTimerOnTimer() {
+			startIdentityLookups();
+		}
+
+		void ProtocolClient::startIdentityLookups() {
+			while (m_identityResolver.hasPendingRequests()) {
+				QSet<openmittsu::protocol::ContactId> const batch = m_identityResolver.takeBatch();
+				LOGGER_DEBUG("Looking up a batch of {} identities.", batch.size());
+				m_metrics.recordValue(QStringLiteral("protocol.identities.lookupBatchSize"), batch.size());
+				enqeueCallbackTask(new openmittsu::tasks::IdentityBulkReceiverCallbackTask(m_serverConfiguration, batch));
+			}
+		}
+
+		void ProtocolClient::identityLookupFinished(openmittsu::protocol::ContactId const& contactId, bool isSuccess, openmittsu::crypto::PublicKey const& publicKey) {
+			if (!missingIdentityProcessors.contains(contactId)) {
+				LOGGER()->warn("Identity lookup finished for ID {}, but no MissingIdentityProcessor is registered for this ID.", contactId.toString());
+				return;
+			}
+
+			std::shared_ptr<MissingIdentityProcessor> missingIdentityProcessor = missingIdentityProcessors.value(contactId);
+			if (missingIdentityProcessor->isRestoring()) {
+				LOGGER()->warn("Identity lookup finished for ID {}, but its MissingIdentityProcessor is already restoring its messages.", contactId.toString());
+				return;
+			}
+			missingIdentityProcessors.remove(contactId);
+			LOGGER_DEBUG("Identity lookup finished for ID {}, removing related MissingIdentityProcessor.", contactId.toString());
+
+			if (!isSuccess) {
+				LOGGER()->warn("Received a message from user {} that we can not decrypt since the Identity could not be retrieved.", contactId.toString());
+				missingIdentityProcessor->identityFetcherTaskFinished(contactId, false);
+			} else {
+				missingIdentityProcessor->identityFetcherTaskFinished(contactId, true);
+				if (m_cryptoBox->getKeyRegistry().hasIdentity(contactId)) {
+					LOGGER()->warn("Identity {} is already known to KeyRegistry, ignoring result of the identity lookup.", contactId.toString());
+				} else {
+					LOGGER_DEBUG("PublicKey for Identity {} is {}.", contactId.toString(), publicKey.toString());
+					m_messageCenterWrapper->addNewContact(contactId, publicKey);
+				}
+			}
+
+			if (missingIdentityProcessor->hasFinished()) {
+				if (missingIdentityProcessor->hasAssociatedGroupId()) {
+					groupsWithMissingIdentities.remove(missingIdentityProcessor->getAssociatedGroupId());
+				}
+				m_pendingMessagesBytes -= missingIdentityProcessor->getQueuedMessagesBytes();
+				if (missingIdentityProcessor->hasFinishedSuccessfully()) {
+					LOGGER()->info("MissingIdentityProcessor finished successfully, now processing {} queued messages.", missingIdentityProcessor->getQueuedMessages().size());
+					std::list<openmittsu::messages::MessageWithEncryptedPayload> queuedMessages(missingIdentityProcessor->getQueuedMessages());
+
+					// Until the spilled messages are back from the storage, the processor stays in place so newer messages are queued behind them.
+					if (missingIdentityProcessor->getSpilledMessageCount() > 0) {
+						LOGGER()->info("Restoring {} further queued messages from the storage.", missingIdentityProcessor->getSpilledMessageCount());
+						missingIdentityProcessor->startRestoring();
+						for (openmittsu::messages::MessageWithEncryptedPayload const& queuedMessage : queuedMessages) {
+							missingIdentityProcessor->addRestoredMessage(queuedMessage);
 						}
-						if (missingIdentityProcessor->hasFinishedSuccessfully()) {
-							LOGGER()->info("MissingIdentityProcessor finished successfully, now processing {} queued messages.", missingIdentityProcessor->getQueuedMessages().size());
-							std::list<openmittsu::messages::MessageWithEncryptedPayload> queuedMessages(missingIdentityProcessor->getQueuedMessages());
-							auto it = queuedMessages.cbegin();
-							auto const end = queuedMessages.cend();
-							for (; it != end; ++it) {
-								handleIncomingMessage(*it);
-							}
+						if (missingIdentityProcessor->hasAssociatedGroupId()) {
+							groupsWithMissingIdentities.insert(missingIdentityProcessor->getAssociatedGroupId(), missingIdentityProcessor);
 						} else {
-							LOGGER()->warn("MissingIdentityProcessor failed, will now discard {} messages.", missingIdentityProcessor->getQueuedMessages().size());
+							missingIdentityProcessors.insert(contactId, missingIdentityProcessor);
 						}
+						m_restoringMissingIdentityProcessors.insert(missingIdentityProcessor->getPendingMessagesKey(), missingIdentityProcessor);
+						m_messageCenterWrapper->restorePendingMessages(missingIdentityProcessor->getPendingMessagesKey());
+					}
+
+					auto it = queuedMessages.cbegin();
+					auto const end = queuedMessages.cend();
+					for (; it != end; ++it) {
+						handleIncomingMessage(*it);
+					}
+				} else {
+					LOGGER()->warn("MissingIdentityProcessor failed, will now discard {} messages.", missingIdentityProcessor->getQueuedMessages().size() + missingIdentityProcessor->getSpilledMessageCount());
+					if (missingIdentityProcessor->getSpilledMessageCount() > 0) {
+						m_messageCenterWrapper->discardPendingMessages(missingIdentityProcessor->getPendingMessagesKey());
+					}
+				}
+			}
+		}
+
+		void ProtocolClient::enqeueCallbackTask(openmittsu::tasks::CallbackTask* callbackTask) {
+			if (callbackTask == nullptr) {
+				LOGGER()->warn("Ignoring nullptr callback task.");
+				return;
+			}
+
+			OPENMITTSU_CONNECT_QUEUED(callbackTask, finished(openmittsu::tasks::CallbackTask*), this, callbackTaskFinished(openmittsu::tasks::CallbackTask*));
+
+			// Incoming messages are held back until the identity of their sender is known, so fetch those first.
+			openmittsu::tasks::TaskExecutor::TaskPriority const priority = (dynamic_cast<openmittsu::tasks::IdentityBulkReceiverCallbackTask*>(callbackTask) != nullptr) ? openmittsu::tasks::TaskExecutor::TaskPriority::HIGH : openmittsu::tasks::TaskExecutor::TaskPriority::NORMAL;
+			openmittsu::tasks::TaskExecutor::globalInstance()->submit(callbackTask, priority);
+		}
+
+		void ProtocolClient::callbackTaskFinished(openmittsu::tasks::CallbackTask* callbackTask) {
+			if (dynamic_cast<openmittsu::tasks::IdentityBulkReceiverCallbackTask*>(callbackTask) != nullptr) {
+				std::unique_ptr<openmittsu::tasks::IdentityBulkReceiverCallbackTask> ibrct(dynamic_cast<openmittsu::tasks::IdentityBulkReceiverCallbackTask*>(callbackTask));
+				if (!ibrct->hasFinishedSuccessfully()) {
+					LOGGER()->warn("Could not retrieve {} identities. Error: {}", ibrct->getContactIds().size(), ibrct->getErrorMessage().toStdString());
+				}
+
+				qint64 const now = QDateTime::currentMSecsSinceEpoch();
+				QHash<openmittsu::protocol::ContactId, openmittsu::crypto::PublicKey> const& fetchedPublicKeys = ibrct->getFetchedPublicKeys();
+				QSet<openmittsu::protocol::ContactId> const& unknownIdentities = ibrct->getUnknownIdentities();
+				int retriedCount = 0;
+				auto it = ibrct->getContactIds().constBegin();
+				auto const end = ibrct->getContactIds().constEnd();
+				for (; it != end; ++it) {
+					auto const itFetched = fetchedPublicKeys.constFind(*it);
+					if (itFetched != fetchedPublicKeys.constEnd()) {
+						m_identityResolver.resolved(*it);
+						m_metrics.incrementCounter(QStringLiteral("protocol.identities.resolved"));
+						identityLookupFinished(*it, true, itFetched.value());
+					} else if (unknownIdentities.contains(*it)) {
+						m_identityResolver.failed(*it, now);
+						m_metrics.incrementCounter(QStringLiteral("protocol.identities.failed"));
+						identityLookupFinished(*it, false, openmittsu::crypto::PublicKey());
+					} else {
+						// The server could not be asked, the messages keep waiting without an acknowledgment.
+						m_identityResolver.retry(*it);
+						m_metrics.incrementCounter(QStringLiteral("protocol.identities.retried"));
+						++retriedCount;
 					}
 				}
+
+				scheduleIdentityLookupRetry(retriedCount > 0);
 			} else if (dynamic_cast<openmittsu::tasks::MessageCallbackTask*>(callbackTask) != nullptr) {
-				openmittsu::utility::UniquePtrWithDelayedThreadDeletion<openmittsu::tasks::MessageCallbackTask> messageCallbackTask(dynamic_cast<openmittsu::tasks::MessageCallbackTask*>(callbackTask));
+				std::unique_ptr<openmittsu::tasks::MessageCallbackTask> messageCallbackTask(dynamic_cast<openmittsu::tasks::MessageCallbackTask*>(callbackTask));
 				if (messageCallbackTask->getInitialMessage()->getMessageHeader().getSender() == m_ourContactId) {
 					// Sending
 					if (!messageCallbackTask->hasFinishedSuccessfully()) {
@@ -876,28 +1346,82 @@ namespace openmittsu {
 		void ProtocolClient::sendClientAcknowlegmentForMessage(openmittsu::messages::MessageWithEncryptedPayload const& message) {
 			LOGGER()->error("sendClientAcknowlegmentForMessage() should not be called anymore?!");
 			LOGGER_DEBUG("Sending client acknowledgment to server for message #{}.", message.getMessageHeader().getMessageId().toString());
-			encryptAndSendDataPacketToServer(openmittsu::protocol::ClientAcknowledgement(message.getMessageHeader().getSender(), message.getMessageHeader().getMessageId()).toPacket());
+			encryptAndSendDataPacketToServer(openmittsu::protocol::ClientAcknowledgement(message.getMessageHeader().getSender(), message.getMessageHeader().getMessageId()).toPacket(), OutgoingLane::CONTROL);
 		}
 
 		void ProtocolClient::sendMessageReceivedAcknowledgement(openmittsu::protocol::ContactId const& messageSender, openmittsu::protocol::MessageId const& messageId) {
 			LOGGER_DEBUG("Sending client acknowledgment to server for message #{} from contact {}.", messageId.toString(), messageSender.toString());
-			encryptAndSendDataPacketToServer(openmittsu::protocol::ClientAcknowledgement(messageSender, messageId).toPacket());
+			if (!m_clientAcknowledgementBatcher.add(messageSender, messageId)) {
+				LOGGER_DEBUG("Client acknowledgment for message #{} is already batched.", messageId.toString());
+				return;
+			}
+
+			if (m_clientAcknowledgementBatcher.size() >= OPENMITTSU_PROTOCOLCLIENT_CLIENT_ACKNOWLEDGEMENT_MAX_BATCH_SIZE) {
+				flushClientAcknowledgements();
+			} else if ((m_clientAcknowledgementFlushTimer != nullptr) && !m_clientAcknowledgementFlushTimer->isActive()) {
+				m_clientAcknowledgementFlushTimer->start();
+			}
+		}
+
+		void ProtocolClient::clientAcknowledgementFlushTimerOnTimer() {
+			flushClientAcknowledgements();
+		}
+
+		void ProtocolClient::flushClientAcknowledgements() {
+			if (m_clientAcknowledgementFlushTimer != nullptr) {
+				m_clientAcknowledgementFlushTimer->stop();
+			}
+			if (m_clientAcknowledgementBatcher.isEmpty()) {
+				return;
+			}
+
+			QList<QByteArray> const packets = m_clientAcknowledgementBatcher.takePackets();
+			LOGGER_DEBUG("Queueing a batch of {} client acknowledgments.", packets.size());
+			m_metrics.recordValue(QStringLiteral("protocol.acks.client.batchSize"), packets.size());
+			encryptAndSendDataPacketsToServer(packets, OutgoingLane::CONTROL);
 		}
 
-		void ProtocolClient::encryptAndSendDataPacketToServer(QByteArray const& dataPacket) {
-			QByteArray const encryptedDataPacket = m_cryptoBox->encryptForServer(dataPacket);
-			LOGGER_DEBUG("Writing Message with {} Bytes to outbound queue.", encryptedDataPacket.size());
+		void ProtocolClient::encryptAndSendDataPacketToServer(QByteArray const& dataPacket, OutgoingLane lane) {
+			LOGGER_DEBUG("Writing Message with {} Bytes to outbound queue lane {}.", dataPacket.size(), static_cast<int>(lane));
+			encryptAndSendDataPacketsToServer(QList<QByteArray>({ dataPacket }), lane);
+		}
+
+		void ProtocolClient::encryptAndSendDataPacketsToServer(QList<QByteArray> const& dataPackets, OutgoingLane lane) {
+			for (QByteArray const& dataPacket : dataPackets) {
+				if (!dataPacket.isEmpty()) {
+					m_metrics.incrementCounter(getPacketTypeMetricName(QStringLiteral("protocol.packets.sent"), dataPacket.at(0)));
+				}
+			}
 
 			QMutexLocker lock(&outgoingMessagesMutex);
-			outgoingMessages.append(encryptedDataPacket);
-			outgoingMessagesTimer->start(0);
+			for (QByteArray const& dataPacket : dataPackets) {
+				outgoingMessages[static_cast<std::size_t>(lane)].append(dataPacket);
+				outgoingMessagesBytes += getOutgoingFrameSize(dataPacket);
+			}
+			m_metrics.setGauge(QStringLiteral("protocol.queue.outgoing"), getQueuedOutgoingMessagesCount());
+			if (!m_isOutgoingQueueFull && (getPendingOutgoingBytes() > OPENMITTSU_PROTOCOLCLIENT_OUTGOING_HIGH_WATER_MARK_BYTES)) {
+				LOGGER()->info("Outgoing queue holds more than {} Bytes, asking senders to pause.", OPENMITTSU_PROTOCOLCLIENT_OUTGOING_HIGH_WATER_MARK_BYTES);
+				m_isOutgoingQueueFull = true;
+				m_metrics.incrementCounter(QStringLiteral("protocol.queue.outgoing.full"));
+				emit outgoingQueueFull();
+			}
+			if (!outgoingMessagesTimer->isActive()) {
+				outgoingMessagesTimer->start();
+			}
 		}
 
 		void ProtocolClient::enqeueWaitForAcknowledgment(openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, std::shared_ptr<openmittsu::acknowledgments::AcknowledgmentProcessor> const& acknowledgmentProcessor) {
 			QMutexLocker lock(&acknowledgmentWaitingMutex);
 	
 			acknowledgmentProcessor->addMessage(messageId);
-			acknowledgmentWaitingMessages.insert(messageId, acknowledgmentProcessor);
+
+			qint64 const deadline = acknowledgmentProcessor->getTimeoutTime().toMSecsSinceEpoch();
+			bool const isNewEarliestDeadline = acknowledgmentWaitingMessages.isEmpty() || (deadline < acknowledgmentWaitingMessages.getNextDeadline());
+			acknowledgmentWaitingMessages.insert(messageId, AcknowledgmentWait{ acknowledgmentProcessor, m_metricsClock.elapsed() }, deadline);
+			m_metrics.setGauge(QStringLiteral("protocol.queue.awaitingAck"), acknowledgmentWaitingMessages.size());
+			if (isNewEarliestDeadline) {
+				rearmAcknowledgmentWaitingTimer();
+			}
 		}
 
 		void ProtocolClient::socketOnError(QAbstractSocket::SocketError socketError) {
@@ -940,35 +1464,87 @@ namespace openmittsu {
 			emit readyConnect();
 		}
 
-		bool ProtocolClient::waitForData(qint64 minBytesRequired) {
-			m_socket->waitForReadyRead(5000);
+		void ProtocolClient::enterHandshakeState(HandshakeState const& newState) {
+			m_handshakeState = newState;
+			m_handshakePhaseTimer.start();
 
-			if (m_socket->bytesAvailable() < minBytesRequired) {
-				return false;
-			} else {
-				return true;
+			switch (newState) {
+			case HandshakeState::CONNECTING:
+				m_handshakeTimeoutTimer->start(OPENMITTSU_PROTOCOLCLIENT_CONNECT_TIMEOUT_MS);
+				break;
+			case HandshakeState::WAITING_FOR_SERVER_HELLO:
+			case HandshakeState::WAITING_FOR_AUTHENTICATION_ACK:
+				m_handshakeTimeoutTimer->start(OPENMITTSU_PROTOCOLCLIENT_HANDSHAKE_PHASE_TIMEOUT_MS);
+				break;
+			case HandshakeState::NONE:
+			default:
+				m_handshakeTimeoutTimer->stop();
+				break;
+			}
+		}
+
+		void ProtocolClient::handshakeFailed(int errCode, QString const& message) {
+			LOGGER()->critical("Handshake failed: {}", message.toStdString());
+			enterHandshakeState(HandshakeState::NONE);
+			++failedReconnectAttempts;
+			emit connectToFinished(errCode, message);
+		}
+
+		void ProtocolClient::handshakeTimeoutTimerOnTimer() {
+			switch (m_handshakeState) {
+			case HandshakeState::CONNECTING:
+				LOGGER()->critical("Could not connect to the server within {} ms.", OPENMITTSU_PROTOCOLCLIENT_CONNECT_TIMEOUT_MS);
+				m_socket->abort();
+				handshakeFailed(-19, "Could not connect to the server in time (incorrect IP or port?).");
+				break;
+			case HandshakeState::WAITING_FOR_SERVER_HELLO:
+				LOGGER()->critical("Got no reply from server, there are {} of {} bytes available.", m_socket->bytesAvailable(), PROTO_SERVERHELLO_LENGTH_BYTES);
+				handshakeFailed(-7, "Server did not reply after Client Hello (incorrect IP or port?).");
+				break;
+			case HandshakeState::WAITING_FOR_AUTHENTICATION_ACK:
+				LOGGER()->critical("Got no reply from server for AuthAck, we have {} of {} bytes available.", m_socket->bytesAvailable(), PROTO_AUTHENTICATION_REPLY_LENGTH_BYTES);
+				handshakeFailed(-17, "Server did not reply after sending client authentication (invalid identity?).");
+				break;
+			case HandshakeState::NONE:
+			default:
+				break;
 			}
 		}
 
+		void ProtocolClient::applySocketOptions() {
+			bool const tcpNoDelay = m_optionMaster->getOptionAsBool(openmittsu::utility::OptionMaster::Options::BOOLEAN_NETWORK_TCP_NODELAY);
+			m_socket->setSocketOption(QAbstractSocket::LowDelayOption, (tcpNoDelay) ? 1 : 0);
+
+			int const sendBufferSize = m_optionMaster->getOptionAsInt(openmittsu::utility::OptionMaster::Options::INTEGER_NETWORK_SOCKET_SEND_BUFFER_SIZE);
+			if (sendBufferSize > 0) {
+				m_socket->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, sendBufferSize);
+			}
+
+			int const receiveBufferSize = m_optionMaster->getOptionAsInt(openmittsu::utility::OptionMaster::Options::INTEGER_NETWORK_SOCKET_RECEIVE_BUFFER_SIZE);
+			if (receiveBufferSize > 0) {
+				m_socket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, receiveBufferSize);
+			}
+			LOGGER_DEBUG("Applied socket options: TCP_NODELAY = {}, send buffer = {} Bytes, receive buffer = {} Bytes.", tcpNoDelay, sendBufferSize, receiveBufferSize);
+		}
+
 		void ProtocolClient::socketConnected() {
 			LOGGER_DEBUG("Socket is now connected.");
 			if (m_isConnected) {
 				socketDisconnected(false);
 				LOGGER()->warn("Connection is already established, but the socket reconnected?!");
 			}
+			m_handshakeConnectLatency = m_handshakePhaseTimer.elapsed();
+
+			applySocketOptions();
 
 			if (m_socket->write(m_cryptoBox->getClientShortTermKeyPair().getPublicKey()) != openmittsu::crypto::Key::getPublicKeyLength()) {
-				LOGGER()->critical("Could not write the short term public key to server.");
-				++failedReconnectAttempts;
-				emit connectToFinished(-5, "Could not write the short term public key to server.");
+				handshakeFailed(-5, "Could not write the short term public key to server.");
 				return;
 			}
 	
 			QByteArray const clientNoncePrefix(m_cryptoBox->getClientNonceGenerator().getNoncePrefix());
 			if (m_socket->write(clientNoncePrefix) != clientNoncePrefix.size()) {
-				LOGGER()->critical("Could not write the client nonce prefix to server.");
-				++failedReconnectAttempts;
-				emit connectToFinished(-6, "Could not write the client nonce prefix to server.");
+				handshakeFailed(-6, "Could not write the client nonce prefix to server.");
 				return;
 			}
 			LOGGER_DEBUG("Client Nonce Prefix: {}", QString(clientNoncePrefix.toHex()).toStdString());
@@ -976,21 +1552,35 @@ namespace openmittsu {
 			m_socket->flush();
 			LOGGER_DEBUG("Wrote Client Hello.");
 
-			// Wait for server answer
-			if (!waitForData(PROTO_SERVERHELLO_LENGTH_BYTES)) {
-				LOGGER()->critical("Got no reply from server, there are {} of {} bytes available.", m_socket->bytesAvailable(), PROTO_SERVERHELLO_LENGTH_BYTES);
-				++failedReconnectAttempts;
-				emit connectToFinished(-7, "Server did not reply after Client Hello (incorrect IP or port?).");
-				return;
+			// The server answer is handled in socketOnReadyRead()
+			enterHandshakeState(HandshakeState::WAITING_FOR_SERVER_HELLO);
+			if (m_socket->bytesAvailable() > 0) {
+				socketOnReadyRead();
 			}
+		}
+
+		bool ProtocolClient::processHandshakeData() {
+			if ((m_handshakeState == HandshakeState::WAITING_FOR_SERVER_HELLO) && (m_socket->bytesAvailable() >= (PROTO_SERVERHELLO_LENGTH_BYTES))) {
+				if (!handleServerHello()) {
+					return false;
+				}
+			}
+
+			if ((m_handshakeState == HandshakeState::WAITING_FOR_AUTHENTICATION_ACK) && (m_socket->bytesAvailable() >= (PROTO_AUTHENTICATION_REPLY_LENGTH_BYTES))) {
+				return handleAuthenticationAcknowledgment();
+			}
+
+			return false;
+		}
+
+		bool ProtocolClient::handleServerHello() {
+			m_handshakeServerHelloLatency = m_handshakePhaseTimer.elapsed();
 
 			LOGGER_DEBUG("Read {} bytes from server.", m_socket->bytesAvailable());
 			QByteArray const serverHello = m_socket->read(PROTO_SERVERHELLO_LENGTH_BYTES);
 			if (serverHello.size() != (PROTO_SERVERHELLO_LENGTH_BYTES)) {
-				LOGGER()->critical("Could not read enough data from server, even though it should be available.");
-				++failedReconnectAttempts;
-				emit connectToFinished(-8, "Could not read enough data from server, even though it should be available.");
-				return;
+				handshakeFailed(-8, "Could not read enough data from server, even though it should be available.");
+				return false;
 			}
 			LOGGER_DEBUG("Data (server HELLO): {}", QString(serverHello.toHex()).toStdString());
 
@@ -1004,9 +1594,8 @@ namespace openmittsu {
 
 			if (m_cryptoBox->getClientNonceGenerator().getNoncePrefix() != clientNoncePrefixCopy) {
 				LOGGER()->critical("The Server returned a different client nonce prefix: {} vs. {}", QString(m_cryptoBox->getClientNonceGenerator().getNoncePrefix().toHex()).toStdString(), QString(clientNoncePrefixCopy.toHex()).toStdString());
-				++failedReconnectAttempts;
-				emit connectToFinished(-10, "The Server returned a different client nonce prefix");
-				return;
+				handshakeFailed(-10, "The Server returned a different client nonce prefix");
+				return false;
 			}
 
 			// Send Authentication Package
@@ -1017,53 +1606,53 @@ namespace openmittsu {
 
 			// Write authentication package to server
 			if (m_socket->write(authenticationPackageEncrypted) != (crypto_box_MACBYTES + PROTO_AUTHENTICATION_UNENCRYPTED_LENGTH_BYTES)) {
-				LOGGER()->critical("Could not write the authentication package to server.");
-				++failedReconnectAttempts;
-				emit connectToFinished(-16, "Could not write the authentication package to server.");
-				return;
+				handshakeFailed(-16, "Could not write the authentication package to server.");
+				return false;
 			}
 			m_socket->flush();
 
-			if (!waitForData(PROTO_AUTHENTICATION_REPLY_LENGTH_BYTES)) {
-				LOGGER()->critical("Got no reply from server for AuthAck, we have {} of {} bytes available.", m_socket->bytesAvailable(), PROTO_AUTHENTICATION_REPLY_LENGTH_BYTES);
-				++failedReconnectAttempts;
-				emit connectToFinished(-17, "Server did not reply after sending client authentication (invalid identity?).");
-				return;
-			}
+			enterHandshakeState(HandshakeState::WAITING_FOR_AUTHENTICATION_ACK);
+			return true;
+		}
+
+		bool ProtocolClient::handleAuthenticationAcknowledgment() {
+			m_handshakeAuthenticationLatency = m_handshakePhaseTimer.elapsed();
 			LOGGER_DEBUG("The AuthAck package is {} bytes long (expecting {} bytes).", m_socket->bytesAvailable(), PROTO_AUTHENTICATION_REPLY_LENGTH_BYTES);
 
 			// Decrypt Authentication acknowledgment
 			QByteArray authenticationAcknowledgment = m_socket->read(PROTO_AUTHENTICATION_REPLY_LENGTH_BYTES);
 			if (authenticationAcknowledgment.size() != (PROTO_AUTHENTICATION_REPLY_LENGTH_BYTES)) {
-				LOGGER()->critical("Could not read authentication acknowledgment data from Server, even though it should be available.");
-				++failedReconnectAttempts;
-				emit connectToFinished(-18, "Could not read authentication acknowledgment data from Server, even though it should be available.");
-				return;
+				handshakeFailed(-18, "Could not read authentication acknowledgment data from Server, even though it should be available.");
+				return false;
 			}
 			LOGGER_DEBUG("Data (server authAck): {}", QString(authenticationAcknowledgment.toHex()).toStdString());
 
 			QByteArray authenticationAcknowledgmentDecrypted = m_cryptoBox->decryptFromServer(authenticationAcknowledgment);
 
-			LOGGER_DEBUG("Handshake finished!");
+			enterHandshakeState(HandshakeState::NONE);
+			LOGGER()->info("Handshake finished! Connecting took {} ms, server hello {} ms and authentication {} ms.", m_handshakeConnectLatency, m_handshakeServerHelloLatency, m_handshakeAuthenticationLatency);
 			failedReconnectAttempts = 0;
 			connectionStart = QDateTime::currentDateTime();
 			m_isConnected = true;
 			m_isAllowedToSend = false;
-			m_readyReadRemainingData.clear();
-
-			// Test if the server already sent a first data package
-			if (m_socket->bytesAvailable() > 0) {
-				LOGGER_DEBUG("Socket has {} Bytes available after handshake.", m_socket->bytesAvailable());
-				QTimer::singleShot(0, this, SLOT(socketOnReadyRead()));
-			}
+			m_frameDecoder.clear();
 
 			emit connectToFinished(0, "Success");
+			return true;
 		}
 
 		QDateTime const& ProtocolClient::getConnectedSince() const {
 			return connectionStart;
 		}
 
+		openmittsu::utility::MetricsRegistry const& ProtocolClient::getMetrics() const {
+			return m_metrics;
+		}
+
+		QString ProtocolClient::getPacketTypeMetricName(QString const& prefix, char packetTypeByte) {
+			return QStringLiteral("%1{type=0x%2}").arg(prefix).arg(static_cast<quint8>(packetTypeByte), 2, 16, QChar('0'));
+		}
+
 		quint64 ProtocolClient::getReceivedMessagesCount() const {
 			return messagesReceived;
 		}
@@ -1080,6 +1669,42 @@ namespace openmittsu {
 			return bytesSend;
 		}
 
+		quint64 ProtocolClient::getSendDrainCount() const {
+			return outgoingDrainsPerformed;
+		}
+
+		quint64 ProtocolClient::getLastDrainSendMessagesCount() const {
+			return lastDrainMessagesSend;
+		}
+
+		quint64 ProtocolClient::getLastDrainSendBytesCount() const {
+			return lastDrainBytesSend;
+		}
+
+		quint64 ProtocolClient::getReadWakeupCount() const {
+			return readWakeups;
+		}
+
+		quint64 ProtocolClient::getLastFramesPerWakeup() const {
+			return lastFramesPerWakeup;
+		}
+
+		quint64 ProtocolClient::getMaxFramesPerWakeup() const {
+			return maxFramesPerWakeup;
+		}
+
+		qint64 ProtocolClient::getHandshakeConnectLatency() const {
+			return m_handshakeConnectLatency;
+		}
+
+		qint64 ProtocolClient::getHandshakeServerHelloLatency() const {
+			return m_handshakeServerHelloLatency;
+		}
+
+		qint64 ProtocolClient::getHandshakeAuthenticationLatency() const {
+			return m_handshakeAuthenticationLatency;
+		}
+
 	}
 
 }
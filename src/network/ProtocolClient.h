@@ -11,14 +11,24 @@
 #include <QTcpSocket>
 #include <QtNetwork>
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <cstdint>
 #include <utility>
+#include <array>
 #include <memory>
 
 #include "src/crypto/KeyPair.h"
 #include "src/crypto/PublicKey.h"
+#include "src/network/ClientAcknowledgementBatcher.h"
+#include "src/network/FrameDecoder.h"
+#include "src/network/GroupMessageFanOut.h"
+#include "src/network/IdentityResolver.h"
+#include "src/network/IncomingMessageDecryptor.h"
 #include "src/network/ServerConfiguration.h"
 #include "src/network/MessageCenterWrapper.h"
+#include "src/network/PacketCaptureWriter.h"
+#include "src/utility/DeadlineQueue.h"
+#include "src/utility/MetricsRegistry.h"
 #include "src/utility/OptionMaster.h"
 #include "src/network/MissingIdentityProcessor.h"
 
@@ -74,11 +84,46 @@ namespace openmittsu {
 
 			void newPushFromId(openmittsu::protocol::PushFromId const& newPushFromId);
 
+			/**
+			 * Emits outgoingQueueDrained() once the outgoing queue is below its low water mark.
+			 * Since slots are invoked in order, this covers all messages handed to this client before the request.
+			 */
+			void requestOutgoingQueueDrainedNotification();
+
+			/**
+			 * Debugging aid: records all decrypted server packets to the given file, see PacketCaptureWriter. An empty filename stops recording.
+			 */
+			void setPacketCaptureFile(QString const& filename);
+
+			/**
+			 * Handles a decrypted server packet as if it had just been read from the socket, e.g. from a capture file.
+			 */
+			void replayPacket(QByteArray const& decodedPacket);
+
+			/**
+			 * Handles the messages that were waiting for a missing identity and had been moved to the storage, see MessageCenter::onPendingMessagesReady.
+			 */
+			void restorePendingMessages(QString const& waitingFor, QList<QByteArray> const& messagePackets);
+
 			quint64 getReceivedMessagesCount() const;
 			quint64 getSendMessagesCount() const;
 			quint64 getReceivedBytesCount() const;
 			quint64 getSendBytesCount() const;
+			quint64 getSendDrainCount() const;
+			quint64 getLastDrainSendMessagesCount() const;
+			quint64 getLastDrainSendBytesCount() const;
+			quint64 getReadWakeupCount() const;
+			quint64 getLastFramesPerWakeup() const;
+			quint64 getMaxFramesPerWakeup() const;
+			qint64 getHandshakeConnectLatency() const;
+			qint64 getHandshakeServerHelloLatency() const;
+			qint64 getHandshakeAuthenticationLatency() const;
 			QDateTime const& getConnectedSince() const;
+
+			/**
+			 * Metrics collected over the lifetime of this client, not reset on reconnects.
+			 */
+			openmittsu::utility::MetricsRegistry const& getMetrics() const;
 		signals:
 			void setupDone();
 			void teardownComplete();
@@ -89,16 +134,26 @@ namespace openmittsu {
 
 			void duplicateIdUsageDetected();
 			void lostConnection();
+
+			// Backpressure on the outgoing queue, senders should pause until outgoingQueueDrained() is emitted
+			void outgoingQueueFull();
+			void outgoingQueueDrained();
 			private slots:
 			void socketOnReadyRead();
 			void socketOnError(QAbstractSocket::SocketError socketError);
 			void socketConnected();
 			void socketDisconnected(bool emitSignal = true);
+			void socketOnBytesWritten(qint64 bytes);
 			void networkSessionOnIsOpen();
 			void outgoingMessagesTimerOnTimer();
+			void clientAcknowledgementFlushTimerOnTimer();
+			void identityLookupTimerOnTimer();
 			void acknowledgmentWaitingTimerOnTimer();
 			void keepAliveTimerOnTimer();
+			void handshakeTimeoutTimerOnTimer();
 			void callbackTaskFinished(openmittsu::tasks::CallbackTask* callbackTask);
+			void groupMessageFanOutProgressed();
+			void incomingMessagesDecrypted();
 		private:
 			std::shared_ptr<openmittsu::crypto::FullCryptoBox> m_cryptoBox;
 			std::shared_ptr<openmittsu::network::MessageCenterWrapper> const m_messageCenterWrapper;
@@ -109,27 +164,79 @@ namespace openmittsu {
 			bool m_isConnected;
 			bool m_isAllowedToSend;
 			bool m_isDisconnecting;
-			QByteArray m_readyReadRemainingData;
+
+			enum class HandshakeState {
+				NONE,
+				CONNECTING,
+				WAITING_FOR_SERVER_HELLO,
+				WAITING_FOR_AUTHENTICATION_ACK
+			};
+
+			// Handshake, driven by readyRead with one timeout per phase
+			HandshakeState m_handshakeState;
+			std::unique_ptr<QTimer> m_handshakeTimeoutTimer;
+			QElapsedTimer m_handshakePhaseTimer;
+			qint64 m_handshakeConnectLatency;
+			qint64 m_handshakeServerHelloLatency;
+			qint64 m_handshakeAuthenticationLatency;
+			FrameDecoder m_frameDecoder;
 			std::unique_ptr<QTcpSocket> m_socket;
 			std::unique_ptr<QNetworkSession> m_networkSession;
 			openmittsu::protocol::ContactId const m_ourContactId;
 			std::shared_ptr<openmittsu::network::ServerConfiguration> m_serverConfiguration;
 			std::shared_ptr<openmittsu::utility::OptionMaster> m_optionMaster;
 
-			// Outgoing Message List
-			QList<QByteArray> outgoingMessages;
+			// Lanes of the outgoing queue, in order of priority
+			enum class OutgoingLane {
+				CONTROL = 0,
+				INTERACTIVE = 1,
+				BULK = 2
+			};
+
+			// Outgoing packets per lane, encrypted only when written since the server expects our nonces in order
+			std::array<QList<QByteArray>, 3> outgoingMessages;
+			qint64 outgoingMessagesBytes;
 			std::unique_ptr<QTimer> outgoingMessagesTimer;
 			QMutex outgoingMessagesMutex;
+			// Set between crossing the high and the low water mark of queued and unwritten socket bytes
+			bool m_isOutgoingQueueFull;
+			bool m_isOutgoingQueueDrainedNotificationRequested;
+
+			// Client acknowledgments for received messages, queued together after a short delay
+			ClientAcknowledgementBatcher m_clientAcknowledgementBatcher;
+			std::unique_ptr<QTimer> m_clientAcknowledgementFlushTimer;
+
+			// Encrypts the per-member copies of group messages in parallel
+			std::unique_ptr<GroupMessageFanOut> m_groupMessageFanOut;
+
+			// Decrypts and parses incoming messages off the protocol thread, keeping the order per sender
+			std::unique_ptr<IncomingMessageDecryptor> m_incomingMessageDecryptor;
 
-			// List of Messages to be acknowledged by the server
-			QHash<openmittsu::protocol::MessageId, std::shared_ptr<openmittsu::acknowledgments::AcknowledgmentProcessor>> acknowledgmentWaitingMessages;
+			struct AcknowledgmentWait {
+				std::shared_ptr<openmittsu::acknowledgments::AcknowledgmentProcessor> processor;
+				// On m_metricsClock, for the acknowledgment latency.
+				qint64 enqueuedAt;
+			};
 
+			// Messages to be acknowledged by the server, ordered by their timeout
+			openmittsu::utility::DeadlineQueue<openmittsu::protocol::MessageId, AcknowledgmentWait> acknowledgmentWaitingMessages;
+
+			// Single shot, armed for the earliest timeout in acknowledgmentWaitingMessages
 			std::unique_ptr<QTimer> acknowledgmentWaitingTimer;
 			QMutex acknowledgmentWaitingMutex;
 
 			// List of Messages kept back because we are waiting for IdentityReceivers
 			QHash<openmittsu::protocol::ContactId, std::shared_ptr<MissingIdentityProcessor>> missingIdentityProcessors;
 			QHash<openmittsu::protocol::GroupId, std::shared_ptr<MissingIdentityProcessor>> groupsWithMissingIdentities;
+			// Finished processors whose spilled messages are on their way back from the storage, by their pending messages key
+			QHash<QString, std::shared_ptr<MissingIdentityProcessor>> m_restoringMissingIdentityProcessors;
+
+			// Public key lookups for unknown identities, collected for a short while and then fetched in bulk
+			IdentityResolver m_identityResolver;
+			std::unique_ptr<QTimer> m_identityLookupTimer;
+			int m_identityLookupRetryDelayMs;
+			// Size of all messages held in the MissingIdentityProcessors, beyond the budget further messages go to the storage
+			qint64 m_pendingMessagesBytes;
 
 			// Connection Keep-Alive
 			std::unique_ptr<QTimer> keepAliveTimer;
@@ -141,11 +248,31 @@ namespace openmittsu {
 			quint64 messagesSend;
 			quint64 bytesSend;
 			quint64 bytesReceived;
+			quint64 outgoingDrainsPerformed;
+			quint64 lastDrainMessagesSend;
+			quint64 lastDrainBytesSend;
+			quint64 readWakeups;
+			quint64 lastFramesPerWakeup;
+			quint64 maxFramesPerWakeup;
 			QDateTime connectionStart;
+			openmittsu::utility::MetricsRegistry m_metrics;
+			QElapsedTimer m_metricsClock;
+
+			// Only set while recording a capture of the received packets
+			std::unique_ptr<PacketCaptureWriter> m_packetCaptureWriter;
 
+			void applySocketOptions();
 			void enqeueCallbackTask(openmittsu::tasks::CallbackTask* callbackTask);
+			void rearmAcknowledgmentWaitingTimer();
+			qint64 getPendingOutgoingBytes() const;
+			void checkOutgoingQueueLowWaterMark();
+			static QString getPacketTypeMetricName(QString const& prefix, char packetTypeByte);
 			void enqeueWaitForAcknowledgment(openmittsu::protocol::ContactId const& sender, openmittsu::protocol::MessageId const& messageId, std::shared_ptr < openmittsu::acknowledgments::AcknowledgmentProcessor > const& acknowledgmentProcessor);
-			bool waitForData(qint64 minBytesRequired);
+			void enterHandshakeState(HandshakeState const& newState);
+			void handshakeFailed(int errCode, QString const& message);
+			bool processHandshakeData();
+			bool handleServerHello();
+			bool handleAuthenticationAcknowledgment();
 			void sendClientAcknowlegmentForMessage(openmittsu::messages::MessageWithEncryptedPayload const& message);
 			void handleIncomingAcknowledgment(openmittsu::protocol::MessageId const& messageId);
 
@@ -154,6 +281,7 @@ namespace openmittsu {
 			void messageSendDone(openmittsu::protocol::GroupId const& groupId, openmittsu::protocol::MessageId const& messageId);
 			void messageSendDone(openmittsu::protocol::ContactId const& contactId, openmittsu::protocol::MessageId const& messageId);
 
+			void handleIncomingPacket(QByteArray const& decodedPacket);
 			void handleIncomingMessage(openmittsu::messages::MessageWithEncryptedPayload const& message);
 			void handleIncomingMessage(openmittsu::messages::MessageWithPayload const& messageWithPayload, openmittsu::messages::MessageWithEncryptedPayload const*const message);
 			void handleIncomingMessage(openmittsu::messages::Message const*const message, openmittsu::messages::MessageWithEncryptedPayload const*const messageWithEncryptedPayload);
@@ -173,14 +301,23 @@ namespace openmittsu {
 			void handleIncomingMessage(openmittsu::messages::FullMessageHeader const& messageHeader, std::shared_ptr<openmittsu::messages::group::GroupLeaveMessageContent const> groupLeaveMessageContent);
 			void handleOutgoingMessage(openmittsu::messages::contact::ContactMessage const*const contactMessage, std::shared_ptr<openmittsu::acknowledgments::AcknowledgmentProcessor> const& acknowledgmentProcessor);
 			void handleOutgoingMessage(openmittsu::messages::group::UnspecializedGroupMessage const*const message, std::shared_ptr<openmittsu::acknowledgments::AcknowledgmentProcessor> const& acknowledgmentProcessor);
-			void handleOutgoingMessage(openmittsu::messages::group::SpecializedGroupMessage const*const message, std::shared_ptr<openmittsu::acknowledgments::AcknowledgmentProcessor> const& acknowledgmentProcessor);
-			void encryptAndSendDataPacketToServer(QByteArray const& dataPacket);
+			void encryptAndSendDataPacketToServer(QByteArray const& dataPacket, OutgoingLane lane);
+			void encryptAndSendDataPacketsToServer(QList<QByteArray> const& dataPackets, OutgoingLane lane);
+			void flushClientAcknowledgements();
+			int getQueuedOutgoingMessagesCount() const;
+			static int getOutgoingFrameSize(QByteArray const& dataPacket);
 			void handleIncomingKeepAliveRequest(QByteArray const& packetData);
 			void handleIncomingKeepAliveAnswer(QByteArray const& packetData);
 
 			// Groups
 			bool needToWaitForMissingIdentity(openmittsu::protocol::ContactId const& contactId, openmittsu::messages::MessageWithEncryptedPayload const*const messageWithEncryptedPayload);
 			bool needToWaitForGroupData(openmittsu::protocol::GroupId const& groupId, openmittsu::messages::MessageWithEncryptedPayload const*const messageWithEncryptedPayload, bool isGroupCreationMessage);
+			void enqueuePendingMessage(std::shared_ptr<MissingIdentityProcessor> const& missingIdentityProcessor, openmittsu::messages::MessageWithEncryptedPayload const& message);
+			bool requestIdentityLookup(openmittsu::protocol::ContactId const& contactId);
+			void startIdentityLookups();
+			/** Backs off exponentially while lookups can not reach the server, and returns to the normal delay once one gets through. */
+			void scheduleIdentityLookupRetry(bool hasFailedToReachServer);
+			void identityLookupFinished(openmittsu::protocol::ContactId const& contactId, bool isSuccess, openmittsu::crypto::PublicKey const& publicKey);
 		};
 
 	}
@@ -61,6 +61,10 @@ QString ServerConfiguration::getApiServerFetchPublicKeyForIdUrl() const {
 	return QString(getApiServerHost()).append(QStringLiteral("/identity/%1"));
 }
 
+QString ServerConfiguration::getApiServerFetchPublicKeysForIdsUrl() const {
+	return QString(getApiServerHost()).append(QStringLiteral("/identity/fetch_bulk"));
+}
+
 QString ServerConfiguration::getApiServerFetchFeatureLevelsForIdsUrl() const {
 	return QString(getApiServerHost()).append(QStringLiteral("/identity/check_featurelevel"));
 }
@@ -138,6 +142,28 @@ QString ServerConfiguration::toString() const {
 	return result;
 }
 
+ServerConfiguration ServerConfiguration::fromFile(QString const& filename) {
+	if (!QFile::exists(filename)) {
+		throw openmittsu::exceptions::IllegalArgumentException() << QString("Could not open the specified server configuration file as it does not exist: %1").arg(filename).toStdString();
+	}
+
+	QSettings settings(filename, QSettings::IniFormat);
+	if (settings.status() != QSettings::NoError) {
+		throw openmittsu::exceptions::IllegalArgumentException() << QString("Could not parse the specified server configuration file: %1").arg(filename).toStdString();
+	} else if (!settings.contains(QStringLiteral("server/host")) || !settings.contains(QStringLiteral("server/port")) || !settings.contains(QStringLiteral("server/longTermPublicKey"))) {
+		throw openmittsu::exceptions::IllegalArgumentException() << QString("The server configuration file is missing one of server/host, server/port or server/longTermPublicKey: %1").arg(filename).toStdString();
+	}
+
+	bool isPortValid = false;
+	int const serverPort = settings.value(QStringLiteral("server/port")).toInt(&isPortValid);
+	if (!isPortValid || (serverPort <= 0) || (serverPort > 65535)) {
+		throw openmittsu::exceptions::IllegalArgumentException() << QString("The server configuration file contains an invalid port: %1").arg(filename).toStdString();
+	}
+
+	ServerConfiguration const defaults;
+	return ServerConfiguration(settings.value(QStringLiteral("server/host")).toString(), serverPort, openmittsu::crypto::PublicKey::fromHexString(settings.value(QStringLiteral("server/longTermPublicKey")).toString()), defaults.apiServerHost, defaults.apiServerAgent, defaults.apiServerCertificate, defaults.blobServerRequestDownloadUrl, defaults.blobServerRequestDownloadFinishedUrl, defaults.blobServerRequestUploadUrl, defaults.blobServerRequestAgent, defaults.blobServerCertificate);
+}
+
 
 	}
 }
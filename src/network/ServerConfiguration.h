@@ -22,6 +22,7 @@ namespace openmittsu {
 			QString const& getApiServerCertificateAsBase64() const;
 
 			QString getApiServerFetchPublicKeyForIdUrl() const;
+			QString getApiServerFetchPublicKeysForIdsUrl() const;
 			QString getApiServerFetchFeatureLevelsForIdsUrl() const;
 			QString getApiServerSetFeatureLevelUrl() const;
 			QString getApiServerCheckStatusForIdsUrl() const;
@@ -41,6 +42,12 @@ namespace openmittsu {
 			QString const& getBlobServerCertificateAsBase64() const;
 
 			QString toString() const;
+
+			/**
+			 * Reads an INI file with the keys server/host, server/port and server/longTermPublicKey (hex), e.g. for pointing the client at a local test server.
+			 * All other values are taken from the default configuration.
+			 */
+			static ServerConfiguration fromFile(QString const& filename);
 		private:
 			QString const serverHost;
 			int const serverPort;
@@ -2,14 +2,11 @@
 
 #include "src/exceptions/IllegalFunctionCallException.h"
 #include "src/exceptions/IllegalArgumentException.h"
+#include "src/network/HttpClient.h"
 #include "src/protocol/ProtocolSpecs.h"
-#include "src/utility/QObjectConnectionMacro.h"
 #include "src/utility/Logging.h"
 
-#include <QEventLoop>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
-#include <QHttpMultiPart>
+#include <QNetworkRequest>
 
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -31,31 +28,20 @@ namespace openmittsu {
 		void BlobDeleterCallbackTask::taskRun() {
 			LOGGER_DEBUG("Running BlobDeleterCallbackTask for BlobId {}.", QString(blobId.toHex()).toStdString());
 
-			QNetworkAccessManager networkAccessManager;
-			QEventLoop eventLoop;
-
-			OPENMITTSU_CONNECT(&networkAccessManager, finished(QNetworkReply*), &eventLoop, quit());
-
 			// the HTTPs request
 			QNetworkRequest request;
 			request.setSslConfiguration(getSslConfigurationWithCaCerts());
 			request.setUrl(QUrl(urlFinishedString.arg(QString(blobId.left(1).toHex())).arg(QString(blobId.toHex()))));
 			request.setRawHeader("User-Agent", agentString.toUtf8());
 
-			QNetworkReply *reply = networkAccessManager.get(request);
-			eventLoop.exec(); // blocks until "finished()" has been called
+			openmittsu::network::HttpClient::Response const response = openmittsu::network::HttpClient::globalInstance()->get(request); // blocks until the reply has been received
 
-			if (reply->error() == QNetworkReply::NoError) {
+			if (response.isSuccess()) {
 				// success
-				QByteArray answer(reply->readAll());
-				delete reply;
-
 				finishedWithNoError();
 			} else {
 				// failure
-				QString const errorString(reply->errorString());
-				delete reply;
-				finishedWithError(-1, errorString);
+				finishedWithError(-1, response.errorString);
 			}
 		}
 
@@ -1,18 +1,20 @@
 #include "src/tasks/BlobDownloaderCallbackTask.h"
 
+#include "src/crypto/StreamingSecretBox.h"
 #include "src/exceptions/CryptoException.h"
 #include "src/exceptions/IllegalArgumentException.h"
 #include "src/exceptions/IllegalFunctionCallException.h"
+#include "src/network/HttpClient.h"
 #include "src/protocol/ProtocolSpecs.h"
-#include "src/utility/QObjectConnectionMacro.h"
 #include "src/utility/Logging.h"
 
-#include <QEventLoop>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
-#include <QHttpMultiPart>
+#include <QBuffer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QNetworkRequest>
 #include <QSslConfiguration>
 #include <QSslCertificate>
+#include <QTemporaryFile>
 
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -21,7 +23,16 @@
 namespace openmittsu {
 	namespace tasks {
 
-		BlobDownloaderCallbackTask::BlobDownloaderCallbackTask(std::shared_ptr<openmittsu::network::ServerConfiguration> const& serverConfiguration, openmittsu::messages::Message* message, std::shared_ptr<openmittsu::acknowledgments::AcknowledgmentProcessor> const& acknowledgmentProcessor, QByteArray const& blobId) : CertificateBasedCallbackTask(serverConfiguration->getBlobServerCertificateAsBase64()), MessageCallbackTask(message, acknowledgmentProcessor), urlString(serverConfiguration->getBlobServerRequestDownloadUrl()), agentString(serverConfiguration->getBlobServerRequestAgent()), blobId(blobId) {
+		static QMutex spoolDirectoryMutex;
+		static QString spoolDirectoryPath;
+
+		BlobDownloaderCallbackTask::BlobDownloaderCallbackTask(std::shared_ptr<openmittsu::network::ServerConfiguration> const& serverConfiguration, openmittsu::messages::Message* message, std::shared_ptr<openmittsu::acknowledgments::AcknowledgmentProcessor> const& acknowledgmentProcessor, QByteArray const& blobId) : CertificateBasedCallbackTask(serverConfiguration->getBlobServerCertificateAsBase64()), MessageCallbackTask(message, acknowledgmentProcessor), urlString(serverConfiguration->getBlobServerRequestDownloadUrl()), agentString(serverConfiguration->getBlobServerRequestAgent()), blobId(blobId), decryptBlob(false), encryptionKey(), nonce(), result(), downloadedSize(0) {
+			if (urlString.isEmpty() || urlString.isNull()) {
+				throw openmittsu::exceptions::IllegalArgumentException() << "No blob download URL available from server configuration.";
+			}
+		}
+
+		BlobDownloaderCallbackTask::BlobDownloaderCallbackTask(std::shared_ptr<openmittsu::network::ServerConfiguration> const& serverConfiguration, openmittsu::messages::Message* message, std::shared_ptr<openmittsu::acknowledgments::AcknowledgmentProcessor> const& acknowledgmentProcessor, QByteArray const& blobId, openmittsu::crypto::EncryptionKey const& encryptionKey, openmittsu::crypto::Nonce const& nonce) : CertificateBasedCallbackTask(serverConfiguration->getBlobServerCertificateAsBase64()), MessageCallbackTask(message, acknowledgmentProcessor), urlString(serverConfiguration->getBlobServerRequestDownloadUrl()), agentString(serverConfiguration->getBlobServerRequestAgent()), blobId(blobId), decryptBlob(true), encryptionKey(encryptionKey), nonce(nonce), result(), downloadedSize(0) {
 			if (urlString.isEmpty() || urlString.isNull()) {
 				throw openmittsu::exceptions::IllegalArgumentException() << "No blob download URL available from server configuration.";
 			}
@@ -34,33 +45,53 @@ namespace openmittsu {
 		void BlobDownloaderCallbackTask::taskRun() {
 			LOGGER_DEBUG("Running BlobDownloaderCallbackTask for BlobId {}.", QString(blobId.toHex()).toStdString());
 
-			QNetworkAccessManager networkAccessManager;
-			QEventLoop eventLoop;
-
-			OPENMITTSU_CONNECT(&networkAccessManager, finished(QNetworkReply*), &eventLoop, quit());
-
 			// the HTTPs request
 			QNetworkRequest request;
 			request.setSslConfiguration(getSslConfigurationWithCaCerts());
 			request.setUrl(QUrl(urlString.arg(QString(blobId.left(1).toHex())).arg(QString(blobId.toHex()))));
 			request.setRawHeader("User-Agent", agentString.toUtf8());
 
-			QNetworkReply *reply = networkAccessManager.get(request);
-			eventLoop.exec(); // blocks until "finished()" has been called
-
-			if (reply->error() == QNetworkReply::NoError) {
-				// success
-				result = reply->readAll();
-				delete reply;
+			// Spooling the reply to disk keeps it from piling up in memory while it is received.
+			QTemporaryFile spoolFile(getSpoolDirectory().filePath(QStringLiteral("blobSpool_XXXXXX")));
+			if (!spoolFile.open()) {
+				finishedWithError(-2, QString("Could not create a spool file for the download: ").append(spoolFile.errorString()));
+				return;
+			}
 
-				finishedWithNoError();
-			} else {
+			openmittsu::network::HttpClient::Response const response = openmittsu::network::HttpClient::globalInstance()->download(request, &spoolFile); // blocks until the reply has been received
+			if (!response.isSuccess()) {
 				// failure
-				QString const errorString(reply->errorString());
-				delete reply;
+				finishedWithError(-1, response.errorString);
+				return;
+			}
 
-				finishedWithError(-1, errorString);
+			downloadedSize = spoolFile.size();
+			if (!spoolFile.seek(0)) {
+				finishedWithError(-2, QString("Could not rewind the spool file: ").append(spoolFile.errorString()));
+				return;
 			}
+
+			if (decryptBlob) {
+				qint64 const decryptedSize = openmittsu::crypto::StreamingSecretBox::getDecryptedSize(downloadedSize);
+				if (decryptedSize > 0) {
+					result.reserve(static_cast<int>(decryptedSize));
+				}
+
+				QBuffer resultBuffer(&result);
+				resultBuffer.open(QIODevice::WriteOnly);
+				try {
+					openmittsu::crypto::StreamingSecretBox::decrypt(spoolFile, downloadedSize, resultBuffer, encryptionKey, nonce);
+				} catch (openmittsu::exceptions::CryptoException& cryptoException) {
+					result.clear();
+					finishedWithError(-3, QString(cryptoException.what()));
+					return;
+				}
+			} else {
+				result = spoolFile.readAll();
+			}
+
+			// success
+			finishedWithNoError();
 		}
 
 		QByteArray const& BlobDownloaderCallbackTask::getDownloadedBlob() const {
@@ -70,5 +101,26 @@ namespace openmittsu {
 			return result;
 		}
 
+		qint64 BlobDownloaderCallbackTask::getDownloadedBlobSize() const {
+			return downloadedSize;
+		}
+
+		bool BlobDownloaderCallbackTask::hasDecryptedBlob() const {
+			return decryptBlob;
+		}
+
+		void BlobDownloaderCallbackTask::setSpoolDirectory(QDir const& spoolDirectory) {
+			QMutexLocker lock(&spoolDirectoryMutex);
+			spoolDirectoryPath = spoolDirectory.absolutePath();
+		}
+
+		QDir BlobDownloaderCallbackTask::getSpoolDirectory() {
+			QMutexLocker lock(&spoolDirectoryMutex);
+			if (spoolDirectoryPath.isEmpty()) {
+				return QDir::temp();
+			}
+			return QDir(spoolDirectoryPath);
+		}
+
 	}
 }
@@ -1,6 +1,8 @@
 #ifndef OPENMITTSU_TASKS_BLOBDOWNLOADERCALLBACKTASK_H_
 #define OPENMITTSU_TASKS_BLOBDOWNLOADERCALLBACKTASK_H_
 
+#include "src/crypto/EncryptionKey.h"
+#include "src/crypto/Nonce.h"
 #include "src/messages/Message.h"
 #include "src/tasks/CertificateBasedCallbackTask.h"
 #include "src/tasks/MessageCallbackTask.h"
@@ -8,6 +10,7 @@
 
 #include <QString>
 #include <QByteArray>
+#include <QDir>
 #include <QSslCertificate>
 
 namespace openmittsu {
@@ -16,9 +19,25 @@ namespace openmittsu {
 		class BlobDownloaderCallbackTask : public CertificateBasedCallbackTask, public MessageCallbackTask {
 		public:
 			BlobDownloaderCallbackTask(std::shared_ptr<openmittsu::network::ServerConfiguration> const& serverConfiguration, openmittsu::messages::Message* message, std::shared_ptr<openmittsu::acknowledgments::AcknowledgmentProcessor> const& acknowledgmentProcessor, QByteArray const& blobId);
+
+			/**
+			 * Decrypts the blob (a crypto_secretbox) chunk by chunk while reading it back from the spool file, so the encrypted blob is never held in memory.
+			 */
+			BlobDownloaderCallbackTask(std::shared_ptr<openmittsu::network::ServerConfiguration> const& serverConfiguration, openmittsu::messages::Message* message, std::shared_ptr<openmittsu::acknowledgments::AcknowledgmentProcessor> const& acknowledgmentProcessor, QByteArray const& blobId, openmittsu::crypto::EncryptionKey const& encryptionKey, openmittsu::crypto::Nonce const& nonce);
 			virtual ~BlobDownloaderCallbackTask();
 
+			/**
+			 * The blob as downloaded, or the decrypted blob if hasDecryptedBlob().
+			 */
 			QByteArray const& getDownloadedBlob() const;
+			qint64 getDownloadedBlobSize() const;
+			bool hasDecryptedBlob() const;
+
+			/**
+			 * Downloads are spooled to temporary files in this directory (the media directory, if a database is open).
+			 */
+			static void setSpoolDirectory(QDir const& spoolDirectory);
+			static QDir getSpoolDirectory();
 		protected:
 			virtual void taskRun() override;
 		private:
@@ -26,7 +45,11 @@ namespace openmittsu {
 			QString const agentString;
 
 			QByteArray const blobId;
+			bool const decryptBlob;
+			openmittsu::crypto::EncryptionKey const encryptionKey;
+			openmittsu::crypto::Nonce const nonce;
 			QByteArray result;
+			qint64 downloadedSize;
 		};
 
 	}
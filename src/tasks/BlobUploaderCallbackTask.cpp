@@ -2,13 +2,10 @@
 
 #include "src/exceptions/IllegalArgumentException.h"
 #include "src/exceptions/IllegalFunctionCallException.h"
-#include "src/utility/QObjectConnectionMacro.h"
+#include "src/network/HttpClient.h"
 #include "src/utility/Logging.h"
 
-#include <QEventLoop>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
-#include <QHttpMultiPart>
+#include <QNetworkRequest>
 
 namespace openmittsu {
 	namespace tasks {
@@ -26,11 +23,6 @@ namespace openmittsu {
 		void BlobUploaderCallbackTask::taskRun() {
 			LOGGER_DEBUG("Running BlobUploaderCallbackTask for {} Bytes.", dataToUpload.size());
 
-			QNetworkAccessManager networkAccessManager;
-			QEventLoop eventLoop;
-
-			OPENMITTSU_CONNECT(&networkAccessManager, finished(QNetworkReply*), &eventLoop, quit());
-
 			// the HTTPs request
 			QNetworkRequest request;
 			request.setSslConfiguration(getSslConfigurationWithCaCerts());
@@ -43,33 +35,15 @@ namespace openmittsu {
 			filename="blob.bin"
 			Content-Type: application/octet-stream
 			*/
+			openmittsu::network::HttpClient::Response const response = openmittsu::network::HttpClient::globalInstance()->postFormData(request, QStringLiteral("blob"), QStringLiteral("blob.bin"), dataToUpload); // blocks until the reply has been received
 
-			QHttpMultiPart *multiPart = new QHttpMultiPart(QHttpMultiPart::FormDataType);
-
-			QHttpPart textPart;
-			textPart.setHeader(QNetworkRequest::ContentTypeHeader, QVariant("application/octet-stream"));
-			textPart.setHeader(QNetworkRequest::ContentDispositionHeader, QVariant("form-data; name=\"blob\"; filename=\"blob.bin\""));
-			textPart.setBody(dataToUpload);
-
-			multiPart->append(textPart);
-
-			QNetworkReply *reply = networkAccessManager.post(request, multiPart);
-			multiPart->setParent(reply);
-
-			eventLoop.exec(); // blocks until "finished()" has been called
-
-			if (reply->error() == QNetworkReply::NoError) {
+			if (response.isSuccess()) {
 				// success
-				QByteArray answer(QByteArray::fromHex(reply->readAll()));
-				delete reply;
-
-				result = answer;
+				result = QByteArray::fromHex(response.body);
 				finishedWithNoError();
 			} else {
 				// failure
-				QString const errorString(reply->errorString());
-				delete reply;
-				finishedWithError(-1, errorString);
+				finishedWithError(-1, response.errorString);
 			}
 		}
 
@@ -5,8 +5,9 @@
 namespace openmittsu {
 	namespace tasks {
 
-		CallbackTask::CallbackTask() : QThread(nullptr), cb_errorCode(0), cb_errorMessage(""), cb_isFinished(false), cb_finishedSuccessfully(false) {
-			// Intentionally left empty.
+		CallbackTask::CallbackTask() : QObject(nullptr), QRunnable(), cb_errorCode(0), cb_errorMessage(""), cb_isFinished(false), cb_finishedSuccessfully(false), cb_wasCancelled(false), cb_isCancellationRequested(false), cb_queueWaitTime(-1), cb_runTime(-1) {
+			// Ownership stays with whoever receives the finished() signal.
+			setAutoDelete(false);
 		}
 
 		CallbackTask::~CallbackTask() {
@@ -31,13 +32,29 @@ namespace openmittsu {
 		}
 
 		void CallbackTask::run() {
-			LOGGER_DEBUG("CallbackTask::run() will now run the setup.");
-			preRunSetup();
-			LOGGER_DEBUG("CallbackTask::run() will now enter the taskRun section.");
-			taskRun();
-			LOGGER_DEBUG("CallbackTask::run() has left the taskRun section.");
+			QElapsedTimer runTimer;
+			runTimer.start();
+
+			if (isCancellationRequested()) {
+				LOGGER_DEBUG("CallbackTask::run() skips a task that was cancelled while queued.");
+				cb_wasCancelled = true;
+				finishedWithError(-1, QStringLiteral("The task was cancelled before it was started."));
+			} else {
+				LOGGER_DEBUG("CallbackTask::run() will now run the setup.");
+				preRunSetup();
+				LOGGER_DEBUG("CallbackTask::run() will now enter the taskRun section.");
+				taskRun();
+				LOGGER_DEBUG("CallbackTask::run() has left the taskRun section.");
+
+				if (!cb_isFinished) {
+					finishedWithError(-1, QStringLiteral("The task did not report a result."));
+				}
+			}
+
+			cb_runTime = runTimer.elapsed();
 
-			this->exit(0);
+			// Must be last, the receiver may delete this task as soon as it sees the signal.
+			emit finished(this);
 		}
 
 		void CallbackTask::finishedWithNoError() {
@@ -45,8 +62,6 @@ namespace openmittsu {
 			if (!this->cb_isFinished) {
 				this->cb_isFinished = true;
 				this->cb_finishedSuccessfully = true;
-
-				emit finished(this);
 			}
 		}
 
@@ -55,8 +70,6 @@ namespace openmittsu {
 			this->cb_errorMessage = errorMessage;
 			this->cb_isFinished = true;
 			this->cb_finishedSuccessfully = false;
-
-			emit finished(this);
 		}
 
 		bool CallbackTask::hasFinished() const {
@@ -67,5 +80,29 @@ namespace openmittsu {
 			return cb_finishedSuccessfully;
 		}
 
+		void CallbackTask::requestCancellation() {
+			cb_isCancellationRequested = true;
+		}
+
+		bool CallbackTask::isCancellationRequested() const {
+			return cb_isCancellationRequested.load();
+		}
+
+		bool CallbackTask::wasCancelled() const {
+			return cb_wasCancelled;
+		}
+
+		void CallbackTask::setQueueWaitTime(qint64 queueWaitTime) {
+			cb_queueWaitTime = queueWaitTime;
+		}
+
+		qint64 CallbackTask::getQueueWaitTime() const {
+			return cb_queueWaitTime;
+		}
+
+		qint64 CallbackTask::getRunTime() const {
+			return cb_runTime;
+		}
+
 	}
 }
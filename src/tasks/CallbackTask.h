@@ -1,14 +1,21 @@
 #ifndef OPENMITTSU_TASKS_CALLBACKTASK_H_
 #define OPENMITTSU_TASKS_CALLBACKTASK_H_
 
+#include <QElapsedTimer>
 #include <QString>
-#include <QThread>
 #include <QObject>
+#include <QRunnable>
+
+#include <atomic>
 
 namespace openmittsu {
 	namespace tasks {
 
-		class CallbackTask : public QThread {
+		/**
+		 * A unit of background work, run by the TaskExecutor on one of its worker threads.
+		 * The finished() signal is the last thing a task does, so the receiver owns the task from then on and may delete it.
+		 */
+		class CallbackTask : public QObject, public QRunnable {
 			Q_OBJECT
 		public:
 			virtual ~CallbackTask();
@@ -20,6 +27,22 @@ namespace openmittsu {
 
 			virtual bool hasFinished() const;
 			virtual bool hasFinishedSuccessfully() const;
+
+			/**
+			 * Asks the task not to run. A task that has not been started yet finishes with an error instead of doing its work.
+			 */
+			void requestCancellation();
+			bool isCancellationRequested() const;
+			bool wasCancelled() const;
+
+			/**
+			 * @return The time in milliseconds the task spent waiting for a worker, or -1 if it was not run by the TaskExecutor (yet).
+			 */
+			qint64 getQueueWaitTime() const;
+			/**
+			 * @return The time in milliseconds the task spent running, or -1 if it did not finish yet.
+			 */
+			qint64 getRunTime() const;
 		signals:
 			void finished(openmittsu::tasks::CallbackTask* callbackTask);
 		protected:
@@ -31,13 +54,22 @@ namespace openmittsu {
 			void finishedWithNoError();
 			void finishedWithError(int errorCode, QString const& errorMessage);
 		private:
+			// The executor measures the queue wait, since it is the one queueing the task.
+			friend class TaskExecutorRunnable;
+			void setQueueWaitTime(qint64 queueWaitTime);
+
 			int cb_errorCode;
 			QString cb_errorMessage;
 			bool cb_isFinished;
 			bool cb_finishedSuccessfully;
+			bool cb_wasCancelled;
+			std::atomic<bool> cb_isCancellationRequested;
+
+			qint64 cb_queueWaitTime;
+			qint64 cb_runTime;
 		};
 
 	}
 }
 
-#endif // OPENMITTSU_TASKS_CALLBACKTASK_H_
\ No newline at end of file
+#endif // OPENMITTSU_TASKS_CALLBACKTASK_H_
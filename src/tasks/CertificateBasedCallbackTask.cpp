@@ -1,6 +1,7 @@
 #include "CertificateBasedCallbackTask.h"
 
 #include "src/exceptions/IllegalArgumentException.h"
+#include "src/network/HttpClient.h"
 #include "src/utility/Logging.h"
 
 #include <QSslError>
@@ -22,12 +23,7 @@ namespace openmittsu {
 		}
 
 		QSslConfiguration CertificateBasedCallbackTask::getSslConfigurationWithCaCerts() {
-			QSslConfiguration defaultConfig = QSslConfiguration::defaultConfiguration();
-			QList<QSslCertificate> defaultCerts = defaultConfig.caCertificates();
-			defaultCerts.append(m_acceptableNonCaRootCertificates);
-			defaultConfig.setCaCertificates(defaultCerts);
-
-			return defaultConfig;
+			return openmittsu::network::HttpClient::globalInstance()->getSslConfiguration(m_acceptableNonCaRootCertificates);
 		}
 
 		CertificateBasedCallbackTask::CertificateBasedCallbackTask(QString const& acceptableNonCaRootCertificateInBase64) : m_acceptableNonCaRootCertificates() {
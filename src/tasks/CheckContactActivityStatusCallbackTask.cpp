@@ -1,16 +1,13 @@
 #include "src/tasks/CheckContactActivityStatusCallbackTask.h"
 
 #include "src/exceptions/IllegalArgumentException.h"
+#include "src/network/HttpClient.h"
 #include "src/protocol/ProtocolSpecs.h"
 #include "src/utility/Logging.h"
-#include "src/utility/QObjectConnectionMacro.h"
 
 #include <memory>
 
-#include <QEventLoop>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
-#include <QHttpMultiPart>
+#include <QNetworkRequest>
 
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -31,11 +28,6 @@ namespace openmittsu {
 		}
 
 		void CheckContactActivityStatusCallbackTask::taskRun() {
-			QNetworkAccessManager networkAccessManager;
-			QEventLoop eventLoop;
-
-			OPENMITTSU_CONNECT(&networkAccessManager, finished(QNetworkReply*), &eventLoop, quit());
-
 			// the HTTPs request
 			QNetworkRequest request;
 			request.setSslConfiguration(getSslConfigurationWithCaCerts());
@@ -63,16 +55,14 @@ namespace openmittsu {
 			QByteArray postDataSize = QByteArray::number(jsonData.size());
 			request.setRawHeader("Content-Length", postDataSize);
 
-			std::unique_ptr<QNetworkReply> reply(networkAccessManager.post(request, jsonData));
-
 			// clear result
 			m_fetchedFeatureLevels.clear();
 
-			eventLoop.exec(); // blocks until "finished()" has been called
+			openmittsu::network::HttpClient::Response const response = openmittsu::network::HttpClient::globalInstance()->post(request, jsonData); // blocks until the reply has been received
 
-			if (reply->error() == QNetworkReply::NoError) {
+			if (response.isSuccess()) {
 				// success
-				QByteArray answer(reply->readAll());
+				QByteArray const& answer = response.body;
 				LOGGER_DEBUG("CheckContactIds Response was: {}", QString(answer).toStdString());
 
 				QJsonDocument answerDocument = QJsonDocument::fromJson(answer);
@@ -110,8 +100,7 @@ namespace openmittsu {
 				finishedWithNoError();
 			} else {
 				// failure
-				QString const errorString(reply->errorString());
-				finishedWithError(-1, errorString);
+				finishedWithError(-1, response.errorString);
 			}
 		}
 
@@ -1,12 +1,10 @@
 #include "src/tasks/FileDownloaderCallbackTask.h"
 
 #include "src/exceptions/IllegalFunctionCallException.h"
-#include "src/utility/QObjectConnectionMacro.h"
+#include "src/network/HttpClient.h"
 #include "src/utility/Logging.h"
 
-#include <QEventLoop>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
+#include <QNetworkRequest>
 
 namespace openmittsu {
 	namespace tasks {
@@ -22,30 +20,20 @@ namespace openmittsu {
 		void FileDownloaderCallbackTask::taskRun() {
 			LOGGER_DEBUG("Running FileDownloaderCallbackTask for URL {}.", QString(m_url.toDisplayString()).toStdString());
 
-			QNetworkAccessManager networkAccessManager;
-			QEventLoop eventLoop;
-
-			OPENMITTSU_CONNECT(&networkAccessManager, finished(QNetworkReply*), &eventLoop, quit());
-
 			// the HTTPs request
 			QNetworkRequest request;
 			request.setUrl(m_url);
 
-			QNetworkReply *reply = networkAccessManager.get(request);
-			eventLoop.exec(); // blocks until "finished()" has been called
+			openmittsu::network::HttpClient::Response const response = openmittsu::network::HttpClient::globalInstance()->get(request); // blocks until the reply has been received
 
-			if (reply->error() == QNetworkReply::NoError) {
+			if (response.isSuccess()) {
 				// success
-				m_result = reply->readAll();
-				delete reply;
+				m_result = response.body;
 
 				finishedWithNoError();
 			} else {
 				// failure
-				QString const errorString(reply->errorString());
-				delete reply;
-
-				finishedWithError(-1, errorString);
+				finishedWithError(-1, response.errorString);
 			}
 		}
 
@@ -0,0 +1,158 @@
+#include "src/tasks/IdentityBulkReceiverCallbackTask.h"
+
+#include "src/exceptions/IllegalArgumentException.h"
+#include "src/network/HttpClient.h"
+#include "src/utility/Logging.h"
+
+#include <QNetworkRequest>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonValue>
+
+namespace openmittsu {
+	namespace tasks {
+
+		IdentityBulkReceiverCallbackTask::IdentityBulkReceiverCallbackTask(std::shared_ptr<openmittsu::network::ServerConfiguration> const& serverConfiguration, QSet<openmittsu::protocol::ContactId> const& identitiesToFetch) : CertificateBasedCallbackTask(serverConfiguration->getApiServerCertificateAsBase64()), CallbackTask(), m_bulkUrlString(serverConfiguration->getApiServerFetchPublicKeysForIdsUrl()), m_singleUrlString(serverConfiguration->getApiServerFetchPublicKeyForIdUrl()), m_agentString(serverConfiguration->getApiServerAgent()), m_identitiesToFetch(identitiesToFetch), m_fetchedPublicKeys(), m_unknownIdentities() {
+			if (m_singleUrlString.isEmpty() || m_singleUrlString.isNull()) {
+				throw openmittsu::exceptions::IllegalArgumentException() << "No identity download URL available from server configuration.";
+			}
+		}
+
+		IdentityBulkReceiverCallbackTask::~IdentityBulkReceiverCallbackTask() {
+			// Intentionally left empty.
+		}
+
+		void IdentityBulkReceiverCallbackTask::taskRun() {
+			m_fetchedPublicKeys.clear();
+			m_unknownIdentities.clear();
+
+			QString errorMessage;
+			if ((m_identitiesToFetch.size() > 1) && fetchAll(errorMessage)) {
+				finishedWithNoError();
+				return;
+			} else if (m_identitiesToFetch.size() > 1) {
+				LOGGER()->warn("Bulk fetching {} identities failed, falling back to fetching them one by one. Error: {}", m_identitiesToFetch.size(), errorMessage.toStdString());
+			}
+
+			// One by one, but still on this thread and in sequence, so a large batch does not turn into a burst of requests.
+			bool hasReachedServer = false;
+			auto it = m_identitiesToFetch.constBegin();
+			auto const end = m_identitiesToFetch.constEnd();
+			for (; it != end; ++it) {
+				if (fetchOne(*it, errorMessage)) {
+					hasReachedServer = true;
+				} else {
+					LOGGER()->warn("Could not fetch public key for identity {}. Error: {}", it->toString(), errorMessage.toStdString());
+				}
+			}
+
+			if (hasReachedServer) {
+				finishedWithNoError();
+			} else {
+				finishedWithError(-1, QString("Could not fetch any of %1 public keys: %2").arg(m_identitiesToFetch.size()).arg(errorMessage));
+			}
+		}
+
+		bool IdentityBulkReceiverCallbackTask::fetchAll(QString& errorMessage) {
+			QNetworkRequest request;
+			request.setSslConfiguration(getSslConfigurationWithCaCerts());
+			request.setUrl(QUrl(m_bulkUrlString));
+			request.setRawHeader("User-Agent", m_agentString.toUtf8());
+			request.setRawHeader("Content-Type", "application/json");
+
+			QJsonArray jsonIdentities;
+			auto it = m_identitiesToFetch.constBegin();
+			auto const end = m_identitiesToFetch.constEnd();
+			for (; it != end; ++it) {
+				jsonIdentities.append(QJsonValue(it->toQString()));
+			}
+			QJsonObject jsonObject;
+			jsonObject.insert("identities", jsonIdentities);
+			QByteArray const jsonData = QJsonDocument(jsonObject).toJson();
+			request.setRawHeader("Content-Length", QByteArray::number(jsonData.size()));
+
+			openmittsu::network::HttpClient::Response const response = openmittsu::network::HttpClient::globalInstance()->post(request, jsonData); // blocks until the reply has been received
+			if (!response.isSuccess()) {
+				errorMessage = response.errorString;
+				return false;
+			}
+
+			QJsonDocument const answerDocument = QJsonDocument::fromJson(response.body);
+			QJsonValue const answerValue = answerDocument.object().value("identities");
+			if (!answerDocument.isObject() || !answerValue.isArray()) {
+				errorMessage = QString("Unexpected server reply: ").append(response.body.toHex());
+				return false;
+			}
+
+			QJsonArray const answerArray = answerValue.toArray();
+			for (int i = 0, size = answerArray.size(); i < size; ++i) {
+				QJsonObject const entry = answerArray.at(i).toObject();
+				insertFetchedPublicKey(entry.value("identity").toString(), entry.value("publicKey").toString());
+			}
+
+			// The server leaves out identities it does not know.
+			for (it = m_identitiesToFetch.constBegin(); it != end; ++it) {
+				if (!m_fetchedPublicKeys.contains(*it)) {
+					m_unknownIdentities.insert(*it);
+				}
+			}
+			LOGGER_DEBUG("Bulk fetch returned {} of {} requested public keys.", m_fetchedPublicKeys.size(), m_identitiesToFetch.size());
+
+			return true;
+		}
+
+		bool IdentityBulkReceiverCallbackTask::fetchOne(openmittsu::protocol::ContactId const& identity, QString& errorMessage) {
+			QNetworkRequest request;
+			request.setSslConfiguration(getSslConfigurationWithCaCerts());
+			request.setUrl(QUrl(m_singleUrlString.arg(identity.toQString())));
+			request.setRawHeader("User-Agent", m_agentString.toUtf8());
+
+			openmittsu::network::HttpClient::Response const response = openmittsu::network::HttpClient::globalInstance()->get(request); // blocks until the reply has been received
+			if (response.httpStatusCode == 404) {
+				m_unknownIdentities.insert(identity);
+				return true;
+			} else if (!response.isSuccess()) {
+				errorMessage = response.errorString;
+				return false;
+			}
+
+			QJsonObject const jsonObject = QJsonDocument::fromJson(response.body).object();
+			insertFetchedPublicKey(jsonObject.value("identity").toString(), jsonObject.value("publicKey").toString());
+			if (!m_fetchedPublicKeys.contains(identity)) {
+				m_unknownIdentities.insert(identity);
+			}
+			return true;
+		}
+
+		void IdentityBulkReceiverCallbackTask::insertFetchedPublicKey(QString const& identity, QString const& base64PublicKey) {
+			try {
+				openmittsu::protocol::ContactId const contactId(identity);
+				if (!m_identitiesToFetch.contains(contactId)) {
+					LOGGER()->warn("Server returned a public key for identity {}, which was not requested.", contactId.toString());
+					return;
+				}
+
+				QString const publicKeyHexString = QByteArray::fromBase64(base64PublicKey.toLatin1()).toHex();
+				LOGGER_DEBUG("Received reply for identity = \"{}\" with public key = \"{}\".", identity.toStdString(), publicKeyHexString.toStdString());
+				m_fetchedPublicKeys.insert(contactId, openmittsu::crypto::PublicKey::fromHexString(publicKeyHexString));
+			} catch (...) {
+				LOGGER()->warn("Could not parse the public key \"{}\" returned for identity \"{}\".", base64PublicKey.toStdString(), identity.toStdString());
+			}
+		}
+
+		QSet<openmittsu::protocol::ContactId> const& IdentityBulkReceiverCallbackTask::getContactIds() const {
+			return m_identitiesToFetch;
+		}
+
+		QHash<openmittsu::protocol::ContactId, openmittsu::crypto::PublicKey> const& IdentityBulkReceiverCallbackTask::getFetchedPublicKeys() const {
+			return m_fetchedPublicKeys;
+		}
+
+		QSet<openmittsu::protocol::ContactId> const& IdentityBulkReceiverCallbackTask::getUnknownIdentities() const {
+			return m_unknownIdentities;
+		}
+
+	}
+}
@@ -0,0 +1,54 @@
+#ifndef OPENMITTSU_TASKS_IDENTITYBULKRECEIVERCALLBACKTASK_H_
+#define OPENMITTSU_TASKS_IDENTITYBULKRECEIVERCALLBACKTASK_H_
+
+#include "src/protocol/ContactId.h"
+#include "src/network/ServerConfiguration.h"
+#include "src/crypto/PublicKey.h"
+
+#include "src/tasks/CallbackTask.h"
+#include "src/tasks/CertificateBasedCallbackTask.h"
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
+#include <QSslCertificate>
+
+#include <memory>
+
+namespace openmittsu {
+	namespace tasks {
+
+		/**
+		 * Fetches the public keys of several identities with one request.
+		 * Identities unknown to the server are missing from the fetched keys and listed as unknown, the task itself only fails if the server could not be asked at all.
+		 */
+		class IdentityBulkReceiverCallbackTask : public CertificateBasedCallbackTask, public CallbackTask {
+		public:
+			IdentityBulkReceiverCallbackTask(std::shared_ptr<openmittsu::network::ServerConfiguration> const& serverConfiguration, QSet<openmittsu::protocol::ContactId> const& identitiesToFetch);
+			virtual ~IdentityBulkReceiverCallbackTask();
+
+			QSet<openmittsu::protocol::ContactId> const& getContactIds() const;
+			QHash<openmittsu::protocol::ContactId, openmittsu::crypto::PublicKey> const& getFetchedPublicKeys() const;
+			/** The identities the server answered for without a usable public key. Identities neither fetched nor unknown could not be asked for. */
+			QSet<openmittsu::protocol::ContactId> const& getUnknownIdentities() const;
+		protected:
+			virtual void taskRun() override;
+		private:
+			QString const m_bulkUrlString;
+			QString const m_singleUrlString;
+			QString const m_agentString;
+			QSet<openmittsu::protocol::ContactId> const m_identitiesToFetch;
+
+			QHash<openmittsu::protocol::ContactId, openmittsu::crypto::PublicKey> m_fetchedPublicKeys;
+			QSet<openmittsu::protocol::ContactId> m_unknownIdentities;
+
+			bool fetchAll(QString& errorMessage);
+			bool fetchOne(openmittsu::protocol::ContactId const& identity, QString& errorMessage);
+			void insertFetchedPublicKey(QString const& identity, QString const& base64PublicKey);
+		};
+
+	}
+}
+
+#endif // OPENMITTSU_TASKS_IDENTITYBULKRECEIVERCALLBACKTASK_H_
@@ -1,14 +1,11 @@
 #include "src/tasks/IdentityReceiverCallbackTask.h"
 
 #include "src/exceptions/IllegalArgumentException.h"
+#include "src/network/HttpClient.h"
 #include "src/protocol/ProtocolSpecs.h"
 #include "src/utility/Logging.h"
-#include "src/utility/QObjectConnectionMacro.h"
 
-#include <QEventLoop>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
-#include <QHttpMultiPart>
+#include <QNetworkRequest>
 
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -28,24 +25,17 @@ namespace openmittsu {
 		}
 
 		void IdentityReceiverCallbackTask::taskRun() {
-			QNetworkAccessManager networkAccessManager;
-			QEventLoop eventLoop;
-
-			OPENMITTSU_CONNECT(&networkAccessManager, finished(QNetworkReply*), &eventLoop, quit());
-
 			// the HTTPs request
 			QNetworkRequest request;
 			request.setSslConfiguration(getSslConfigurationWithCaCerts());
 			request.setUrl(QUrl(m_urlString.arg(m_identityToFetch.toQString())));
 			request.setRawHeader("User-Agent", m_agentString.toUtf8());
 
-			QNetworkReply *reply = networkAccessManager.get(request);
-			eventLoop.exec(); // blocks until "finished()" has been called
+			openmittsu::network::HttpClient::Response const response = openmittsu::network::HttpClient::globalInstance()->get(request); // blocks until the reply has been received
 
-			if (reply->error() == QNetworkReply::NoError) {
+			if (response.isSuccess()) {
 				// success
-				QByteArray answer(reply->readAll());
-				delete reply;
+				QByteArray const& answer = response.body;
 
 				try {
 					QJsonDocument jsonResponse = QJsonDocument::fromJson(answer);
@@ -62,9 +52,7 @@ namespace openmittsu {
 				}
 			} else {
 				// failure
-				QString const errorString(reply->errorString());
-				delete reply;
-				finishedWithError(-2, QString("Could not fetch public key for identity ").append(m_identityToFetch.toQString()).append("An error occurred while parsing the server reply: ").append(errorString));
+				finishedWithError(-2, QString("Could not fetch public key for identity ").append(m_identityToFetch.toQString()).append("An error occurred while parsing the server reply: ").append(response.errorString));
 			}
 		}
 
@@ -2,15 +2,12 @@
 
 #include "src/exceptions/CryptoException.h"
 #include "src/exceptions/IllegalArgumentException.h"
+#include "src/network/HttpClient.h"
 #include "src/utility/Logging.h"
-#include "src/utility/QObjectConnectionMacro.h"
 
 #include <memory>
 
-#include <QEventLoop>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
-#include <QHttpMultiPart>
+#include <QNetworkRequest>
 
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -32,12 +29,7 @@ namespace openmittsu {
 		}
 
 		void SetFeatureLevelCallbackTask::taskRun() {
-			QNetworkAccessManager networkAccessManager;
-			QEventLoop eventLoop;
-
-			OPENMITTSU_CONNECT(&networkAccessManager, finished(QNetworkReply*), &eventLoop, quit());
-
-			std::unique_ptr<QNetworkReply> reply;
+			openmittsu::network::HttpClient::Response response;
 			{
 				// the HTTPs request
 				QNetworkRequest request;
@@ -56,14 +48,12 @@ namespace openmittsu {
 				QByteArray postDataSize = QByteArray::number(jsonData.size());
 				request.setRawHeader("Content-Length", postDataSize);
 
-				reply.reset(networkAccessManager.post(request, jsonData));
+				response = openmittsu::network::HttpClient::globalInstance()->post(request, jsonData); // blocks until the reply has been received
 			}
 
-			eventLoop.exec(); // blocks until "finished()" has been called
-
-			if (reply->error() == QNetworkReply::NoError) {
+			if (response.isSuccess()) {
 				// success
-				QByteArray answer(reply->readAll());
+				QByteArray const& answer = response.body;
 				LOGGER_DEBUG("SetFeatureLevel first response was: {}", QString(answer).toStdString());
 
 				QJsonDocument answerDocument = QJsonDocument::fromJson(answer);
@@ -85,7 +75,7 @@ namespace openmittsu {
 					QString const encryptedTokenBase64 = QString::fromLatin1(cryptoResult.second.toBase64());
 					QString const nonceBase64 = QString::fromLatin1(cryptoResult.first.getNonce().toBase64());
 
-					std::unique_ptr<QNetworkReply> replyReponse;
+					openmittsu::network::HttpClient::Response responseReponse;
 
 					{
 						QJsonObject jsonObjectResponse;
@@ -110,14 +100,12 @@ namespace openmittsu {
 						requestReponse.setRawHeader("Content-Length", postDataResponseSize);
 
 						LOGGER_DEBUG("SetFeatureLevel challenge response is: {}", QString(jsonDataReponse).toStdString());
-						replyReponse.reset(networkAccessManager.post(requestReponse, jsonDataReponse));
+						responseReponse = openmittsu::network::HttpClient::globalInstance()->post(requestReponse, jsonDataReponse); // blocks until the reply has been received
 					}
 
-					eventLoop.exec(); // blocks until "finished()" has been called
-
-					if (replyReponse->error() == QNetworkReply::NoError) {
+					if (responseReponse.isSuccess()) {
 						// success
-						QByteArray answerResponse(replyReponse->readAll());
+						QByteArray const& answerResponse = responseReponse.body;
 						LOGGER_DEBUG("SetFeatureLevel second response was: {}", QString(answerResponse).toStdString());
 						QJsonDocument answerResponseDocument = QJsonDocument::fromJson(answerResponse);
 						if (answerResponseDocument.isObject()) {
@@ -134,8 +122,7 @@ namespace openmittsu {
 						}
 					} else {
 						// failure
-						QString const errorString(replyReponse->errorString());
-						finishedWithError(-4, errorString);
+						finishedWithError(-4, responseReponse.errorString);
 					}
 				} else {
 					finishedWithError(-2, "Result is not a JSON Object.");
@@ -144,8 +131,7 @@ namespace openmittsu {
 				finishedWithNoError();
 			} else {
 				// failure
-				QString const errorString(reply->errorString());
-				finishedWithError(-1, errorString);
+				finishedWithError(-1, response.errorString);
 			}
 		}
 
@@ -0,0 +1,195 @@
+#include "src/tasks/TaskExecutor.h"
+
+#include "src/exceptions/IllegalArgumentException.h"
+#include "src/utility/Logging.h"
+
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+
+#include <algorithm>
+
+#define OPENMITTSU_TASKEXECUTOR_DEFAULT_WORKER_COUNT (4)
+
+namespace openmittsu {
+	namespace tasks {
+
+		/**
+		 * Wraps a CallbackTask for the thread pool. The task emits finished() at the very end of its run(), after which neither the pool nor the executor touches it again.
+		 */
+		class TaskExecutorRunnable : public QRunnable {
+		public:
+			TaskExecutorRunnable(TaskExecutor* executor, CallbackTask* callbackTask) : QRunnable(), m_executor(executor), m_callbackTask(callbackTask) {
+				setAutoDelete(true);
+			}
+
+			virtual void run() override {
+				bool isDiscarded = false;
+				bool const wasCancelled = !m_executor->taskStarting(m_callbackTask, &isDiscarded);
+				qint64 const queueWaitTime = m_enqueueTimer.elapsed();
+
+				if (isDiscarded) {
+					// The task never ran and nothing was ever sent to it, so it is safe to delete it from this thread.
+					delete m_callbackTask;
+					m_executor->taskDone(queueWaitTime, 0, true);
+					return;
+				}
+
+				QElapsedTimer runTimer;
+				runTimer.start();
+				m_callbackTask->setQueueWaitTime(queueWaitTime);
+				m_callbackTask->run();
+
+				m_executor->taskDone(queueWaitTime, runTimer.elapsed(), wasCancelled);
+			}
+
+			void markEnqueued() {
+				m_enqueueTimer.start();
+			}
+		private:
+			TaskExecutor* const m_executor;
+			CallbackTask* const m_callbackTask;
+			QElapsedTimer m_enqueueTimer;
+		};
+
+		TaskExecutor::TaskExecutor(int workerCount) : m_threadPool(), m_mutex(), m_queuedTasks(), m_discardedTasks(), m_runningTasks(0), m_submittedTasks(0), m_completedTasks(0), m_cancelledTasks(0), m_totalQueueWaitTime(0), m_maxQueueWaitTime(0), m_totalRunTime(0), m_maxRunTime(0) {
+			setWorkerCount(workerCount);
+		}
+
+		TaskExecutor::~TaskExecutor() {
+			cancelAll();
+			m_threadPool.waitForDone();
+		}
+
+		TaskExecutor* TaskExecutor::globalInstance() {
+			static TaskExecutor executor(OPENMITTSU_TASKEXECUTOR_DEFAULT_WORKER_COUNT);
+			return &executor;
+		}
+
+		void TaskExecutor::submit(CallbackTask* callbackTask, TaskPriority priority) {
+			if (callbackTask == nullptr) {
+				throw openmittsu::exceptions::IllegalArgumentException() << "Can not submit a null CallbackTask to the TaskExecutor.";
+			}
+
+			TaskExecutorRunnable* runnable = new TaskExecutorRunnable(this, callbackTask);
+			{
+				QMutexLocker lock(&m_mutex);
+				m_queuedTasks.insert(callbackTask);
+				++m_submittedTasks;
+			}
+
+			runnable->markEnqueued();
+			m_threadPool.start(runnable, static_cast<int>(priority));
+		}
+
+		bool TaskExecutor::cancel(CallbackTask* callbackTask) {
+			QMutexLocker lock(&m_mutex);
+			if (!m_queuedTasks.contains(callbackTask)) {
+				return false;
+			}
+
+			callbackTask->requestCancellation();
+			return true;
+		}
+
+		void TaskExecutor::cancelAll() {
+			QMutexLocker lock(&m_mutex);
+			for (CallbackTask* callbackTask : m_queuedTasks) {
+				callbackTask->requestCancellation();
+			}
+		}
+
+		void TaskExecutor::discardQueuedTasks() {
+			QMutexLocker lock(&m_mutex);
+			for (CallbackTask* callbackTask : m_queuedTasks) {
+				callbackTask->requestCancellation();
+				m_discardedTasks.insert(callbackTask);
+			}
+		}
+
+		bool TaskExecutor::waitForDone(int msecs) {
+			return m_threadPool.waitForDone(msecs);
+		}
+
+		void TaskExecutor::setWorkerCount(int workerCount) {
+			if (workerCount <= 0) {
+				workerCount = std::max(1, QThread::idealThreadCount());
+			}
+			m_threadPool.setMaxThreadCount(workerCount);
+		}
+
+		int TaskExecutor::getWorkerCount() const {
+			return m_threadPool.maxThreadCount();
+		}
+
+		bool TaskExecutor::taskStarting(CallbackTask* callbackTask, bool* isDiscarded) {
+			QMutexLocker lock(&m_mutex);
+			// From here on the task may be deleted by its owner at any time, so forget about it before it runs.
+			m_queuedTasks.remove(callbackTask);
+			*isDiscarded = m_discardedTasks.remove(callbackTask);
+			++m_runningTasks;
+			return !callbackTask->isCancellationRequested();
+		}
+
+		void TaskExecutor::taskDone(qint64 queueWaitTime, qint64 runTime, bool wasCancelled) {
+			QMutexLocker lock(&m_mutex);
+			--m_runningTasks;
+			if (wasCancelled) {
+				++m_cancelledTasks;
+			} else {
+				++m_completedTasks;
+				m_totalRunTime += runTime;
+				m_maxRunTime = std::max(m_maxRunTime, runTime);
+			}
+			m_totalQueueWaitTime += queueWaitTime;
+			m_maxQueueWaitTime = std::max(m_maxQueueWaitTime, queueWaitTime);
+		}
+
+		quint64 TaskExecutor::getSubmittedTaskCount() const {
+			QMutexLocker lock(&m_mutex);
+			return m_submittedTasks;
+		}
+
+		quint64 TaskExecutor::getCompletedTaskCount() const {
+			QMutexLocker lock(&m_mutex);
+			return m_completedTasks;
+		}
+
+		quint64 TaskExecutor::getCancelledTaskCount() const {
+			QMutexLocker lock(&m_mutex);
+			return m_cancelledTasks;
+		}
+
+		int TaskExecutor::getQueuedTaskCount() const {
+			QMutexLocker lock(&m_mutex);
+			return m_queuedTasks.size();
+		}
+
+		int TaskExecutor::getRunningTaskCount() const {
+			QMutexLocker lock(&m_mutex);
+			return m_runningTasks;
+		}
+
+		qint64 TaskExecutor::getTotalQueueWaitTime() const {
+			QMutexLocker lock(&m_mutex);
+			return m_totalQueueWaitTime;
+		}
+
+		qint64 TaskExecutor::getMaxQueueWaitTime() const {
+			QMutexLocker lock(&m_mutex);
+			return m_maxQueueWaitTime;
+		}
+
+		qint64 TaskExecutor::getTotalRunTime() const {
+			QMutexLocker lock(&m_mutex);
+			return m_totalRunTime;
+		}
+
+		qint64 TaskExecutor::getMaxRunTime() const {
+			QMutexLocker lock(&m_mutex);
+			return m_maxRunTime;
+		}
+
+	}
+}
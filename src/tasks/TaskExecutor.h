@@ -0,0 +1,94 @@
+#ifndef OPENMITTSU_TASKS_TASKEXECUTOR_H_
+#define OPENMITTSU_TASKS_TASKEXECUTOR_H_
+
+#include <QMutex>
+#include <QSet>
+#include <QThreadPool>
+
+#include "src/tasks/CallbackTask.h"
+
+namespace openmittsu {
+	namespace tasks {
+
+		/**
+		 * Runs CallbackTasks on a fixed number of worker threads, taking queued tasks in order of their priority.
+		 * Replaces the former one-thread-per-task model, so a burst of tasks (e.g. images sent to a large group) no longer spawns a thread each.
+		 */
+		class TaskExecutor {
+		public:
+			enum class TaskPriority {
+				LOW = 0,
+				NORMAL = 1,
+				HIGH = 2
+			};
+
+			explicit TaskExecutor(int workerCount);
+			virtual ~TaskExecutor();
+
+			/**
+			 * The executor shared by all parts of the application.
+			 */
+			static TaskExecutor* globalInstance();
+
+			/**
+			 * Queues the task. Its finished() signal is emitted from a worker thread, connect to it before submitting.
+			 */
+			void submit(CallbackTask* callbackTask, TaskPriority priority = TaskPriority::NORMAL);
+
+			/**
+			 * Cancels a task that has not been started yet. It still emits finished(), with an error.
+			 * @return True iff the task was still waiting for a worker.
+			 */
+			bool cancel(CallbackTask* callbackTask);
+			void cancelAll();
+
+			/**
+			 * Cancels all tasks that have not been started yet and takes ownership of them: they are deleted without emitting finished().
+			 * Meant for shutting down, when the receivers of finished() are about to go away. Only valid if all queued tasks were allocated with new.
+			 */
+			void discardQueuedTasks();
+
+			bool waitForDone(int msecs = -1);
+
+			/**
+			 * @param workerCount The number of worker threads, zero or less selects the number of cores.
+			 */
+			void setWorkerCount(int workerCount);
+			int getWorkerCount() const;
+
+			// Statistics
+			quint64 getSubmittedTaskCount() const;
+			quint64 getCompletedTaskCount() const;
+			quint64 getCancelledTaskCount() const;
+			int getQueuedTaskCount() const;
+			int getRunningTaskCount() const;
+			qint64 getTotalQueueWaitTime() const;
+			qint64 getMaxQueueWaitTime() const;
+			qint64 getTotalRunTime() const;
+			qint64 getMaxRunTime() const;
+		private:
+			QThreadPool m_threadPool;
+
+			mutable QMutex m_mutex;
+			QSet<CallbackTask*> m_queuedTasks;
+			QSet<CallbackTask*> m_discardedTasks;
+			int m_runningTasks;
+
+			quint64 m_submittedTasks;
+			quint64 m_completedTasks;
+			quint64 m_cancelledTasks;
+			qint64 m_totalQueueWaitTime;
+			qint64 m_maxQueueWaitTime;
+			qint64 m_totalRunTime;
+			qint64 m_maxRunTime;
+
+			bool taskStarting(CallbackTask* callbackTask, bool* isDiscarded);
+			void taskDone(qint64 queueWaitTime, qint64 runTime, bool wasCancelled);
+
+			friend class TaskExecutorRunnable;
+		};
+
+	}
+}
+
+#endif // OPENMITTSU_TASKS_TASKEXECUTOR_H_
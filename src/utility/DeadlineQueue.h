@@ -0,0 +1,166 @@
+#ifndef OPENMITTSU_UTILITY_DEADLINEQUEUE_H_
+#define OPENMITTSU_UTILITY_DEADLINEQUEUE_H_
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <QHash>
+#include <QtGlobal>
+
+namespace openmittsu {
+	namespace utility {
+
+		/**
+		 * A map whose entries expire at a deadline (e.g. milliseconds since the epoch), backed by a min-heap on the deadlines.
+		 * Taking the expired entries costs O(expired * log n) instead of a scan over all entries.
+		 * Removed or replaced entries are dropped from the heap lazily. Not thread-safe, callers have to provide their own locking.
+		 */
+		template<typename Key, typename Value>
+		class DeadlineQueue {
+		public:
+			DeadlineQueue() : m_entries(), m_heap(), m_nextSequence(0) {
+				// Intentionally left empty.
+			}
+
+			/**
+			 * Inserts the entry, replacing (and rescheduling) an existing entry for the same key.
+			 */
+			void insert(Key const& key, Value const& value, qint64 deadline) {
+				quint64 const sequence = m_nextSequence++;
+				m_entries.insert(key, Entry(value, deadline, sequence));
+				m_heap.push_back(HeapEntry(deadline, sequence, key));
+				std::push_heap(m_heap.begin(), m_heap.end(), std::greater<HeapEntry>());
+
+				compactIfNeeded();
+			}
+
+			bool contains(Key const& key) const {
+				return m_entries.contains(key);
+			}
+
+			/**
+			 * @return True iff the key was found, in which case value holds the entry.
+			 */
+			bool get(Key const& key, Value& value) const {
+				auto const it = m_entries.constFind(key);
+				if (it == m_entries.constEnd()) {
+					return false;
+				}
+
+				value = it->value;
+				return true;
+			}
+
+			bool remove(Key const& key) {
+				bool const result = m_entries.remove(key) > 0;
+				compactIfNeeded();
+				return result;
+			}
+
+			void clear() {
+				m_entries.clear();
+				m_heap.clear();
+			}
+
+			int size() const {
+				return m_entries.size();
+			}
+
+			bool isEmpty() const {
+				return m_entries.isEmpty();
+			}
+
+			/**
+			 * @return The earliest deadline of all entries, or -1 if the queue is empty.
+			 */
+			qint64 getNextDeadline() {
+				dropStaleHeads();
+				if (m_heap.empty()) {
+					return -1;
+				}
+				return m_heap.front().deadline;
+			}
+
+			/**
+			 * Removes and returns all entries with a deadline of at most now, earliest first.
+			 */
+			std::vector<std::pair<Key, Value>> takeExpired(qint64 now) {
+				std::vector<std::pair<Key, Value>> result;
+
+				dropStaleHeads();
+				while (!m_heap.empty() && (m_heap.front().deadline <= now)) {
+					HeapEntry const head = m_heap.front();
+					std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<HeapEntry>());
+					m_heap.pop_back();
+
+					auto const it = m_entries.find(head.key);
+					result.push_back(std::make_pair(head.key, it->value));
+					m_entries.erase(it);
+
+					dropStaleHeads();
+				}
+
+				return result;
+			}
+		private:
+			struct Entry {
+				Entry() : value(), deadline(0), sequence(0) {
+					// Intentionally left empty.
+				}
+
+				Entry(Value const& entryValue, qint64 entryDeadline, quint64 entrySequence) : value(entryValue), deadline(entryDeadline), sequence(entrySequence) {
+					// Intentionally left empty.
+				}
+
+				Value value;
+				qint64 deadline;
+				quint64 sequence;
+			};
+
+			struct HeapEntry {
+				HeapEntry(qint64 entryDeadline, quint64 entrySequence, Key const& entryKey) : deadline(entryDeadline), sequence(entrySequence), key(entryKey) {
+					// Intentionally left empty.
+				}
+
+				qint64 deadline;
+				quint64 sequence;
+				Key key;
+
+				bool operator>(HeapEntry const& other) const {
+					return (deadline > other.deadline) || ((deadline == other.deadline) && (sequence > other.sequence));
+				}
+			};
+
+			QHash<Key, Entry> m_entries;
+			std::vector<HeapEntry> m_heap;
+			quint64 m_nextSequence;
+
+			bool isStale(HeapEntry const& heapEntry) const {
+				auto const it = m_entries.constFind(heapEntry.key);
+				return (it == m_entries.constEnd()) || (it->sequence != heapEntry.sequence);
+			}
+
+			void dropStaleHeads() {
+				while (!m_heap.empty() && isStale(m_heap.front())) {
+					std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<HeapEntry>());
+					m_heap.pop_back();
+				}
+			}
+
+			// Keeps entries that were removed or replaced before expiring from piling up in the heap.
+			void compactIfNeeded() {
+				if (m_heap.size() <= (2 * static_cast<size_t>(m_entries.size()) + 64)) {
+					return;
+				}
+
+				m_heap.erase(std::remove_if(m_heap.begin(), m_heap.end(), [this](HeapEntry const& heapEntry) { return isStale(heapEntry); }), m_heap.end());
+				std::make_heap(m_heap.begin(), m_heap.end(), std::greater<HeapEntry>());
+			}
+		};
+
+	}
+}
+
+#endif // OPENMITTSU_UTILITY_DEADLINEQUEUE_H_
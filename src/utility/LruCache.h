@@ -0,0 +1,91 @@
+#ifndef OPENMITTSU_UTILITY_LRUCACHE_H_
+#define OPENMITTSU_UTILITY_LRUCACHE_H_
+
+#include <list>
+#include <utility>
+
+#include <QHash>
+
+namespace openmittsu {
+	namespace utility {
+
+		/**
+		 * A bounded least-recently-used map. Not thread-safe, callers have to provide their own locking.
+		 */
+		template<typename Key, typename Value>
+		class LruCache {
+		public:
+			explicit LruCache(int capacity) : m_capacity((capacity < 1) ? 1 : capacity), m_entries(), m_index() {
+				// Intentionally left empty.
+			}
+
+			// The index stores iterators into the entry list, which stay valid on move but not on copy.
+			LruCache(LruCache const& other) = delete;
+			LruCache(LruCache&& other) = default;
+			LruCache& operator=(LruCache const& other) = delete;
+			LruCache& operator=(LruCache&& other) = default;
+
+			/**
+			 * Looks up key and marks it as most recently used.
+			 * @return True iff the key was found, in which case value holds the cached entry.
+			 */
+			bool get(Key const& key, Value& value) {
+				auto const it = m_index.constFind(key);
+				if (it == m_index.constEnd()) {
+					return false;
+				}
+
+				m_entries.splice(m_entries.begin(), m_entries, it.value());
+				value = it.value()->second;
+				return true;
+			}
+
+			void insert(Key const& key, Value const& value) {
+				auto const it = m_index.find(key);
+				if (it != m_index.end()) {
+					it.value()->second = value;
+					m_entries.splice(m_entries.begin(), m_entries, it.value());
+					return;
+				}
+
+				if (m_entries.size() >= static_cast<typename EntryList::size_type>(m_capacity)) {
+					m_index.remove(m_entries.back().first);
+					m_entries.pop_back();
+				}
+
+				m_entries.emplace_front(key, value);
+				m_index.insert(key, m_entries.begin());
+			}
+
+			void remove(Key const& key) {
+				auto const it = m_index.find(key);
+				if (it != m_index.end()) {
+					m_entries.erase(it.value());
+					m_index.erase(it);
+				}
+			}
+
+			void clear() {
+				m_entries.clear();
+				m_index.clear();
+			}
+
+			int size() const {
+				return m_index.size();
+			}
+
+			int getCapacity() const {
+				return m_capacity;
+			}
+		private:
+			typedef std::list<std::pair<Key, Value>> EntryList;
+
+			int m_capacity;
+			EntryList m_entries;
+			QHash<Key, typename EntryList::iterator> m_index;
+		};
+
+	}
+}
+
+#endif // OPENMITTSU_UTILITY_LRUCACHE_H_
@@ -0,0 +1,149 @@
+#include "src/utility/MetricsRegistry.h"
+
+#include <QMutexLocker>
+#include <QStringList>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace openmittsu {
+	namespace utility {
+
+		constexpr int MetricsRegistry::HISTOGRAM_BUCKET_COUNT;
+
+		MetricsRegistry::Histogram::Histogram() : m_count(0), m_sum(0), m_min(0), m_max(0), m_buckets() {
+			m_buckets.fill(0);
+		}
+
+		int MetricsRegistry::Histogram::getBucketIndex(qint64 value) {
+			// Bucket i holds values in [2^(i - 1), 2^i), bucket 0 holds zero and the last bucket everything above.
+			int index = 0;
+			quint64 remaining = (value < 0) ? 0 : static_cast<quint64>(value);
+			while ((remaining > 0) && (index < (HISTOGRAM_BUCKET_COUNT - 1))) {
+				remaining >>= 1;
+				++index;
+			}
+			return index;
+		}
+
+		qint64 MetricsRegistry::Histogram::getBucketUpperBound(int bucketIndex) {
+			if (bucketIndex >= (HISTOGRAM_BUCKET_COUNT - 1)) {
+				return std::numeric_limits<qint64>::max();
+			}
+			return (static_cast<qint64>(1) << bucketIndex) - 1;
+		}
+
+		void MetricsRegistry::Histogram::record(qint64 value) {
+			if (m_count == 0) {
+				m_min = value;
+				m_max = value;
+			} else {
+				m_min = std::min(m_min, value);
+				m_max = std::max(m_max, value);
+			}
+			++m_count;
+			m_sum += value;
+			++m_buckets[getBucketIndex(value)];
+		}
+
+		quint64 MetricsRegistry::Histogram::getCount() const {
+			return m_count;
+		}
+
+		qint64 MetricsRegistry::Histogram::getSum() const {
+			return m_sum;
+		}
+
+		qint64 MetricsRegistry::Histogram::getMin() const {
+			return m_min;
+		}
+
+		qint64 MetricsRegistry::Histogram::getMax() const {
+			return m_max;
+		}
+
+		qint64 MetricsRegistry::Histogram::getPercentileUpperBound(double percentile) const {
+			if (m_count == 0) {
+				return -1;
+			}
+
+			quint64 const rank = std::max<quint64>(1, static_cast<quint64>(std::ceil((percentile / 100.0) * static_cast<double>(m_count))));
+			quint64 seen = 0;
+			for (int i = 0; i < HISTOGRAM_BUCKET_COUNT; ++i) {
+				seen += m_buckets[i];
+				if (seen >= rank) {
+					return std::min(getBucketUpperBound(i), m_max);
+				}
+			}
+			return m_max;
+		}
+
+		MetricsRegistry::MetricsRegistry() : m_mutex(), m_since(QDateTime::currentDateTime()), m_counters(), m_gauges(), m_histograms() {
+			// Intentionally left empty.
+		}
+
+		MetricsRegistry::~MetricsRegistry() {
+			// Intentionally left empty.
+		}
+
+		void MetricsRegistry::incrementCounter(QString const& name, quint64 amount) {
+			QMutexLocker lock(&m_mutex);
+			m_counters[name] += amount;
+		}
+
+		void MetricsRegistry::setGauge(QString const& name, qint64 value) {
+			QMutexLocker lock(&m_mutex);
+			m_gauges.insert(name, value);
+		}
+
+		void MetricsRegistry::recordValue(QString const& name, qint64 value) {
+			QMutexLocker lock(&m_mutex);
+			m_histograms[name].record(value);
+		}
+
+		quint64 MetricsRegistry::getCounter(QString const& name) const {
+			QMutexLocker lock(&m_mutex);
+			return m_counters.value(name, 0);
+		}
+
+		qint64 MetricsRegistry::getGauge(QString const& name) const {
+			QMutexLocker lock(&m_mutex);
+			return m_gauges.value(name, 0);
+		}
+
+		MetricsRegistry::Histogram MetricsRegistry::getHistogram(QString const& name) const {
+			QMutexLocker lock(&m_mutex);
+			return m_histograms.value(name);
+		}
+
+		QString MetricsRegistry::toText() const {
+			QMutexLocker lock(&m_mutex);
+
+			QStringList lines;
+			for (auto it = m_counters.constBegin(), end = m_counters.constEnd(); it != end; ++it) {
+				lines.append(QStringLiteral("counter %1 %2").arg(it.key()).arg(it.value()));
+			}
+			for (auto it = m_gauges.constBegin(), end = m_gauges.constEnd(); it != end; ++it) {
+				lines.append(QStringLiteral("gauge %1 %2").arg(it.key()).arg(it.value()));
+			}
+			for (auto it = m_histograms.constBegin(), end = m_histograms.constEnd(); it != end; ++it) {
+				Histogram const& histogram = it.value();
+				lines.append(QStringLiteral("histogram %1 count=%2 sum=%3 min=%4 max=%5 p50<=%6 p90<=%7 p99<=%8").arg(it.key()).arg(histogram.getCount()).arg(histogram.getSum()).arg(histogram.getMin()).arg(histogram.getMax()).arg(histogram.getPercentileUpperBound(50.0)).arg(histogram.getPercentileUpperBound(90.0)).arg(histogram.getPercentileUpperBound(99.0)));
+			}
+			std::sort(lines.begin(), lines.end(), [](QString const& a, QString const& b) { return a.section(QChar(' '), 1) < b.section(QChar(' '), 1); });
+
+			lines.prepend(QStringLiteral("# Metrics since %1, snapshot taken %2").arg(m_since.toString(Qt::ISODate)).arg(QDateTime::currentDateTime().toString(Qt::ISODate)));
+			return lines.join(QChar('\n')).append(QChar('\n'));
+		}
+
+		void MetricsRegistry::reset() {
+			QMutexLocker lock(&m_mutex);
+			m_since = QDateTime::currentDateTime();
+			m_counters.clear();
+			m_gauges.clear();
+			m_histograms.clear();
+		}
+
+	}
+}
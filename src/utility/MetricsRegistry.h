@@ -0,0 +1,78 @@
+#ifndef OPENMITTSU_UTILITY_METRICSREGISTRY_H_
+#define OPENMITTSU_UTILITY_METRICSREGISTRY_H_
+
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QtGlobal>
+
+#include <array>
+
+namespace openmittsu {
+	namespace utility {
+
+		/**
+		 * Named counters, gauges and histograms that live as long as their owner, e.g. across reconnects of the ProtocolClient.
+		 * Histograms use power-of-two buckets, so percentiles are reported as the upper bound of the bucket they fall into.
+		 * All methods are thread-safe.
+		 */
+		class MetricsRegistry {
+		public:
+			static constexpr int HISTOGRAM_BUCKET_COUNT = 40;
+
+			class Histogram {
+			public:
+				Histogram();
+
+				void record(qint64 value);
+
+				quint64 getCount() const;
+				qint64 getSum() const;
+				qint64 getMin() const;
+				qint64 getMax() const;
+
+				/**
+				 * @param percentile In the range (0, 100].
+				 * @return An upper bound for the given percentile of the recorded values, or -1 if nothing was recorded.
+				 */
+				qint64 getPercentileUpperBound(double percentile) const;
+			private:
+				quint64 m_count;
+				qint64 m_sum;
+				qint64 m_min;
+				qint64 m_max;
+				std::array<quint64, HISTOGRAM_BUCKET_COUNT> m_buckets;
+
+				static int getBucketIndex(qint64 value);
+				static qint64 getBucketUpperBound(int bucketIndex);
+			};
+
+			MetricsRegistry();
+			virtual ~MetricsRegistry();
+
+			void incrementCounter(QString const& name, quint64 amount = 1);
+			void setGauge(QString const& name, qint64 value);
+			void recordValue(QString const& name, qint64 value);
+
+			quint64 getCounter(QString const& name) const;
+			qint64 getGauge(QString const& name) const;
+			Histogram getHistogram(QString const& name) const;
+
+			/**
+			 * A plain text dump of all metrics, one per line and sorted by name.
+			 */
+			QString toText() const;
+			void reset();
+		private:
+			mutable QMutex m_mutex;
+			QDateTime m_since;
+			QHash<QString, quint64> m_counters;
+			QHash<QString, qint64> m_gauges;
+			QHash<QString, Histogram> m_histograms;
+		};
+
+	}
+}
+
+#endif // OPENMITTSU_UTILITY_METRICSREGISTRY_H_
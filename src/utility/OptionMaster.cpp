@@ -41,6 +41,7 @@ namespace openmittsu {
 			m_groupToNameMap.insert(OptionGroups::GROUP_PRIVACY, tr("Privacy"));
 			m_groupToNameMap.insert(OptionGroups::GROUP_NOTIFICATIONS, tr("Notifications"));
 			m_groupToNameMap.insert(OptionGroups::GROUP_GENERAL, tr("General"));
+			m_groupToNameMap.insert(OptionGroups::GROUP_NETWORK, tr("Network"));
 			m_groupToNameMap.insert(OptionGroups::GROUP_INTERNAL, "");
 
 			// Register all the options
@@ -55,6 +56,12 @@ namespace openmittsu {
 			registerOption(OptionGroups::GROUP_GENERAL, Options::BOOLEAN_RECONNECT_ON_CONNECTION_LOSS, QStringLiteral("options/reconnectOnConnectionLoss"), tr("Whether a reconnect should automatically be tried on a connection loss."), true, OptionTypes::TYPE_BOOL, OptionStorage::STORAGE_DATABASE);
 			registerOption(OptionGroups::GROUP_GENERAL, Options::BOOLEAN_TRUST_OTHERS, QStringLiteral("options/trustOthers"), tr("Whether to accept messages from users whos group membership has not (yet) been confirmed."), false, OptionTypes::TYPE_BOOL, OptionStorage::STORAGE_DATABASE);
 			registerOption(OptionGroups::GROUP_GENERAL, Options::BOOLEAN_UPDATE_FEATURE_LEVEL, QStringLiteral("options/updateFeatureLevel"), tr("Whether the supported feature level of the used identity should be updated if the stored feature level is lower than the one supported by this app."), true, OptionTypes::TYPE_BOOL, OptionStorage::STORAGE_DATABASE);
+			registerOption(OptionGroups::GROUP_NETWORK, Options::BOOLEAN_NETWORK_TCP_NODELAY, QStringLiteral("options/network/tcpNoDelay"), tr("Whether outgoing packets should be sent immediately instead of being delayed by the operating system (TCP_NODELAY)."), true, OptionTypes::TYPE_BOOL, OptionStorage::STORAGE_DATABASE);
+			registerOption(OptionGroups::GROUP_NETWORK, Options::INTEGER_NETWORK_SOCKET_SEND_BUFFER_SIZE, QStringLiteral("options/network/socketSendBufferSize"), tr("The size of the socket send buffer in bytes (0 uses the system default)."), 0, OptionTypes::TYPE_INTEGER, OptionStorage::STORAGE_DATABASE);
+			registerOption(OptionGroups::GROUP_NETWORK, Options::INTEGER_NETWORK_SOCKET_RECEIVE_BUFFER_SIZE, QStringLiteral("options/network/socketReceiveBufferSize"), tr("The size of the socket receive buffer in bytes (0 uses the system default)."), 0, OptionTypes::TYPE_INTEGER, OptionStorage::STORAGE_DATABASE);
+			registerOption(OptionGroups::GROUP_NETWORK, Options::INTEGER_NETWORK_GROUP_ENCRYPTION_THREADS, QStringLiteral("options/network/groupEncryptionThreads"), tr("The number of threads used to encrypt the copies of a message sent to a large group (0 uses one per processor core). Takes effect on the next start."), 0, OptionTypes::TYPE_INTEGER, OptionStorage::STORAGE_DATABASE);
+			registerOption(OptionGroups::GROUP_NETWORK, Options::INTEGER_NETWORK_DECRYPTION_THREADS, QStringLiteral("options/network/decryptionThreads"), tr("The number of threads used to decrypt received messages (0 uses one per processor core). Takes effect on the next start."), 0, OptionTypes::TYPE_INTEGER, OptionStorage::STORAGE_DATABASE);
+			registerOption(OptionGroups::GROUP_GENERAL, Options::INTEGER_BACKGROUND_TASK_THREADS, QStringLiteral("options/backgroundTaskThreads"), tr("The number of threads running background tasks like blob uploads and downloads or identity lookups (0 uses one per processor core). Takes effect on the next start."), 4, OptionTypes::TYPE_INTEGER, OptionStorage::STORAGE_SIMPLE);
 			registerOption(OptionGroups::GROUP_GENERAL, Options::FILEPATH_DATABASE, QStringLiteral("options/database/databaseFile"), tr("The file path where the main database file is stored."), "", OptionTypes::TYPE_FILEPATH, OptionStorage::STORAGE_SIMPLE);
 			registerOption(OptionGroups::GROUP_INTERNAL, Options::BINARY_MAINWINDOW_GEOMETRY, QStringLiteral("options/internal/clientMainWindowGeometry"), "", QByteArray(), OptionTypes::TYPE_BINARY, OptionStorage::STORAGE_SIMPLE);
 			registerOption(OptionGroups::GROUP_INTERNAL, Options::BINARY_MAINWINDOW_STATE, QStringLiteral("options/internal/clientMainWindowState"), "", QByteArray(), OptionTypes::TYPE_BINARY, OptionStorage::STORAGE_SIMPLE);
@@ -71,6 +78,8 @@ namespace openmittsu {
 				return QMetaType::Type::Bool;
 			} else if (type == OptionTypes::TYPE_FILEPATH) {
 				return QMetaType::Type::QString;
+			} else if (type == OptionTypes::TYPE_INTEGER) {
+				return QMetaType::Type::Int;
 			} else {
 				throw openmittsu::exceptions::InternalErrorException() << "Unknown OptionMaster::OptionTypes Key with value " << static_cast<int>(type) << "!";
 			}
@@ -124,6 +133,8 @@ namespace openmittsu {
 							m_database->setOptionValue(i.value().name, i.value().defaultValue.toBool());
 						} else if (i.value().type == OptionTypes::TYPE_FILEPATH) {
 							m_database->setOptionValue(i.value().name, i.value().defaultValue.toString());
+						} else if (i.value().type == OptionTypes::TYPE_INTEGER) {
+							m_database->setOptionValue(i.value().name, i.value().defaultValue.toInt());
 						} else {
 							throw openmittsu::exceptions::InternalErrorException() << "Unknown OptionMaster::OptionTypes Key with value " << static_cast<int>(i.value().type) << " found on Option " << static_cast<int>(i.key()) << " with name \"" << i.value().name.toStdString() << "\"!";
 						}
@@ -136,6 +147,8 @@ namespace openmittsu {
 							m_settings->setValue(i.value().name, i.value().defaultValue.toBool());
 						} else if (i.value().type == OptionTypes::TYPE_FILEPATH) {
 							m_settings->setValue(i.value().name, i.value().defaultValue.toString());
+						} else if (i.value().type == OptionTypes::TYPE_INTEGER) {
+							m_settings->setValue(i.value().name, i.value().defaultValue.toInt());
 						} else {
 							throw openmittsu::exceptions::InternalErrorException() << "Unknown OptionMaster::OptionTypes Key with value " << static_cast<int>(i.value().type) << " found on Option " << static_cast<int>(i.key()) << " with name \"" << i.value().name.toStdString() << "\"!";
 						}
@@ -246,6 +259,39 @@ namespace openmittsu {
 			}
 		}
 
+		int OptionMaster::getOptionAsInt(Options const& option) const {
+			if (!m_optionToOptionContainerMap.contains(option)) {
+				throw openmittsu::exceptions::InternalErrorException() << "Requested option " << static_cast<int>(option) << " does not exist!";
+			}
+			QString const optionName = getOptionKeyForOption(option);
+			OptionStorage const optionStorage = m_optionToOptionContainerMap.constFind(option)->storage;
+
+			if (optionStorage == OptionStorage::STORAGE_DATABASE) {
+				if (m_database == nullptr) {
+					return m_optionToOptionContainerMap.constFind(option)->defaultValue.toInt();
+				}
+
+				if (m_database->hasOption(optionName)) {
+					return m_database->getOptionValueAsInt(optionName);
+				} else {
+					throw openmittsu::exceptions::InternalErrorException() << "Requested option " << static_cast<int>(option) << " does not exist in database!";
+				}
+			} else if (optionStorage == OptionStorage::STORAGE_SIMPLE) {
+				if (m_settings->contains(optionName)) {
+					QVariant const v = m_settings->value(optionName);
+					if (v.canConvert(QMetaType::Type::Int)) {
+						return v.toInt();
+					} else {
+						throw openmittsu::exceptions::InternalErrorException() << "Can not convert requested option " << static_cast<int>(option) << " to int!";
+					}
+				} else {
+					throw openmittsu::exceptions::InternalErrorException() << "Requested option " << static_cast<int>(option) << " does not exist in settings!";
+				}
+			} else {
+				throw openmittsu::exceptions::InternalErrorException() << "Unknown OptionMaster::OptionStorage Key with value " << static_cast<int>(optionStorage) << " found on Option " << static_cast<int>(option) << " with name \"" << optionName.toStdString() << "\"!";
+			}
+		}
+
 		void OptionMaster::setOption(Options const& option, QVariant const& value) {
 			if (!m_optionToOptionContainerMap.contains(option)) {
 				throw openmittsu::exceptions::InternalErrorException() << "Requested option " << static_cast<int>(option) << " does not exist!";
@@ -266,6 +312,8 @@ namespace openmittsu {
 					m_database->setOptionValue(optionName, value.toBool());
 				} else if (type == OptionTypes::TYPE_FILEPATH) {
 					m_database->setOptionValue(optionName, value.toString());
+				} else if (type == OptionTypes::TYPE_INTEGER) {
+					m_database->setOptionValue(optionName, value.toInt());
 				} else {
 					throw openmittsu::exceptions::InternalErrorException() << "Unknown OptionMaster::OptionTypes Key with value " << static_cast<int>(type) << "!";
 				}
@@ -37,13 +37,15 @@ namespace openmittsu {
 				GROUP_PRIVACY,
 				GROUP_NOTIFICATIONS,
 				GROUP_GENERAL,
+				GROUP_NETWORK,
 				GROUP_INTERNAL
 			};
 
 			enum class OptionTypes {
 				TYPE_BOOL,
 				TYPE_FILEPATH,
-				TYPE_BINARY
+				TYPE_BINARY,
+				TYPE_INTEGER
 			};
 
 			enum class Options {
@@ -54,6 +56,12 @@ namespace openmittsu {
 				BOOLEAN_RECONNECT_ON_CONNECTION_LOSS,
 				BOOLEAN_UPDATE_FEATURE_LEVEL,
 				BOOLEAN_TRUST_OTHERS,
+				BOOLEAN_NETWORK_TCP_NODELAY,
+				INTEGER_NETWORK_SOCKET_SEND_BUFFER_SIZE,
+				INTEGER_NETWORK_SOCKET_RECEIVE_BUFFER_SIZE,
+				INTEGER_NETWORK_GROUP_ENCRYPTION_THREADS,
+				INTEGER_NETWORK_DECRYPTION_THREADS,
+				INTEGER_BACKGROUND_TASK_THREADS,
 				FILEPATH_DATABASE,
 				FILEPATH_LEGACY_CLIENT_CONFIGURATION,
 				FILEPATH_LEGACY_CONTACTS_DATABASE,
@@ -71,6 +79,7 @@ namespace openmittsu {
 			virtual bool getOptionAsBool(Options const& option) const;
 			virtual QString getOptionAsQString(Options const& option) const;
 			virtual QByteArray getOptionAsQByteArray(Options const& option) const;
+			virtual int getOptionAsInt(Options const& option) const;
 
 			virtual void setOption(Options const& option, QVariant const& value);
 
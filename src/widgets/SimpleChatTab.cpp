@@ -18,6 +18,7 @@
 #include "src/utility/QObjectConnectionMacro.h"
 
 #include "src/protocol/TextLengthLimiter.h"
+#include "src/tasks/TaskExecutor.h"
 
 #include "ui_simplechattab.h"
 
@@ -172,9 +173,7 @@ namespace openmittsu {
 				openmittsu::tasks::FileDownloaderCallbackTask* fileDownloaderCallbackTask = new openmittsu::tasks::FileDownloaderCallbackTask(QUrl(urlString));
 				OPENMITTSU_CONNECT(fileDownloaderCallbackTask, finished(openmittsu::tasks::CallbackTask*), this, fileDownloaderCallbackTaskFinished(openmittsu::tasks::CallbackTask*));
 
-				if (!QMetaObject::invokeMethod(fileDownloaderCallbackTask, "start", Qt::QueuedConnection)) {
-					throw openmittsu::exceptions::InternalErrorException() << "Could not invoke method start in " << __FILE__ << "  at line " << __LINE__ << ".";
-				}
+				openmittsu::tasks::TaskExecutor::globalInstance()->submit(fileDownloaderCallbackTask);
 			}
 		}
 
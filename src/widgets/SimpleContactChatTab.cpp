@@ -68,16 +68,16 @@ namespace openmittsu {
 					LOGGER()->warn("Can not create audio message item in GUI, not supported yet.");
 					break;
 				case openmittsu::dataproviders::messages::ContactMessageType::IMAGE:
-					this->addChatWidgetItem(new ContactImageChatWidgetItem(m_contact.getMessageByUuid(uuid)));
+					this->addChatWidgetItem(new ContactImageChatWidgetItem(message));
 					break;
 				case openmittsu::dataproviders::messages::ContactMessageType::LOCATION:
-					this->addChatWidgetItem(new ContactLocationChatWidgetItem(m_contact.getMessageByUuid(uuid)));
+					this->addChatWidgetItem(new ContactLocationChatWidgetItem(message));
 					break;
 				case openmittsu::dataproviders::messages::ContactMessageType::POLL:
 					LOGGER()->warn("Can not create poll message item in GUI, not supported yet.");
 					break;
 				case openmittsu::dataproviders::messages::ContactMessageType::TEXT:
-					this->addChatWidgetItem(new ContactTextChatWidgetItem(m_contact.getMessageByUuid(uuid)));
+					this->addChatWidgetItem(new ContactTextChatWidgetItem(message));
 					break;
 				case openmittsu::dataproviders::messages::ContactMessageType::VIDEO:
 					LOGGER()->warn("Can not create video message item in GUI, not supported yet.");
@@ -67,28 +67,28 @@ namespace openmittsu {
 					LOGGER()->warn("Can not create audio message item in GUI, not supported yet.");
 					break;
 				case openmittsu::dataproviders::messages::GroupMessageType::GROUP_CREATION:
-					this->addChatWidgetItem(new GroupStatusChatWidgetItem(m_group.getMessageByUuid(uuid)));
+					this->addChatWidgetItem(new GroupStatusChatWidgetItem(message));
 					break;
 				case openmittsu::dataproviders::messages::GroupMessageType::IMAGE:
-					this->addChatWidgetItem(new GroupImageChatWidgetItem(m_group.getMessageByUuid(uuid)));
+					this->addChatWidgetItem(new GroupImageChatWidgetItem(message));
 					break;
 				case openmittsu::dataproviders::messages::GroupMessageType::LOCATION:
-					this->addChatWidgetItem(new GroupLocationChatWidgetItem(m_group.getMessageByUuid(uuid)));
+					this->addChatWidgetItem(new GroupLocationChatWidgetItem(message));
 					break;
 				case openmittsu::dataproviders::messages::GroupMessageType::POLL:
 					LOGGER()->warn("Can not create poll message item in GUI, not supported yet.");
 					break;
 				case openmittsu::dataproviders::messages::GroupMessageType::SET_IMAGE:
-					this->addChatWidgetItem(new GroupStatusChatWidgetItem(m_group.getMessageByUuid(uuid)));
+					this->addChatWidgetItem(new GroupStatusChatWidgetItem(message));
 					break;
 				case openmittsu::dataproviders::messages::GroupMessageType::SET_TITLE:
-					this->addChatWidgetItem(new GroupStatusChatWidgetItem(m_group.getMessageByUuid(uuid)));
+					this->addChatWidgetItem(new GroupStatusChatWidgetItem(message));
 					break;
 				case openmittsu::dataproviders::messages::GroupMessageType::SYNC_REQUEST:
-					this->addChatWidgetItem(new GroupStatusChatWidgetItem(m_group.getMessageByUuid(uuid)));
+					this->addChatWidgetItem(new GroupStatusChatWidgetItem(message));
 					break;
 				case openmittsu::dataproviders::messages::GroupMessageType::TEXT:
-					this->addChatWidgetItem(new GroupTextChatWidgetItem(m_group.getMessageByUuid(uuid)));
+					this->addChatWidgetItem(new GroupTextChatWidgetItem(message));
 					break;
 				case openmittsu::dataproviders::messages::GroupMessageType::VIDEO:
 					LOGGER()->warn("Can not create video message item in GUI, not supported yet.");
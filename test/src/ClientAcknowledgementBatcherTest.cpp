@@ -0,0 +1,32 @@
+#include "gtest/gtest.h"
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+#include "src/network/ClientAcknowledgementBatcher.h"
+#include "src/protocol/ClientAcknowledgement.h"
+#include "src/protocol/ContactId.h"
+#include "src/protocol/MessageId.h"
+
+TEST(ClientAcknowledgementBatcherTest, KeepsOrderAndDropsDuplicates) {
+	openmittsu::protocol::ContactId const sender(QStringLiteral("ECHOECHO"));
+	openmittsu::protocol::MessageId const first(static_cast<quint64>(1));
+	openmittsu::protocol::MessageId const second(static_cast<quint64>(2));
+
+	openmittsu::network::ClientAcknowledgementBatcher batcher;
+	EXPECT_TRUE(batcher.isEmpty());
+	EXPECT_TRUE(batcher.add(sender, second));
+	EXPECT_TRUE(batcher.add(sender, first));
+	EXPECT_FALSE(batcher.add(sender, second));
+	EXPECT_EQ(2, batcher.size());
+
+	QList<QByteArray> const packets = batcher.takePackets();
+	ASSERT_EQ(2, packets.size());
+	EXPECT_EQ(openmittsu::protocol::ClientAcknowledgement(sender, second).toPacket(), packets.at(0));
+	EXPECT_EQ(openmittsu::protocol::ClientAcknowledgement(sender, first).toPacket(), packets.at(1));
+	EXPECT_TRUE(batcher.isEmpty());
+
+	// A new batch may acknowledge the same message again.
+	EXPECT_TRUE(batcher.add(sender, second));
+}
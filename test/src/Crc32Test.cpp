@@ -0,0 +1,31 @@
+#include "gtest/gtest.h"
+
+#include <QByteArray>
+
+#include "src/crypto/Crc32.h"
+
+TEST(Crc32Test, MatchesReferenceValue) {
+	QByteArray const data("123456789");
+	EXPECT_EQ(0xCBF43926u, openmittsu::crypto::Crc32::checksum(data));
+	EXPECT_EQ(0xCBF43926u, openmittsu::crypto::Crc32::checksum(data, openmittsu::crypto::Crc32::Implementation::BYTEWISE));
+	EXPECT_EQ(0u, openmittsu::crypto::Crc32::checksum(QByteArray()));
+}
+
+TEST(Crc32Test, AllImplementationsAgree) {
+	QByteArray buffer(1024 + 3, 0x00);
+	for (int i = 0; i < buffer.size(); ++i) {
+		buffer[i] = static_cast<char>((i * 131) ^ (i >> 3));
+	}
+
+	// Covers the tails of every implementation and unaligned starts.
+	for (int offset = 0; offset < 3; ++offset) {
+		for (int length = 0; length <= 1024; length += ((length < 160) ? 1 : 37)) {
+			QByteArray const data = buffer.mid(offset, length);
+			uint32_t const expected = openmittsu::crypto::Crc32::checksum(data, openmittsu::crypto::Crc32::Implementation::BYTEWISE);
+			EXPECT_EQ(expected, openmittsu::crypto::Crc32::checksum(data, openmittsu::crypto::Crc32::Implementation::SLICING_BY_8)) << "Length " << length << ", offset " << offset;
+			if (openmittsu::crypto::Crc32::isHardwareAccelerationAvailable()) {
+				EXPECT_EQ(expected, openmittsu::crypto::Crc32::checksum(data, openmittsu::crypto::Crc32::Implementation::HARDWARE)) << "Length " << length << ", offset " << offset;
+			}
+		}
+	}
+}
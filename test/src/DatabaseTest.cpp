@@ -3,6 +3,9 @@
 #include <QString>
 #include <QSet>
 #include <QList>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QStringList>
 #include <QVariant>
 
 #include "exceptions/InternalErrorException.h"
@@ -598,3 +601,225 @@ TEST_F(DatabaseTestFramework, settings) {
 	ASSERT_EQ(optionValueB, optionValueAfterSaveB);
 	ASSERT_EQ(optionValueC, optionValueAfterSaveC);
 }
+
+TEST_F(DatabaseTestFramework, pendingMessages) {
+	QString const waitingForA(QStringLiteral("identity/contact/AAAAAAAA"));
+	QString const waitingForB(QStringLiteral("identity/contact/BBBBBBBB"));
+	QByteArray const messageA1("first message", 13);
+	QByteArray const messageA2(QByteArray(1000, '\0'));
+	QByteArray const messageB("other message", 13);
+
+	ASSERT_TRUE(db->getPendingMessages(waitingForA).isEmpty());
+	ASSERT_NO_THROW(db->storePendingMessage(waitingForA, messageA1));
+	ASSERT_NO_THROW(db->storePendingMessage(waitingForB, messageB));
+	ASSERT_NO_THROW(db->storePendingMessage(waitingForA, messageA2));
+
+	QList<QByteArray> const pendingA = db->getPendingMessages(waitingForA);
+	ASSERT_EQ(2, pendingA.size());
+	ASSERT_EQ(messageA1, pendingA.at(0));
+	ASSERT_EQ(messageA2, pendingA.at(1));
+	ASSERT_EQ(pendingA, db->getPendingMessages(waitingForA));
+	ASSERT_NO_THROW(db->removePendingMessages(waitingForA));
+	ASSERT_TRUE(db->getPendingMessages(waitingForA).isEmpty());
+	ASSERT_EQ(1, db->getPendingMessages(waitingForB).size());
+
+	ASSERT_NO_THROW(db->removePendingMessages(waitingForB));
+	ASSERT_TRUE(db->getPendingMessages(waitingForB).isEmpty());
+}
+
+TEST_F(DatabaseTestFramework, preparedStatementCache) {
+	QString const optionName = QStringLiteral("cachedOption");
+	ASSERT_NO_THROW(db->setOptionValue(optionName, QStringLiteral("first")));
+	ASSERT_EQ(QStringLiteral("first"), db->getOptionValueAsString(optionName));
+
+	quint64 const hitsBefore = db->getStatementCache().getHitCount();
+	quint64 const missesBefore = db->getStatementCache().getMissCount();
+	for (int i = 0; i < 10; ++i) {
+		ASSERT_TRUE(db->hasOption(optionName));
+		ASSERT_EQ(QStringLiteral("first"), db->getOptionValueAsString(optionName));
+	}
+	ASSERT_EQ(missesBefore, db->getStatementCache().getMissCount());
+	ASSERT_LE(hitsBefore + 10, db->getStatementCache().getHitCount());
+
+	// Values bound by an earlier use must not leak into the next one.
+	ASSERT_FALSE(db->hasOption(QStringLiteral("otherOption")));
+}
+
+TEST_F(DatabaseTestFramework, messagesByUuid) {
+	openmittsu::protocol::ContactId contactIdB(QStringLiteral("BBBBBBBB"));
+	ASSERT_NO_THROW(db->storeNewContact(contactIdB, openmittsu::crypto::KeyPair::randomKey()));
+	openmittsu::protocol::ContactId contactIdC(QStringLiteral("CCCCCCCC"));
+	ASSERT_NO_THROW(db->storeNewContact(contactIdC, openmittsu::crypto::KeyPair::randomKey()));
+
+	openmittsu::protocol::MessageId messageA(0);
+	openmittsu::protocol::MessageId messageB(0);
+	openmittsu::protocol::MessageId messageC(0);
+	ASSERT_NO_THROW(messageA = db->storeSentContactMessageText(contactIdB, openmittsu::protocol::MessageTime::fromDatabase(1000), true, QStringLiteral("TestMessageA")));
+	this->addMessageId(messageA);
+	ASSERT_NO_THROW(messageB = db->storeSentContactMessageText(contactIdB, openmittsu::protocol::MessageTime::fromDatabase(2000), true, QStringLiteral("TestMessageB")));
+	this->addMessageId(messageB);
+	ASSERT_NO_THROW(messageC = db->storeSentContactMessageText(contactIdC, openmittsu::protocol::MessageTime::fromDatabase(3000), true, QStringLiteral("TestMessageC")));
+	this->addMessageId(messageC);
+
+	openmittsu::database::DatabaseContactMessageCursor cursorB = db->getMessageCursor(contactIdB);
+	openmittsu::database::DatabaseContactMessageCursor cursorC = db->getMessageCursor(contactIdC);
+	ASSERT_TRUE(cursorB.seek(messageA));
+	QString const uuidA = cursorB.getMessage()->getUid();
+	ASSERT_TRUE(cursorB.seek(messageB));
+	QString const uuidB = cursorB.getMessage()->getUid();
+	ASSERT_TRUE(cursorC.seek(messageC));
+	QString const uuidC = cursorC.getMessage()->getUid();
+
+	// Requested order is kept, messages of other contacts and unknown UUIDs are skipped.
+	auto const messages = cursorB.getMessagesByUuid({ uuidB, uuidC, QStringLiteral("unknown"), uuidA });
+	ASSERT_EQ(2, messages.size());
+	ASSERT_EQ(messageB, messages.at(0)->getMessageId());
+	ASSERT_EQ(QStringLiteral("TestMessageB"), messages.at(0)->getContentAsText());
+	ASSERT_EQ(messageA, messages.at(1)->getMessageId());
+	ASSERT_EQ(openmittsu::protocol::MessageTime::fromDatabase(1000).getMessageTime(), messages.at(1)->getCreatedAt().getMessageTime());
+	ASSERT_TRUE(messages.at(1)->isQueued());
+
+	// Changes made through another object become visible after a refresh.
+	cursorB.getMessage()->setIsQueued(false);
+	ASSERT_TRUE(cursorB.getMessage()->getMessageId() == messageB);
+	ASSERT_TRUE(messages.at(0)->isQueued());
+	messages.at(0)->refresh();
+	ASSERT_FALSE(messages.at(0)->isQueued());
+}
+
+TEST_F(DatabaseTestFramework, messagePages) {
+	openmittsu::protocol::ContactId contactIdB(QStringLiteral("BBBBBBBB"));
+	ASSERT_NO_THROW(db->storeNewContact(contactIdB, openmittsu::crypto::KeyPair::randomKey()));
+
+	// Two messages share a timestamp, so paging has to continue on the uid.
+	QList<qint64> const times({ 1000, 2000, 2000, 3000, 4000 });
+	for (int i = 0; i < times.size(); ++i) {
+		openmittsu::protocol::MessageId messageId(0);
+		ASSERT_NO_THROW(messageId = db->storeSentContactMessageText(contactIdB, openmittsu::protocol::MessageTime::fromDatabase(times.at(i)), true, QStringLiteral("Message%1").arg(i)));
+		this->addMessageId(messageId);
+	}
+
+	QVector<QString> const newestFirst = db->getMessageCursor(contactIdB).getLastMessages(5);
+	ASSERT_EQ(5, newestFirst.size());
+
+	openmittsu::database::DatabaseContactMessageCursor cursor = db->getMessageCursor(contactIdB);
+	auto const newestPage = cursor.previousPage(2);
+	ASSERT_EQ(2, newestPage.size());
+	ASSERT_EQ(newestFirst.at(1), newestPage.at(0)->getUid());
+	ASSERT_EQ(newestFirst.at(0), newestPage.at(1)->getUid());
+	ASSERT_TRUE(cursor.isValid());
+	ASSERT_EQ(newestPage.at(0)->getMessageId(), cursor.getMessageId());
+
+	auto const middlePage = cursor.previousPage(2);
+	ASSERT_EQ(2, middlePage.size());
+	ASSERT_EQ(newestFirst.at(3), middlePage.at(0)->getUid());
+	ASSERT_EQ(newestFirst.at(2), middlePage.at(1)->getUid());
+
+	auto const oldestPage = cursor.previousPage(2);
+	ASSERT_EQ(1, oldestPage.size());
+	ASSERT_EQ(newestFirst.at(4), oldestPage.at(0)->getUid());
+	ASSERT_TRUE(cursor.previousPage(2).isEmpty());
+
+	// Forward again from the oldest message.
+	auto const forwardPage = cursor.nextPage(3);
+	ASSERT_EQ(3, forwardPage.size());
+	ASSERT_EQ(newestFirst.at(3), forwardPage.at(0)->getUid());
+	ASSERT_EQ(newestFirst.at(1), forwardPage.at(2)->getUid());
+	ASSERT_TRUE(cursor.next());
+	ASSERT_EQ(newestFirst.at(0), cursor.getMessage()->getUid());
+	ASSERT_FALSE(cursor.next());
+}
+
+TEST_F(DatabaseTestFramework, writeBatching) {
+	openmittsu::protocol::ContactId contactIdB(QStringLiteral("BBBBBBBB"));
+	ASSERT_NO_THROW(db->storeNewContact(contactIdB, openmittsu::crypto::KeyPair::randomKey()));
+
+	int announced = 0;
+	QObject::connect(db.get(), &openmittsu::dataproviders::MessageStorage::receivedNewContactMessage, [&announced](openmittsu::protocol::ContactId const&) { ++announced; });
+
+	for (int i = 0; i < 3; ++i) {
+		openmittsu::protocol::MessageId const messageId = this->getFreeMessageId();
+		ASSERT_NO_THROW(db->storeReceivedContactMessageText(contactIdB, messageId, openmittsu::protocol::MessageTime::fromDatabase(1000 + i), openmittsu::protocol::MessageTime::fromDatabase(2000 + i), QStringLiteral("TestMessage")));
+	}
+
+	// Readable on the same connection before the batch is committed, announced only after.
+	ASSERT_EQ(3, db->getMessageCursor(contactIdB).getLastMessages(5).size());
+	ASSERT_EQ(0, announced);
+	db->commitWriteBatch();
+	ASSERT_EQ(3, announced);
+	ASSERT_EQ(3, db->getMessageCursor(contactIdB).getLastMessages(5).size());
+
+	db->commitWriteBatch();
+	ASSERT_EQ(3, announced);
+
+	// Acknowledgements wait for the commit as well, without an open batch they run right away.
+	int committed = 0;
+	int rolledBack = 0;
+	ASSERT_NO_THROW(db->storeReceivedContactMessageText(contactIdB, this->getFreeMessageId(), openmittsu::protocol::MessageTime::fromDatabase(1003), openmittsu::protocol::MessageTime::fromDatabase(2003), QStringLiteral("TestMessage")));
+	db->runAfterCommit([&committed]() { ++committed; }, [&rolledBack]() { ++rolledBack; });
+	ASSERT_EQ(0, committed);
+	db->commitWriteBatch();
+	ASSERT_EQ(1, committed);
+	db->runAfterCommit([&committed]() { ++committed; }, [&rolledBack]() { ++rolledBack; });
+	ASSERT_EQ(2, committed);
+	ASSERT_EQ(0, rolledBack);
+}
+
+namespace {
+	// A second connection to the database file, next to the one of the Database under test.
+	QSqlDatabase openRawConnection(QString const& filename, QString const& password) {
+		bool const isCrypto = QSqlDatabase::isDriverAvailable(QStringLiteral("QSQLCIPHER"));
+		QSqlDatabase database = QSqlDatabase::addDatabase(isCrypto ? QStringLiteral("QSQLCIPHER") : QStringLiteral("QSQLITE"), QStringLiteral("rawTestConnection"));
+		database.setDatabaseName(filename);
+		if (database.open() && isCrypto) {
+			QSqlQuery query(database);
+			query.exec(QStringLiteral("PRAGMA key = '%1';").arg(password));
+		}
+		return database;
+	}
+}
+
+TEST_F(DatabaseTestFramework, upgradeTablesToVersion2) {
+	QStringList const upgradedTables({ QStringLiteral("contact_messages"), QStringLiteral("control_messages"), QStringLiteral("group_messages") });
+	QStringList const indexes({ QStringLiteral("contact_messages_by_identity"), QStringLiteral("contact_messages_unsent_outbox"), QStringLiteral("control_messages_unsent_outbox"), QStringLiteral("group_messages_by_group"), QStringLiteral("group_messages_unsent_outbox") });
+	int const contactCount = db->getContactCount();
+	db = nullptr;
+
+	// Turn the new database back into one written before the indexes were added.
+	{
+		QSqlDatabase database = openRawConnection(databaseFilename, QStringLiteral("AAAAAAAA"));
+		ASSERT_TRUE(database.isOpen());
+		QSqlQuery query(database);
+		for (QString const& index : indexes) {
+			ASSERT_TRUE(query.exec(QStringLiteral("DROP INDEX `%1`").arg(index)));
+		}
+		for (QString const& table : upgradedTables) {
+			ASSERT_TRUE(query.exec(QStringLiteral("UPDATE `table_versions` SET `version` = 1 WHERE `table_name` = '%1'").arg(table)));
+		}
+		query.finish();
+		database.close();
+	}
+	QSqlDatabase::removeDatabase(QStringLiteral("rawTestConnection"));
+
+	ASSERT_NO_THROW(db = std::make_shared<openmittsu::database::Database>(databaseFilename, QStringLiteral("AAAAAAAA"), tempMediaStorageLocation));
+	ASSERT_EQ(contactCount, db->getContactCount());
+	db = nullptr;
+
+	{
+		QSqlDatabase database = openRawConnection(databaseFilename, QStringLiteral("AAAAAAAA"));
+		ASSERT_TRUE(database.isOpen());
+		QSqlQuery query(database);
+		for (QString const& table : upgradedTables) {
+			ASSERT_TRUE(query.exec(QStringLiteral("SELECT `version` FROM `table_versions` WHERE `table_name` = '%1'").arg(table)));
+			ASSERT_TRUE(query.next());
+			ASSERT_EQ(2, query.value(0).toInt());
+		}
+		for (QString const& index : indexes) {
+			ASSERT_TRUE(query.exec(QStringLiteral("SELECT `name` FROM `sqlite_master` WHERE `type` = 'index' AND `name` = '%1'").arg(index)));
+			ASSERT_TRUE(query.next());
+		}
+		query.finish();
+		database.close();
+	}
+	QSqlDatabase::removeDatabase(QStringLiteral("rawTestConnection"));
+}
@@ -0,0 +1,57 @@
+#include "gtest/gtest.h"
+
+#include <QString>
+
+#include "src/utility/DeadlineQueue.h"
+
+TEST(DeadlineQueueTest, ExpiresEntriesInDeadlineOrder) {
+	openmittsu::utility::DeadlineQueue<int, QString> queue;
+	queue.insert(1, QStringLiteral("late"), 300);
+	queue.insert(2, QStringLiteral("early"), 100);
+	queue.insert(3, QStringLiteral("middle"), 200);
+	EXPECT_EQ(100, queue.getNextDeadline());
+
+	EXPECT_TRUE(queue.takeExpired(99).empty());
+
+	auto const expired = queue.takeExpired(200);
+	ASSERT_EQ(2u, expired.size());
+	EXPECT_EQ(2, expired.at(0).first);
+	EXPECT_EQ(QStringLiteral("early"), expired.at(0).second);
+	EXPECT_EQ(3, expired.at(1).first);
+
+	EXPECT_EQ(1, queue.size());
+	EXPECT_EQ(300, queue.getNextDeadline());
+}
+
+TEST(DeadlineQueueTest, RemovedAndReplacedEntriesDoNotExpire) {
+	openmittsu::utility::DeadlineQueue<int, QString> queue;
+	queue.insert(1, QStringLiteral("removed"), 100);
+	queue.insert(2, QStringLiteral("rescheduled"), 100);
+	queue.insert(2, QStringLiteral("rescheduled"), 500);
+	ASSERT_TRUE(queue.remove(1));
+	EXPECT_FALSE(queue.remove(1));
+
+	EXPECT_EQ(500, queue.getNextDeadline());
+	EXPECT_TRUE(queue.takeExpired(499).empty());
+
+	QString value;
+	ASSERT_TRUE(queue.get(2, value));
+	EXPECT_EQ(QStringLiteral("rescheduled"), value);
+
+	EXPECT_EQ(1u, queue.takeExpired(500).size());
+	EXPECT_TRUE(queue.isEmpty());
+	EXPECT_EQ(-1, queue.getNextDeadline());
+}
+
+TEST(DeadlineQueueTest, CompactsStaleHeapEntries) {
+	openmittsu::utility::DeadlineQueue<int, int> queue;
+	for (int i = 0; i < 10000; ++i) {
+		queue.insert(i, i, 1000 + i);
+		queue.remove(i);
+	}
+	queue.insert(42, 42, 5);
+
+	auto const expired = queue.takeExpired(100000);
+	ASSERT_EQ(1u, expired.size());
+	EXPECT_EQ(42, expired.at(0).first);
+}
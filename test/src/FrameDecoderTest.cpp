@@ -0,0 +1,89 @@
+#include "gtest/gtest.h"
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QList>
+
+#include "src/network/FrameDecoder.h"
+
+namespace {
+	QByteArray makeFrame(QByteArray const& packet) {
+		QByteArray result;
+		result.append(static_cast<char>(packet.size() & 0xFF));
+		result.append(static_cast<char>((packet.size() >> 8) & 0xFF));
+		result.append(packet);
+		return result;
+	}
+}
+
+TEST(FrameDecoderTest, DecodesAllCompleteFramesInOnePass) {
+	openmittsu::network::FrameDecoder decoder(16);
+	QByteArray const packetA("first");
+	QByteArray const packetB(300, 'b');
+	QByteArray const packetC("third");
+
+	QByteArray const stream = makeFrame(packetA) + makeFrame(packetB) + makeFrame(packetC);
+	// Only deliver a partial last frame
+	decoder.append(stream.left(stream.size() - 2));
+
+	QByteArray frame;
+	ASSERT_TRUE(decoder.nextFrame(frame));
+	ASSERT_EQ(packetA, frame);
+	ASSERT_TRUE(decoder.nextFrame(frame));
+	ASSERT_EQ(packetB, frame);
+	ASSERT_FALSE(decoder.nextFrame(frame));
+
+	decoder.append(stream.right(2));
+	ASSERT_TRUE(decoder.nextFrame(frame));
+	ASSERT_EQ(packetC, frame);
+	ASSERT_FALSE(decoder.nextFrame(frame));
+	ASSERT_EQ(0, decoder.getBufferedBytesCount());
+}
+
+TEST(FrameDecoderTest, HandlesFramesWrappingAroundTheBuffer) {
+	openmittsu::network::FrameDecoder decoder(64);
+	int const initialCapacity = decoder.getCapacity();
+
+	QList<QByteArray> packets;
+	QByteArray stream;
+	for (int i = 0; i < 100; ++i) {
+		QByteArray const packet(11 + (i % 7), static_cast<char>('a' + (i % 26)));
+		packets.append(packet);
+		stream.append(makeFrame(packet));
+	}
+
+	// Feed the stream in small chunks so that partial frames remain buffered and the read position moves around the ring
+	int decodedPackets = 0;
+	QByteArray frame;
+	for (int offset = 0; offset < stream.size(); offset += 7) {
+		decoder.append(stream.mid(offset, 7));
+		while (decoder.nextFrame(frame)) {
+			ASSERT_EQ(packets.at(decodedPackets), frame);
+			++decodedPackets;
+		}
+	}
+
+	ASSERT_EQ(packets.size(), decodedPackets);
+	ASSERT_EQ(0, decoder.getBufferedBytesCount());
+	// The ring never holds more than one partial frame and one chunk, so it never needs to grow
+	ASSERT_EQ(initialCapacity, decoder.getCapacity());
+}
+
+TEST(FrameDecoderTest, ReadsFromDevice) {
+	QByteArray const packetA(5000, 'x');
+	QByteArray const packetB("y");
+	QByteArray data = makeFrame(packetA) + makeFrame(packetB);
+
+	QBuffer buffer(&data);
+	ASSERT_TRUE(buffer.open(QIODevice::ReadOnly));
+
+	openmittsu::network::FrameDecoder decoder(128);
+	ASSERT_EQ(data.size(), decoder.readFrom(&buffer));
+
+	QByteArray frame;
+	ASSERT_TRUE(decoder.nextFrame(frame));
+	ASSERT_EQ(packetA, frame);
+	ASSERT_TRUE(decoder.nextFrame(frame));
+	ASSERT_EQ(packetB, frame);
+	ASSERT_FALSE(decoder.nextFrame(frame));
+}
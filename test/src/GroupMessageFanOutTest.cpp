@@ -0,0 +1,66 @@
+#include "gtest/gtest.h"
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QThread>
+
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "src/crypto/FullCryptoBox.h"
+#include "src/dataproviders/KeyRegistry.h"
+#include "src/messages/FullMessageHeader.h"
+#include "src/messages/MessageFlags.h"
+#include "src/messages/MessageWithEncryptedPayload.h"
+#include "src/network/GroupMessageFanOut.h"
+#include "src/protocol/MessageTime.h"
+#include "src/protocol/PushFromId.h"
+
+#include "DatabaseTestFramework.h"
+
+TEST_F(DatabaseTestFramework, groupMessageFanOut) {
+	openmittsu::protocol::MessageId const messageId = this->getFreeMessageId();
+	openmittsu::protocol::MessageTime const messageTime = openmittsu::protocol::MessageTime::now();
+
+	// Enough copies to be split into several chunks, one of them for an unknown contact that can not be encrypted.
+	std::vector<openmittsu::messages::FullMessageHeader> headers;
+	int const failingIndex = 10;
+	for (int i = 0; i < 24; ++i) {
+		openmittsu::protocol::ContactId const receiver((i == failingIndex) ? QStringLiteral("ZZZZZZZZ") : QStringLiteral("M%1").arg(i, 7, 10, QChar('0')));
+		if (i != failingIndex) {
+			ASSERT_NO_THROW(db->storeNewContact(receiver, openmittsu::crypto::KeyPair::randomKey()));
+		}
+		headers.push_back(openmittsu::messages::FullMessageHeader(receiver, messageTime, selfContactId, messageId, openmittsu::messages::MessageFlags(), openmittsu::protocol::PushFromId(selfContactId)));
+	}
+
+	openmittsu::dataproviders::KeyRegistry const keyRegistry(openmittsu::crypto::KeyPair::randomKey(), db);
+	std::shared_ptr<openmittsu::crypto::FullCryptoBox> const cryptoBox = std::make_shared<openmittsu::crypto::FullCryptoBox>(keyRegistry);
+	openmittsu::network::GroupMessageFanOut fanOut(cryptoBox, 4);
+	fanOut.submit(headers, QByteArray("Hello group!"), nullptr);
+
+	std::list<std::shared_ptr<openmittsu::network::GroupMessageFanOut::FanOut>> completed;
+	QElapsedTimer timer;
+	timer.start();
+	while (completed.empty() && (timer.elapsed() < 10000)) {
+		completed = fanOut.takeCompletedFanOuts();
+		if (completed.empty()) {
+			QThread::msleep(1);
+		}
+	}
+	ASSERT_EQ(1u, completed.size());
+	ASSERT_FALSE(fanOut.hasPendingFanOuts());
+
+	// Copies are in the order of their headers, the failed one is left empty.
+	std::shared_ptr<openmittsu::network::GroupMessageFanOut::FanOut> const result = completed.front();
+	ASSERT_EQ(headers.size(), result->packets.size());
+	for (std::size_t i = 0; i < headers.size(); ++i) {
+		if (static_cast<int>(i) == failingIndex) {
+			ASSERT_TRUE(result->packets.at(i).isEmpty());
+		} else {
+			openmittsu::messages::MessageWithEncryptedPayload const message(openmittsu::messages::MessageWithEncryptedPayload::fromPacket(result->packets.at(i)));
+			ASSERT_EQ(headers.at(i).getReceiver(), message.getMessageHeader().getReceiver());
+			ASSERT_EQ(messageId, message.getMessageHeader().getMessageId());
+		}
+	}
+}
@@ -0,0 +1,63 @@
+#include "gtest/gtest.h"
+
+#include <QSet>
+#include <QString>
+
+#include "src/network/IdentityResolver.h"
+#include "src/protocol/ContactId.h"
+
+TEST(IdentityResolverTest, CoalescesRequestsIntoBatches) {
+	openmittsu::protocol::ContactId const first(QStringLiteral("AAAAAAAA"));
+	openmittsu::protocol::ContactId const second(QStringLiteral("BBBBBBBB"));
+	openmittsu::protocol::ContactId const third(QStringLiteral("CCCCCCCC"));
+
+	openmittsu::network::IdentityResolver resolver(1000, 2);
+	EXPECT_FALSE(resolver.hasPendingRequests());
+	EXPECT_TRUE(resolver.request(first, 0));
+	EXPECT_TRUE(resolver.request(second, 0));
+	EXPECT_TRUE(resolver.request(first, 0));
+	EXPECT_TRUE(resolver.request(third, 0));
+
+	QSet<openmittsu::protocol::ContactId> const batch = resolver.takeBatch();
+	EXPECT_EQ(QSet<openmittsu::protocol::ContactId>({ first, second }), batch);
+	EXPECT_EQ(2, resolver.getInFlightCount());
+
+	// Already being looked up, so not requested a second time.
+	EXPECT_TRUE(resolver.request(second, 0));
+	EXPECT_EQ(QSet<openmittsu::protocol::ContactId>({ third }), resolver.takeBatch());
+	EXPECT_FALSE(resolver.hasPendingRequests());
+
+	resolver.resolved(first);
+	EXPECT_EQ(2, resolver.getInFlightCount());
+}
+
+TEST(IdentityResolverTest, RemembersFailuresForTheTtl) {
+	openmittsu::protocol::ContactId const contact(QStringLiteral("AAAAAAAA"));
+
+	openmittsu::network::IdentityResolver resolver(1000, 10);
+	EXPECT_TRUE(resolver.request(contact, 0));
+	resolver.takeBatch();
+	resolver.failed(contact, 100);
+
+	EXPECT_TRUE(resolver.hasFailedRecently(contact, 500));
+	EXPECT_FALSE(resolver.request(contact, 500));
+	EXPECT_FALSE(resolver.hasPendingRequests());
+
+	EXPECT_FALSE(resolver.hasFailedRecently(contact, 1100));
+	EXPECT_TRUE(resolver.request(contact, 1100));
+	EXPECT_TRUE(resolver.hasPendingRequests());
+}
+
+TEST(IdentityResolverTest, RetriesWithoutNegativeCaching) {
+	openmittsu::protocol::ContactId const contact(QStringLiteral("AAAAAAAA"));
+
+	openmittsu::network::IdentityResolver resolver(1000, 10);
+	EXPECT_TRUE(resolver.request(contact, 0));
+	resolver.takeBatch();
+	resolver.retry(contact);
+
+	EXPECT_FALSE(resolver.hasFailedRecently(contact, 100));
+	EXPECT_EQ(0, resolver.getInFlightCount());
+	EXPECT_TRUE(resolver.request(contact, 100));
+	EXPECT_EQ(QSet<openmittsu::protocol::ContactId>({ contact }), resolver.takeBatch());
+}
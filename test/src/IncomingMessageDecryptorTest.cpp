@@ -0,0 +1,74 @@
+#include "gtest/gtest.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QThread>
+
+#include <list>
+#include <memory>
+
+#include "src/crypto/FullCryptoBox.h"
+#include "src/crypto/Nonce.h"
+#include "src/crypto/PrecomputedSharedKey.h"
+#include "src/dataproviders/KeyRegistry.h"
+#include "src/encoding/Pkcs7.h"
+#include "src/messages/FullMessageHeader.h"
+#include "src/messages/MessageFlags.h"
+#include "src/messages/MessageWithEncryptedPayload.h"
+#include "src/network/IncomingMessageDecryptor.h"
+#include "src/protocol/MessageTime.h"
+#include "src/protocol/ProtocolSpecs.h"
+#include "src/protocol/PushFromId.h"
+
+#include "DatabaseTestFramework.h"
+
+TEST_F(DatabaseTestFramework, incomingMessageDecryptorKeepsSenderOrder) {
+	QList<openmittsu::protocol::ContactId> const senders({ openmittsu::protocol::ContactId(QStringLiteral("BBBBBBBB")), openmittsu::protocol::ContactId(QStringLiteral("CCCCCCCC")) });
+	QHash<openmittsu::protocol::ContactId, std::shared_ptr<openmittsu::crypto::PrecomputedSharedKey>> sharedKeys;
+	for (openmittsu::protocol::ContactId const& sender : senders) {
+		openmittsu::crypto::KeyPair const senderKeyPair = openmittsu::crypto::KeyPair::randomKey();
+		ASSERT_NO_THROW(db->storeNewContact(sender, senderKeyPair));
+		sharedKeys.insert(sender, std::make_shared<openmittsu::crypto::PrecomputedSharedKey>(selfKeyPair, senderKeyPair));
+	}
+
+	openmittsu::dataproviders::KeyRegistry const keyRegistry(openmittsu::crypto::KeyPair::randomKey(), db);
+	std::shared_ptr<openmittsu::crypto::FullCryptoBox> const cryptoBox = std::make_shared<openmittsu::crypto::FullCryptoBox>(keyRegistry);
+	openmittsu::network::IncomingMessageDecryptor decryptor(cryptoBox, 4);
+
+	// Interleaved, so messages of the two senders run on the workers at the same time.
+	QHash<openmittsu::protocol::ContactId, QList<openmittsu::protocol::MessageId>> submitted;
+	int const messagesPerSender = 50;
+	for (int i = 0; i < messagesPerSender; ++i) {
+		for (openmittsu::protocol::ContactId const& sender : senders) {
+			openmittsu::protocol::MessageId const messageId = this->getFreeMessageId();
+			openmittsu::messages::FullMessageHeader const header(selfContactId, openmittsu::protocol::MessageTime::now(), sender, messageId, openmittsu::messages::MessageFlags(), openmittsu::protocol::PushFromId(sender));
+			QByteArray payload(1, PROTO_MESSAGE_SIGNATURE_CONTACT_TEXT);
+			payload.append(QStringLiteral("Message %1").arg(i).toUtf8());
+			openmittsu::crypto::Nonce const nonce;
+			QByteArray const encryptedPayload = sharedKeys.value(sender)->encrypt(openmittsu::encoding::Pkcs7::encodePkcs7Sequence(payload), nonce);
+
+			decryptor.submit(openmittsu::messages::MessageWithEncryptedPayload(header, nonce, encryptedPayload));
+			submitted[sender].append(messageId);
+		}
+	}
+
+	QHash<openmittsu::protocol::ContactId, QList<openmittsu::protocol::MessageId>> completed;
+	QElapsedTimer timer;
+	timer.start();
+	while (decryptor.hasPendingJobs() && (timer.elapsed() < 10000)) {
+		std::list<std::shared_ptr<openmittsu::network::IncomingMessageDecryptor::Job>> const jobs = decryptor.takeCompletedJobs();
+		for (std::shared_ptr<openmittsu::network::IncomingMessageDecryptor::Job> const& job : jobs) {
+			ASSERT_TRUE(job->result != nullptr);
+			completed[job->message.getMessageHeader().getSender()].append(job->message.getMessageHeader().getMessageId());
+		}
+		if (jobs.empty()) {
+			QThread::msleep(1);
+		}
+	}
+
+	ASSERT_FALSE(decryptor.hasPendingJobs());
+	for (openmittsu::protocol::ContactId const& sender : senders) {
+		ASSERT_EQ(submitted.value(sender), completed.value(sender));
+	}
+}
@@ -0,0 +1,41 @@
+#include "gtest/gtest.h"
+
+#include <QString>
+
+#include "src/utility/LruCache.h"
+
+TEST(LruCacheTest, EvictsLeastRecentlyUsedEntry) {
+	openmittsu::utility::LruCache<int, QString> cache(2);
+	cache.insert(1, QStringLiteral("one"));
+	cache.insert(2, QStringLiteral("two"));
+
+	QString value;
+	ASSERT_TRUE(cache.get(1, value));
+	EXPECT_EQ(QStringLiteral("one"), value);
+
+	// 2 is now the least recently used entry.
+	cache.insert(3, QStringLiteral("three"));
+	EXPECT_EQ(2, cache.size());
+	EXPECT_FALSE(cache.get(2, value));
+	EXPECT_TRUE(cache.get(1, value));
+	EXPECT_TRUE(cache.get(3, value));
+}
+
+TEST(LruCacheTest, UpdatesAndRemovesEntries) {
+	openmittsu::utility::LruCache<int, QString> cache(4);
+	cache.insert(1, QStringLiteral("one"));
+	cache.insert(1, QStringLiteral("uno"));
+	EXPECT_EQ(1, cache.size());
+
+	QString value;
+	ASSERT_TRUE(cache.get(1, value));
+	EXPECT_EQ(QStringLiteral("uno"), value);
+
+	cache.remove(1);
+	EXPECT_FALSE(cache.get(1, value));
+	EXPECT_EQ(0, cache.size());
+
+	cache.insert(2, QStringLiteral("two"));
+	cache.clear();
+	EXPECT_EQ(0, cache.size());
+}
@@ -0,0 +1,104 @@
+#include "gtest/gtest.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+#include <memory>
+
+#include "src/dataproviders/MessageQueue.h"
+#include "src/dataproviders/messages/GroupMessageType.h"
+#include "src/exceptions/IllegalArgumentException.h"
+#include "src/protocol/GroupId.h"
+#include "src/protocol/MessageTime.h"
+#include "src/utility/Location.h"
+
+#include "DatabaseTestFramework.h"
+
+using openmittsu::dataproviders::MessageQueue;
+using openmittsu::dataproviders::messages::GroupMessageType;
+
+namespace {
+	MessageQueue::ReceivedGroupMessage createGroupMessage(openmittsu::protocol::GroupId const& group, openmittsu::protocol::MessageId const& messageId, GroupMessageType messageType, QVariant const& content) {
+		return MessageQueue::ReceivedGroupMessage(group, openmittsu::protocol::ContactId(QStringLiteral("BBBBBBBB")), messageId, openmittsu::protocol::MessageTime::fromDatabase(1500000000000), openmittsu::protocol::MessageTime::fromDatabase(1500000001000), messageType, content);
+	}
+
+	void assertSameMessage(MessageQueue::ReceivedGroupMessage const& expected, MessageQueue::ReceivedGroupMessage const& actual) {
+		ASSERT_EQ(expected.group, actual.group);
+		ASSERT_EQ(expected.sender, actual.sender);
+		ASSERT_EQ(expected.messageId, actual.messageId);
+		ASSERT_EQ(expected.timeSent, actual.timeSent);
+		ASSERT_EQ(expected.timeReceived, actual.timeReceived);
+		ASSERT_EQ(expected.messageType, actual.messageType);
+	}
+}
+
+TEST(MessageQueue, serializationRoundTrip) {
+	openmittsu::protocol::GroupId const group(openmittsu::protocol::ContactId(QStringLiteral("AAAAAAAA")), 1234567890ULL);
+	openmittsu::utility::Location const location(47.5, 8.25, 400.0, QStringLiteral("Some Street 1"), QStringLiteral("Meeting point"));
+
+	MessageQueue::ReceivedGroupMessage const text = createGroupMessage(group, openmittsu::protocol::MessageId(1), GroupMessageType::TEXT, QVariant(QStringLiteral("Hello group!")));
+	MessageQueue::ReceivedGroupMessage const image = createGroupMessage(group, openmittsu::protocol::MessageId(2), GroupMessageType::IMAGE, QVariant(QByteArray(5000, '\x42')));
+	QVariant locationContent;
+	locationContent.setValue(location);
+	MessageQueue::ReceivedGroupMessage const locationMessage = createGroupMessage(group, openmittsu::protocol::MessageId(3), GroupMessageType::LOCATION, locationContent);
+	MessageQueue::ReceivedGroupMessage const leave = createGroupMessage(group, openmittsu::protocol::MessageId(4), GroupMessageType::LEAVE, QVariant());
+
+	MessageQueue::ReceivedGroupMessage result;
+	ASSERT_NO_THROW(result = MessageQueue::deserialize(MessageQueue::serialize(text)));
+	assertSameMessage(text, result);
+	ASSERT_EQ(text.content.toString(), result.content.toString());
+
+	ASSERT_NO_THROW(result = MessageQueue::deserialize(MessageQueue::serialize(image)));
+	assertSameMessage(image, result);
+	ASSERT_EQ(image.content.toByteArray(), result.content.toByteArray());
+
+	ASSERT_NO_THROW(result = MessageQueue::deserialize(MessageQueue::serialize(locationMessage)));
+	assertSameMessage(locationMessage, result);
+	ASSERT_EQ(location, result.content.value<openmittsu::utility::Location>());
+
+	ASSERT_NO_THROW(result = MessageQueue::deserialize(MessageQueue::serialize(leave)));
+	assertSameMessage(leave, result);
+
+	QByteArray const serialized = MessageQueue::serialize(text);
+	ASSERT_THROW(MessageQueue::deserialize(serialized.left(serialized.size() / 2)), openmittsu::exceptions::IllegalArgumentException);
+	ASSERT_THROW(MessageQueue::deserialize(QByteArray(1, '\x7F') + serialized.mid(1)), openmittsu::exceptions::IllegalArgumentException);
+}
+
+TEST_F(DatabaseTestFramework, messageQueueSpillsToStorage) {
+	openmittsu::protocol::GroupId const group(openmittsu::protocol::ContactId(QStringLiteral("AAAAAAAA")), 1ULL);
+	openmittsu::protocol::GroupId const otherGroup(openmittsu::protocol::ContactId(QStringLiteral("AAAAAAAA")), 2ULL);
+
+	// Room for a single message, everything after it goes to the storage.
+	MessageQueue queue(200);
+	queue.setStorage(db);
+
+	QVector<MessageQueue::ReceivedGroupMessage> expected;
+	for (int i = 0; i < 10; ++i) {
+		MessageQueue::ReceivedGroupMessage const message = createGroupMessage(group, this->getFreeMessageId(), GroupMessageType::TEXT, QVariant(QStringLiteral("Message %1").arg(i)));
+		queue.storeGroupMessage(message);
+		expected.append(message);
+	}
+	queue.storeGroupMessage(createGroupMessage(otherGroup, this->getFreeMessageId(), GroupMessageType::TEXT, QVariant(QStringLiteral("Other group"))));
+
+	ASSERT_EQ(10, queue.getSpilledMessageCount());
+	ASSERT_TRUE(queue.hasMessageForGroup(group));
+	ASSERT_EQ(9, db->getPendingMessages(QStringLiteral("queue/group/%1").arg(group.toQString())).size());
+
+	// A row that can not be read back is dropped, the others are still returned in order.
+	ASSERT_NO_THROW(db->storePendingMessage(QStringLiteral("queue/group/%1").arg(group.toQString()), QByteArray("garbage")));
+
+	QVector<MessageQueue::ReceivedGroupMessage> const result = queue.getAndRemoveQueuedMessages(group);
+	ASSERT_EQ(expected.size(), result.size());
+	for (int i = 0; i < expected.size(); ++i) {
+		assertSameMessage(expected.at(i), result.at(i));
+		ASSERT_EQ(expected.at(i).content.toString(), result.at(i).content.toString());
+	}
+
+	ASSERT_FALSE(queue.hasMessageForGroup(group));
+	ASSERT_TRUE(db->getPendingMessages(QStringLiteral("queue/group/%1").arg(group.toQString())).isEmpty());
+	ASSERT_EQ(1, queue.getSpilledMessageCount());
+	ASSERT_EQ(1, queue.getAndRemoveQueuedMessages(otherGroup).size());
+	ASSERT_EQ(0, queue.getMemoryUsageBytes());
+}
@@ -0,0 +1,56 @@
+#include "gtest/gtest.h"
+
+#include <QString>
+
+#include "src/utility/MetricsRegistry.h"
+
+TEST(MetricsRegistryTest, CountsAndGauges) {
+	openmittsu::utility::MetricsRegistry registry;
+	registry.incrementCounter(QStringLiteral("packets"));
+	registry.incrementCounter(QStringLiteral("packets"), 4);
+	registry.setGauge(QStringLiteral("queue"), 7);
+	registry.setGauge(QStringLiteral("queue"), 3);
+
+	EXPECT_EQ(5u, registry.getCounter(QStringLiteral("packets")));
+	EXPECT_EQ(0u, registry.getCounter(QStringLiteral("unknown")));
+	EXPECT_EQ(3, registry.getGauge(QStringLiteral("queue")));
+
+	registry.reset();
+	EXPECT_EQ(0u, registry.getCounter(QStringLiteral("packets")));
+}
+
+TEST(MetricsRegistryTest, HistogramPercentilesAreBucketUpperBounds) {
+	openmittsu::utility::MetricsRegistry registry;
+	EXPECT_EQ(-1, registry.getHistogram(QStringLiteral("latency")).getPercentileUpperBound(50.0));
+
+	for (int i = 1; i <= 100; ++i) {
+		registry.recordValue(QStringLiteral("latency"), i);
+	}
+
+	openmittsu::utility::MetricsRegistry::Histogram const histogram = registry.getHistogram(QStringLiteral("latency"));
+	EXPECT_EQ(100u, histogram.getCount());
+	EXPECT_EQ(5050, histogram.getSum());
+	EXPECT_EQ(1, histogram.getMin());
+	EXPECT_EQ(100, histogram.getMax());
+	// 50 falls into [32, 64), 90 and 99 into [64, 128) which is capped by the maximum.
+	EXPECT_EQ(63, histogram.getPercentileUpperBound(50.0));
+	EXPECT_EQ(100, histogram.getPercentileUpperBound(90.0));
+	EXPECT_EQ(100, histogram.getPercentileUpperBound(99.0));
+}
+
+TEST(MetricsRegistryTest, TextSnapshotIsSortedByName) {
+	openmittsu::utility::MetricsRegistry registry;
+	registry.incrementCounter(QStringLiteral("b.counter"), 2);
+	registry.setGauge(QStringLiteral("a.gauge"), 1);
+	registry.recordValue(QStringLiteral("c.histogram"), 10);
+
+	QString const text = registry.toText();
+	int const gaugeIndex = text.indexOf(QStringLiteral("gauge a.gauge 1"));
+	int const counterIndex = text.indexOf(QStringLiteral("counter b.counter 2"));
+	int const histogramIndex = text.indexOf(QStringLiteral("histogram c.histogram count=1 sum=10 min=10 max=10"));
+	ASSERT_GE(gaugeIndex, 0);
+	ASSERT_GE(counterIndex, 0);
+	ASSERT_GE(histogramIndex, 0);
+	EXPECT_LT(gaugeIndex, counterIndex);
+	EXPECT_LT(counterIndex, histogramIndex);
+}
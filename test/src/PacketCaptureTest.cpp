@@ -0,0 +1,59 @@
+#include "gtest/gtest.h"
+
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "src/exceptions/IllegalArgumentException.h"
+#include "src/network/PacketCaptureReader.h"
+#include "src/network/PacketCaptureWriter.h"
+
+TEST(PacketCaptureTest, ReadsBackWrittenPackets) {
+	QTemporaryDir directory;
+	ASSERT_TRUE(directory.isValid());
+	QString const filename = QDir(directory.path()).absoluteFilePath(QStringLiteral("capture.bin"));
+
+	QList<QByteArray> const packets({ QByteArray(4, 0x00), QByteArray("\x02\x00\x00\x00payload", 11), QByteArray(4000, 'x') });
+	{
+		openmittsu::network::PacketCaptureWriter writer(filename);
+		for (QByteArray const& packet : packets) {
+			writer.write(packet);
+		}
+		EXPECT_EQ(3u, writer.getPacketCount());
+	}
+
+	openmittsu::network::PacketCaptureReader reader(filename);
+	qint64 timestamp = 0;
+	QByteArray packet;
+	for (QByteArray const& expectedPacket : packets) {
+		ASSERT_TRUE(reader.readNext(timestamp, packet));
+		EXPECT_EQ(expectedPacket, packet);
+		EXPECT_GT(timestamp, 0);
+	}
+	EXPECT_FALSE(reader.readNext(timestamp, packet));
+}
+
+TEST(PacketCaptureTest, RejectsTruncatedAndForeignFiles) {
+	QTemporaryDir directory;
+	ASSERT_TRUE(directory.isValid());
+	QString const filename = QDir(directory.path()).absoluteFilePath(QStringLiteral("capture.bin"));
+	{
+		openmittsu::network::PacketCaptureWriter writer(filename);
+		writer.write(QByteArray(100, 'x'));
+	}
+
+	QFile file(filename);
+	ASSERT_TRUE(file.resize(file.size() - 10));
+	openmittsu::network::PacketCaptureReader reader(filename);
+	qint64 timestamp = 0;
+	QByteArray packet;
+	EXPECT_THROW(reader.readNext(timestamp, packet), openmittsu::exceptions::IllegalArgumentException);
+
+	QString const foreignFilename = QDir(directory.path()).absoluteFilePath(QStringLiteral("foreign.bin"));
+	QFile foreignFile(foreignFilename);
+	ASSERT_TRUE(foreignFile.open(QFile::WriteOnly));
+	foreignFile.write("not a capture");
+	foreignFile.close();
+	EXPECT_THROW(openmittsu::network::PacketCaptureReader foreignReader(foreignFilename), openmittsu::exceptions::IllegalArgumentException);
+}
@@ -0,0 +1,31 @@
+#include "gtest/gtest.h"
+
+#include <QByteArray>
+#include <sodium.h>
+
+#include "src/crypto/KeyPair.h"
+#include "src/crypto/Nonce.h"
+#include "src/crypto/PrecomputedSharedKey.h"
+#include "src/exceptions/CryptoException.h"
+
+TEST(PrecomputedSharedKeyTest, InteroperatesWithCryptoBoxEasy) {
+	openmittsu::crypto::KeyPair const clientKey = openmittsu::crypto::KeyPair::randomKey();
+	openmittsu::crypto::KeyPair const serverKey = openmittsu::crypto::KeyPair::randomKey();
+	openmittsu::crypto::Nonce const nonce;
+	QByteArray const data("Hello from the precomputed key!");
+
+	openmittsu::crypto::PrecomputedSharedKey const clientSessionKey(serverKey, clientKey);
+	QByteArray const encryptedData = clientSessionKey.encrypt(data, nonce);
+	ASSERT_EQ(data.size() + static_cast<int>(crypto_box_MACBYTES), encryptedData.size());
+
+	QByteArray decryptedData(data.size(), 0x00);
+	ASSERT_EQ(0, crypto_box_open_easy(reinterpret_cast<unsigned char*>(decryptedData.data()), reinterpret_cast<unsigned char const*>(encryptedData.data()), encryptedData.size(), nonce.getNonceAsCharPtr(), reinterpret_cast<unsigned char const*>(clientKey.getPublicKey().data()), reinterpret_cast<unsigned char const*>(serverKey.getPrivateKey().data())));
+	EXPECT_EQ(data, decryptedData);
+
+	openmittsu::crypto::PrecomputedSharedKey const serverSessionKey(clientKey, serverKey);
+	EXPECT_EQ(data, serverSessionKey.decrypt(encryptedData, nonce));
+
+	QByteArray tamperedData(encryptedData);
+	tamperedData[0] = static_cast<char>(tamperedData.at(0) ^ 0x01);
+	EXPECT_THROW(serverSessionKey.decrypt(tamperedData, nonce), openmittsu::exceptions::CryptoException);
+}
@@ -0,0 +1,52 @@
+#include "gtest/gtest.h"
+
+#include <QBuffer>
+#include <QByteArray>
+#include <sodium.h>
+
+#include "src/crypto/EncryptionKey.h"
+#include "src/crypto/Nonce.h"
+#include "src/crypto/StreamingSecretBox.h"
+#include "src/exceptions/CryptoException.h"
+
+static QByteArray secretBoxEasy(QByteArray const& data, openmittsu::crypto::EncryptionKey const& key, openmittsu::crypto::Nonce const& nonce) {
+	QByteArray encryptedData(data.size() + static_cast<int>(crypto_secretbox_MACBYTES), 0x00);
+	crypto_secretbox_easy(reinterpret_cast<unsigned char*>(encryptedData.data()), reinterpret_cast<unsigned char const*>(data.constData()), data.size(), nonce.getNonceAsCharPtr(), key.getEncryptionKeyAsCharPtr());
+	return encryptedData;
+}
+
+TEST(StreamingSecretBoxTest, MatchesSecretBoxOpenEasy) {
+	openmittsu::crypto::EncryptionKey const key;
+	openmittsu::crypto::Nonce const nonce;
+
+	// Around the 32 byte first block, the 64 byte block size and the chunk size.
+	for (int size : { 1, 31, 32, 33, 95, 96, 97, 64 * 1024, 64 * 1024 + 33, 200 * 1024 + 7 }) {
+		QByteArray data(size, 0x00);
+		randombytes_buf(data.data(), data.size());
+		QByteArray encryptedData = secretBoxEasy(data, key, nonce);
+
+		QBuffer source(&encryptedData);
+		ASSERT_TRUE(source.open(QIODevice::ReadOnly));
+		QByteArray decryptedData;
+		QBuffer sink(&decryptedData);
+		ASSERT_TRUE(sink.open(QIODevice::WriteOnly));
+
+		openmittsu::crypto::StreamingSecretBox::decrypt(source, encryptedData.size(), sink, key, nonce);
+		EXPECT_EQ(data, decryptedData) << "for " << size << " Bytes";
+	}
+}
+
+TEST(StreamingSecretBoxTest, RejectsTamperedCipherText) {
+	openmittsu::crypto::EncryptionKey const key;
+	openmittsu::crypto::Nonce const nonce;
+	QByteArray encryptedData = secretBoxEasy(QByteArray(1000, 'x'), key, nonce);
+	encryptedData[500] = static_cast<char>(encryptedData.at(500) ^ 0x01);
+
+	QBuffer source(&encryptedData);
+	ASSERT_TRUE(source.open(QIODevice::ReadOnly));
+	QByteArray decryptedData;
+	QBuffer sink(&decryptedData);
+	ASSERT_TRUE(sink.open(QIODevice::WriteOnly));
+
+	EXPECT_THROW(openmittsu::crypto::StreamingSecretBox::decrypt(source, encryptedData.size(), sink, key, nonce), openmittsu::exceptions::CryptoException);
+}
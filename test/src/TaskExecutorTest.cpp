@@ -0,0 +1,133 @@
+#include "gtest/gtest.h"
+
+#include <QAtomicInt>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSemaphore>
+#include <QThread>
+
+#include <memory>
+
+#include "src/tasks/CallbackTask.h"
+#include "src/tasks/TaskExecutor.h"
+
+namespace {
+	class RecordingCallbackTask : public openmittsu::tasks::CallbackTask {
+	public:
+		RecordingCallbackTask(int id, QList<int>* order, QMutex* orderMutex, QSemaphore* gate = nullptr) : CallbackTask(), m_id(id), m_order(order), m_orderMutex(orderMutex), m_gate(gate) {
+			// Intentionally left empty.
+		}
+	protected:
+		virtual void taskRun() override {
+			if (m_gate != nullptr) {
+				m_gate->acquire();
+			}
+
+			{
+				QMutexLocker lock(m_orderMutex);
+				m_order->append(m_id);
+			}
+			finishedWithNoError();
+		}
+	private:
+		int const m_id;
+		QList<int>* const m_order;
+		QMutex* const m_orderMutex;
+		QSemaphore* const m_gate;
+	};
+
+	class DeletionRecordingCallbackTask : public openmittsu::tasks::CallbackTask {
+	public:
+		explicit DeletionRecordingCallbackTask(QSemaphore* deleted) : CallbackTask(), m_deleted(deleted) {
+			// Intentionally left empty.
+		}
+
+		virtual ~DeletionRecordingCallbackTask() {
+			m_deleted->release();
+		}
+	private:
+		QSemaphore* const m_deleted;
+	};
+}
+
+TEST(TaskExecutorTest, RunsQueuedTasksByPriority) {
+	openmittsu::tasks::TaskExecutor executor(1);
+	QList<int> order;
+	QMutex orderMutex;
+	QSemaphore gate;
+
+	// Occupies the only worker until the other tasks are queued.
+	RecordingCallbackTask blocker(0, &order, &orderMutex, &gate);
+	RecordingCallbackTask low(1, &order, &orderMutex);
+	RecordingCallbackTask normal(2, &order, &orderMutex);
+	RecordingCallbackTask high(3, &order, &orderMutex);
+
+	executor.submit(&blocker);
+	executor.submit(&low, openmittsu::tasks::TaskExecutor::TaskPriority::LOW);
+	executor.submit(&normal, openmittsu::tasks::TaskExecutor::TaskPriority::NORMAL);
+	executor.submit(&high, openmittsu::tasks::TaskExecutor::TaskPriority::HIGH);
+	gate.release();
+	ASSERT_TRUE(executor.waitForDone(10000));
+
+	EXPECT_EQ(QList<int>() << 0 << 3 << 2 << 1, order);
+	EXPECT_EQ(4u, executor.getSubmittedTaskCount());
+	EXPECT_EQ(4u, executor.getCompletedTaskCount());
+	EXPECT_EQ(0, executor.getQueuedTaskCount());
+	EXPECT_TRUE(high.hasFinishedSuccessfully());
+	EXPECT_GE(high.getRunTime(), 0);
+	EXPECT_GE(high.getQueueWaitTime(), 0);
+}
+
+TEST(TaskExecutorTest, CancelledTasksFinishWithoutRunning) {
+	openmittsu::tasks::TaskExecutor executor(1);
+	QList<int> order;
+	QMutex orderMutex;
+	QSemaphore gate;
+
+	RecordingCallbackTask blocker(0, &order, &orderMutex, &gate);
+	RecordingCallbackTask cancelled(1, &order, &orderMutex);
+
+	executor.submit(&blocker);
+	executor.submit(&cancelled);
+	EXPECT_TRUE(executor.cancel(&cancelled));
+	gate.release();
+	ASSERT_TRUE(executor.waitForDone(10000));
+
+	EXPECT_EQ(QList<int>() << 0, order);
+	EXPECT_TRUE(cancelled.hasFinished());
+	EXPECT_FALSE(cancelled.hasFinishedSuccessfully());
+	EXPECT_TRUE(cancelled.wasCancelled());
+	EXPECT_EQ(1u, executor.getCancelledTaskCount());
+	EXPECT_FALSE(executor.cancel(&cancelled));
+}
+
+TEST(TaskExecutorTest, DiscardedTasksAreDeletedWithoutFinishing) {
+	openmittsu::tasks::TaskExecutor executor(1);
+	QList<int> order;
+	QMutex orderMutex;
+	QSemaphore gate;
+	QSemaphore deleted;
+	QAtomicInt finishedCount(0);
+
+	RecordingCallbackTask blocker(0, &order, &orderMutex, &gate);
+	executor.submit(&blocker);
+	// Discarding must not catch the blocker, so wait until it occupies the worker.
+	while (executor.getRunningTaskCount() == 0) {
+		QThread::msleep(1);
+	}
+
+	DeletionRecordingCallbackTask* discarded = new DeletionRecordingCallbackTask(&deleted);
+	QObject::connect(discarded, &openmittsu::tasks::CallbackTask::finished, [&finishedCount](openmittsu::tasks::CallbackTask*) { finishedCount.fetchAndAddOrdered(1); });
+	executor.submit(discarded);
+	executor.discardQueuedTasks();
+	gate.release();
+	ASSERT_TRUE(executor.waitForDone(10000));
+
+	EXPECT_EQ(1, deleted.available());
+	EXPECT_EQ(0, finishedCount.load());
+	EXPECT_TRUE(blocker.hasFinishedSuccessfully());
+	EXPECT_EQ(1u, executor.getCompletedTaskCount());
+	EXPECT_EQ(1u, executor.getCancelledTaskCount());
+	EXPECT_EQ(0, executor.getQueuedTaskCount());
+}
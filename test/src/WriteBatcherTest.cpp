@@ -0,0 +1,70 @@
+#include "gtest/gtest.h"
+
+#include <QList>
+
+#include <functional>
+
+#include "src/database/WriteBatcher.h"
+
+TEST(WriteBatcherTest, HoldsNotificationsUntilTaken) {
+	openmittsu::database::WriteBatcher batcher(3);
+	EXPECT_FALSE(batcher.isOpen());
+
+	QList<int> fired;
+	EXPECT_TRUE(batcher.beginOperation());
+	batcher.addNotification([&fired]() { fired.append(1); });
+	EXPECT_FALSE(batcher.endOperation());
+
+	// Only the first operation opens the batch.
+	EXPECT_FALSE(batcher.beginOperation());
+	batcher.addNotification([&fired]() { fired.append(2); });
+	EXPECT_FALSE(batcher.endOperation());
+	EXPECT_TRUE(batcher.isOpen());
+	EXPECT_EQ(2, batcher.getOperationCount());
+
+	EXPECT_FALSE(batcher.beginOperation());
+	EXPECT_TRUE(batcher.endOperation());
+
+	QList<std::function<void()>> const notifications = batcher.takeNotifications();
+	EXPECT_FALSE(batcher.isOpen());
+	EXPECT_TRUE(fired.isEmpty());
+	for (auto const& notification : notifications) {
+		notification();
+	}
+	EXPECT_EQ(QList<int>({ 1, 2 }), fired);
+}
+
+TEST(WriteBatcherTest, ClearDropsNotifications) {
+	openmittsu::database::WriteBatcher batcher(10);
+	EXPECT_TRUE(batcher.beginOperation());
+	batcher.addNotification([]() {});
+	batcher.clear();
+
+	EXPECT_FALSE(batcher.isOpen());
+	EXPECT_TRUE(batcher.takeNotifications().isEmpty());
+	EXPECT_TRUE(batcher.beginOperation());
+}
+
+TEST(WriteBatcherTest, RollbackHandlersReplaceNotifications) {
+	openmittsu::database::WriteBatcher batcher(10);
+	QList<int> fired;
+	EXPECT_TRUE(batcher.beginOperation());
+	batcher.addNotification([&fired]() { fired.append(1); });
+	batcher.addRollbackHandler([&fired]() { fired.append(2); });
+	batcher.addRollbackHandler([&fired]() { fired.append(3); });
+	EXPECT_FALSE(batcher.endOperation());
+
+	QList<std::function<void()>> const rollbackHandlers = batcher.takeRollbackHandlers();
+	EXPECT_FALSE(batcher.isOpen());
+	EXPECT_TRUE(batcher.takeNotifications().isEmpty());
+	for (auto const& rollbackHandler : rollbackHandlers) {
+		rollbackHandler();
+	}
+	EXPECT_EQ(QList<int>({ 2, 3 }), fired);
+
+	// A committed batch does not report a rollback.
+	EXPECT_TRUE(batcher.beginOperation());
+	batcher.addRollbackHandler([&fired]() { fired.append(4); });
+	EXPECT_TRUE(batcher.takeNotifications().isEmpty());
+	EXPECT_TRUE(batcher.takeRollbackHandlers().isEmpty());
+}